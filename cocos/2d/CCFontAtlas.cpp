@@ -35,6 +35,8 @@
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
+#include "platform/CCFileUtils.h"
+#include "platform/CCMappedFile.h"
 
 namespace cocos2d {
 
@@ -48,6 +50,8 @@ FontAtlas::FontAtlas(Font &theFont)
 , _fontFreeType(nullptr)
 , _iconv(nullptr)
 , _currentPageData(nullptr)
+, _cachedPages(0)
+, _glyphCacheDirty(false)
 , _fontAscender(0)
 , _rendererRecreatedListener(nullptr)
 , _antialiasEnabled(true)
@@ -132,6 +136,10 @@ void FontAtlas::reset()
     _currentPageOrigX = 0;
     _currentPageOrigY = 0;
     _letterDefinitions.clear();
+    _textLayouts.clear();
+    _filledPagesData.clear();
+    _cachedPages = 0;
+    _glyphCacheDirty = false;
 }
 
 void FontAtlas::releaseTextures()
@@ -176,6 +184,25 @@ void FontAtlas::scaleFontLetterDefinition(float scaleFactor)
     }
 }
 
+const FontTextLayout* FontAtlas::getTextLayout(const std::string& key) const
+{
+    auto it = _textLayouts.find(key);
+    return it != _textLayouts.end() ? &it->second : nullptr;
+}
+
+void FontAtlas::addTextLayout(const std::string& key, FontTextLayout&& layout)
+{
+    if (CC_LABEL_LAYOUT_CACHE_SIZE <= 0)
+    {
+        return;
+    }
+    if (_textLayouts.size() >= static_cast<size_t>(CC_LABEL_LAYOUT_CACHE_SIZE))
+    {
+        _textLayouts.clear();
+    }
+    _textLayouts.emplace(key, std::move(layout));
+}
+
 bool FontAtlas::getLetterDefinitionForChar(char16_t utf16Char, FontLetterDefinition &letterDefinition)
 {
     auto outIterator = _letterDefinitions.find(utf16Char);
@@ -377,20 +404,15 @@ bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16Text)
 
                     startY = 0.0f;
 
+                    if (!_glyphCacheFile.empty())
+                    {
+                        _filledPagesData.emplace_back(_currentPageData, _currentPageData + _currentPageDataSize);
+                    }
+
                     _currentPageOrigY = 0;
                     memset(_currentPageData, 0, _currentPageDataSize);
                     _currentPage++;
-                    auto tex = new (std::nothrow) Texture2D;
-                    if (_antialiasEnabled)
-                    {
-                        tex->setAntiAliasTexParameters();
-                    }
-                    else
-                    {
-                        tex->setAliasTexParameters();
-                    }
-                    tex->initWithData(_currentPageData, _currentPageDataSize,
-                        pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
+                    auto tex = createPageTexture(_currentPageData);
                     addTexture(tex, _currentPage);
                     tex->release();
                 }
@@ -442,6 +464,251 @@ bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16Text)
     }
     _atlasTextures[_currentPage]->updateWithData(data, 0, startY, CacheTextureWidth, _currentPageOrigY - startY + _currLineHeight);
 
+    _glyphCacheDirty = true;
+
+    return true;
+}
+
+Texture2D* FontAtlas::createPageTexture(const unsigned char* data)
+{
+    auto pixelFormat = _fontFreeType->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+    auto texture = new (std::nothrow) Texture2D;
+    if (_antialiasEnabled)
+    {
+        texture->setAntiAliasTexParameters();
+    }
+    else
+    {
+        texture->setAliasTexParameters();
+    }
+    texture->initWithData(data, _currentPageDataSize,
+        pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
+    return texture;
+}
+
+namespace {
+
+const char GLYPH_CACHE_MAGIC[4] = { 'C', 'C', 'G', 'C' };
+const uint32_t GLYPH_CACHE_VERSION = 1;
+
+struct GlyphCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t letterRecordSize;
+    uint32_t pageWidth;
+    uint32_t pageHeight;
+    uint32_t pageDataSize;
+    uint32_t pageCount;
+    uint32_t letterCount;
+    float contentScaleFactor;
+    float lineHeight;
+    float currentPageOrigX;
+    float currentPageOrigY;
+    int32_t currLineHeight;
+};
+
+struct GlyphCacheLetter
+{
+    uint32_t utf16Char;
+    FontLetterDefinition definition;
+};
+
+// Returns the header if the cache file was written by this build for an atlas with the same settings.
+const GlyphCacheHeader* validateGlyphCache(const MappedFile& file, int pageDataSize, float lineHeight)
+{
+    if (file.getSize() < static_cast<ssize_t>(sizeof(GlyphCacheHeader)))
+    {
+        return nullptr;
+    }
+
+    auto header = reinterpret_cast<const GlyphCacheHeader*>(file.getBytes());
+    if (memcmp(header->magic, GLYPH_CACHE_MAGIC, sizeof(GLYPH_CACHE_MAGIC)) != 0
+        || header->version != GLYPH_CACHE_VERSION
+        || header->letterRecordSize != sizeof(GlyphCacheLetter)
+        || header->pageWidth != static_cast<uint32_t>(FontAtlas::CacheTextureWidth)
+        || header->pageHeight != static_cast<uint32_t>(FontAtlas::CacheTextureHeight)
+        || header->pageDataSize != static_cast<uint32_t>(pageDataSize)
+        || header->pageCount == 0
+        || header->contentScaleFactor != CC_CONTENT_SCALE_FACTOR()
+        || header->lineHeight != lineHeight)
+    {
+        return nullptr;
+    }
+
+    auto expectedSize = sizeof(GlyphCacheHeader)
+        + static_cast<size_t>(header->letterCount) * sizeof(GlyphCacheLetter)
+        + static_cast<size_t>(header->pageCount) * header->pageDataSize;
+    if (static_cast<size_t>(file.getSize()) != expectedSize)
+    {
+        return nullptr;
+    }
+
+    return header;
+}
+
+} // namespace
+
+bool FontAtlas::loadGlyphCache(const std::string& fullPath)
+{
+    if (_fontFreeType == nullptr)
+    {
+        return false;
+    }
+
+    _glyphCacheFile = fullPath;
+
+    auto file = MappedFile::open(fullPath);
+    if (!file)
+    {
+        return false;
+    }
+
+    auto header = validateGlyphCache(*file, _currentPageDataSize, _lineHeight);
+    if (header == nullptr)
+    {
+        CCLOG("FontAtlas: ignoring outdated glyph cache %s", fullPath.c_str());
+        return false;
+    }
+
+    auto letters = reinterpret_cast<const GlyphCacheLetter*>(file->getBytes() + sizeof(GlyphCacheHeader));
+    auto pages = reinterpret_cast<const unsigned char*>(letters + header->letterCount);
+
+    // the filled pages are uploaded straight from the mapping, the last
+    // one is copied since glyphs are still rendered into it
+    int lastPage = static_cast<int>(header->pageCount) - 1;
+    for (int page = 0; page < lastPage; ++page)
+    {
+        auto data = pages + static_cast<size_t>(page) * _currentPageDataSize;
+        if (page == 0)
+        {
+            _atlasTextures[0]->updateWithData(data, 0, 0, CacheTextureWidth, CacheTextureHeight);
+        }
+        else
+        {
+            auto texture = createPageTexture(data);
+            addTexture(texture, page);
+            texture->release();
+        }
+    }
+
+    memcpy(_currentPageData, pages + static_cast<size_t>(lastPage) * _currentPageDataSize, _currentPageDataSize);
+    if (lastPage == 0)
+    {
+        _atlasTextures[0]->updateWithData(_currentPageData, 0, 0, CacheTextureWidth, CacheTextureHeight);
+    }
+    else
+    {
+        auto texture = createPageTexture(_currentPageData);
+        addTexture(texture, lastPage);
+        texture->release();
+    }
+
+    _letterDefinitions.reserve(header->letterCount);
+    for (uint32_t index = 0; index < header->letterCount; ++index)
+    {
+        _letterDefinitions[static_cast<char16_t>(letters[index].utf16Char)] = letters[index].definition;
+    }
+
+    _currentPage = lastPage;
+    _currentPageOrigX = header->currentPageOrigX;
+    _currentPageOrigY = header->currentPageOrigY;
+    _currLineHeight = header->currLineHeight;
+    _cachedPages = lastPage;
+    _glyphCacheDirty = false;
+
+    return true;
+}
+
+bool FontAtlas::saveGlyphCache()
+{
+    if (_glyphCacheFile.empty() || !_glyphCacheDirty || _fontFreeType == nullptr)
+    {
+        return true;
+    }
+
+    // the filled pages restored from the previous cache are only kept in that file
+    std::unique_ptr<MappedFile> previousCache;
+    const unsigned char* cachedPages = nullptr;
+    if (_cachedPages > 0)
+    {
+        previousCache = MappedFile::open(_glyphCacheFile);
+        auto header = previousCache ? validateGlyphCache(*previousCache, _currentPageDataSize, _lineHeight) : nullptr;
+        if (header == nullptr || header->pageCount <= static_cast<uint32_t>(_cachedPages))
+        {
+            CCLOG("FontAtlas: glyph cache %s changed on disk, can't update it", _glyphCacheFile.c_str());
+            return false;
+        }
+        cachedPages = previousCache->getBytes() + sizeof(GlyphCacheHeader) + header->letterCount * sizeof(GlyphCacheLetter);
+    }
+
+    CCASSERT(_cachedPages + _filledPagesData.size() == static_cast<size_t>(_currentPage), "Missing glyph page data");
+
+    GlyphCacheHeader header;
+    memcpy(header.magic, GLYPH_CACHE_MAGIC, sizeof(GLYPH_CACHE_MAGIC));
+    header.version = GLYPH_CACHE_VERSION;
+    header.letterRecordSize = sizeof(GlyphCacheLetter);
+    header.pageWidth = CacheTextureWidth;
+    header.pageHeight = CacheTextureHeight;
+    header.pageDataSize = _currentPageDataSize;
+    header.pageCount = _currentPage + 1;
+    header.letterCount = static_cast<uint32_t>(_letterDefinitions.size());
+    header.contentScaleFactor = CC_CONTENT_SCALE_FACTOR();
+    header.lineHeight = _lineHeight;
+    header.currentPageOrigX = _currentPageOrigX;
+    header.currentPageOrigY = _currentPageOrigY;
+    header.currLineHeight = _currLineHeight;
+
+    size_t size = sizeof(GlyphCacheHeader)
+        + _letterDefinitions.size() * sizeof(GlyphCacheLetter)
+        + static_cast<size_t>(header.pageCount) * _currentPageDataSize;
+    auto bytes = static_cast<unsigned char*>(malloc(size));
+    if (bytes == nullptr)
+    {
+        return false;
+    }
+
+    auto out = bytes;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (auto&& item : _letterDefinitions)
+    {
+        GlyphCacheLetter letter;
+        memset(&letter, 0, sizeof(letter));
+        letter.utf16Char = item.first;
+        letter.definition = item.second;
+        memcpy(out, &letter, sizeof(letter));
+        out += sizeof(letter);
+    }
+
+    if (cachedPages)
+    {
+        memcpy(out, cachedPages, static_cast<size_t>(_cachedPages) * _currentPageDataSize);
+        out += static_cast<size_t>(_cachedPages) * _currentPageDataSize;
+    }
+    for (auto&& page : _filledPagesData)
+    {
+        memcpy(out, page.data(), page.size());
+        out += page.size();
+    }
+    memcpy(out, _currentPageData, _currentPageDataSize);
+
+    previousCache.reset();
+
+    Data data;
+    data.fastSet(bytes, static_cast<ssize_t>(size));
+
+    // write aside and swap, a partially written cache must never be loaded
+    auto fileUtils = FileUtils::getInstance();
+    auto tempFile = _glyphCacheFile + ".tmp";
+    if (!fileUtils->writeDataToFile(data, tempFile) || !fileUtils->renameFile(tempFile, _glyphCacheFile))
+    {
+        fileUtils->removeFile(tempFile);
+        return false;
+    }
+
+    _glyphCacheDirty = false;
     return true;
 }
 
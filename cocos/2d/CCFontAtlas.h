@@ -30,6 +30,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "platform/CCPlatformMacros.h"
 #include "base/CCRef.h"
@@ -56,6 +57,31 @@ struct FontLetterDefinition
     int xAdvance;
 };
 
+/**
+ * Wrapped layout of one string, shared by all the Labels which render the same text
+ * with the same atlas and layout settings. Letter positions don't include alignment offsets.
+ */
+struct FontTextLayout
+{
+    struct Letter
+    {
+        char16_t utf16Char;
+        bool valid;
+        float positionX;
+        float positionY;
+        int lineIndex;
+    };
+
+    std::vector<Letter> letters;
+    std::vector<float> linesWidth;
+    int numberOfLines;
+    float textDesiredHeight;
+    float contentWidth;
+    float contentHeight;
+    float tailoredTopY;
+    float tailoredBottomY;
+};
+
 class CC_DLL FontAtlas : public Ref
 {
 public:
@@ -108,8 +134,27 @@ public:
      */
      void setAliasTexParameters();
 
+    /**
+     * Restores the glyph pages and letter definitions saved by saveGlyphCache() and remembers
+     * the file for the next save. The pages are uploaded straight from the memory mapped file.
+     * Returns false if the file is missing or was written for other font settings.
+     */
+    bool loadGlyphCache(const std::string& fullPath);
+
+    /** Writes the glyph pages and letter definitions to the file given to loadGlyphCache(),
+     if glyphs were added since it was loaded. */
+    bool saveGlyphCache();
+
+    /** Returns the cached layout stored under key, or nullptr. */
+    const FontTextLayout* getTextLayout(const std::string& key) const;
+
+    /** Stores a layout under key. The cache is emptied when it reaches CC_LABEL_LAYOUT_CACHE_SIZE entries. */
+    void addTextLayout(const std::string& key, FontTextLayout&& layout);
+
 protected:
     void reset();
+
+    Texture2D* createPageTexture(const unsigned char* data);
     
     void releaseTextures();
 
@@ -126,6 +171,7 @@ protected:
 
     std::unordered_map<ssize_t, Texture2D*> _atlasTextures;
     std::unordered_map<char16_t, FontLetterDefinition> _letterDefinitions;
+    std::unordered_map<std::string, FontTextLayout> _textLayouts;
     float _lineHeight;
     Font* _font;
     FontFreeType* _fontFreeType;
@@ -140,6 +186,12 @@ protected:
     int _letterPadding;
     int _letterEdgeExtend;
 
+    // glyph cache file and the pixels of the filled pages which didn't come from it
+    std::string _glyphCacheFile;
+    std::vector<std::vector<unsigned char>> _filledPagesData;
+    int _cachedPages;
+    bool _glyphCacheDirty;
+
     int _fontAscender;
     EventListenerCustom* _rendererRecreatedListener;
     bool _antialiasEnabled;
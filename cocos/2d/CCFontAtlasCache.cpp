@@ -35,6 +35,7 @@
 namespace cocos2d {
 
 std::unordered_map<std::string, FontAtlas *> FontAtlasCache::_atlasMap;
+std::string FontAtlasCache::_glyphCacheDirectory;
 #define ATLAS_MAP_KEY_BUFFER 255
 
 void FontAtlasCache::purgeCachedData()
@@ -74,6 +75,12 @@ FontAtlas* FontAtlasCache::getFontAtlasTTF(const TTFConfig* config)
             config->customGlyphs, useDistanceField, config->outlineSize);
         if (font)
         {
+            if (!_glyphCacheDirectory.empty())
+            {
+                snprintf(tmp, ATLAS_MAP_KEY_BUFFER, "%08x_%.2f_%d_%d_%.2f.glyphs", font->getFontDataHash(),
+                         config->fontSize, config->outlineSize, useDistanceField ? 1 : 0, CC_CONTENT_SCALE_FACTOR());
+                font->setGlyphCacheFile(_glyphCacheDirectory + tmp);
+            }
             auto tempAtlas = font->createFontAtlas();
             if (tempAtlas)
             {
@@ -273,4 +280,30 @@ void FontAtlasCache::unloadFontAtlasTTF(const std::string& fontFileName)
     }
 }
 
+void FontAtlasCache::setGlyphCacheDirectory(const std::string& directory)
+{
+    _glyphCacheDirectory = directory;
+    if (!_glyphCacheDirectory.empty() && _glyphCacheDirectory.back() != '/')
+    {
+        _glyphCacheDirectory += '/';
+    }
+}
+
+void FontAtlasCache::saveGlyphCaches()
+{
+    if (_glyphCacheDirectory.empty())
+    {
+        return;
+    }
+
+    FileUtils::getInstance()->createDirectory(_glyphCacheDirectory);
+    for (auto&& atlas : _atlasMap)
+    {
+        if (!atlas.second->saveGlyphCache())
+        {
+            CCLOG("FontAtlasCache: failed to save glyph cache for %s", atlas.first.c_str());
+        }
+    }
+}
+
 } // namespace cocos2d
@@ -66,8 +66,18 @@ public:
     */
     static void unloadFontAtlasTTF(const std::string& fontFileName);
 
+    /** Sets the directory TTF glyph atlases are persisted to, an empty string disables persistence.
+     Atlases created afterwards are restored from their cache file, skipping glyph rasterization.
+     */
+    static void setGlyphCacheDirectory(const std::string& directory);
+    static const std::string& getGlyphCacheDirectory() { return _glyphCacheDirectory; }
+
+    /** Writes the glyphs rendered since loading to the cache directory. */
+    static void saveGlyphCaches();
+
 private:
     static std::unordered_map<std::string, FontAtlas *> _atlasMap;
+    static std::string _glyphCacheDirectory;
 };
 
 } // namespace cocos2d
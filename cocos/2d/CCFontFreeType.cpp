@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "base/CCDirector.h"
 #include "base/ccUTF8.h"
 #include "platform/CCFileUtils.h"
+#include "xxhash.h"
 
 namespace cocos2d {
 
@@ -45,6 +46,7 @@ typedef struct _DataRef
 {
     Data data;
     unsigned int referenceCount;
+    unsigned int hash;
 }DataRef;
 
 static std::unordered_map<std::string, DataRef> s_cacheFontData;
@@ -138,6 +140,7 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
         {
             return false;
         }
+        s_cacheFontData[fontName].hash = 0;
     }
 
     if (FT_New_Memory_Face(getFTLibrary(), s_cacheFontData[fontName].data.getBytes(), s_cacheFontData[fontName].data.getSize(), 0, &face ))
@@ -211,6 +214,10 @@ FontAtlas * FontFreeType::createFontAtlas()
     if (_fontAtlas == nullptr)
     {
         _fontAtlas = new (std::nothrow) FontAtlas(*this);
+        if (_fontAtlas && !_glyphCacheFile.empty())
+        {
+            _fontAtlas->loadGlyphCache(_glyphCacheFile);
+        }
         if (_fontAtlas && _usedGlyphs != GlyphCollection::DYNAMIC)
         {
             std::u16string utf16;
@@ -225,6 +232,22 @@ FontAtlas * FontFreeType::createFontAtlas()
     return _fontAtlas;
 }
 
+unsigned int FontFreeType::getFontDataHash() const
+{
+    auto it = s_cacheFontData.find(_fontName);
+    if (it == s_cacheFontData.end())
+    {
+        return 0;
+    }
+
+    auto& fontData = it->second;
+    if (fontData.hash == 0)
+    {
+        fontData.hash = XXH32(fontData.data.getBytes(), static_cast<int>(fontData.data.getSize()), 0);
+    }
+    return fontData.hash;
+}
+
 int * FontFreeType::getHorizontalKerningForTextUTF16(const std::u16string& text, int &outNumLetters) const
 {
     if (!_fontRef)
@@ -76,6 +76,12 @@ public:
     virtual FontAtlas* createFontAtlas() override;
     virtual int getFontMaxHeight() const override { return _lineHeight; }
 
+    /** Hash of the font file contents, used to key persisted glyph caches. */
+    unsigned int getFontDataHash() const;
+
+    /** Sets the glyph cache file the atlas is restored from, must be called before createFontAtlas. */
+    void setGlyphCacheFile(const std::string& fullPath) { _glyphCacheFile = fullPath; }
+
     static void releaseFont(const std::string &fontName);
 
 private:
@@ -110,6 +116,7 @@ private:
 
     GlyphCollection _usedGlyphs;
     std::string _customGlyphs;
+    std::string _glyphCacheFile;
 };
 
 /// @endcond
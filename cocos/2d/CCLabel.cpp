@@ -144,13 +144,16 @@ public:
         {
             displayedOpacity = 0.0f;
         }
-        Color4B color4(_displayedColor.r, _displayedColor.g, _displayedColor.b, displayedOpacity);
+        Color4B color4(_displayedColor.r * _textColor.r / 255,
+                       _displayedColor.g * _textColor.g / 255,
+                       _displayedColor.b * _textColor.b / 255,
+                       displayedOpacity * _textColor.a / 255);
         // special opacity for premultiplied textures
         if (_opacityModifyRGB)
         {
-            color4.r *= displayedOpacity / 255.0f;
-            color4.g *= displayedOpacity / 255.0f;
-            color4.b *= displayedOpacity / 255.0f;
+            color4.r *= color4.a / 255.0f;
+            color4.g *= color4.a / 255.0f;
+            color4.b *= color4.a / 255.0f;
         }
         _quad.bl.colors = color4;
         _quad.br.colors = color4;
@@ -165,6 +168,16 @@ public:
         _letterVisible = visible;
         updateColor();
     }
+
+    // text color baked into the quad, see Label::isQuadBatchable()
+    void setTextColor(const Color4B& color)
+    {
+        if (_textColor != color)
+        {
+            _textColor = color;
+            updateColor();
+        }
+    }
     
     //LabelLetter doesn't need to draw directly.
     void draw(Renderer* /*renderer*/, const Mat4 & /*transform*/, uint32_t /*flags*/) override
@@ -173,6 +186,7 @@ public:
     
 private:
     bool _letterVisible;
+    Color4B _textColor = Color4B::WHITE;
 };
 
 Label* Label::create()
@@ -543,7 +557,7 @@ void Label::updateShaderProgram()
         if (_useDistanceField)
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL));
         else if (_useA8Shader)
-            setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_NORMAL));
+            setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(_shadowEnabled ? GLProgram::SHADER_NAME_LABEL_NORMAL : GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR_NO_MVP));
         else if (_shadowEnabled)
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR, _getTexture(this)));
         else
@@ -566,6 +580,30 @@ void Label::updateShaderProgram()
     }
     
     _uniformTextColor = glGetUniformLocation(getGLProgram()->getProgram(), "u_textColor");
+
+    // the text color moves between the vertices and the shader uniform
+    updateColor();
+}
+
+bool Label::isQuadBatchable() const
+{
+    // Letters drawn with a QuadCommand can be batched with the other nodes sharing the atlas texture.
+    // Shadow and the TTF effects need extra passes or per label uniforms, so they go through onDraw().
+    if (_shadowEnabled)
+    {
+        return false;
+    }
+
+    switch (_currentLabelType)
+    {
+    case LabelType::BMFONT:
+    case LabelType::CHARMAP:
+        return true;
+    case LabelType::TTF:
+        return _currLabelEffect == LabelEffect::NORMAL && _useA8Shader && !_useDistanceField;
+    default:
+        return false;
+    }
 }
 
 void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false */, bool useA8Shader /* = false */)
@@ -826,13 +864,28 @@ bool Label::alignText()
         _lengthOfString = 0;
         _textDesiredHeight = 0.f;
         _linesWidth.clear();
-        if (_maxLineWidth > 0.f && !_lineBreakWithoutSpaces)
+
+        // the wrapped layout doesn't depend on alignment, so labels which
+        // differ only in alignment share it
+        updateBMFontScale();
+        auto layoutKey = getTextLayoutKey();
+        auto cachedLayout = _fontAtlas->getTextLayout(layoutKey);
+        if (cachedLayout)
         {
-            multilineTextWrapByWord();
+            applyTextLayout(*cachedLayout);
         }
         else
         {
-            multilineTextWrapByChar();
+            computeHorizontalKernings(_utf16Text);
+            if (_maxLineWidth > 0.f && !_lineBreakWithoutSpaces)
+            {
+                multilineTextWrapByWord();
+            }
+            else
+            {
+                multilineTextWrapByChar();
+            }
+            cacheTextLayout(layoutKey);
         }
         computeAlignmentOffset();
 
@@ -840,6 +893,8 @@ bool Label::alignText()
             float fontSize = this->getRenderingFontSize();
 
             if(fontSize > 0 &&  isVerticalClamp()){
+                if (cachedLayout)
+                    computeHorizontalKernings(_utf16Text);
                 this->shrinkLabelToContentSize(CC_CALLBACK_0(Label::isVerticalClamp, this));
             }
         }
@@ -847,6 +902,8 @@ bool Label::alignText()
         if(!updateQuads()){
             ret = false;
             if(_overflow == Overflow::SHRINK){
+                if (cachedLayout)
+                    computeHorizontalKernings(_utf16Text);
                 this->shrinkLabelToContentSize(CC_CALLBACK_0(Label::isHorizontalClamp, this));
             }
             break;
@@ -1129,9 +1186,9 @@ void Label::enableShadow(const Color4B& shadowColor /* = Color4B::BLACK */,
     _shadowColor4F.b = shadowColor.b / 255.0f;
     _shadowColor4F.a = shadowColor.a / 255.0f;
 
-    if (_currentLabelType == LabelType::BMFONT || _currentLabelType == LabelType::CHARMAP)
+    if (_currentLabelType != LabelType::STRING_TEXTURE)
     {
-        setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(_shadowEnabled ? GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR : GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP, _getTexture(this)));
+        updateShaderProgram();
     }
 }
 
@@ -1351,7 +1408,6 @@ void Label::updateContent()
             _utf16Text = utf16String;
         }
 
-        computeHorizontalKernings(_utf16Text);
         updateFinished = alignText();
     }
     else
@@ -1556,18 +1612,33 @@ void Label::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
     if (_insideBounds)
 #endif
     {
-        if (!_shadowEnabled && (_currentLabelType == LabelType::BMFONT || _currentLabelType == LabelType::CHARMAP))
+        if (isQuadBatchable())
         {
             for (auto&& it : _letters)
             {
                 it.second->updateTransform();
             }
-            // ETC1 ALPHA supports for BMFONT & CHARMAP
-            auto textureAtlas = _batchNodes.at(0)->getTextureAtlas();
-            auto texture = textureAtlas->getTexture();
-            _quadCommand.init(_globalZOrder, texture, getGLProgramState(), 
-                _blendFunc, textureAtlas->getQuads(), textureAtlas->getTotalQuads(), transform, flags);
-            renderer->addCommand(&_quadCommand);
+
+            // one command per atlas page, the renderer merges the ones sharing a texture
+            while (_quadCommands.size() < _batchNodes.size())
+            {
+                _quadCommands.push_back(std::make_unique<QuadCommand>());
+            }
+
+            for (size_t index = 0; index < _batchNodes.size(); ++index)
+            {
+                // ETC1 ALPHA supports for BMFONT & CHARMAP
+                auto textureAtlas = _batchNodes[index]->getTextureAtlas();
+                if (textureAtlas->getTotalQuads() == 0)
+                {
+                    continue;
+                }
+
+                auto& quadCommand = _quadCommands[index];
+                quadCommand->init(_globalZOrder, textureAtlas->getTexture(), getGLProgramState(),
+                    _blendFunc, textureAtlas->getQuads(), textureAtlas->getTotalQuads(), transform, flags);
+                renderer->addCommand(quadCommand.get());
+            }
         }
         else
         {
@@ -1926,6 +1997,11 @@ void Label::setTextColor(const Color4B &color)
     _textColorF.g = _textColor.g / 255.0f;
     _textColorF.b = _textColor.b / 255.0f;
     _textColorF.a = _textColor.a / 255.0f;
+
+    if (isQuadBatchable())
+    {
+        updateColor();
+    }
 }
 
 void Label::updateColor()
@@ -1935,14 +2011,24 @@ void Label::updateColor()
         return;
     }
 
-    Color4B color4( _displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity );
+    // without the u_textColor uniform the text color is baked into the vertex colors
+    auto textColor = Color4B::WHITE;
+    if (_currentLabelType == LabelType::TTF && isQuadBatchable())
+    {
+        textColor = _textColor;
+    }
+
+    Color4B color4(_displayedColor.r * textColor.r / 255,
+                   _displayedColor.g * textColor.g / 255,
+                   _displayedColor.b * textColor.b / 255,
+                   _displayedOpacity * textColor.a / 255);
 
     // special opacity for premultiplied textures
     if (_isOpacityModifyRGB)
     {
-        color4.r *= _displayedOpacity/255.0f;
-        color4.g *= _displayedOpacity/255.0f;
-        color4.b *= _displayedOpacity/255.0f;
+        color4.r *= color4.a/255.0f;
+        color4.g *= color4.a/255.0f;
+        color4.b *= color4.a/255.0f;
     }
 
     cocos2d::TextureAtlas* textureAtlas;
@@ -1962,6 +2048,11 @@ void Label::updateColor()
             textureAtlas->updateQuad(&quads[index], index);
         }
     }
+
+    for (auto&& it : _letters)
+    {
+        static_cast<LabelLetter*>(it.second)->setTextColor(textColor);
+    }
 }
 
 std::string Label::getDescription() const
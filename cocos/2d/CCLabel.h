@@ -32,6 +32,7 @@
 #include "base/ccTypes.h"
 #include "base/CCRef.h"
 
+#include <memory>
 #include <vector>
 
 namespace cocos2d {
@@ -670,6 +671,10 @@ protected:
     void computeAlignmentOffset();
     bool computeHorizontalKernings(const std::u16string& stringToRender);
 
+    std::string getTextLayoutKey() const;
+    void applyTextLayout(const FontTextLayout& layout);
+    void cacheTextLayout(const std::string& key);
+
     void recordLetterInfo(const cocos2d::Vec2& point, char16_t utf16Char, int letterIndex, int lineIndex);
     void recordPlaceholderInfo(int letterIndex, char16_t utf16Char);
     
@@ -679,6 +684,7 @@ protected:
     void createShadowSpriteForSystemFont(const FontDefinition& fontDef);
 
     virtual void updateShaderProgram();
+    bool isQuadBatchable() const;
     void updateBMFontScale();
     void scaleFontSizeDown(float fontSize);
     bool setTTFConfigInternal(const TTFConfig& ttfConfig);
@@ -745,7 +751,7 @@ protected:
     Color4B _textColor;
     Color4F _textColorF;
 
-    QuadCommand _quadCommand;
+    std::vector<std::unique_ptr<QuadCommand>> _quadCommands;
     CustomCommand _customCommand;
     Mat4  _shadowTransform;
     GLuint _uniformEffectColor;
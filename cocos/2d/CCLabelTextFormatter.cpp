@@ -366,6 +366,74 @@ void Label::shrinkLabelToContentSize(const std::function<bool(void)>& lambda)
     }
 }
 
+std::string Label::getTextLayoutKey() const
+{
+    const float settings[] = {
+        _maxLineWidth,
+        _labelWidth,
+        _labelHeight,
+        _lineHeight,
+        _lineSpacing,
+        _additionalKerning,
+        _bmfontScale,
+        CC_CONTENT_SCALE_FACTOR(),
+        _enableWrap ? 1.f : 0.f,
+        _lineBreakWithoutSpaces ? 1.f : 0.f
+    };
+
+    std::string key(reinterpret_cast<const char*>(settings), sizeof(settings));
+    key.append(reinterpret_cast<const char*>(_utf16Text.data()), _utf16Text.size() * sizeof(char16_t));
+    return key;
+}
+
+void Label::applyTextLayout(const FontTextLayout& layout)
+{
+    _lengthOfString = static_cast<int>(layout.letters.size());
+    if (_lettersInfo.size() < layout.letters.size())
+    {
+        _lettersInfo.resize(layout.letters.size());
+    }
+    for (int index = 0; index < _lengthOfString; ++index)
+    {
+        auto& letter = layout.letters[index];
+        auto& letterInfo = _lettersInfo[index];
+        letterInfo.utf16Char = letter.utf16Char;
+        letterInfo.valid = letter.valid;
+        letterInfo.positionX = letter.positionX;
+        letterInfo.positionY = letter.positionY;
+        letterInfo.lineIndex = letter.lineIndex;
+    }
+
+    _linesWidth = layout.linesWidth;
+    _numberOfLines = layout.numberOfLines;
+    _textDesiredHeight = layout.textDesiredHeight;
+    setContentSize(Size(layout.contentWidth, layout.contentHeight));
+    _tailoredTopY = layout.tailoredTopY;
+    _tailoredBottomY = layout.tailoredBottomY;
+}
+
+void Label::cacheTextLayout(const std::string& key)
+{
+    FontTextLayout layout;
+    layout.letters.reserve(_lengthOfString);
+    for (int index = 0; index < _lengthOfString; ++index)
+    {
+        auto& letterInfo = _lettersInfo[index];
+        layout.letters.push_back({letterInfo.utf16Char, letterInfo.valid,
+            letterInfo.positionX, letterInfo.positionY, letterInfo.lineIndex});
+    }
+
+    layout.linesWidth = _linesWidth;
+    layout.numberOfLines = _numberOfLines;
+    layout.textDesiredHeight = _textDesiredHeight;
+    layout.contentWidth = _contentSize.width;
+    layout.contentHeight = _contentSize.height;
+    layout.tailoredTopY = _tailoredTopY;
+    layout.tailoredBottomY = _tailoredBottomY;
+
+    _fontAtlas->addTextLayout(key, std::move(layout));
+}
+
 void Label::recordLetterInfo(const cocos2d::Vec2& point, char16_t utf16Char, int letterIndex, int lineIndex)
 {
     if (static_cast<std::size_t>(letterIndex) >= _lettersInfo.size())
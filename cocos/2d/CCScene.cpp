@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "base/ccUTF8.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCFrameBuffer.h"
+#include "3d/CCBoundingVolumeTree.h"
 
 #if CC_USE_PHYSICS
 #include "physics/CCPhysicsWorld.h"
@@ -210,6 +211,8 @@ void Scene::render(Renderer* renderer, const Mat4* eyeTransforms, const Mat4* ey
         camera->apply();
         //clear background with max depth
         camera->clearBackground();
+        if (_cullingTree)
+            _cullingTree->cull(camera);
         //visit the scene
         visit(renderer, transform, 0);
 #if CC_USE_NAVMESH
@@ -267,6 +270,23 @@ void Scene::removeAllChildren()
     }
 }
 
+void Scene::setCullingTreeEnabled(bool enabled)
+{
+    if (enabled == isCullingTreeEnabled())
+        return;
+    if (enabled)
+    {
+        _cullingTree.reset(new (std::nothrow) BoundingVolumeTree());
+        // the nodes which enter later add themselves
+        if (_running)
+            _cullingTree->addNodes(this);
+    }
+    else
+    {
+        _cullingTree.reset();
+    }
+}
+
 #if CC_USE_3D_PHYSICS && CC_ENABLE_BULLET_INTEGRATION
 void Scene::setPhysics3DDebugCamera(Camera* camera)
 {
@@ -27,6 +27,7 @@ THE SOFTWARE.
 #ifndef __CCSCENE_H__
 #define __CCSCENE_H__
 
+#include <memory>
 #include <string>
 #include "2d/CCNode.h"
 
@@ -37,6 +38,7 @@ class BaseLight;
 class Renderer;
 class EventListenerCustom;
 class EventCustom;
+class BoundingVolumeTree;
 #if CC_USE_PHYSICS
 class PhysicsWorld;
 #endif
@@ -113,6 +115,14 @@ public:
 
     /** override function */
     virtual void removeAllChildren() override;
+
+    /** Culls the Sprite3D and BillBoard nodes of the scene with a bounding volume tree,
+     * once per camera, instead of testing the bounds of every node against every camera.
+     * Worth it for scenes with many 3D nodes which mostly stand still.
+     */
+    void setCullingTreeEnabled(bool enabled);
+    bool isCullingTreeEnabled() const { return _cullingTree != nullptr; }
+    BoundingVolumeTree* getCullingTree() const { return _cullingTree.get(); }
     
 protected:
     Scene();
@@ -139,6 +149,8 @@ protected:
     EventListenerCustom*       _event;
 
     std::vector<BaseLight *> _lights;
+
+    std::unique_ptr<BoundingVolumeTree> _cullingTree;
     
 private:
     Scene(const Scene &) = delete;
@@ -14,6 +14,7 @@ CCAnimate3D.cpp \
 CCAnimation3D.cpp \
 CCAttachNode.cpp \
 CCBillBoard.cpp \
+CCBoundingVolumeTree.cpp \
 CCBundle3D.cpp \
 CCBundleReader.cpp \
 CCMesh.cpp \
@@ -25,6 +26,7 @@ CCObjLoader.cpp \
 CCSkeleton3D.cpp \
 CCSprite3D.cpp \
 CCTerrain.cpp \
+CCPagedTerrain.cpp \
 CCSkybox.cpp
 
 LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/..
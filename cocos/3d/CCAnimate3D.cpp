@@ -23,6 +23,8 @@
  ****************************************************************************/
 
 #include "3d/CCAnimate3D.h"
+#include <algorithm>
+#include <cstdint>
 #include "3d/CCSprite3D.h"
 #include "3d/CCSkeleton3D.h"
 #include "platform/CCFileUtils.h"
@@ -37,6 +39,8 @@ std::unordered_map<Node*, Animate3D*> Animate3D::s_fadeInAnimates;
 std::unordered_map<Node*, Animate3D*> Animate3D::s_fadeOutAnimates;
 std::unordered_map<Node*, Animate3D*> Animate3D::s_runningAnimates;
 float      Animate3D::_transTime = 0.1f;
+std::vector<Animate3D::LodLevel> Animate3D::s_lodLevels;
+bool       Animate3D::s_skipCulled = false;
 
 Animate3D::Animate3D(Animation3D* animation, float fromTime, float duration)
     : _state(Animate3D::Animate3DState::Running)
@@ -48,6 +52,7 @@ Animate3D::Animate3D(Animation3D* animation, float fromTime, float duration)
     , _playReverse(false)
     , _accTransTime(0.0f)
     , _lastTime(0.0f)
+    , _evaluatedTime(-1.0f)
     , _originInterval(0.0f)
     , _frameRate(30.0f)
 {
@@ -131,6 +136,7 @@ void Animate3D::startWithTarget(Node *target)
 {
     bool needReMap = (getTarget() != target);
     ActionInterval::startWithTarget(target);
+    _evaluatedTime = -1.0f;
     
     if (needReMap)
     {
@@ -154,8 +160,12 @@ void Animate3D::startWithTarget(Node *target)
                         auto bone = skin->getBoneByName(boneName);
                         if (bone)
                         {
-                            auto curve = _animation->getBoneCurveByName(boneName);
-                            _boneCurves[bone] = curve;
+                            BoneCurve boneCurve;
+                            boneCurve.bone = bone;
+                            boneCurve.curve = _animation->getBoneCurveByName(boneName);
+                            boneCurve.translateCursor = boneCurve.rotCursor = boneCurve.scaleCursor = 0;
+                            boneCurve.leaf = bone->getChildBoneCount() == 0;
+                            _boneCurves.push_back(boneCurve);
                             hasCurve = true;
                         }
                         else
@@ -178,6 +188,15 @@ void Animate3D::startWithTarget(Node *target)
                         }
                     }
                 }
+                
+                // evaluate in skeleton order, the bones are then visited in memory order
+                auto skeleton = sprite->getSkeleton();
+                if (skeleton)
+                {
+                    std::sort(_boneCurves.begin(), _boneCurves.end(), [skeleton](const BoneCurve& a, const BoneCurve& b) {
+                        return skeleton->getBoneIndex(a.bone) < skeleton->getBoneIndex(b.bone);
+                    });
+                }
             }
         }
         else
@@ -304,12 +323,18 @@ void Animate3D::step(float t)
     float lastTime = _lastTime;
     _lastTime = t;
 
+    // the only animation of the target didn't move, the bones keep their pose
+    if (_state == Animate3D::Animate3DState::Running && t == _evaluatedTime
+        && s_fadeOutAnimates.find(getTarget()) == s_fadeOutAnimates.end())
+    {
+        return;
+    }
+
     if (_quality != Animate3DQuality::QUALITY_NONE)
     {
         if (_weight > 0.0f)
         {
-            float transDst[3], rotDst[4], scaleDst[3];
-            float* trans = nullptr, *rot = nullptr, *scale = nullptr;
+            float frameTime = t;
             if (_playReverse){
                 t = 1 - t;
                 lastTime = 1.0f - lastTime;
@@ -318,50 +343,18 @@ void Animate3D::step(float t)
             t = _start + t * _last;
             lastTime = _start + lastTime * _last;
 
-            for (const auto& it : _boneCurves) {
-                auto bone = it.first;
-                auto curve = it.second;
-                if (curve->translateCurve)
-                {
-                    curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
-                    trans = &transDst[0];
-                }
-                if (curve->rotCurve)
-                {
-                    curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
-                    rot = &rotDst[0];
-                }
-                if (curve->scaleCurve)
-                {
-                    curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
-                    scale = &scaleDst[0];
-                }
-                bone->setAnimationValue(trans, rot, scale, this, _weight);
+            // key frame events are dispatched even while the level of detail skips the curves
+            bool skipLeafBones = false;
+            if (_boneCurves.empty() || isEvaluationDue(&skipLeafBones))
+            {
+                _evaluatedTime = frameTime;
+                evaluateCurves(t, skipLeafBones);
             }
-
-            for (const auto& it : _nodeCurves)
+            else
             {
-                auto node = it.first;
-                auto curve = it.second;
-                Mat4 transform;
-                if (curve->translateCurve)
-                {
-                    curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
-                    transform.translate(transDst[0], transDst[1], transDst[2]);
-                }
-                if (curve->rotCurve)
-                {
-                    curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
-                    Quaternion qua(rotDst[0], rotDst[1], rotDst[2], rotDst[3]);
-                    transform.rotate(qua);
-                }
-                if (curve->scaleCurve)
-                {
-                    curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
-                    transform.scale(scaleDst[0], scaleDst[1], scaleDst[2]);
-                }
-                node->setAdditionalTransform(&transform);
+                static_cast<Sprite3D*>(getTarget())->_animationSkipped = true;
             }
+
             if (!_keyFrameUserInfos.empty()){
                 float prekeyTime = lastTime * getDuration() * _frameRate;
                 float keyTime = t * getDuration() * _frameRate;
@@ -391,6 +384,107 @@ void Animate3D::step(float t)
     }
 }
 
+void Animate3D::evaluateCurves(float t, bool skipLeafBones)
+{
+    float transDst[3], rotDst[4], scaleDst[3];
+    float* trans = nullptr, *rot = nullptr, *scale = nullptr;
+
+    for (auto& boneCurve : _boneCurves) {
+        if (skipLeafBones && boneCurve.leaf)
+            continue;
+        auto curve = boneCurve.curve;
+        if (curve->translateCurve)
+        {
+            curve->translateCurve->evaluate(t, transDst, _translateEvaluate, boneCurve.translateCursor);
+            trans = &transDst[0];
+        }
+        if (curve->rotCurve)
+        {
+            curve->rotCurve->evaluate(t, rotDst, _roteEvaluate, boneCurve.rotCursor);
+            rot = &rotDst[0];
+        }
+        if (curve->scaleCurve)
+        {
+            curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate, boneCurve.scaleCursor);
+            scale = &scaleDst[0];
+        }
+        boneCurve.bone->setAnimationValue(trans, rot, scale, this, _weight);
+    }
+    if (!_boneCurves.empty())
+    {
+        static_cast<Sprite3D*>(getTarget())->requestSkeletonUpdate();
+    }
+
+    for (const auto& it : _nodeCurves)
+    {
+        auto node = it.first;
+        auto curve = it.second;
+        Mat4 transform;
+        if (curve->translateCurve)
+        {
+            curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
+            transform.translate(transDst[0], transDst[1], transDst[2]);
+        }
+        if (curve->rotCurve)
+        {
+            curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
+            Quaternion qua(rotDst[0], rotDst[1], rotDst[2], rotDst[3]);
+            transform.rotate(qua);
+        }
+        if (curve->scaleCurve)
+        {
+            curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
+            transform.scale(scaleDst[0], scaleDst[1], scaleDst[2]);
+        }
+        node->setAdditionalTransform(&transform);
+    }
+}
+
+bool Animate3D::isEvaluationDue(bool* skipLeafBones) const
+{
+    auto sprite = static_cast<Sprite3D*>(getTarget());
+    auto frame = Director::getInstance()->getTotalFrames();
+    if (s_skipCulled && sprite->_drawnFrame + 1 < frame)
+        return false;
+
+    const LodLevel* lod = nullptr;
+    for (const auto& level : s_lodLevels)
+    {
+        if (sprite->_screenSize < level.screenSize)
+            lod = &level;
+    }
+    if (lod == nullptr)
+        return true;
+
+    *skipLeafBones = lod->skipLeafBones;
+    if (lod->frameInterval <= 1)
+        return true;
+    // spread the sprites sharing a level over the frames of the interval
+    auto stagger = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(sprite) >> 4);
+    return (frame + stagger) % lod->frameInterval == 0;
+}
+
+void Animate3D::setLodLevels(const std::vector<LodLevel>& levels)
+{
+    s_lodLevels = levels;
+}
+
+void Animate3D::evaluateSkipped(Node* target)
+{
+    for (auto animates : { &s_fadeOutAnimates, &s_runningAnimates, &s_fadeInAnimates })
+    {
+        auto it = animates->find(target);
+        if (it == animates->end())
+            continue;
+        auto animate = it->second;
+        if (animate->_quality == Animate3DQuality::QUALITY_NONE || animate->_weight <= 0.0f)
+            continue;
+        float t = animate->_playReverse ? 1.0f - animate->_lastTime : animate->_lastTime;
+        animate->_evaluatedTime = animate->_lastTime;
+        animate->evaluateCurves(animate->_start + t * animate->_last, false);
+    }
+}
+
 float Animate3D::getSpeed() const
 {
     return _playReverse ? -_absSpeed : _absSpeed;
@@ -27,6 +27,7 @@
 #include <limits>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include "3d/CCAnimation3D.h"
 #include "base/ccMacros.h"
@@ -95,6 +96,32 @@ public:
     /** set animate transition time between 3d animations */
     static void setTransitionTime(float transTime) { if (transTime >= 0.f) _transTime = transTime; }
     
+    /** Animation level of detail of the Sprite3Ds covering less than screenSize of the viewport height */
+    struct LodLevel
+    {
+        float screenSize;           // fraction of the viewport height
+        unsigned int frameInterval; // the curves are evaluated once every frameInterval frames
+        bool skipLeafBones;         // the bones without child bones keep their last pose
+    };
+    
+    /**
+     * Sets the animation levels of detail, by decreasing screen size. The smallest level a sprite
+     * fits in applies. Empty by default, every drawn sprite is evaluated each frame.
+     */
+    static void setLodLevels(const std::vector<LodLevel>& levels);
+    static const std::vector<LodLevel>& getLodLevels() { return s_lodLevels; }
+    
+    /**
+     * Sets whether the animations of the Sprite3Ds that were not drawn last frame only advance
+     * their time and blend weights, their curves being evaluated once they are drawn again. False by default,
+     * as the bones and attached nodes of culled sprites are stale while it is enabled.
+     */
+    static void setSkipCulledEnabled(bool enabled) { s_skipCulled = enabled; }
+    static bool isSkipCulledEnabled() { return s_skipCulled; }
+    
+    /** Evaluates the animations of target skipped by level of detail, called by Sprite3D when it is drawn */
+    static void evaluateSkipped(Node* target);
+    
     /**set animate quality*/
     void setQuality(Animate3DQuality quality);
     
@@ -118,6 +145,12 @@ protected:
     
     void removeFromMap();
     
+    /** applies the curves at t (0 - 1) to the bones and nodes */
+    void evaluateCurves(float t, bool skipLeafBones);
+    
+    /** whether the curves are due this frame under the level of detail of the target Sprite3D */
+    bool isEvaluationDue(bool* skipLeafBones) const;
+    
     virtual void at_stop() override;
 
 protected:
@@ -139,6 +172,7 @@ protected:
     static float      _transTime; //transition time from one animate3d to another
     float      _accTransTime; // accumulate transition time
     float      _lastTime;     // last t (0 - 1)
+    float      _evaluatedTime; // t of the last curve evaluation, -1 if none
     float      _originInterval;// save origin interval time
     float      _frameRate;
     
@@ -148,7 +182,17 @@ protected:
     EvaluateType _scaleEvaluate;
     Animate3DQuality _quality;
     
-    std::unordered_map<Bone3D*, Animation3D::Curve*> _boneCurves; //weak ref
+    // bone curves in skeleton order, with the keyframe each curve was evaluated at last
+    struct BoneCurve
+    {
+        Bone3D* bone; //weak ref
+        Animation3D::Curve* curve; //weak ref
+        int translateCursor;
+        int rotCursor;
+        int scaleCursor;
+        bool leaf; // the bone has no child bones
+    };
+    std::vector<BoneCurve> _boneCurves;
     std::unordered_map<Node*, Animation3D::Curve*> _nodeCurves;
     
     std::unordered_map<int, ValueMap> _keyFrameUserInfos;
@@ -159,6 +203,9 @@ protected:
     static std::unordered_map<Node*, Animate3D*> s_fadeInAnimates;
     static std::unordered_map<Node*, Animate3D*> s_fadeOutAnimates;
     static std::unordered_map<Node*, Animate3D*> s_runningAnimates;
+    
+    static std::vector<LodLevel> s_lodLevels;
+    static bool s_skipCulled;
 };
 
 // end of 3d group
@@ -74,6 +74,16 @@ public:
      */
     void evaluate(float time, float* dst, EvaluateType type) const;
     
+    /**
+     * evaluate value of time, looking for the keyframe from the one used last time first
+     * @param time Time to be estimated
+     * @param dst Estimated value of that time
+     * @param type EvaluateType
+     * @param cursor Keyframe index of the previous evaluation, start with 0. Updated to the keyframe used,
+     * so evaluating at increasing (or decreasing) times finds the keyframe in constant time.
+     */
+    void evaluate(float time, float* dst, EvaluateType type, int& cursor) const;
+    
     /**set evaluate function, allow the user use own function*/
     void setEvaluateFun(std::function<void(float time, float* dst)> fun);
     
@@ -93,6 +103,11 @@ protected:
      */
     int determineIndex(float time) const;
     
+    /**
+     * Determine index by time, checking the keyframes around cursor before searching.
+     */
+    int determineIndex(float time, int cursor) const;
+    
 protected:
     
     float* _value;   //
@@ -3,6 +3,13 @@ namespace cocos2d {
 
 template <int componentSize>
 void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateType type) const
+{
+    int cursor = 0;
+    evaluate(time, dst, type, cursor);
+}
+
+template <int componentSize>
+void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateType type, int& cursor) const
 {
     if (_count == 1 || time <= _keytime[0])
     {
@@ -15,7 +22,8 @@ void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateTyp
         return;
     }
     
-    unsigned int index = determineIndex(time);
+    unsigned int index = determineIndex(time, cursor);
+    cursor = index;
     
     float scale = (_keytime[index + 1] - _keytime[index]);
     float t = (time - _keytime[index]) / scale;
@@ -118,6 +126,28 @@ AnimationCurve<componentSize>::~AnimationCurve()
     CC_SAFE_DELETE_ARRAY(_value);
 }
 
+template <int componentSize>
+int AnimationCurve<componentSize>::determineIndex(float time, int cursor) const
+{
+    // playback time moves by less than a keyframe per frame, so the keyframe is usually the last one or a neighbour
+    if (cursor >= 0 && cursor < _count - 1)
+    {
+        if (time >= _keytime[cursor])
+        {
+            if (time <= _keytime[cursor + 1])
+                return cursor;
+            if (cursor + 2 < _count && time <= _keytime[cursor + 2])
+                return cursor + 1;
+        }
+        else if (cursor > 0 && time >= _keytime[cursor - 1])
+        {
+            return cursor - 1;
+        }
+    }
+    
+    return determineIndex(time);
+}
+
 template <int componentSize>
 int AnimationCurve<componentSize>::determineIndex(float time) const
 {
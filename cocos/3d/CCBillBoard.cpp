@@ -26,6 +26,8 @@
 #include "2d/CCSpriteFrameCache.h"
 #include "base/CCDirector.h"
 #include "2d/CCCamera.h"
+#include "2d/CCScene.h"
+#include "3d/CCBoundingVolumeTree.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCGLProgramCache.h"
 
@@ -34,6 +36,8 @@ namespace cocos2d {
 BillBoard::BillBoard()
 : _mode(Mode::VIEW_POINT_ORIENTED)
 , _modeDirty(false)
+, _cullingTree(nullptr)
+, _cullingProxy(-1)
 {
     Node::setAnchorPoint(Vec2(0.5f,0.5f));
 }
@@ -105,6 +109,10 @@ void BillBoard::visit(Renderer *renderer, const Mat4& parentTransform, uint32_t
     bool visibleByCamera = isVisitableByVisitingCamera();
     
     uint32_t flags = processParentFlags(parentTransform, parentFlags);
+
+    // the bounds don't depend on the camera, only on the transform of the node
+    if (_cullingTree && (flags & FLAGS_DIRTY_MASK))
+        _cullingTree->updateProxy(_cullingProxy, getCullingBounds());
     
     //Add 3D flag so all the children will be rendered as 3D object
     flags |= FLAGS_RENDER_AS_3D;
@@ -217,7 +225,8 @@ bool BillBoard::calculateBillbaordTransform()
 
 void BillBoard::draw(Renderer *renderer, const Mat4 &/*transform*/, uint32_t flags)
 {
-    //FIXME: frustum culling here
+    if (_cullingTree && _cullingTree->getVisibility(_cullingProxy) == BoundingVolumeTree::Visibility::CULLED)
+        return;
     flags |= Node::FLAGS_RENDER_AS_3D;
     _trianglesCommand.init(0, _texture->getName(), getGLProgramState(), _blendFunc, _polyInfo.triangles, _modelViewTransform, flags);
     _trianglesCommand.setTransparent(true);
@@ -225,6 +234,39 @@ void BillBoard::draw(Renderer *renderer, const Mat4 &/*transform*/, uint32_t fla
     renderer->addCommand(&_trianglesCommand);
 }
 
+void BillBoard::onEnter()
+{
+    Sprite::onEnter();
+    auto scene = getScene();
+    if (scene && scene->getCullingTree())
+        scene->getCullingTree()->addNode(this);
+}
+
+void BillBoard::onExit()
+{
+    if (_cullingTree)
+        _cullingTree->removeNode(this);
+    Sprite::onExit();
+}
+
+AABB BillBoard::getCullingBounds() const
+{
+    // a sphere around the anchor point holding the quad in any orientation
+    Mat4 transform = getNodeToWorldTransform();
+    const Vec2& anchorInPoints = getAnchorPointInPoints();
+    Vec3 position(anchorInPoints.x, anchorInPoints.y, 0);
+    transform.transformPoint(&position);
+    float scale = std::max(Vec3(transform.m[0], transform.m[1], transform.m[2]).length(),
+                           std::max(Vec3(transform.m[4], transform.m[5], transform.m[6]).length(),
+                                    Vec3(transform.m[8], transform.m[9], transform.m[10]).length()));
+    const Size& size = getContentSize();
+    const Vec2& anchor = getAnchorPoint();
+    float width = std::max(anchor.x, 1 - anchor.x) * size.width;
+    float height = std::max(anchor.y, 1 - anchor.y) * size.height;
+    float radius = std::sqrt(width * width + height * height) * scale;
+    return AABB(position - Vec3(radius, radius, radius), position + Vec3(radius, radius, radius));
+}
+
 void BillBoard::setMode( Mode mode )
 {
     _mode = mode;
@@ -26,8 +26,12 @@
 #define __CCBILLBOARD_H__
 
 #include "2d/CCSprite.h"
+#include "3d/CCAABB.h"
 
 namespace cocos2d {
+
+class BoundingVolumeTree;
+
 /**
  * @addtogroup _3d
  * @{
@@ -38,6 +42,7 @@ namespace cocos2d {
  */
 class CC_DLL BillBoard : public Sprite
 {
+    friend class BoundingVolumeTree;
 public:
 
     enum class Mode
@@ -103,6 +108,12 @@ public:
      */
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
 
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+    /** the world space bounds of the billboard whatever the camera it faces */
+    AABB getCullingBounds() const;
+
 
 protected:
     BillBoard();
@@ -120,6 +131,8 @@ protected:
 
     Mode _mode;
     bool _modeDirty;
+    BoundingVolumeTree* _cullingTree; // culling tree of the scene, when it's enabled
+    int _cullingProxy;
 
 private:
     BillBoard(const BillBoard &) = delete;
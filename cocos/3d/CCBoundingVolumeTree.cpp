@@ -0,0 +1,362 @@
+/****************************************************************************
+ Copyright (c) 2015 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "3d/CCBoundingVolumeTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "3d/CCBillBoard.h"
+#include "3d/CCFrustum.h"
+#include "3d/CCSprite3D.h"
+#include "2d/CCCamera.h"
+
+namespace cocos2d {
+
+static inline Vec3 centerOf(const AABB& aabb)
+{
+    return (aabb._min + aabb._max) * 0.5f;
+}
+
+BoundingVolumeTree::BoundingVolumeTree()
+: _root(-1)
+, _needsRebuild(false)
+, _cullStamp(0)
+, _culledCamera(nullptr)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        _planeX[i] = _planeY[i] = _planeZ[i] = 0;
+        _planeAbsX[i] = _planeAbsY[i] = _planeAbsZ[i] = 0;
+        _planeDist[i] = 1;
+    }
+}
+
+BoundingVolumeTree::~BoundingVolumeTree()
+{
+    // the nodes outlive the tree when culling is disabled on a running scene
+    for (auto& proxy : _proxies)
+    {
+        if (proxy.owner)
+            removeNode(proxy.owner);
+    }
+}
+
+void BoundingVolumeTree::addNodes(Node* root)
+{
+    addNode(root);
+    for (auto& child : root->getChildren())
+        addNodes(child.get());
+}
+
+void BoundingVolumeTree::addNode(Node* node)
+{
+    if (auto sprite = dynamic_cast<Sprite3D*>(node))
+    {
+        if (!sprite->_cullingTree)
+        {
+            sprite->_cullingTree = this;
+            sprite->_cullingProxy = createProxy(sprite->getAABB(), sprite);
+        }
+    }
+    else if (auto billBoard = dynamic_cast<BillBoard*>(node))
+    {
+        if (!billBoard->_cullingTree)
+        {
+            billBoard->_cullingTree = this;
+            billBoard->_cullingProxy = createProxy(billBoard->getCullingBounds(), billBoard);
+        }
+    }
+}
+
+void BoundingVolumeTree::removeNode(Node* node)
+{
+    if (auto sprite = dynamic_cast<Sprite3D*>(node))
+    {
+        if (sprite->_cullingTree == this)
+        {
+            destroyProxy(sprite->_cullingProxy);
+            sprite->_cullingTree = nullptr;
+            sprite->_cullingProxy = -1;
+        }
+    }
+    else if (auto billBoard = dynamic_cast<BillBoard*>(node))
+    {
+        if (billBoard->_cullingTree == this)
+        {
+            destroyProxy(billBoard->_cullingProxy);
+            billBoard->_cullingTree = nullptr;
+            billBoard->_cullingProxy = -1;
+        }
+    }
+}
+
+int BoundingVolumeTree::createProxy(const AABB& aabb, Node* owner)
+{
+    int index;
+    if (_freeProxies.empty())
+    {
+        index = (int)_proxies.size();
+        _proxies.push_back(Proxy());
+    }
+    else
+    {
+        index = _freeProxies.back();
+        _freeProxies.pop_back();
+    }
+    auto& proxy = _proxies[index];
+    proxy.aabb = aabb;
+    proxy.owner = owner;
+    proxy.leaf = -1;
+    proxy.visibleStamp = 0;
+    proxy.updateStamp = _cullStamp;
+    proxy.dirty = false;
+    _needsRebuild = true;
+    return index;
+}
+
+void BoundingVolumeTree::destroyProxy(int index)
+{
+    auto& proxy = _proxies[index];
+    proxy.owner = nullptr;
+    proxy.leaf = -1;
+    _freeProxies.push_back(index);
+    _needsRebuild = true;
+}
+
+void BoundingVolumeTree::updateProxy(int index, const AABB& aabb)
+{
+    auto& proxy = _proxies[index];
+    proxy.aabb = aabb;
+    proxy.updateStamp = _cullStamp;
+    if (!proxy.dirty)
+    {
+        proxy.dirty = true;
+        _dirtyProxies.push_back(index);
+    }
+}
+
+void BoundingVolumeTree::rebuild()
+{
+    _nodes.clear();
+    _buildProxies.clear();
+    for (int i = 0, size = (int)_proxies.size(); i < size; ++i)
+    {
+        _proxies[i].dirty = false;
+        if (_proxies[i].owner)
+            _buildProxies.push_back(i);
+    }
+    _dirtyProxies.clear();
+    _root = _buildProxies.empty() ? -1 : build(0, _buildProxies.size(), -1);
+    _needsRebuild = false;
+}
+
+int BoundingVolumeTree::build(size_t begin, size_t end, int parent)
+{
+    int index = (int)_nodes.size();
+    _nodes.push_back(TreeNode());
+    _nodes[index].parent = parent;
+    _nodes[index].left = -1;
+    _nodes[index].right = -1;
+    _nodes[index].proxy = -1;
+
+    if (end - begin == 1)
+    {
+        int proxy = _buildProxies[begin];
+        _nodes[index].proxy = proxy;
+        _nodes[index].aabb = _proxies[proxy].aabb;
+        _proxies[proxy].leaf = index;
+        return index;
+    }
+
+    // median split along the longest axis of the centers
+    AABB centers;
+    centers.reset();
+    for (size_t i = begin; i < end; ++i)
+    {
+        Vec3 center = centerOf(_proxies[_buildProxies[i]].aabb);
+        centers.updateMinMax(&center, 1);
+    }
+    Vec3 size = centers._max - centers._min;
+    int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+    size_t middle = begin + (end - begin) / 2;
+    std::nth_element(_buildProxies.begin() + begin, _buildProxies.begin() + middle, _buildProxies.begin() + end,
+        [this, axis](int a, int b) {
+            Vec3 centerA = centerOf(_proxies[a].aabb);
+            Vec3 centerB = centerOf(_proxies[b].aabb);
+            return (axis == 0 ? centerA.x < centerB.x : (axis == 1 ? centerA.y < centerB.y : centerA.z < centerB.z));
+        });
+
+    int left = build(begin, middle, index);
+    int right = build(middle, end, index);
+    _nodes[index].left = left;
+    _nodes[index].right = right;
+    _nodes[index].aabb = _nodes[left].aabb;
+    _nodes[index].aabb.merge(_nodes[right].aabb);
+    return index;
+}
+
+void BoundingVolumeTree::refit()
+{
+    for (auto index : _dirtyProxies)
+    {
+        auto& proxy = _proxies[index];
+        proxy.dirty = false;
+        if (!proxy.owner || proxy.leaf < 0)
+            continue;
+        _nodes[proxy.leaf].aabb = proxy.aabb;
+        for (int node = _nodes[proxy.leaf].parent; node >= 0; node = _nodes[node].parent)
+        {
+            auto& treeNode = _nodes[node];
+            treeNode.aabb = _nodes[treeNode.left].aabb;
+            treeNode.aabb.merge(_nodes[treeNode.right].aabb);
+        }
+    }
+    _dirtyProxies.clear();
+}
+
+unsigned int BoundingVolumeTree::classify(const AABB& aabb, unsigned int* inside) const
+{
+    Vec3 center = centerOf(aabb);
+    Vec3 extents = (aabb._max - aabb._min) * 0.5f;
+
+    // the box is outside a plane when even its nearest corner is in front of it,
+    // and inside when even its farthest corner is behind it
+#ifdef __SSE__
+    __m128 cx = _mm_set1_ps(center.x);
+    __m128 cy = _mm_set1_ps(center.y);
+    __m128 cz = _mm_set1_ps(center.z);
+    __m128 ex = _mm_set1_ps(extents.x);
+    __m128 ey = _mm_set1_ps(extents.y);
+    __m128 ez = _mm_set1_ps(extents.z);
+    __m128 zero = _mm_setzero_ps();
+    unsigned int outsideMask = 0;
+    unsigned int insideMask = 0;
+    for (int group = 0; group < 2; ++group)
+    {
+        int offset = group * 4;
+        __m128 dist = _mm_sub_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(_planeX + offset), cx),
+            _mm_mul_ps(_mm_loadu_ps(_planeY + offset), cy)),
+            _mm_mul_ps(_mm_loadu_ps(_planeZ + offset), cz)),
+            _mm_loadu_ps(_planeDist + offset));
+        __m128 radius = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(_planeAbsX + offset), ex),
+            _mm_mul_ps(_mm_loadu_ps(_planeAbsY + offset), ey)),
+            _mm_mul_ps(_mm_loadu_ps(_planeAbsZ + offset), ez));
+        outsideMask |= (unsigned int)_mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(dist, radius), zero)) << offset;
+        insideMask |= (unsigned int)_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), zero)) << offset;
+    }
+#else
+    unsigned int outsideMask = 0;
+    unsigned int insideMask = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        float dist = _planeX[i] * center.x + _planeY[i] * center.y + _planeZ[i] * center.z - _planeDist[i];
+        float radius = _planeAbsX[i] * extents.x + _planeAbsY[i] * extents.y + _planeAbsZ[i] * extents.z;
+        outsideMask |= (dist - radius > 0 ? 1u : 0u) << i;
+        insideMask |= (dist + radius < 0 ? 1u : 0u) << i;
+    }
+#endif
+    *inside = insideMask;
+    return outsideMask;
+}
+
+void BoundingVolumeTree::cull(const Camera* camera)
+{
+    if (_needsRebuild)
+        rebuild();
+    else if (!_dirtyProxies.empty())
+        refit();
+
+    ++_cullStamp;
+    _culledCamera = camera;
+    if (_root < 0)
+        return;
+
+    Frustum frustum;
+    frustum.initFrustum(camera);
+    int planeCount = frustum.getPlaneCount();
+    for (int i = 0; i < planeCount; ++i)
+    {
+        const Plane& plane = frustum.getPlane(i);
+        const Vec3& normal = plane.getNormal();
+        _planeX[i] = normal.x;
+        _planeY[i] = normal.y;
+        _planeZ[i] = normal.z;
+        _planeAbsX[i] = std::abs(normal.x);
+        _planeAbsY[i] = std::abs(normal.y);
+        _planeAbsZ[i] = std::abs(normal.z);
+        _planeDist[i] = plane.getDist();
+    }
+    for (int i = planeCount; i < 8; ++i)
+    {
+        _planeX[i] = _planeY[i] = _planeZ[i] = 0;
+        _planeAbsX[i] = _planeAbsY[i] = _planeAbsZ[i] = 0;
+        _planeDist[i] = 1;
+    }
+
+    // each entry carries the planes which still have to be tested below it
+    _stack.clear();
+    _stack.push_back(std::make_pair(_root, (1u << planeCount) - 1));
+    while (!_stack.empty())
+    {
+        auto entry = _stack.back();
+        _stack.pop_back();
+        const auto& node = _nodes[entry.first];
+        unsigned int mask = entry.second;
+        if (mask)
+        {
+            unsigned int inside;
+            if (classify(node.aabb, &inside) & mask)
+                continue;
+            mask &= ~inside;
+        }
+        if (node.proxy >= 0)
+        {
+            _proxies[node.proxy].visibleStamp = _cullStamp;
+        }
+        else
+        {
+            _stack.push_back(std::make_pair(node.left, mask));
+            _stack.push_back(std::make_pair(node.right, mask));
+        }
+    }
+}
+
+BoundingVolumeTree::Visibility BoundingVolumeTree::getVisibility(int index) const
+{
+    if (_culledCamera == nullptr || Camera::getVisitingCamera() != _culledCamera)
+        return Visibility::UNKNOWN;
+    const auto& proxy = _proxies[index];
+    if (proxy.updateStamp == _cullStamp)
+        return Visibility::UNKNOWN;
+    return proxy.visibleStamp == _cullStamp ? Visibility::VISIBLE : Visibility::CULLED;
+}
+
+} // namespace cocos2d
@@ -0,0 +1,138 @@
+/****************************************************************************
+ Copyright (c) 2015 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_BOUNDING_VOLUME_TREE_H__
+#define __CC_BOUNDING_VOLUME_TREE_H__
+
+#include <utility>
+#include <vector>
+
+#include "3d/CCAABB.h"
+
+namespace cocos2d {
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+class Camera;
+class Node;
+
+/**
+ * A bounding volume hierarchy over the world space bounds of the Sprite3D and BillBoard
+ * nodes of a scene, see Scene::setCullingTreeEnabled.
+ *
+ * The scene culls the tree once per camera before visiting it. A subtree outside a frustum
+ * plane is skipped as a whole, and the planes a subtree is completely inside of aren't tested
+ * again below it, so most of the nodes of a large scene cost no plane test at all.
+ * The nodes then read their result with getVisibility() instead of testing their own bounds.
+ *
+ * The tree is rebuilt when nodes are added or removed, moving nodes only refit their ancestors.
+ * A node which moved after the tree was culled tests itself until the next cull.
+ */
+class CC_DLL BoundingVolumeTree
+{
+public:
+    enum class Visibility
+    {
+        VISIBLE,
+        CULLED,
+        UNKNOWN // not culled for the visiting camera, or moved since
+    };
+
+    BoundingVolumeTree();
+    ~BoundingVolumeTree();
+
+    /** adds the Sprite3D and BillBoard nodes of the subtree */
+    void addNodes(Node* root);
+    /** adds a Sprite3D or a BillBoard, other nodes are ignored */
+    void addNode(Node* node);
+    void removeNode(Node* node);
+
+    /** sets the world space bounds of a proxy, called by its node when it moved */
+    void updateProxy(int proxy, const AABB& aabb);
+
+    /** culls the tree against the frustum of the camera */
+    void cull(const Camera* camera);
+
+    /** the result of the last cull for a proxy, UNKNOWN if the visiting camera isn't the culled one */
+    Visibility getVisibility(int proxy) const;
+
+    size_t getProxyCount() const { return _proxies.size() - _freeProxies.size(); }
+
+protected:
+    struct Proxy
+    {
+        AABB aabb;
+        Node* owner;
+        int leaf;
+        unsigned int visibleStamp;
+        unsigned int updateStamp;
+        bool dirty;
+    };
+    struct TreeNode
+    {
+        AABB aabb;
+        int parent;
+        int left;
+        int right;
+        int proxy; // >= 0 for leaves
+    };
+
+    int createProxy(const AABB& aabb, Node* owner);
+    void destroyProxy(int proxy);
+    void rebuild();
+    int build(size_t begin, size_t end, int parent);
+    void refit();
+    /** returns the planes the box is outside of, and sets the planes it is completely inside of */
+    unsigned int classify(const AABB& aabb, unsigned int* inside) const;
+
+    std::vector<Proxy> _proxies;
+    std::vector<int> _freeProxies;
+    std::vector<int> _dirtyProxies;
+    std::vector<TreeNode> _nodes;
+    std::vector<int> _buildProxies;
+    std::vector<std::pair<int, unsigned int>> _stack;
+    int _root;
+    bool _needsRebuild;
+    unsigned int _cullStamp;
+    const Camera* _culledCamera;
+
+    // frustum planes as structure of arrays, padded to 8 with planes which never cull
+    float _planeX[8];
+    float _planeY[8];
+    float _planeZ[8];
+    float _planeAbsX[8];
+    float _planeAbsY[8];
+    float _planeAbsZ[8];
+    float _planeDist[8];
+};
+
+// end of 3d group
+/// @}
+
+} // namespace cocos2d
+
+#endif // __CC_BOUNDING_VOLUME_TREE_H__
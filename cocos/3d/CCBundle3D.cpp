@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #include "base/ccMacros.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCMappedFile.h"
 #include "renderer/CCGLProgram.h"
 #include "3d/CCBundleReader.h"
 #include "base/CCData.h"
@@ -161,12 +162,15 @@ void Bundle3D::clear()
 {
     if (_isBinary)
     {
-        _binaryBuffer.clear();
+        _binaryFile.reset();
+        _binaryReader.init(nullptr, 0);
         CC_SAFE_DELETE_ARRAY(_references);
     }
     else
     {
         _jsonBuffer.clear();
+        _jsonMeshDatas.resetData();
+        _jsonMeshDatasHandedOver = false;
     }
 }
 
@@ -386,10 +390,16 @@ bool Bundle3D::loadMeshDatas(MeshDatas& meshdatas)
     }
     return true;
 }
+static bool isPayloadAligned(const unsigned char* base, ssize_t offset, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(base + offset) % alignment == 0;
+}
+
 bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
 {
     if (!seekToFirstType(BUNDLE_TYPE_MESH))
         return false;
+    _payloadOffsets.clear();
     unsigned int meshSize = 0;
     if (_binaryReader.read(&meshSize, 4, 1) != 1)
     {
@@ -433,12 +443,32 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
             goto FAILED;
         }
 
-        meshData->vertex.resize(vertexSizeInFloat);
-        if (_binaryReader.read(&meshData->vertex[0], 4, vertexSizeInFloat) != vertexSizeInFloat)
+        if (_isAligned && !_binaryReader.align(16))
         {
             CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
             goto FAILED;
         }
+        _payloadOffsets.push_back(_binaryReader.tell());
+        meshData->vertexSizeInFloat = vertexSizeInFloat;
+        if (_meshDataAliasing && isPayloadAligned(_binaryFile->getBytes(), _binaryReader.tell(), alignof(float)))
+        {
+            meshData->mappedVertex = reinterpret_cast<const float*>(_binaryReader.readInPlace(4, vertexSizeInFloat));
+            if (!meshData->mappedVertex)
+            {
+                CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
+                goto FAILED;
+            }
+            meshData->mappedFile = _binaryFile;
+        }
+        else
+        {
+            meshData->vertex.resize(vertexSizeInFloat);
+            if (_binaryReader.read(&meshData->vertex[0], 4, vertexSizeInFloat) != vertexSizeInFloat)
+            {
+                CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
+                goto FAILED;
+            }
+        }
 
         // Read index data
         unsigned int meshPartCount = 1;
@@ -455,14 +485,39 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
                 CCLOG("warning: Failed to read meshdata: nIndexCount '%s'.", _path.c_str());
                 goto FAILED;
             }
-            indexArray.resize(nIndexCount);
-            if (_binaryReader.read(&indexArray[0], 2, nIndexCount) != nIndexCount)
+            if (_isAligned && !_binaryReader.align(16))
             {
                 CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
                 goto FAILED;
             }
-            meshData->subMeshIndices.push_back(indexArray);
-            meshData->numIndex = (int)meshData->subMeshIndices.size();
+            _payloadOffsets.push_back(_binaryReader.tell());
+            MeshData::IndexSpan indices;
+            if (meshData->mappedVertex && isPayloadAligned(_binaryFile->getBytes(), _binaryReader.tell(), alignof(unsigned short)))
+            {
+                indices.data = reinterpret_cast<const unsigned short*>(_binaryReader.readInPlace(2, nIndexCount));
+                indices.count = nIndexCount;
+                if (!indices.data)
+                {
+                    CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
+                    goto FAILED;
+                }
+            }
+            else
+            {
+                indexArray.resize(nIndexCount);
+                if (_binaryReader.read(&indexArray[0], 2, nIndexCount) != nIndexCount)
+                {
+                    CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
+                    goto FAILED;
+                }
+                // the buffer of the array is kept when it is moved into subMeshIndices
+                indices.data = indexArray.data();
+                indices.count = nIndexCount;
+                meshData->subMeshIndices.push_back(std::move(indexArray));
+            }
+            if (meshData->mappedVertex)
+                meshData->mappedSubMeshIndices.push_back(indices);
+            meshData->numIndex = (int)meshData->getSubMeshCount();
             //meshData->subMeshAABB.push_back(calculateAABB(meshData->vertex, meshData->getPerVertexSize(), indexArray));
             if (_version != "0.3" && _version != "0.4" && _version != "0.5")
             {
@@ -477,7 +532,7 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
             }
             else
             {
-                meshData->subMeshAABB.push_back(calculateAABB(meshData->vertex, meshData->getPerVertexSize(), indexArray));
+                meshData->subMeshAABB.push_back(calculateAABB(meshData->getVertexData(), meshData->getPerVertexSize(), indices.data, indices.count));
             }
         }
         meshdatas.meshDatas.push_back(meshData);
@@ -733,79 +788,14 @@ bool Bundle3D::loadMeshDatasBinary_0_2(MeshDatas& meshdatas)
 }
 bool  Bundle3D::loadMeshDatasJson(MeshDatas& meshdatas)
 {
-    const rapidjson::Value& mesh_data_array = _jsonReader[MESHES];
-    for (rapidjson::SizeType index = 0, mesh_data_array_size = mesh_data_array.Size(); index < mesh_data_array_size; ++index)
-    {
-        MeshData*   meshData = new (std::nothrow) MeshData();
-        const rapidjson::Value& mesh_data = mesh_data_array[index];
-        // mesh_vertex_attribute
-        const rapidjson::Value& mesh_vertex_attribute = mesh_data[ATTRIBUTES];
-        MeshVertexAttrib tempAttrib;
-        meshData->attribCount=mesh_vertex_attribute.Size();
-        meshData->attribs.resize(meshData->attribCount);
-        for (rapidjson::SizeType i = 0, mesh_vertex_attribute_size = mesh_vertex_attribute.Size(); i < mesh_vertex_attribute_size; ++i)
-        {
-            const rapidjson::Value& mesh_vertex_attribute_val = mesh_vertex_attribute[i];
-
-            int size = mesh_vertex_attribute_val[ATTRIBUTESIZE].GetInt();
-            std::string type = mesh_vertex_attribute_val[TYPE].GetString();
-            std::string attribute = mesh_vertex_attribute_val[ATTRIBUTE].GetString();
-
-            tempAttrib.size = size;
-            tempAttrib.attribSizeBytes = sizeof(float) * size;
-            tempAttrib.type = parseGLType(type);
-            tempAttrib.vertexAttrib = parseGLProgramAttribute(attribute);
-            meshData->attribs[i]=tempAttrib;
-        }
-        // mesh vertices
-        ////////////////////////////////////////////////////////////////////////////////////////////////
-        const rapidjson::Value& mesh_data_vertex_array = mesh_data[VERTICES];
-        auto mesh_data_vertex_array_size = mesh_data_vertex_array.Size();
-        meshData->vertexSizeInFloat = mesh_data_vertex_array_size;
-        for (rapidjson::SizeType i = 0; i < mesh_data_vertex_array_size; ++i)
-        {
-            meshData->vertex.push_back(mesh_data_vertex_array[i].GetDouble());
-        }
-        // mesh part
-        ////////////////////////////////////////////////////////////////////////////////////////////////
-        const rapidjson::Value& mesh_part_array = mesh_data[PARTS];
-        for (rapidjson::SizeType i = 0, mesh_part_array_size = mesh_part_array.Size(); i < mesh_part_array_size; ++i)
-        {
-            std::vector<unsigned short>      indexArray;
-            const rapidjson::Value& mesh_part = mesh_part_array[i];
-            meshData->subMeshIds.push_back(mesh_part[ID].GetString());
-            // index_number
-            const rapidjson::Value& indices_val_array = mesh_part[INDICES];
-            for (rapidjson::SizeType j = 0, indices_val_array_size = indices_val_array.Size(); j < indices_val_array_size; ++j)
-                indexArray.push_back((unsigned short)indices_val_array[j].GetUint());
-
-            meshData->subMeshIndices.push_back(indexArray);
-            meshData->numIndex = (int)meshData->subMeshIndices.size();
-
-            if(mesh_data.HasMember(AABBS))
-            {
-                const rapidjson::Value& mesh_part_aabb = mesh_part[AABBS];
-                if (mesh_part.HasMember(AABBS) && mesh_part_aabb.Size() == 6)
-                {
-                    Vec3 min(mesh_part_aabb[(rapidjson::SizeType)0].GetDouble(),
-                             mesh_part_aabb[(rapidjson::SizeType)1].GetDouble(), mesh_part_aabb[(rapidjson::SizeType)2].GetDouble());
-                    Vec3 max(mesh_part_aabb[(rapidjson::SizeType)3].GetDouble(),
-                             mesh_part_aabb[(rapidjson::SizeType)4].GetDouble(), mesh_part_aabb[(rapidjson::SizeType)5].GetDouble());
-                    meshData->subMeshAABB.push_back(AABB(min, max));
-                }
-                else
-                {
-                    meshData->subMeshAABB.push_back(calculateAABB(meshData->vertex, meshData->getPerVertexSize(), indexArray));
-                }
-            }
-            else
-            {
-                meshData->subMeshAABB.push_back(calculateAABB(meshData->vertex, meshData->getPerVertexSize(), indexArray));
-            }
-           
-        }
-        meshdatas.meshDatas.push_back(meshData);
-    }
+    // read by MeshDatasJsonHandler in loadJson, if a previous call took them the file is read again
+    if (_jsonMeshDatasHandedOver && !loadJson(_path))
+        return false;
+    
+    auto& meshes = _jsonMeshDatas.meshDatas;
+    meshdatas.meshDatas.insert(meshdatas.meshDatas.end(), meshes.begin(), meshes.end());
+    meshes.clear();
+    _jsonMeshDatasHandedOver = true;
     return true;
 }
 bool Bundle3D::loadNodes(NodeDatas& nodedatas)
@@ -1051,12 +1041,226 @@ bool  Bundle3D::loadMaterialsJson(MaterialDatas& materialdatas)
     }
     return true;
 }
+/**
+ * Reads the "meshes" of a c3t while rapidjson scans the text, straight into MeshDatas,
+ * and locates their array so that it is left out of the DOM.
+ */
+class Bundle3D::MeshDatasJsonHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Bundle3D::MeshDatasJsonHandler>
+{
+public:
+    MeshDatasJsonHandler(Bundle3D* bundle, const rapidjson::StringStream& stream)
+    : _bundle(bundle)
+    , _stream(stream)
+    , _meshData(nullptr)
+    , _meshesBegin(0)
+    , _meshesEnd(0)
+    {
+    }
+    
+    size_t getMeshesBegin() const { return _meshesBegin; }
+    size_t getMeshesEnd() const { return _meshesEnd; }
+    
+    bool Default() { return true; }
+    bool Int(int i) { return number(i); }
+    bool Uint(unsigned u) { return number(u); }
+    bool Int64(int64_t i) { return number((double)i); }
+    bool Uint64(uint64_t u) { return number((double)u); }
+    bool Double(double d) { return number(d); }
+    
+    bool String(const char* str, rapidjson::SizeType length, bool /*copy*/)
+    {
+        if (_scopes.empty())
+            return true;
+        
+        if (_scopes.back() == Scope::Attribute)
+        {
+            auto& attrib = _meshData->attribs.back();
+            if (_key == TYPE)
+                attrib.type = _bundle->parseGLType(std::string(str, length));
+            else if (_key == ATTRIBUTE)
+                attrib.vertexAttrib = _bundle->parseGLProgramAttribute(std::string(str, length));
+        }
+        else if (_scopes.back() == Scope::Part && _key == ID)
+        {
+            _meshData->subMeshIds.push_back(std::string(str, length));
+        }
+        return true;
+    }
+    
+    bool Key(const char* str, rapidjson::SizeType length, bool /*copy*/)
+    {
+        _key.assign(str, length);
+        return true;
+    }
+    
+    bool StartObject()
+    {
+        Scope scope = Scope::Other;
+        if (_scopes.empty())
+        {
+            scope = Scope::Root;
+        }
+        else if (_scopes.back() == Scope::Meshes)
+        {
+            scope = Scope::Mesh;
+            _meshData = new (std::nothrow) MeshData();
+            _bundle->_jsonMeshDatas.meshDatas.push_back(_meshData);
+            _partAABBs.clear();
+        }
+        else if (_scopes.back() == Scope::Attributes)
+        {
+            scope = Scope::Attribute;
+            _meshData->attribs.push_back(MeshVertexAttrib());
+        }
+        else if (_scopes.back() == Scope::Parts)
+        {
+            scope = Scope::Part;
+            _meshData->subMeshIndices.push_back(MeshData::IndexArray());
+            _partAABBs.push_back(std::vector<float>());
+        }
+        _scopes.push_back(scope);
+        return true;
+    }
+    
+    bool EndObject(rapidjson::SizeType /*memberCount*/)
+    {
+        if (_scopes.back() == Scope::Mesh)
+        {
+            // the parts may come before the vertices
+            _meshData->attribCount = (int)_meshData->attribs.size();
+            _meshData->vertexSizeInFloat = (int)_meshData->vertex.size();
+            _meshData->numIndex = (int)_meshData->subMeshIndices.size();
+            for (size_t i = 0; i < _partAABBs.size(); ++i)
+            {
+                const auto& aabb = _partAABBs[i];
+                if (aabb.size() == 6)
+                    _meshData->subMeshAABB.push_back(AABB(Vec3(aabb[0], aabb[1], aabb[2]), Vec3(aabb[3], aabb[4], aabb[5])));
+                else
+                    _meshData->subMeshAABB.push_back(calculateAABB(_meshData->vertex, _meshData->getPerVertexSize(), _meshData->subMeshIndices[i]));
+            }
+        }
+        _scopes.pop_back();
+        return true;
+    }
+    
+    bool StartArray()
+    {
+        Scope scope = Scope::Other;
+        Scope parent = _scopes.empty() ? Scope::Other : _scopes.back();
+        if (parent == Scope::Root && _key == MESHES)
+        {
+            scope = Scope::Meshes;
+            _meshesBegin = _stream.Tell() - 1;
+        }
+        else if (parent == Scope::Mesh)
+        {
+            if (_key == ATTRIBUTES)
+                scope = Scope::Attributes;
+            else if (_key == VERTICES)
+                scope = Scope::Vertices;
+            else if (_key == PARTS)
+                scope = Scope::Parts;
+        }
+        else if (parent == Scope::Part)
+        {
+            if (_key == INDICES)
+                scope = Scope::Indices;
+            else if (_key == AABBS)
+                scope = Scope::PartAABB;
+        }
+        _scopes.push_back(scope);
+        return true;
+    }
+    
+    bool EndArray(rapidjson::SizeType /*elementCount*/)
+    {
+        if (_scopes.back() == Scope::Meshes)
+            _meshesEnd = _stream.Tell();
+        _scopes.pop_back();
+        return true;
+    }
+    
+private:
+    enum class Scope
+    {
+        Other,
+        Root,
+        Meshes,
+        Mesh,
+        Attributes,
+        Attribute,
+        Vertices,
+        Parts,
+        Part,
+        Indices,
+        PartAABB,
+    };
+    
+    bool number(double value)
+    {
+        if (_scopes.empty())
+            return true;
+        
+        switch (_scopes.back())
+        {
+            case Scope::Vertices:
+                _meshData->vertex.push_back((float)value);
+                break;
+            case Scope::Indices:
+                _meshData->subMeshIndices.back().push_back((unsigned short)value);
+                break;
+            case Scope::PartAABB:
+                _partAABBs.back().push_back((float)value);
+                break;
+            case Scope::Attribute:
+                if (_key == ATTRIBUTESIZE)
+                {
+                    auto& attrib = _meshData->attribs.back();
+                    attrib.size = (GLint)value;
+                    attrib.attribSizeBytes = sizeof(float) * attrib.size;
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+    
+    Bundle3D* _bundle;
+    const rapidjson::StringStream& _stream;
+    std::vector<Scope> _scopes;
+    std::string _key;
+    MeshData* _meshData;
+    std::vector<std::vector<float>> _partAABBs;
+    size_t _meshesBegin;
+    size_t _meshesEnd;
+};
+
 bool Bundle3D::loadJson(const std::string& path)
 {
     clear();
 
     _jsonBuffer = FileUtils::getInstance()->getStringFromFile(path);
 
+    // the vertices and indices make most of the text, they are read without building their DOM
+    rapidjson::Reader reader;
+    rapidjson::StringStream stream(_jsonBuffer.c_str());
+    MeshDatasJsonHandler handler(this, stream);
+    if (reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler).IsError())
+    {
+        clear();
+        CCLOG("Parse json failed in Bundle3D::loadJson function");
+        return false;
+    }
+    if (handler.getMeshesEnd() > handler.getMeshesBegin())
+    {
+        // an empty array in place of the meshes
+        auto meshes = &_jsonBuffer[handler.getMeshesBegin()];
+        memset(meshes, ' ', handler.getMeshesEnd() - handler.getMeshesBegin());
+        meshes[0] = '[';
+        meshes[1] = ']';
+    }
+
     if (_jsonReader.ParseInsitu<0>((char*)_jsonBuffer.c_str()).HasParseError())
     {
         clear();
@@ -1078,10 +1282,9 @@ bool Bundle3D::loadBinary(const std::string& path)
 {
     clear();
     
-    // get file data
-    _binaryBuffer.clear();
-    _binaryBuffer = FileUtils::getInstance()->getDataFromFile(path);
-    if (_binaryBuffer.isNull())
+    // map the file, the mesh payloads may alias it
+    _binaryFile = MappedFile::open(path);
+    if (!_binaryFile)
     {
         clear();
         CCLOG("warning: Failed to read file: %s", path.c_str());
@@ -1089,12 +1292,12 @@ bool Bundle3D::loadBinary(const std::string& path)
     }
     
     // Initialise bundle reader
-    _binaryReader.init( (char*)_binaryBuffer.getBytes(),  _binaryBuffer.getSize() );
+    _binaryReader.init( (char*)_binaryFile->getBytes(),  _binaryFile->getSize() );
     
-    // Read identifier info
+    // Read identifier info, 'A' instead of '\0' for the aligned payloads variant
     char identifier[] = { 'C', '3', 'B', '\0'};
     char sig[4];
-    if (_binaryReader.read(sig, 1, 4) != 4 || memcmp(sig, identifier, 4) != 0)
+    if (_binaryReader.read(sig, 1, 4) != 4 || memcmp(sig, identifier, 3) != 0 || (sig[3] != '\0' && sig[3] != 'A'))
     {
         clear();
         CCLOG("warning: Invalid identifier: %s", path.c_str());
@@ -1111,6 +1314,7 @@ bool Bundle3D::loadBinary(const std::string& path)
     char version[20] = {0};
     sprintf(version, "%d.%d", ver[0], ver[1]);
     _version = version;
+    _isAligned = sig[3] == 'A';
     
     // Read ref table size
     if (_binaryReader.read(&_referenceCount, 4, 1) != 1)
@@ -1139,6 +1343,71 @@ bool Bundle3D::loadBinary(const std::string& path)
     return true;
 }
 
+bool Bundle3D::writeAlignedBinary(const std::string& srcPath, const std::string& dstPath)
+{
+    Bundle3D bundle;
+    if (FileUtils::getInstance()->getFileExtension(srcPath) != ".c3b" || !bundle.load(srcPath))
+        return false;
+    
+    if (bundle._version == "0.1" || bundle._version == "0.2")
+    {
+        CCLOG("warning: c3b version %s can't be aligned: %s", bundle._version.c_str(), srcPath.c_str());
+        return false;
+    }
+    
+    // locate the payloads
+    MeshDatas meshdatas;
+    if (!bundle.loadMeshDatas(meshdatas))
+        return false;
+    
+    const unsigned char* bytes = bundle._binaryFile->getBytes();
+    ssize_t size = bundle._binaryFile->getSize();
+    
+    // the reference table precedes every payload, its offset fields don't move
+    std::vector<ssize_t> offsetFields;
+    BundleReader reader;
+    reader.init((char*)bytes, size);
+    reader.seek(4 + 2 + 4, SEEK_SET);
+    for (unsigned int i = 0; i < bundle._referenceCount; ++i)
+    {
+        reader.readString();
+        reader.seek(4, SEEK_CUR);
+        offsetFields.push_back(reader.tell());
+        reader.seek(4, SEEK_CUR);
+    }
+    
+    // copy the file, padding up to each payload, shifts[i] being the padding inserted up to payloads[i]
+    const auto& payloads = bundle._payloadOffsets;
+    std::vector<unsigned char> aligned;
+    std::vector<ssize_t> shifts;
+    aligned.reserve(size + payloads.size() * 16);
+    ssize_t position = 0;
+    for (auto payload : payloads)
+    {
+        aligned.insert(aligned.end(), bytes + position, bytes + payload);
+        aligned.resize((aligned.size() + 15) / 16 * 16, 0);
+        shifts.push_back((ssize_t)aligned.size() - payload);
+        position = payload;
+    }
+    aligned.insert(aligned.end(), bytes + position, bytes + size);
+    
+    aligned[3] = 'A';
+    for (auto field : offsetFields)
+    {
+        unsigned int offset;
+        memcpy(&offset, bytes + field, 4);
+        ssize_t shift = 0;
+        for (size_t i = 0; i < payloads.size() && payloads[i] < offset; ++i)
+            shift = shifts[i];
+        offset += (unsigned int)shift;
+        memcpy(&aligned[field], &offset, 4);
+    }
+    
+    Data data;
+    data.copy(aligned.data(), (ssize_t)aligned.size());
+    return FileUtils::getInstance()->writeDataToFile(data, dstPath);
+}
+
 bool Bundle3D::loadMeshDataJson_0_1(MeshDatas& meshdatas)
 {
     const rapidjson::Value& mesh_data_array = _jsonReader[MESH];
@@ -2223,9 +2492,12 @@ Bundle3D::Bundle3D()
 : _modelPath(""),
 _path(""),
 _version(""),
+_jsonMeshDatasHandedOver(false),
 _referenceCount(0),
 _references(nullptr),
-_isBinary(false)
+_isBinary(false),
+_isAligned(false),
+_meshDataAliasing(false)
 {
 
 }
@@ -2236,12 +2508,17 @@ Bundle3D::~Bundle3D()
 }
 
 cocos2d::AABB Bundle3D::calculateAABB( const std::vector<float>& vertex, int stride, const std::vector<unsigned short>& index )
+{
+    return calculateAABB(vertex.data(), stride, index.data(), index.size());
+}
+
+cocos2d::AABB Bundle3D::calculateAABB(const float* vertex, int stride, const unsigned short* index, size_t indexCount)
 {
     AABB aabb;
     stride /= 4;
-    for (const auto& it : index)
+    for (size_t i = 0; i < indexCount; ++i)
     {
-        Vec3 point(vertex[it * stride], vertex[it * stride + 1], vertex[it * stride + 2]);
+        Vec3 point(vertex[index[i] * stride], vertex[index[i] * stride + 1], vertex[index[i] * stride + 2]);
         aabb.updateMinMax(&point, 1);
     }
     return aabb;
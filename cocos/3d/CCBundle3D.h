@@ -25,6 +25,8 @@
 #ifndef __CCBUNDLE3D_H__
 #define __CCBUNDLE3D_H__
 
+#include <memory>
+
 #include "base/CCData.h"
 #include "3d/CCBundle3DData.h"
 #include "3d/CCBundleReader.h"
@@ -38,6 +40,7 @@ namespace cocos2d {
  */
 
 class Animation3D;
+class MappedFile;
 
 /**
  * @brief Defines a bundle file that contains a collection of assets. Mesh, Material, MeshSkin, Animation
@@ -78,6 +81,14 @@ public:
      */
     virtual bool loadAnimationData(const std::string& id, Animation3DData* animationdata);
     
+    /**
+     * Sets whether loadMeshDatas aliases the vertex and index payloads of a memory-mapped c3b file
+     * instead of copying them, see MeshData::getVertexData. The payloads are aliased when they are
+     * aligned, which is always the case for the files written by writeAlignedBinary. False by default.
+     */
+    void setMeshDataAliasing(bool aliasing) { _meshDataAliasing = aliasing; }
+    bool isMeshDataAliasing() const { return _meshDataAliasing; }
+
     //since 3.3, to support reskin
     virtual bool loadMeshDatas(MeshDatas& meshdatas);
     //since 3.3, to support reskin
@@ -85,6 +96,12 @@ public:
     //since 3.3, to support reskin
     virtual bool loadMaterials(MaterialDatas& materialdatas);
     
+    /**
+     * Writes a copy of a c3b file with its vertex and index payloads padded to 16 bytes boundaries,
+     * identified by the "C3BA" signature. Supports the files of version 0.3 and later.
+     */
+    static bool writeAlignedBinary(const std::string& srcPath, const std::string& dstPath);
+
     /**
      * load triangle list
      * @param path the file path to load
@@ -96,6 +113,7 @@ public:
     
     //calculate aabb
     static AABB calculateAABB(const std::vector<float>& vertex, int stride, const std::vector<unsigned short>& index);
+    static AABB calculateAABB(const float* vertex, int stride, const unsigned short* index, size_t indexCount);
   
 protected:
 
@@ -177,15 +195,21 @@ protected:
     std::string _version;// the c3b or c3t version
     
     // for json reading
+    class MeshDatasJsonHandler;
     std::string _jsonBuffer;
-    rapidjson::Document _jsonReader;
+    rapidjson::Document _jsonReader; // without the "meshes", read into _jsonMeshDatas while scanning the text
+    MeshDatas _jsonMeshDatas; // handed over by loadMeshDatas
+    bool _jsonMeshDatasHandedOver;
 
     // for binary reading
-    Data _binaryBuffer;
+    std::shared_ptr<const MappedFile> _binaryFile;
     BundleReader _binaryReader;
     unsigned int _referenceCount;
     Reference* _references;
     bool  _isBinary;
+    bool  _isAligned; // the payloads are padded to 16 bytes, "C3BA" signature
+    bool  _meshDataAliasing;
+    std::vector<ssize_t> _payloadOffsets; // vertex and index payloads read by the last loadMeshDatasBinary
 };
 
 // end of 3d group
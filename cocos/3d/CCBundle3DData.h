@@ -30,11 +30,14 @@
 #include "math/CCMath.h"
 #include "3d/CCAABB.h"
 
+#include <memory>
 #include <vector>
 #include <map>
  
 namespace cocos2d {
 
+class MappedFile;
+
 /**mesh vertex attribute
 * @js NA
 * @lua NA
@@ -153,6 +156,16 @@ struct MeshData
     std::vector<MeshVertexAttrib> attribs;
     int attribCount;
 
+    // payloads aliasing the bundle file, used in place of vertex and subMeshIndices when mappedVertex is set
+    struct IndexSpan
+    {
+        const unsigned short* data;
+        unsigned int count;
+    };
+    const float* mappedVertex; // vertexSizeInFloat floats
+    std::vector<IndexSpan> mappedSubMeshIndices;
+    std::shared_ptr<const MappedFile> mappedFile; // keeps the payloads alive
+
 public:
     /**
      * Get per vertex size
@@ -168,6 +181,32 @@ public:
         return vertexsize;
     }
 
+    /** Vertex payload, aliasing the bundle file if mapped */
+    const float* getVertexData() const
+    {
+        return mappedVertex ? mappedVertex : vertex.data();
+    }
+
+    /** Number of floats in the vertex payload */
+    size_t getVertexDataSize() const
+    {
+        return mappedVertex ? static_cast<size_t>(vertexSizeInFloat) : vertex.size();
+    }
+
+    /** Index payload of the sub mesh, aliasing the bundle file if mapped */
+    IndexSpan getSubMeshIndexData(size_t index) const
+    {
+        if (mappedVertex)
+            return mappedSubMeshIndices[index];
+        return IndexSpan{subMeshIndices[index].data(), static_cast<unsigned int>(subMeshIndices[index].size())};
+    }
+
+    /** Number of sub meshes */
+    size_t getSubMeshCount() const
+    {
+        return mappedVertex ? mappedSubMeshIndices.size() : subMeshIndices.size();
+    }
+
     /**
      * Reset the data
      */
@@ -177,6 +216,9 @@ public:
         subMeshIndices.clear();
         subMeshAABB.clear();
         attribs.clear();
+        mappedVertex = nullptr;
+        mappedSubMeshIndices.clear();
+        mappedFile.reset();
         vertexSizeInFloat = 0;
         numIndex = 0;
         attribCount = 0;
@@ -185,6 +227,7 @@ public:
     : vertexSizeInFloat(0)
     , numIndex(0)
     , attribCount(0)
+    , mappedVertex(nullptr)
     {
     }
     ~MeshData()
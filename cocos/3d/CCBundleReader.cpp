@@ -84,6 +84,32 @@ ssize_t BundleReader::read(void* ptr, ssize_t size, ssize_t count)
     return validCount;
 }
 
+const char* BundleReader::readInPlace(ssize_t size, ssize_t count)
+{
+    if (!_buffer || size * count > _length - _position)
+    {
+        CCLOG("warning: bundle reader out of range");
+        return nullptr;
+    }
+
+    const char* ptr = _buffer + _position;
+    _position += size * count;
+    return ptr;
+}
+
+bool BundleReader::align(ssize_t alignment)
+{
+    if (!_buffer)
+        return false;
+
+    ssize_t position = (_position + alignment - 1) / alignment * alignment;
+    if (position > _length)
+        return false;
+
+    _position = position;
+    return true;
+}
+
 char* BundleReader::readLine(int num,char* line)
 {
     if (!_buffer)
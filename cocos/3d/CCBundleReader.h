@@ -76,6 +76,18 @@ public:
      */
     ssize_t read(void* ptr, ssize_t size, ssize_t count);
 
+    /**
+     * Returns the address of count elements in the buffer and moves past them, without copying.
+     *
+     * @return nullptr if less than count elements are left.
+     */
+    const char* readInPlace(ssize_t size, ssize_t count);
+
+    /**
+     * Moves the position to the next multiple of alignment from the start of the buffer.
+     */
+    bool align(ssize_t alignment);
+
     /**
      * Reads a line from the buffer.
      */
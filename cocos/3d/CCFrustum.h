@@ -70,6 +70,12 @@ public:
      */
     void setClipZ(bool clipZ) { _clipZ = clipZ; }
     bool isClipZ() { return _clipZ; }
+
+    /**
+     * get the clip planes, left, right, bottom, top, near, far. The last two are only used with z clip.
+     */
+    const Plane& getPlane(int index) const { return _plane[index]; }
+    int getPlaneCount() const { return _clipZ ? 6 : 4; }
     
 protected:
     /**
@@ -322,6 +322,10 @@ void Mesh::draw(Renderer* renderer, float globalZOrder, const Mat4& transform, u
     _meshCommand.set3D(!_force2DQueue);
     _material->getStateBlock()->setBlend(_force2DQueue || isTransparent);
 
+    // instanced shaders read the color from the instance data
+    if (_meshCommand.getInstanceID())
+        _meshCommand.setInstanceColor(color);
+
     // set default uniforms for Mesh
     // 'u_color' and others
     const auto scene = Director::getInstance()->getRunningScene();
@@ -329,7 +333,8 @@ void Mesh::draw(Renderer* renderer, float globalZOrder, const Mat4& transform, u
     for(auto & pass : technique->_passes)
     {
         auto programState = pass->getGLProgramState();
-        programState->setUniformVec4("u_color", color);
+        if (!_meshCommand.getInstanceID() || !programState->getGLProgram()->getVertexAttrib(GLProgram::ATTRIBUTE_NAME_INSTANCE_COLOR))
+            programState->setUniformVec4("u_color", color);
 
         if (_skin)
             programState->setUniformVec4v("u_matrixPalette", (GLsizei)_skin->getMatrixPaletteSize(), _skin->getMatrixPalette());
@@ -427,6 +432,7 @@ void Mesh::bindMeshCommand()
         auto blend = BlendFunc::ALPHA_PREMULTIPLIED;
 
         _meshCommand.genMaterialID(textureid, glprogramstate, _meshIndexData->getVertexBuffer()->getVBO(), _meshIndexData->getIndexBuffer()->getVBO(), blend);
+        _meshCommand.genInstanceID(textureid, glprogramstate->getGLProgram(), _meshIndexData->getVertexBuffer()->getVBO(), _meshIndexData->getIndexBuffer()->getVBO(), blend);
         _material->getStateBlock()->setCullFace(true);
         _material->getStateBlock()->setDepthTest(true);
     }
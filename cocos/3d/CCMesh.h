@@ -130,6 +130,8 @@ public:
      * mesh index data getter
      */
     std::shared_ptr<MeshIndexData> getMeshIndexData() const { return _meshIndexData; }
+    /**get skin, nullptr if the mesh isn't skinned*/
+    MeshSkin* getSkin() const { return _skin.get(); }
     
     /**
      * get GLProgramState
@@ -32,6 +32,7 @@ static int PALETTE_ROWS = 3;
 
 MeshSkin::MeshSkin(std::shared_ptr<Skeleton3D> skeleton, const std::vector<std::string>& boneNames, const std::vector<Mat4>& invBindPose)
     : _skeleton( skeleton )
+    , _paletteVersion(0)
 {
     CCASSERT(boneNames.size() == invBindPose.size(), "bone names' num should equals to invBindPose's num");
 
@@ -79,6 +80,11 @@ const Vec4* MeshSkin::getMatrixPalette()
     {
         _matrixPalette.resize(_skinBones.size() * PALETTE_ROWS, Vec4());
     }
+    else if (_paletteVersion == _skeleton->getPoseVersion())
+    {
+        return _matrixPalette.data();
+    }
+    _paletteVersion = _skeleton->getPoseVersion();
 
     int i = 0;
     int paletteIndex = 0;
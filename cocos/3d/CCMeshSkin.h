@@ -60,7 +60,7 @@ public:
     /**get bone index*/
     int getBoneIndex(Bone3D* bone) const;
     
-    /**compute matrix palette used by gpu skin*/
+    /**compute matrix palette used by gpu skin, only recomputed when the skeleton pose changed*/
     const Vec4* getMatrixPalette();
     
     /**getSkinBoneCount() * 3*/
@@ -89,6 +89,7 @@ protected:
     // Each 4x3 row-wise matrix is represented as 3 Vec4's.
     // The number of Vec4's is (_skinBones.size() * 3).
     std::vector<Vec4> _matrixPalette;
+    unsigned int _paletteVersion; // skeleton pose version the palette was computed from
 };
 
 // end of 3d group
@@ -77,7 +77,7 @@ MeshVertexData* MeshVertexData::create(const MeshData& meshdata)
 {
     auto vertexdata = new (std::nothrow) MeshVertexData();
     int pervertexsize = meshdata.getPerVertexSize();
-    vertexdata->_vertexBuffer = VertexBuffer::create(pervertexsize, (int)(meshdata.vertex.size() / (pervertexsize / 4)));
+    vertexdata->_vertexBuffer = VertexBuffer::create(pervertexsize, (int)(meshdata.getVertexDataSize() / (pervertexsize / 4)));
     vertexdata->_vertexData = VertexData::create();
     CC_SAFE_RETAIN(vertexdata->_vertexData);
     CC_SAFE_RETAIN(vertexdata->_vertexBuffer);
@@ -92,21 +92,22 @@ MeshVertexData* MeshVertexData::create(const MeshData& meshdata)
     
     if(vertexdata->_vertexBuffer)
     {
-        vertexdata->_vertexBuffer->updateVertices((void*)&meshdata.vertex[0], (int)meshdata.vertex.size() * 4 / vertexdata->_vertexBuffer->getSizePerVertex(), 0);
+        // uploaded straight from the bundle file when it is mapped
+        vertexdata->_vertexBuffer->updateVertices(meshdata.getVertexData(), (int)meshdata.getVertexDataSize() * 4 / vertexdata->_vertexBuffer->getSizePerVertex(), 0);
     }
     
-    bool needCalcAABB = (meshdata.subMeshAABB.size() != meshdata.subMeshIndices.size());
-    for (size_t i = 0, size = meshdata.subMeshIndices.size(); i < size; ++i) {
+    bool needCalcAABB = (meshdata.subMeshAABB.size() != meshdata.getSubMeshCount());
+    for (size_t i = 0, size = meshdata.getSubMeshCount(); i < size; ++i) {
 
-        auto& index = meshdata.subMeshIndices[i];
-        auto indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)(index.size()));
-        indexBuffer->updateIndices(&index[0], (int)index.size(), 0);
+        auto index = meshdata.getSubMeshIndexData(i);
+        auto indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)index.count);
+        indexBuffer->updateIndices(index.data, (int)index.count, 0);
         std::string id = (i < meshdata.subMeshIds.size() ? meshdata.subMeshIds[i] : "");
 
         std::shared_ptr<MeshIndexData> indexdata;
         if (needCalcAABB)
         {
-            auto aabb = Bundle3D::calculateAABB(meshdata.vertex, meshdata.getPerVertexSize(), index);
+            auto aabb = Bundle3D::calculateAABB(meshdata.getVertexData(), meshdata.getPerVertexSize(), index.data, index.count);
             indexdata = MeshIndexData::create(id, vertexdata, indexBuffer, aabb);
         }
         else
@@ -0,0 +1,441 @@
+/****************************************************************************
+ Copyright (c) 2015 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "3d/CCPagedTerrain.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/CCAsyncTaskPool.h"
+#include "base/CCDirector.h"
+#include "base/ccUTF8.h"
+#include "2d/CCCamera.h"
+#include "2d/CCScene.h"
+#include "platform/CCFileUtils.h"
+#include "platform/CCImage.h"
+#include "platform/CCMappedFile.h"
+
+namespace cocos2d {
+
+// same mapping as Terrain::getImageHeight
+static float sampleToHeight(unsigned char sample, float mapHeight)
+{
+    return sample*1.0f/255*mapHeight - 0.5f*mapHeight;
+}
+
+PagedTerrain::PagedTerrainData::PagedTerrainData()
+: _tilesX(0)
+, _tilesY(0)
+, _tileSize(129)
+, _lowResStep(8)
+{
+}
+
+PagedTerrain * PagedTerrain::create(const PagedTerrainData &parameter, Terrain::CrackFixedType fixedType)
+{
+    auto terrain = new (std::nothrow) PagedTerrain();
+    if (terrain && terrain->init(parameter, fixedType))
+    {
+        terrain->autorelease();
+        return terrain;
+    }
+    CC_SAFE_DELETE(terrain);
+    return nullptr;
+}
+
+PagedTerrain::PagedTerrain()
+: _crackFixedType(Terrain::CrackFixedType::INCREASE_LOWER)
+, _rawWidth(0)
+, _tileExtent(0)
+, _residencyBudget(9)
+, _loadDistance(0)
+, _camera(nullptr)
+, _lowResWidth(0)
+, _lowResHeight(0)
+, _lowResSpacing(0)
+{
+}
+
+PagedTerrain::~PagedTerrain()
+{
+    for (auto request : _readyTiles)
+    {
+        CC_SAFE_RELEASE(request->_image);
+        delete request;
+    }
+}
+
+bool PagedTerrain::init(const PagedTerrainData &parameter, Terrain::CrackFixedType fixedType)
+{
+    if (parameter._tilesX <= 0 || parameter._tilesY <= 0 || parameter._tileSize < 2)
+    {
+        CCLOG("warning: PagedTerrain needs at least one tile");
+        return false;
+    }
+    if (parameter._tileFilePattern.empty() && parameter._rawHeightFile.empty())
+    {
+        CCLOG("warning: PagedTerrain needs tile files or a raw height file");
+        return false;
+    }
+
+    _data = parameter;
+    _crackFixedType = fixedType;
+    _tileExtent = (_data._tileSize - 1)*_data._tileData._mapScale;
+    _loadDistance = _tileExtent*1.5f;
+    _tiles.resize(_data._tilesX*_data._tilesY, Tile{nullptr, false, false});
+
+    if (!_data._rawHeightFile.empty())
+    {
+        _rawFile = MappedFile::open(_data._rawHeightFile);
+        _rawWidth = _data._tilesX*(_data._tileSize - 1) + 1;
+        int rawHeight = _data._tilesY*(_data._tileSize - 1) + 1;
+        if (!_rawFile || _rawFile->getSize() < (ssize_t)_rawWidth*rawHeight)
+        {
+            CCLOG("warning: the raw height file %s should hold %dx%d samples", _data._rawHeightFile.c_str(), _rawWidth, rawHeight);
+            return false;
+        }
+    }
+
+    initLowResHeights();
+    Director::getInstance()->getScheduler().schedule(
+        UpdateJob(this, 0).paused( isPaused() )
+    );
+    return true;
+}
+
+void PagedTerrain::initLowResHeights()
+{
+    float mapHeight = _data._tileData._mapHeight;
+    Size worldSize = getWorldSize();
+    if (!_data._lowResHeightMapSrc.empty())
+    {
+        Image image;
+        if (!image.initWithImageFile(_data._lowResHeightMapSrc) || image.getWidth() < 2 || image.getHeight() < 2)
+        {
+            return;
+        }
+        int byteStride = 1;
+        switch (image.getRenderFormat())
+        {
+        case Texture2D::PixelFormat::BGRA8888:
+        case Texture2D::PixelFormat::RGBA8888:
+            byteStride = 4;
+            break;
+        case Texture2D::PixelFormat::RGB888:
+            byteStride = 3;
+            break;
+        default:
+            break;
+        }
+        _lowResWidth = image.getWidth();
+        _lowResHeight = image.getHeight();
+        _lowResSpacing = worldSize.width/(_lowResWidth - 1);
+        _lowResHeights.resize(_lowResWidth*_lowResHeight);
+        auto bytes = image.getData();
+        for (int i = 0, size = _lowResWidth*_lowResHeight; i < size; ++i)
+        {
+            _lowResHeights[i] = sampleToHeight(bytes[i*byteStride], mapHeight);
+        }
+    }
+    else if (_rawFile)
+    {
+        int step = std::max(_data._lowResStep, 1);
+        int rawHeight = _data._tilesY*(_data._tileSize - 1) + 1;
+        _lowResWidth = (_rawWidth - 1)/step + 1;
+        _lowResHeight = (rawHeight - 1)/step + 1;
+        _lowResSpacing = step*_data._tileData._mapScale;
+        _lowResHeights.resize(_lowResWidth*_lowResHeight);
+        // only every step-th row is touched, the rest of the mapping is never paged in
+        auto bytes = _rawFile->getBytes();
+        for (int i = 0; i < _lowResHeight; ++i)
+        {
+            for (int j = 0; j < _lowResWidth; ++j)
+            {
+                _lowResHeights[i*_lowResWidth + j] = sampleToHeight(bytes[(size_t)i*step*_rawWidth + j*step], mapHeight);
+            }
+        }
+    }
+}
+
+Size PagedTerrain::getWorldSize() const
+{
+    return Size(_data._tilesX*_tileExtent, _data._tilesY*_tileExtent);
+}
+
+void PagedTerrain::setResidencyBudget(int tiles)
+{
+    _residencyBudget = std::max(tiles, 1);
+}
+
+void PagedTerrain::setLoadDistance(float distance)
+{
+    _loadDistance = distance;
+}
+
+Terrain * PagedTerrain::getTile(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= _data._tilesX || y >= _data._tilesY)
+        return nullptr;
+    return _tiles[y*_data._tilesX + x]._terrain;
+}
+
+int PagedTerrain::getResidentTileCount() const
+{
+    int count = 0;
+    for (auto& tile : _tiles)
+    {
+        if (tile._terrain)
+            ++count;
+    }
+    return count;
+}
+
+float PagedTerrain::getTileDistance(int index, const Vec2& localPos) const
+{
+    Size worldSize = getWorldSize();
+    float minX = (index%_data._tilesX)*_tileExtent - worldSize.width/2;
+    float minZ = (index/_data._tilesX)*_tileExtent - worldSize.height/2;
+    float dx = std::max(std::max(minX - localPos.x, localPos.x - (minX + _tileExtent)), 0.0f);
+    float dz = std::max(std::max(minZ - localPos.y, localPos.y - (minZ + _tileExtent)), 0.0f);
+    return std::sqrt(dx*dx + dz*dz);
+}
+
+void PagedTerrain::update(float /*delta*/)
+{
+    Camera * camera = _camera ? _camera : Camera::getDefaultCamera();
+    if (!camera)
+        return;
+
+    // the paging works in local space, the distances are scaled back to world units below
+    Mat4 cameraTransform = camera->getNodeToWorldTransform();
+    Vec3 cameraPos(cameraTransform.m[12], cameraTransform.m[13], cameraTransform.m[14]);
+    getWorldToNodeTransform().transformPoint(&cameraPos);
+    Vec2 localPos(cameraPos.x, cameraPos.z);
+    float scale = std::max(std::abs(getScaleX()), std::abs(getScaleZ()));
+    float loadDistance = scale > 0 ? _loadDistance/scale : _loadDistance;
+
+    // the nearest tiles within the load distance are wanted, as many as the budget allows
+    _candidates.clear();
+    for (int i = 0, size = (int)_tiles.size(); i < size; ++i)
+    {
+        _tiles[i]._wanted = false;
+        float distance = getTileDistance(i, localPos);
+        if (distance <= loadDistance)
+            _candidates.push_back(std::make_pair(distance, i));
+    }
+    std::sort(_candidates.begin(), _candidates.end());
+    if ((int)_candidates.size() > _residencyBudget)
+        _candidates.resize(_residencyBudget);
+    for (auto& candidate : _candidates)
+    {
+        _tiles[candidate.second]._wanted = true;
+    }
+
+    // unload before loading, so the budget holds at any time
+    int used = 0;
+    for (int i = 0, size = (int)_tiles.size(); i < size; ++i)
+    {
+        auto& tile = _tiles[i];
+        if (tile._terrain && !tile._wanted)
+            unloadTile(i);
+        if (tile._terrain || tile._loading)
+            ++used;
+    }
+    for (auto& candidate : _candidates)
+    {
+        if (used >= _residencyBudget)
+            break;
+        auto& tile = _tiles[candidate.second];
+        if (!tile._terrain && !tile._loading)
+        {
+            loadTile(candidate.second);
+            ++used;
+        }
+    }
+
+    // creating a Terrain uploads its buffers and textures, do one per frame
+    while (!_readyTiles.empty())
+    {
+        auto request = _readyTiles.front();
+        _readyTiles.pop_front();
+        auto& tile = _tiles[request->_index];
+        tile._loading = false;
+        bool created = false;
+        if (tile._wanted && !tile._terrain)
+        {
+            auto terrain = Terrain::create(_data._tileData, request->_image, _crackFixedType);
+            if (terrain)
+            {
+                // Terrain puts its first sample at -imageWidth/2*mapScale, the first sample of a tile lands on its corner
+                Size worldSize = getWorldSize();
+                float firstSample = (_data._tileSize/2)*_data._tileData._mapScale;
+                float x = (request->_index%_data._tilesX)*_tileExtent + firstSample - worldSize.width/2;
+                float z = (request->_index/_data._tilesX)*_tileExtent + firstSample - worldSize.height/2;
+                terrain->setPosition3D(Vec3(x, 0, z));
+                terrain->setCameraMask(getCameraMask());
+                addChild(terrain);
+                tile._terrain = terrain;
+                created = true;
+            }
+        }
+        request->_image->release();
+        delete request;
+        if (created)
+            break;
+    }
+}
+
+void PagedTerrain::loadTile(int index)
+{
+    int x = index%_data._tilesX;
+    int y = index/_data._tilesX;
+    _tiles[index]._loading = true;
+
+    auto request = new TileRequest();
+    request->_index = index;
+    request->_image = nullptr;
+
+    std::string fullPath;
+    if (!_rawFile)
+    {
+        // resolved in the main thread, the FileUtils caches aren't thread safe
+        fullPath = FileUtils::getInstance()->fullPathForFilename(StringUtils::format(_data._tileFilePattern.c_str(), x, y));
+    }
+    int tileSize = _data._tileSize;
+    int rawWidth = _rawWidth;
+    auto rawFile = _rawFile;
+
+    // the pending callback keeps the terrain alive
+    retain();
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_DECODE, CC_CALLBACK_1(PagedTerrain::onTileLoaded, this), request,
+        [request, fullPath, rawFile, rawWidth, tileSize, x, y]()
+    {
+        auto image = new Image();
+        bool result = false;
+        if (rawFile)
+        {
+            // Image only takes RGBA8888 raw data, the height goes in the red channel of each pixel
+            std::vector<unsigned char> pixels(tileSize*tileSize*4, 0);
+            const unsigned char * bytes = rawFile->getBytes() + ((size_t)y*(tileSize - 1)*rawWidth + (size_t)x*(tileSize - 1));
+            for (int i = 0; i < tileSize; ++i)
+            {
+                for (int j = 0; j < tileSize; ++j)
+                {
+                    pixels[(i*tileSize + j)*4] = bytes[(size_t)i*rawWidth + j];
+                }
+            }
+            result = image->initWithRawData(pixels.data(), pixels.size(), tileSize, tileSize, 8);
+        }
+        else
+        {
+            result = image->initWithImageFile(fullPath);
+        }
+        if (!result)
+        {
+            CC_SAFE_RELEASE_NULL(image);
+        }
+        request->_image = image;
+    });
+}
+
+void PagedTerrain::onTileLoaded(void * param)
+{
+    auto request = static_cast<TileRequest*>(param);
+    if (request->_image && _tiles[request->_index]._wanted)
+    {
+        // still counted as loading until update() builds it
+        _readyTiles.push_back(request);
+    }
+    else
+    {
+        _tiles[request->_index]._loading = false;
+        if (!request->_image)
+            CCLOG("warning: PagedTerrain failed to load tile %d", request->_index);
+        CC_SAFE_RELEASE(request->_image);
+        delete request;
+    }
+    release();
+}
+
+void PagedTerrain::unloadTile(int index)
+{
+    auto& tile = _tiles[index];
+    removeChild(tile._terrain);
+    tile._terrain = nullptr;
+}
+
+float PagedTerrain::getHeight(float x, float z, Vec3 * normal) const
+{
+    Vec3 localPos(x, 0, z);
+    getWorldToNodeTransform().transformPoint(&localPos);
+    Size worldSize = getWorldSize();
+    int tileX = (int)std::floor((localPos.x + worldSize.width/2)/_tileExtent);
+    int tileY = (int)std::floor((localPos.z + worldSize.height/2)/_tileExtent);
+    auto terrain = getTile(tileX, tileY);
+    if (terrain)
+    {
+        return terrain->getHeight(x, z, normal);
+    }
+    return getLowResHeight(localPos.x, localPos.z, normal);
+}
+
+float PagedTerrain::getHeight(const Vec2& pos, Vec3* normal) const
+{
+    return getHeight(pos.x, pos.y, normal);
+}
+
+float PagedTerrain::getLowResHeight(float localX, float localZ, Vec3 * normal) const
+{
+    Size worldSize = getWorldSize();
+    float gridX = (localX + worldSize.width/2)/_lowResSpacing;
+    float gridY = (localZ + worldSize.height/2)/_lowResSpacing;
+    if (_lowResHeights.empty() || gridX < 0 || gridY < 0 || gridX >= _lowResWidth - 1 || gridY >= _lowResHeight - 1)
+    {
+        if (normal)
+        {
+            normal->setZero();
+        }
+        return 0;
+    }
+
+    int i = (int)gridX;
+    int j = (int)gridY;
+    float u = gridX - i;
+    float v = gridY - j;
+    float scaleY = getScaleY();
+    float a = _lowResHeights[j*_lowResWidth + i]*scaleY;
+    float b = _lowResHeights[(j + 1)*_lowResWidth + i]*scaleY;
+    float c = _lowResHeights[j*_lowResWidth + i + 1]*scaleY;
+    float d = _lowResHeights[(j + 1)*_lowResWidth + i + 1]*scaleY;
+    if (normal)
+    {
+        // the slopes along x & z, averaged over the cell
+        float slopeX = ((c - a) + (d - b))/(2*_lowResSpacing);
+        float slopeZ = ((b - a) + (d - c))/(2*_lowResSpacing);
+        normal->set(-slopeX, 1, -slopeZ);
+        normal->normalize();
+    }
+    return (1 - u)*(1 - v)*a + (1 - u)*v*b + u*(1 - v)*c + u*v*d;
+}
+
+}
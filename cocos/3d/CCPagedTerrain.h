@@ -0,0 +1,170 @@
+/****************************************************************************
+ Copyright (c) 2015 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef CC_PAGED_TERRAIN_H
+#define CC_PAGED_TERRAIN_H
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "3d/CCTerrain.h"
+
+namespace cocos2d {
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+class Camera;
+class Image;
+class MappedFile;
+
+/**
+ * PagedTerrain splits a large world into a grid of Terrain tiles and only keeps the tiles
+ * around the camera in memory.
+ *
+ * The height of each tile comes either from its own height map file or from a window of one
+ * 8 bit raw height file, which is memory mapped instead of being loaded as a whole.
+ * Tiles are decoded on the AsyncTaskPool and at most one tile is turned into a Terrain per frame.
+ * The number of resident tiles never exceeds the residency budget; the farthest tiles are
+ * unloaded first.
+ *
+ * getHeight() answers from the resident tile when there is one, and from a coarse height grid
+ * covering the whole world otherwise, so gameplay queries keep working far from the camera.
+ */
+class CC_DLL PagedTerrain : public Node
+{
+public:
+    /**
+     * PagedTerrainData
+     * all the parameters PagedTerrain needs to create
+     */
+    struct CC_DLL PagedTerrainData
+    {
+        /**constructor*/
+        PagedTerrainData();
+        /**the settings shared by every tile: detail maps, chunk size, height and scale. _heightMapSrc is ignored.*/
+        Terrain::TerrainData _tileData;
+        /**the height map of each tile, a printf pattern which takes the tile column and row, e.g. "terrain/tile_%d_%d.png"*/
+        std::string _tileFilePattern;
+        /**alternatively, one 8 bit raw height file for the whole world, samples are stored row by row*/
+        std::string _rawHeightFile;
+        /**the amount of tiles along x and z*/
+        int _tilesX;
+        int _tilesY;
+        /**the samples along a tile edge, it must be POT + 1. Neighbor tiles share their edge samples,
+         * so a raw height file is (_tilesX * (_tileSize - 1) + 1) samples wide.
+         */
+        int _tileSize;
+        /**optional height map of the whole world, used by getHeight() on areas which are not resident*/
+        std::string _lowResHeightMapSrc;
+        /**without _lowResHeightMapSrc, the fallback grid takes one sample of the raw height file every _lowResStep samples*/
+        int _lowResStep;
+    };
+
+    /**create entry*/
+    static PagedTerrain * create(const PagedTerrainData &parameter, Terrain::CrackFixedType fixedType = Terrain::CrackFixedType::INCREASE_LOWER);
+
+    /**
+     * set the maximum number of tiles which are loaded or being loaded, 9 by default.
+     * Each resident tile holds a Terrain, roughly 100 bytes per height sample.
+     */
+    void setResidencyBudget(int tiles);
+    int getResidencyBudget() const { return _residencyBudget; }
+
+    /**set the distance from the camera within which tiles are loaded, in world units*/
+    void setLoadDistance(float distance);
+    float getLoadDistance() const { return _loadDistance; }
+
+    /**set the camera which drives the paging, it isn't retained. The default camera of the running scene is used when it's nullptr*/
+    void setCamera(Camera * camera) { _camera = camera; }
+
+    /**get the tile at the specified column and row, nullptr if it isn't resident*/
+    Terrain * getTile(int x, int y) const;
+
+    /**get the number of tiles which are currently resident*/
+    int getResidentTileCount() const;
+
+    /**get specified position's height, see Terrain::getHeight.
+     * On areas which are not resident the height is interpolated from the coarse fallback grid.
+     **/
+    float getHeight(float x, float z, Vec3 * normal = nullptr) const;
+    float getHeight(const Vec2& pos, Vec3* normal = nullptr) const;
+
+    /**the size of the whole world in local space*/
+    Size getWorldSize() const;
+
+    virtual void update(float delta) override;
+
+protected:
+    PagedTerrain();
+    virtual ~PagedTerrain();
+    bool init(const PagedTerrainData &parameter, Terrain::CrackFixedType fixedType);
+
+    struct Tile
+    {
+        Terrain * _terrain;
+        bool _loading;
+        bool _wanted;
+    };
+    struct TileRequest
+    {
+        int _index;
+        Image * _image;
+    };
+
+    /**build the coarse height grid used by getHeight() on areas which are not resident*/
+    void initLowResHeights();
+    float getLowResHeight(float localX, float localZ, Vec3 * normal) const;
+    /**the distance on the xz plane from a local position to the tile rectangle*/
+    float getTileDistance(int index, const Vec2& localPos) const;
+    void loadTile(int index);
+    void onTileLoaded(void * param);
+    void unloadTile(int index);
+
+    PagedTerrainData _data;
+    Terrain::CrackFixedType _crackFixedType;
+    std::vector<Tile> _tiles;
+    /**decoded tiles waiting to be turned into a Terrain*/
+    std::deque<TileRequest*> _readyTiles;
+    std::shared_ptr<const MappedFile> _rawFile;
+    int _rawWidth;
+    /**the world size of one tile along x and z*/
+    float _tileExtent;
+    int _residencyBudget;
+    float _loadDistance;
+    Camera * _camera;
+    std::vector<float> _lowResHeights;
+    int _lowResWidth;
+    int _lowResHeight;
+    float _lowResSpacing;
+    std::vector<std::pair<float, int>> _candidates;
+};
+
+// end of 3D group
+/// @}
+}
+
+#endif // CC_PAGED_TERRAIN_H
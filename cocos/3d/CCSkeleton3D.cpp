@@ -45,11 +45,15 @@ const Mat4& Bone3D::getInverseBindPose()
 void Bone3D::setOriPose(const Mat4& m)
 {
     _oriPose = m;
+    if (_skeleton)
+        _skeleton->_poseDirty = true;
 }
 
 void Bone3D::resetPose()
 {
     _local =_oriPose;
+    if (_skeleton)
+        _skeleton->_poseDirty = true;
     
     for (auto & it : _children) {
         it->resetPose();
@@ -93,6 +97,9 @@ const Mat4& Bone3D::getWorldMat()
 
 void Bone3D::setAnimationValue(float* trans, float* rot, float* scale, void* tag, float weight)
 {
+    if (_skeleton)
+        _skeleton->_poseDirty = true;
+    
     for (auto& it : _blendStates) {
         if (it.tag == tag)
         {
@@ -131,7 +138,7 @@ void Bone3D::clearBoneBlendState()
 void Bone3D::updateJointMatrix(Vec4* matrixPalette)
 {
     {
-        static Mat4 t;
+        Mat4 t;
         Mat4::multiply(_world, getInverseBindPose(), &t);
 
         matrixPalette[0].set(t.m[0], t.m[4], t.m[8], t.m[12]);
@@ -165,6 +172,7 @@ void Bone3D::addChildBone(Bone3D* bone)
 Bone3D::Bone3D(const std::string& id)
 : _name(id)
 , _parent(nullptr)
+, _skeleton(nullptr)
 , _worldDirty(true)
 {}
 
@@ -223,6 +231,8 @@ void Bone3D::updateLocalMat()
 Skeleton3D::Skeleton3D(const std::vector<NodeData*>& skeletondata)
 : _bones()
 , _rootBones()
+, _poseVersion(0)
+, _poseDirty(true)
 {
     for (const auto& it : skeletondata)
     {
@@ -275,10 +285,16 @@ int Skeleton3D::getBoneIndex(Bone3D* bone) const
 //refresh bone world matrix
 void Skeleton3D::updateBoneMatrix()
 {
+    // local matrices only change when bones are animated or reset, the world matrices are still valid otherwise
+    if (!_poseDirty)
+        return;
+    
+    _poseDirty = false;
     for (const auto & it : _rootBones) {
         it->setWorldMatDirty(true);
         it->updateWorldMat();
     }
+    ++_poseVersion;
 }
 
 Bone3D* Skeleton3D::createBone3D(const NodeData& nodedata)
@@ -293,6 +309,7 @@ Bone3D* Skeleton3D::createBone3D(const NodeData& nodedata)
     }
 
     bone->_oriPose = nodedata.transform;
+    bone->_skeleton = this;
     _bones.push_back( std::move( bone ));
 
     return _bones.back().get();
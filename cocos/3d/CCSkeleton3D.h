@@ -30,6 +30,8 @@
 
 namespace cocos2d {
 
+class Skeleton3D;
+
 /**
  * @addtogroup _3d
  * @{
@@ -156,6 +158,8 @@ protected:
     
     Bone3D* _parent; //parent bone
     
+    Skeleton3D* _skeleton; //skeleton owning the bone, told when the local matrix changes
+    
     std::vector<Bone3D*> _children;
     
     bool          _worldDirty;
@@ -172,6 +176,8 @@ protected:
  */
 class CC_DLL Skeleton3D
 {
+    friend class Bone3D;
+
 public:
     /**
      * @lua NA
@@ -189,9 +195,12 @@ public:
     /**get bone index*/
     int getBoneIndex(Bone3D* bone) const;
     
-    /**refresh bone world matrix*/
+    /**refresh bone world matrix, does nothing if no bone was animated or reset since the last refresh*/
     void updateBoneMatrix();
     
+    /**incremented each time the bone world matrices change*/
+    unsigned int getPoseVersion() const { return _poseVersion; }
+    
 private:
     
     /** create Bone3D from NodeData */
@@ -202,6 +211,10 @@ protected:
     std::vector<std::unique_ptr<Bone3D>> _bones;
 
     std::vector<Bone3D*> _rootBones;
+    
+    unsigned int _poseVersion;
+    
+    bool _poseDirty; //a bone local matrix changed since the last refresh
 };
 
 // end of 3d group
@@ -22,6 +22,7 @@
  ****************************************************************************/
 
 #include "3d/CCSprite3D.h"
+#include "3d/CCAnimate3D.h"
 #include "3d/CCObjLoader.h"
 #include "3d/CCMeshSkin.h"
 #include "3d/CCBundle3D.h"
@@ -31,13 +32,19 @@
 
 #include "base/CCDirector.h"
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCJobPool.h"
 #include "base/ccUTF8.h"
 #include "2d/CCAction.h"
 #include "2d/CCLight.h"
 #include "2d/CCCamera.h"
+#include "2d/CCScene.h"
+#include "3d/CCBoundingVolumeTree.h"
 #include "base/ccMacros.h"
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCImage.h"
 #include "renderer/CCTextureCache.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCGLProgramState.h"
@@ -46,9 +53,47 @@
 #include "renderer/CCTechnique.h"
 #include "renderer/CCPass.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace cocos2d {
 
-static std::shared_ptr<Material> getSprite3DMaterialForAttribs(const MeshVertexData * meshVertexData, bool usesLight);
+static std::shared_ptr<Material> getSprite3DMaterialForAttribs(const MeshVertexData * meshVertexData, bool usesLight, bool instanced);
+
+// decodes the textures of the materials in a loading thread
+static void decodeTextures(const MaterialDatas& materialdatas, std::vector<std::pair<std::string, Image*>>* images)
+{
+    auto fileUtils = FileUtils::getInstance();
+    for (const auto& material : materialdatas.materials)
+    {
+        for (const auto& texture : material.textures)
+        {
+            const auto& path = texture.filename;
+            // relative paths go through the FileUtils caches, ETC textures look up their alpha file when loaded
+            if (path.empty() || !fileUtils->isAbsolutePath(path) || fileUtils->getFileExtension(path) == ".pkm")
+                continue;
+            
+            auto decoded = std::find_if(images->begin(), images->end(), [&path](const std::pair<std::string, Image*>& image) {
+                return image.first == path;
+            });
+            if (decoded != images->end())
+                continue;
+            
+            auto image = new (std::nothrow) Image();
+            if (image && image->initWithImageFile(path))
+                images->emplace_back(path, image);
+            else
+                CC_SAFE_RELEASE(image);
+        }
+    }
+}
+
+std::vector<Sprite3D*> Sprite3D::s_skeletonUpdates;
+EventListenerCustom* Sprite3D::s_skeletonUpdateListener = nullptr;
+std::deque<Sprite3D*> Sprite3D::s_asyncUploads;
+std::unordered_map<std::string, std::vector<Sprite3D*>> Sprite3D::s_asyncLoads;
+EventListenerCustom* Sprite3D::s_asyncUploadListener = nullptr;
+float Sprite3D::s_asyncUploadBudget = 0.004f;
 
 Sprite3D* Sprite3D::create()
 {
@@ -109,16 +154,92 @@ void Sprite3D::createAsync(const std::string& modelPath, const std::string& text
     sprite->_asyncLoadParam.texPath = texturePath;
     sprite->_asyncLoadParam.modlePath = modelPath;
     sprite->_asyncLoadParam.callbackParam = callbackparam;
+    
+    // the model is already being loaded, the sprite is created from the cache afterwards
+    auto loading = s_asyncLoads.find(modelPath);
+    if (loading != s_asyncLoads.end())
+    {
+        loading->second.push_back(sprite);
+        return;
+    }
+    s_asyncLoads[modelPath];
+    
     sprite->_asyncLoadParam.materialdatas = new (std::nothrow) MaterialDatas();
     sprite->_asyncLoadParam.meshdatas = new (std::nothrow) MeshDatas();
     sprite->_asyncLoadParam.nodeDatas = new (std::nothrow) NodeDatas();
-    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_IO, CC_CALLBACK_1(Sprite3D::afterAsyncLoad, sprite), (void*)(&sprite->_asyncLoadParam), [sprite]()
+    // resolved in the main thread, the FileUtils caches aren't thread safe
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(modelPath);
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_DECODE, CC_CALLBACK_1(Sprite3D::queueAsyncUpload, sprite), (void*)(&sprite->_asyncLoadParam), [sprite, fullPath]()
     {
-        sprite->_asyncLoadParam.result = sprite->loadFromFile(sprite->_asyncLoadParam.modlePath, sprite->_asyncLoadParam.nodeDatas, sprite->_asyncLoadParam.meshdatas, sprite->_asyncLoadParam.materialdatas);
+        auto& param = sprite->_asyncLoadParam;
+        param.result = sprite->loadFromFile(fullPath, param.nodeDatas, param.meshdatas, param.materialdatas);
+        if (param.result)
+            decodeTextures(*param.materialdatas, &param.images);
     });
     
 }
 
+void Sprite3D::stopAsyncLoads()
+{
+    AsyncTaskPool::getInstance()->stopTasks(AsyncTaskPool::TaskType::TASK_DECODE);
+    // the loads in progress complete without waiting sprites
+    clearAsyncLoads();
+}
+
+void Sprite3D::clearAsyncLoads()
+{
+    // the waiting sprites were allocated by createAsync, nothing else holds them
+    for (auto& loading : s_asyncLoads)
+    {
+        for (auto sprite : loading.second)
+            sprite->release();
+    }
+    s_asyncLoads.clear();
+}
+
+void Sprite3D::queueAsyncUpload(void* /*param*/)
+{
+    if (!s_asyncUploadListener)
+    {
+        auto dispatcher = Director::getInstance()->getEventDispatcher();
+        s_asyncUploadListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [](EventCustom*) {
+            uploadAsyncLoads();
+        });
+        dispatcher->addCustomEventListener(Director::EVENT_RESET, [](EventCustom*) {
+            s_asyncUploadListener = nullptr;
+            for (auto sprite : s_asyncUploads)
+            {
+                auto& param = sprite->_asyncLoadParam;
+                for (auto& image : param.images)
+                    image.second->release();
+                CC_SAFE_DELETE(param.meshdatas);
+                CC_SAFE_DELETE(param.materialdatas);
+                CC_SAFE_DELETE(param.nodeDatas);
+                sprite->release();
+            }
+            s_asyncUploads.clear();
+            clearAsyncLoads();
+        });
+    }
+    
+    s_asyncUploads.push_back(this);
+}
+
+void Sprite3D::uploadAsyncLoads()
+{
+    auto start = std::chrono::steady_clock::now();
+    while (!s_asyncUploads.empty())
+    {
+        auto sprite = s_asyncUploads.front();
+        s_asyncUploads.pop_front();
+        sprite->afterAsyncLoad(&sprite->_asyncLoadParam);
+        
+        std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= s_asyncUploadBudget)
+            break;
+    }
+}
+
 void Sprite3D::afterAsyncLoad(void* param)
 {
     Sprite3D::AsyncLoadParam* asyncParam = (Sprite3D::AsyncLoadParam*)param;
@@ -132,6 +253,15 @@ void Sprite3D::afterAsyncLoad(void* param)
             _skeleton.reset();
             removeAllAttachNode();
             
+            // the textures decoded with the model are found in the cache by initFrom
+            auto textureCache = Director::getInstance()->getTextureCache();
+            for (auto& image : asyncParam->images)
+            {
+                textureCache->addImage(image.second, image.first);
+                image.second->release();
+            }
+            asyncParam->images.clear();
+            
             //create in the main thread
             auto& meshdatas = asyncParam->meshdatas;
             auto& materialdatas = asyncParam->materialdatas;
@@ -171,6 +301,28 @@ void Sprite3D::afterAsyncLoad(void* param)
             CCLOG("file load failed: %s ", asyncParam->modlePath.c_str());
         }
         asyncParam->afterLoadCallback(this, asyncParam->callbackParam);
+        
+        auto loading = s_asyncLoads.find(asyncParam->modlePath);
+        if (loading != s_asyncLoads.end())
+        {
+            auto waiting = std::move(loading->second);
+            s_asyncLoads.erase(loading);
+            for (auto sprite : waiting)
+            {
+                auto& param = sprite->_asyncLoadParam;
+                sprite->autorelease();
+                if (sprite->loadFromCache(param.modlePath))
+                {
+                    if (!param.texPath.empty())
+                        sprite->setTexture(param.texPath);
+                }
+                else
+                {
+                    CCLOG("file load failed: %s ", param.modlePath.c_str());
+                }
+                param.afterLoadCallback(sprite, param.callbackParam);
+            }
+        }
     }
 }
 
@@ -246,6 +398,8 @@ bool Sprite3D::loadFromFile(const std::string& path, NodeDatas* nodedatas, MeshD
             return false;
         }
         
+        // the payloads are uploaded straight from the mapped file
+        bundle->setMeshDataAliasing(true);
         auto ret = bundle->loadMeshDatas(*meshdatas)
             && bundle->loadMaterials(*materialdatas) && bundle->loadNodes(*nodedatas);
         Bundle3D::destroyBundle(bundle);
@@ -263,11 +417,22 @@ Sprite3D::Sprite3D()
 , _shaderUsingLight(false)
 , _forceDepthWrite(false)
 , _usingAutogeneratedGLProgram(true)
+, _instancingEnabled(false)
+, _skeletonUpdateRequested(false)
+, _drawnFrame(0)
+, _screenSize(1.0f)
+, _animationSkipped(false)
+, _cullingTree(nullptr)
+, _cullingProxy(-1)
 {
 }
 
 Sprite3D::~Sprite3D()
 {
+    if (_skeletonUpdateRequested)
+    {
+        s_skeletonUpdates.erase(std::find(s_skeletonUpdates.begin(), s_skeletonUpdates.end(), this));
+    }
     _meshes.clear();
     _meshVertexDatas.clear();
     removeAllAttachNode();
@@ -501,7 +666,7 @@ void Sprite3D::genMaterial(bool useLight)
     {
         auto meshVertexData = mesh->getMeshIndexData()->getMeshVertexData().get();
 
-        auto material = getSprite3DMaterialForAttribs(meshVertexData, useLight);
+        auto material = getSprite3DMaterialForAttribs(meshVertexData, useLight, _instancingEnabled);
 
         //keep original state block if exist
         auto oldmaterial = mesh->getMaterial();
@@ -722,6 +887,9 @@ void Sprite3D::visit(cocos2d::Renderer *renderer, const cocos2d::Mat4 &parentTra
     
     uint32_t flags = processParentFlags(parentTransform, parentFlags);
     flags |= FLAGS_RENDER_AS_3D;
+
+    if (_cullingTree && ((flags & FLAGS_TRANSFORM_DIRTY) || _aabbDirty))
+        _cullingTree->updateProxy(_cullingProxy, getAABB());
     
     //
     Director* director = Director::getInstance();
@@ -760,14 +928,49 @@ void Sprite3D::visit(cocos2d::Renderer *renderer, const cocos2d::Mat4 &parentTra
     director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
 }
 
+void Sprite3D::onEnter()
+{
+    Node::onEnter();
+    auto scene = getScene();
+    if (scene && scene->getCullingTree())
+        scene->getCullingTree()->addNode(this);
+}
+
+void Sprite3D::onExit()
+{
+    if (_cullingTree)
+        _cullingTree->removeNode(this);
+    Node::onExit();
+}
+
 void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
 #if CC_USE_CULLING
-    // camera clipping
-    if(getChildren().size() == 0 && Camera::getVisitingCamera() && !Camera::getVisitingCamera()->isVisibleInFrustum(&getAABB()))
-        return;
+    // camera clipping, answered by the culling tree of the scene when it has culled this camera
+    if(getChildren().size() == 0 && Camera::getVisitingCamera())
+    {
+        auto visibility = _cullingTree ? _cullingTree->getVisibility(_cullingProxy) : BoundingVolumeTree::Visibility::UNKNOWN;
+        if (visibility == BoundingVolumeTree::Visibility::CULLED)
+            return;
+        if (visibility == BoundingVolumeTree::Visibility::UNKNOWN && !Camera::getVisitingCamera()->isVisibleInFrustum(&getAABB()))
+            return;
+    }
 #endif
     
+    auto frame = Director::getInstance()->getTotalFrames();
+    if (_skeleton && !Animate3D::getLodLevels().empty() && Camera::getVisitingCamera())
+    {
+        // the largest size among the cameras drawing the sprite this frame
+        float screenSize = getScreenSize(Camera::getVisitingCamera());
+        _screenSize = _drawnFrame == frame ? std::max(_screenSize, screenSize) : screenSize;
+    }
+    _drawnFrame = frame;
+    if (_animationSkipped)
+    {
+        // back into view, catch up with the animation time before skinning
+        _animationSkipped = false;
+        Animate3D::evaluateSkipped(this);
+    }
     if (_skeleton)
         _skeleton->updateBoneMatrix();
     
@@ -806,6 +1009,67 @@ void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
     }
 }
 
+float Sprite3D::getScreenSize(const Camera* camera)
+{
+    const AABB& aabb = getAABB();
+    float radius = (aabb._max - aabb._min).length() * 0.5f;
+    const Mat4& projection = camera->getProjectionMatrix();
+    if (projection.m[11] == 0.0f)
+    {
+        // orthographic, the size does not depend on the distance
+        return radius * projection.m[5];
+    }
+    Mat4 cameraTransform = camera->getNodeToWorldTransform();
+    Vec3 eye(cameraTransform.m[12], cameraTransform.m[13], cameraTransform.m[14]);
+    Vec3 center((aabb._min + aabb._max) * 0.5f);
+    float distance = eye.distance(center);
+    return distance > radius ? radius * projection.m[5] / distance : 1.0f;
+}
+
+void Sprite3D::requestSkeletonUpdate()
+{
+    if (_skeletonUpdateRequested || !_skeleton)
+        return;
+    
+    if (!s_skeletonUpdateListener)
+    {
+        // the listeners are dropped with all the others when the director is reset
+        auto dispatcher = Director::getInstance()->getEventDispatcher();
+        s_skeletonUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [](EventCustom*) {
+            updateRequestedSkeletons();
+        });
+        dispatcher->addCustomEventListener(Director::EVENT_RESET, [](EventCustom*) {
+            s_skeletonUpdateListener = nullptr;
+            s_skeletonUpdates.clear();
+        });
+    }
+    
+    _skeletonUpdateRequested = true;
+    s_skeletonUpdates.push_back(this);
+}
+
+void Sprite3D::updateRequestedSkeletons()
+{
+    // sprites culled last frame are likely culled again, they are updated in draw if not
+    auto frame = Director::getInstance()->getTotalFrames();
+    JobPool::getInstance()->parallelFor(s_skeletonUpdates.size(), [frame](size_t index) {
+        auto sprite = s_skeletonUpdates[index];
+        if (!sprite->_skeleton || sprite->_drawnFrame + 1 < frame)
+            return;
+        
+        sprite->_skeleton->updateBoneMatrix();
+        for (const auto& mesh : sprite->_meshes)
+        {
+            if (mesh->getSkin())
+                mesh->getSkin()->getMatrixPalette();
+        }
+    });
+    
+    for (auto sprite : s_skeletonUpdates)
+        sprite->_skeletonUpdateRequested = false;
+    s_skeletonUpdates.clear();
+}
+
 void Sprite3D::setGLProgramState(GLProgramState* glProgramState)
 {
     Node::setGLProgramState(glProgramState);
@@ -935,6 +1199,16 @@ void Sprite3D::setForce2DQueue(bool force2D)
     }
 }
 
+void Sprite3D::setInstancingEnabled(bool enabled)
+{
+    if (_instancingEnabled == enabled)
+        return;
+
+    _instancingEnabled = enabled;
+    if (_usingAutogeneratedGLProgram)
+        genMaterial(_shaderUsingLight);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 Sprite3DCache* Sprite3DCache::_cacheInstance = nullptr;
 Sprite3DCache* Sprite3DCache::getInstance()
@@ -1001,7 +1275,7 @@ Sprite3DCache::~Sprite3DCache()
 //
 // MARK: Helpers
 //
-static std::shared_ptr<Material> getSprite3DMaterialForAttribs(const MeshVertexData * meshVertexData, bool usesLight)
+static std::shared_ptr<Material> getSprite3DMaterialForAttribs(const MeshVertexData * meshVertexData, bool usesLight, bool instanced)
 {
     bool textured = meshVertexData->hasVertexAttrib(GLProgram::VERTEX_ATTRIB_TEX_COORD);
     bool hasSkin = meshVertexData->hasVertexAttrib(GLProgram::VERTEX_ATTRIB_BLEND_INDEX)
@@ -1026,7 +1300,7 @@ static std::shared_ptr<Material> getSprite3DMaterialForAttribs(const MeshVertexD
     }
     
     return to_retaining_shared_ptr<Material>(
-        Sprite3DMaterial::createBuiltInMaterial(type, hasSkin)
+        Sprite3DMaterial::createBuiltInMaterial(type, hasSkin, instanced)
     );
 }
 
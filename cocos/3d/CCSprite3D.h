@@ -24,6 +24,7 @@
 #ifndef __CCSPRITE3D_H__
 #define __CCSPRITE3D_H__
 
+#include <deque>
 #include <unordered_map>
 
 #include "base/ccTypes.h"
@@ -48,10 +49,16 @@ class Mesh;
 class Texture2D;
 class MeshSkin;
 class AttachNode;
+class Camera;
+class BoundingVolumeTree;
+class EventListenerCustom;
+class Image;
 struct NodeData;
 /** @brief Sprite3D: A sprite can be loaded from 3D model files, .obj, .c3t, .c3b, then can be drawn as sprite */
 class CC_DLL Sprite3D : public Node
 {
+    friend class Animate3D;
+    friend class BoundingVolumeTree;
 public:
     /**
      * Creates an empty sprite3D without 3D model and texture.
@@ -68,7 +75,9 @@ public:
     
     /** create 3d sprite asynchronously
      * If the 3d model was previously loaded, it will create a new 3d sprite and the callback will be called at once.
-     * Otherwise it will load the model file in a new thread, and when the 3d sprite is loaded, the callback will be called with the created Sprite3D and a user-defined parameter.
+     * Otherwise it will load the model file and decode its textures on the AsyncTaskPool decode threads, several models
+     * being loaded concurrently, and when the 3d sprite is loaded, the callback will be called with the created Sprite3D and a user-defined parameter.
+     * The sprites requesting a model which is being loaded are created from the cache once it is loaded.
      * The callback will be called from the main thread, so it is safe to create any cocos2d object from the callback.
      * @param modelPath model to be loaded
      * @param callback callback after loading
@@ -78,6 +87,20 @@ public:
     
     static void createAsync(const std::string &modelPath, const std::string &texturePath, const std::function<void(Sprite3D*, void*)>& callback, void* callbackparam);
     
+    /**
+     * Drops the createAsync loads which haven't started yet and the sprites waiting for a model being loaded,
+     * their callbacks aren't called.
+     * Must be used instead of stopping the AsyncTaskPool decode tasks directly, to forget the pending models.
+     */
+    static void stopAsyncLoads();
+    
+    /**
+     * Sets the time spent each frame creating the GL objects of the models loaded by createAsync,
+     * at least one model is created per frame. 4 ms by default.
+     */
+    static void setAsyncUploadBudget(float seconds) { s_asyncUploadBudget = seconds; }
+    static float getAsyncUploadBudget() { return s_asyncUploadBudget; }
+    
     /**set diffuse texture, set the first if multiple textures exist*/
     void setTexture(const std::string& texFile);
     void setTexture(Texture2D* texture);
@@ -165,12 +188,28 @@ public:
     
     /**draw*/
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
+    
+    /**
+     * Queues the bone matrices and skin palettes to be refreshed once all nodes are updated.
+     * The queued sprites that were drawn last frame are refreshed together on the JobPool,
+     * the others when they are drawn. Called by Animate3D after setting the bone animation values.
+     */
+    void requestSkeletonUpdate();
+
+    /**
+     * Returns the fraction of the viewport height covered by the bounds of the sprite when it was last drawn,
+     * only measured while Animate3D level of detail is set up.
+     */
+    float getScreenSize() const { return _screenSize; }
 
     /**
      * Visits this Sprite3D's children and draw them recursively.
      * Note: all its children will rendered as 3D objects
      */
     virtual void visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags) override;
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
     
     /** Adds a new material to the sprite.
      The Material will be applied to all the meshes that belong to the sprite.
@@ -195,6 +234,15 @@ public:
     */
     void setForce2DQueue(bool force2D);
 
+    /**
+     * Draws the meshes with the instanced versions of the built in shaders, so the Renderer draws all the
+     * opaque meshes sharing a mesh and a texture with one draw call. Disabled by default.
+     * It applies to the auto generated materials of meshes without skin, and is worth it for many sprites
+     * loaded from the same model, like a forest or a crowd. The model should be scaled uniformly.
+     */
+    void setInstancingEnabled(bool enabled);
+    bool isInstancingEnabled() const { return _instancingEnabled; }
+
     /**
     * Get meshes used in sprite 3d
     */
@@ -236,9 +284,24 @@ private:
     void onAABBDirty() { _aabbDirty = true; }
     
     void afterAsyncLoad(void* param);
+    
+    /** queues the sprite loaded by createAsync for uploadAsyncLoads */
+    void queueAsyncUpload(void* param);
+    
+    /** creates the loaded sprites in the frame budget */
+    static void uploadAsyncLoads();
+    
+    /** forgets the models being loaded, the sprites waiting for them are released without calling their callbacks */
+    static void clearAsyncLoads();
 
     static AABB getAABBRecursivelyImp(Node *node);
     
+    /** refreshes the skeletons of the sprites queued by requestSkeletonUpdate */
+    static void updateRequestedSkeletons();
+
+    /** fraction of the viewport height covered by the bounds of the sprite as seen by camera */
+    float getScreenSize(const Camera* camera);
+    
 protected:
 
     std::shared_ptr<Skeleton3D>  _skeleton; //skeleton
@@ -256,6 +319,21 @@ protected:
     bool                         _shaderUsingLight; // is current shader using light ?
     bool                         _forceDepthWrite; // Always write to depth buffer
     bool                         _usingAutogeneratedGLProgram;
+    bool                         _instancingEnabled;
+    bool                         _skeletonUpdateRequested;
+    unsigned int                 _drawnFrame; // last frame the sprite passed culling
+    float                        _screenSize; // viewport height fraction covered in _drawnFrame
+    bool                         _animationSkipped; // Animate3D skipped evaluating curves since last drawn
+    BoundingVolumeTree*          _cullingTree; // culling tree of the scene, when it's enabled
+    int                          _cullingProxy;
+    
+    static std::vector<Sprite3D*> s_skeletonUpdates; // sprites requesting a skeleton update this frame
+    static EventListenerCustom*   s_skeletonUpdateListener;
+    
+    static std::deque<Sprite3D*>  s_asyncUploads; // sprites loaded by createAsync, waiting for their GL objects
+    static std::unordered_map<std::string, std::vector<Sprite3D*>> s_asyncLoads; // models being loaded, with the sprites waiting for them
+    static EventListenerCustom*   s_asyncUploadListener;
+    static float                  s_asyncUploadBudget;
     
     struct AsyncLoadParam
     {
@@ -267,6 +345,7 @@ protected:
         MeshDatas* meshdatas;
         MaterialDatas* materialdatas;
         NodeDatas*   nodeDatas;
+        std::vector<std::pair<std::string, Image*>> images; // textures decoded with the model, by full path
     };
     AsyncLoadParam             _asyncLoadParam;
     
@@ -50,6 +50,11 @@ Sprite3DMaterial* Sprite3DMaterial::_vertexLitMaterialSkin = nullptr;
 Sprite3DMaterial* Sprite3DMaterial::_diffuseMaterialSkin = nullptr;
 Sprite3DMaterial* Sprite3DMaterial::_bumpedDiffuseMaterialSkin = nullptr;
 
+Sprite3DMaterial* Sprite3DMaterial::_unLitMaterialInstanced = nullptr;
+Sprite3DMaterial* Sprite3DMaterial::_unLitNoTexMaterialInstanced = nullptr;
+Sprite3DMaterial* Sprite3DMaterial::_diffuseMaterialInstanced = nullptr;
+Sprite3DMaterial* Sprite3DMaterial::_diffuseNoTexMaterialInstanced = nullptr;
+
 void Sprite3DMaterial::createBuiltInMaterial()
 {
     releaseBuiltInMaterial();
@@ -117,6 +122,38 @@ void Sprite3DMaterial::createBuiltInMaterial()
     {
         _bumpedDiffuseMaterialSkin->_type = Sprite3DMaterial::MaterialType::BUMPED_DIFFUSE;
     }
+
+    glProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED);
+    glprogramstate = GLProgramState::create(glProgram);
+    _unLitMaterialInstanced = new (std::nothrow) Sprite3DMaterial();
+    if (_unLitMaterialInstanced && _unLitMaterialInstanced->initWithGLProgramState(glprogramstate))
+    {
+        _unLitMaterialInstanced->_type = Sprite3DMaterial::MaterialType::UNLIT;
+    }
+
+    glProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_3D_POSITION_INSTANCED);
+    glprogramstate = GLProgramState::create(glProgram);
+    _unLitNoTexMaterialInstanced = new (std::nothrow) Sprite3DMaterial();
+    if (_unLitNoTexMaterialInstanced && _unLitNoTexMaterialInstanced->initWithGLProgramState(glprogramstate))
+    {
+        _unLitNoTexMaterialInstanced->_type = Sprite3DMaterial::MaterialType::UNLIT_NOTEX;
+    }
+
+    glProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_3D_POSITION_NORMAL_TEXTURE_INSTANCED);
+    glprogramstate = GLProgramState::create(glProgram);
+    _diffuseMaterialInstanced = new (std::nothrow) Sprite3DMaterial();
+    if (_diffuseMaterialInstanced && _diffuseMaterialInstanced->initWithGLProgramState(glprogramstate))
+    {
+        _diffuseMaterialInstanced->_type = Sprite3DMaterial::MaterialType::DIFFUSE;
+    }
+
+    glProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_3D_POSITION_NORMAL_INSTANCED);
+    glprogramstate = GLProgramState::create(glProgram);
+    _diffuseNoTexMaterialInstanced = new (std::nothrow) Sprite3DMaterial();
+    if (_diffuseNoTexMaterialInstanced && _diffuseNoTexMaterialInstanced->initWithGLProgramState(glprogramstate))
+    {
+        _diffuseNoTexMaterialInstanced->_type = Sprite3DMaterial::MaterialType::DIFFUSE_NOTEX;
+    }
 }
 
 void Sprite3DMaterial::releaseBuiltInMaterial()
@@ -133,6 +170,11 @@ void Sprite3DMaterial::releaseBuiltInMaterial()
     CC_SAFE_RELEASE_NULL(_vertexLitMaterialSkin);
     CC_SAFE_RELEASE_NULL(_diffuseMaterialSkin);
     CC_SAFE_RELEASE_NULL(_bumpedDiffuseMaterialSkin);
+
+    CC_SAFE_RELEASE_NULL(_unLitMaterialInstanced);
+    CC_SAFE_RELEASE_NULL(_unLitNoTexMaterialInstanced);
+    CC_SAFE_RELEASE_NULL(_diffuseMaterialInstanced);
+    CC_SAFE_RELEASE_NULL(_diffuseNoTexMaterialInstanced);
 }
 
 void Sprite3DMaterial::releaseCachedMaterial()
@@ -170,20 +212,23 @@ Sprite3DMaterial* Sprite3DMaterial::clone() const
     return material;
 }
 
-Sprite3DMaterial* Sprite3DMaterial::createBuiltInMaterial(MaterialType type, bool skinned)
+Sprite3DMaterial* Sprite3DMaterial::createBuiltInMaterial(MaterialType type, bool skinned, bool instanced)
 {
     /////
     if (_diffuseMaterial == nullptr)
         createBuiltInMaterial();
     
+    // the skinned shaders have no instanced version
+    instanced = instanced && !skinned;
+
     Sprite3DMaterial* material = nullptr;
     switch (type) {
         case Sprite3DMaterial::MaterialType::UNLIT:
-            material = skinned ? _unLitMaterialSkin : _unLitMaterial;
+            material = skinned ? _unLitMaterialSkin : (instanced ? _unLitMaterialInstanced : _unLitMaterial);
             break;
             
         case Sprite3DMaterial::MaterialType::UNLIT_NOTEX:
-            material = _unLitNoTexMaterial;
+            material = instanced ? _unLitNoTexMaterialInstanced : _unLitNoTexMaterial;
             break;
             
         case Sprite3DMaterial::MaterialType::VERTEX_LIT:
@@ -191,11 +236,11 @@ Sprite3DMaterial* Sprite3DMaterial::createBuiltInMaterial(MaterialType type, boo
             break;
             
         case Sprite3DMaterial::MaterialType::DIFFUSE:
-            material = skinned ? _diffuseMaterialSkin : _diffuseMaterial;
+            material = skinned ? _diffuseMaterialSkin : (instanced ? _diffuseMaterialInstanced : _diffuseMaterial);
             break;
             
         case Sprite3DMaterial::MaterialType::DIFFUSE_NOTEX:
-            material = _diffuseNoTexMaterial;
+            material = instanced ? _diffuseNoTexMaterialInstanced : _diffuseNoTexMaterial;
             break;
             
         case Sprite3DMaterial::MaterialType::BUMPED_DIFFUSE:
@@ -73,9 +73,11 @@ public:
      * Create built in material from material type
      * @param type Material type
      * @param skinned Has skin?
+     * @param instanced Use the instanced shader? It exists for the unlit and diffuse materials without skin,
+     * the others ignore it. See GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED
      * @return Created material
      */
-    static Sprite3DMaterial* createBuiltInMaterial(MaterialType type, bool skinned);
+    static Sprite3DMaterial* createBuiltInMaterial(MaterialType type, bool skinned, bool instanced = false);
     
     /**
      * Create material with file name, it creates material from cache if it is previously loaded
@@ -128,6 +130,11 @@ protected:
     static Sprite3DMaterial* _vertexLitMaterialSkin;
     static Sprite3DMaterial* _diffuseMaterialSkin;
     static Sprite3DMaterial* _bumpedDiffuseMaterialSkin;
+
+    static Sprite3DMaterial* _unLitMaterialInstanced;
+    static Sprite3DMaterial* _unLitNoTexMaterialInstanced;
+    static Sprite3DMaterial* _diffuseMaterialInstanced;
+    static Sprite3DMaterial* _diffuseNoTexMaterialInstanced;
 };
 
 /**
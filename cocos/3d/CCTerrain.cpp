@@ -37,6 +37,7 @@ using namespace cocos2d;
 #include "renderer/CCRenderState.h"
 #include "base/CCDirector.h"
 #include "base/CCEventType.h"
+#include "base/CCJobPool.h"
 #include "2d/CCCamera.h"
 #include "platform/CCImage.h"
 
@@ -62,7 +63,33 @@ Terrain * Terrain::create(TerrainData &parameter, CrackFixedType fixedType)
     CC_SAFE_DELETE(terrain);
     return terrain;
 }
+
+Terrain * Terrain::create(TerrainData &parameter, Image * heightMap, CrackFixedType fixedType)
+{
+    Terrain * terrain = new (std::nothrow)Terrain();
+    if (terrain->initWithTerrainData(parameter, heightMap, fixedType))
+    {
+        terrain->autorelease();
+        return terrain;
+    }
+    CC_SAFE_DELETE(terrain);
+    return terrain;
+}
+
 bool Terrain::initWithTerrainData(TerrainData &parameter, CrackFixedType fixedType)
+{
+    auto heightMap = new (std::nothrow) Image();
+    if (nullptr == heightMap)
+    {
+        return false;
+    }
+    bool initResult = heightMap->initWithImageFile(parameter._heightMapSrc)
+        && initWithTerrainData(parameter, heightMap, fixedType);
+    heightMap->release();
+    return initResult;
+}
+
+bool Terrain::initWithTerrainData(TerrainData &parameter, Image * heightMap, CrackFixedType fixedType)
 {
     this->setSkirtHeightRatio(parameter._skirtHeightRatio);
     this->_terrainData = parameter;
@@ -73,7 +100,7 @@ bool Terrain::initWithTerrainData(TerrainData &parameter, CrackFixedType fixedTy
     bool initResult = true;
 
     //init heightmap
-    initResult &= this->initHeightMap(parameter._heightMapSrc);
+    initResult &= this->initHeightMap(heightMap);
     //init textures alpha map,detail Maps
     initResult &= this->initTextures();
     initResult &= this->initProperties();
@@ -208,6 +235,7 @@ void Terrain::onDraw(const Mat4 &transform, uint32_t /*flags*/)
             _quadRoot->cullByCamera(camera, _terrainModelMatrix);
         }
     }
+    updateChunksLOD();
     _quadRoot->draw();
     if(_isCameraViewChanged)
     {
@@ -225,8 +253,17 @@ void Terrain::onDraw(const Mat4 &transform, uint32_t /*flags*/)
 
 bool Terrain::initHeightMap(const std::string& heightMap)
 {
-    _heightMapImage = new (std::nothrow) Image();
-    _heightMapImage->initWithImageFile(heightMap);
+    auto image = new (std::nothrow) Image();
+    image->initWithImageFile(heightMap);
+    bool result = initHeightMap(image);
+    image->release();
+    return result;
+}
+
+bool Terrain::initHeightMap(Image * heightMap)
+{
+    _heightMapImage = heightMap;
+    _heightMapImage->retain();
     _data = _heightMapImage->getData();
     _imageWidth =_heightMapImage->getWidth();
     _imageHeight =_heightMapImage->getHeight();
@@ -247,9 +284,26 @@ bool Terrain::initHeightMap(const std::string& heightMap)
                 _chunkesArray[m][n] = new (std::nothrow) Chunk();
                 _chunkesArray[m][n]->_terrain = this;
                 _chunkesArray[m][n]->_size = _chunkSize;
-                _chunkesArray[m][n]->generate(_imageWidth,_imageHeight,m,n,_data);
             }
         }
+        //the chunks only read the shared vertices, so their CPU data is built in parallel
+        JobPool::getInstance()->parallelFor(chunk_amount_y*chunk_amount_x, [this, chunk_amount_x](size_t index) {
+            int m = (int)index/chunk_amount_x;
+            int n = (int)index%chunk_amount_x;
+            _chunkesArray[m][n]->generate(_imageWidth,_imageHeight,m,n,_data);
+        });
+        //the GL buffers have to be created on this thread
+        for(int m =0;m<chunk_amount_y;m++)
+        {
+            for(int n =0; n<chunk_amount_x;n++)
+            {
+                _chunkesArray[m][n]->finish();
+            }
+        }
+        if(chunk_amount_y>0 && chunk_amount_x>0)
+        {
+            memcpy(_skirtVerticesOffset,_chunkesArray[chunk_amount_y-1][chunk_amount_x-1]->_skirtVerticesOffset,sizeof(_skirtVerticesOffset));
+        }
 
         //calculate the neighbor
         for(int m =0;m<chunk_amount_y;m++)
@@ -316,6 +370,36 @@ void Terrain::setChunksLOD(const Vec3& cameraPos)
         }
 }
 
+void Terrain::updateChunksLOD()
+{
+    int chunk_amount_y = _imageHeight/_chunkSize.height;
+    int chunk_amount_x = _imageWidth/_chunkSize.width;
+    _lodChunks.clear();
+    for(int m=0;m<chunk_amount_y;m++)
+        for(int n =0;n<chunk_amount_x;n++)
+        {
+            auto chunk = _chunkesArray[m][n];
+            if(chunk->_parent->_needDraw && (_isCameraViewChanged || chunk->_oldLod <0))
+            {
+                _lodChunks.push_back(chunk);
+            }
+        }
+    if(_lodChunks.empty())
+    {
+        return;
+    }
+
+    //the index & vertex rebuilds only read the LOD cache, which is not modified until commitLOD
+    JobPool::getInstance()->parallelFor(_lodChunks.size(), [this](size_t index) {
+        _lodChunks[index]->prepareLOD();
+    });
+    //upload every chunk before drawing, so the whole terrain switches LOD in the same frame
+    for(auto chunk : _lodChunks)
+    {
+        chunk->commitLOD();
+    }
+}
+
 float Terrain::getHeight(float x, float z, Vec3 * normal) const
 {
     Vec2 pos(x,z);
@@ -380,6 +464,7 @@ float Terrain::getImageHeight(int pixel_x,int pixel_y) const
     switch (_heightMapImage->getRenderFormat())
     {
     case Texture2D::PixelFormat::BGRA8888:
+    case Texture2D::PixelFormat::RGBA8888:
         byte_stride = 4;
         break;
     case  Texture2D::PixelFormat::RGB888:
@@ -396,63 +481,84 @@ float Terrain::getImageHeight(int pixel_x,int pixel_y) const
 
 void Terrain::loadVertices()
 {
-    _maxHeight = -99999;
-    _minHeight = 99999;
-    for(int i =0;i<_imageHeight;++i)
-    {
+    // each row writes its own slice of _vertices, the height range is reduced afterwards
+    _vertices.resize(_imageWidth*_imageHeight);
+    std::vector<float> rowMax(_imageHeight);
+    std::vector<float> rowMin(_imageHeight);
+    JobPool::getInstance()->parallelFor(_imageHeight, [this, &rowMax, &rowMin](size_t row) {
+        int i = (int)row;
+        float maxHeight = -99999;
+        float minHeight = 99999;
         for(int j =0;j<_imageWidth;j++)
         {
             float height = getImageHeight(j,i);
-            TerrainVertexData v;
+            TerrainVertexData& v = _vertices[i*_imageWidth + j];
             v._position = Vec3(j*_terrainData._mapScale- _imageWidth/2*_terrainData._mapScale, //x
                 height, //y
                 i*_terrainData._mapScale - _imageHeight/2*_terrainData._mapScale);//z
             v._texcoord = Tex2F(j*1.0/_imageWidth,i*1.0/_imageHeight);
-            _vertices.push_back (v);
 
             //update the min & max height;
-            if(height>_maxHeight) _maxHeight = height;
-            if(height<_minHeight) _minHeight = height;
+            if(height>maxHeight) maxHeight = height;
+            if(height<minHeight) minHeight = height;
         }
+        rowMax[row] = maxHeight;
+        rowMin[row] = minHeight;
+    });
+
+    _maxHeight = -99999;
+    _minHeight = 99999;
+    for(int i =0;i<_imageHeight;++i)
+    {
+        if(rowMax[i]>_maxHeight) _maxHeight = rowMax[i];
+        if(rowMin[i]<_minHeight) _minHeight = rowMin[i];
     }
 }
 
 void Terrain::calculateNormal()
 {
-    _indices.clear();
-    //we generate whole terrain indices(global indices) for correct normal calculate
-    for(int i =0;i<_imageHeight-1;i+=1)
-    {
-        for(int j = 0;j<_imageWidth-1;j+=1)
+    // The grid is triangulated per quad as (p, p+w, p+1) and (p+1, p+w, p+w+1).
+    // Instead of scattering each face normal to its three corners, every vertex gathers
+    // the normals of the up to six faces around it, so rows can be processed in parallel.
+    auto faceNormal = [this](int index0, int index1, int index2) {
+        Vec3 v1 = _vertices[index1]._position - _vertices[index0]._position;
+        Vec3 v2 = _vertices[index2]._position - _vertices[index0]._position;
+        Vec3 normal;
+        Vec3::cross(v1,v2,&normal);
+        normal.normalize();
+        return normal;
+    };
+
+    const int width = _imageWidth;
+    const int height = _imageHeight;
+    JobPool::getInstance()->parallelFor(height, [this, width, height, &faceNormal](size_t row) {
+        int i = (int)row;
+        for(int j =0;j<width;j++)
         {
-
-            int nLocIndex = i * _imageWidth + j;
-            _indices.push_back (nLocIndex);
-            _indices.push_back (nLocIndex + _imageWidth);
-            _indices.push_back (nLocIndex + 1);
-
-            _indices.push_back (nLocIndex + 1);
-            _indices.push_back (nLocIndex + _imageWidth);
-            _indices.push_back (nLocIndex + _imageWidth+1);
+            int p = i*width + j;
+            Vec3 normal;
+            if(i<height-1 && j<width-1)
+            {
+                normal += faceNormal(p, p+width, p+1);
+            }
+            if(i<height-1 && j>0)
+            {
+                normal += faceNormal(p-1, p-1+width, p);
+                normal += faceNormal(p, p-1+width, p+width);
+            }
+            if(i>0 && j<width-1)
+            {
+                normal += faceNormal(p-width, p, p-width+1);
+                normal += faceNormal(p-width+1, p, p+1);
+            }
+            if(i>0 && j>0)
+            {
+                normal += faceNormal(p-width, p-1, p);
+            }
+            normal.normalize();
+            _vertices[p]._normal = normal;
         }
-    }
-    for (unsigned int i = 0, size = _indices.size(); i < size; i += 3) {
-        unsigned int Index0 = _indices[i];
-        unsigned int Index1 = _indices[i + 1];
-        unsigned int Index2 = _indices[i + 2];
-        Vec3 v1 = _vertices[Index1]._position - _vertices[Index0]._position;
-        Vec3 v2 = _vertices[Index2]._position - _vertices[Index0]._position;
-        Vec3 Normal;
-        Vec3::cross(v1,v2,&Normal);
-        Normal.normalize();
-        _vertices[Index0]._normal += Normal;
-        _vertices[Index1]._normal += Normal;
-        _vertices[Index2]._normal += Normal;
-    }
-
-    for (unsigned int i = 0, size = _vertices.size(); i < size; ++i) {
-        _vertices[i]._normal.normalize();
-    }
+    });
     //global indices no need at all
     _indices.clear();
 }
@@ -925,8 +1031,6 @@ void Terrain::Chunk::finish()
 
     glBindBuffer(GL_ARRAY_BUFFER,0);
 
-    calculateSlope();
-
     for(int i =0;i<4;++i)
     {
         int step = 1<<_currentLod;
@@ -936,27 +1040,61 @@ void Terrain::Chunk::finish()
         _lod[i]._indices.reserve(indicesAmount);
     }
     _oldLod = -1;
+    _pendingVertices = false;
+    _pendingIndices = false;
 }
 
-void Terrain::Chunk::bindAndDraw()
+void Terrain::Chunk::prepareLOD()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    if(_terrain->_isCameraViewChanged || _oldLod <0)
+    switch (_terrain->_crackFixedType)
     {
-        switch (_terrain->_crackFixedType)
-        {
-        case CrackFixedType::SKIRT:
+    case CrackFixedType::SKIRT:
+        updateIndicesLODSkirt();
+        break;
+    case CrackFixedType::INCREASE_LOWER:
+        updateVerticesForLOD();
+        updateIndicesLOD();
+        break;
+    default:
+        break;
+    }
+}
 
-            updateIndicesLODSkirt();
-            break;
-        case CrackFixedType::INCREASE_LOWER:
-            updateVerticesForLOD();
-            updateIndicesLOD();
-            break;
-        default:
-            break;
+void Terrain::Chunk::commitLOD()
+{
+    if(_pendingVertices)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(TerrainVertexData)*_currentVertices.size(), &_currentVertices[0], GL_STREAM_DRAW);
+        _pendingVertices = false;
+    }
+    if(_pendingIndices)
+    {
+        //another chunk may have inserted the same indices during this commit
+        bool isOk;
+        auto& indices = _lod[_currentLod]._indices;
+        if(_terrain->_crackFixedType == CrackFixedType::SKIRT)
+        {
+            _chunkIndices = _terrain->lookForIndicesLODSkrit(_currentLod,&isOk);
+            if(!isOk)
+            {
+                _chunkIndices = _terrain->insertIndicesLODSkirt(_currentLod,&indices[0],(int)indices.size());
+            }
+        }else
+        {
+            _chunkIndices = _terrain->lookForIndicesLOD(_neighborOldLOD,_currentLod,&isOk);
+            if(!isOk)
+            {
+                _chunkIndices = _terrain->insertIndicesLOD(_neighborOldLOD,_currentLod,&indices[0],(int)indices.size());
+            }
         }
+        _pendingIndices = false;
     }
+}
+
+void Terrain::Chunk::bindAndDraw()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,_chunkIndices._indices);
     unsigned long offset = 0;
     //position
@@ -975,6 +1113,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
 {
     _posY = m;
     _posX = n;
+    _originalVertices.reserve((size_t)((_size.height+1)*(_size.width+1) + 2*(_size.height+1) + 2*(_size.width+1)));
     switch (_terrain->_crackFixedType)
     {
     case CrackFixedType::SKIRT:
@@ -993,7 +1132,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
 
             float skirtHeight =  _terrain->_skirtRatio *_terrain->_terrainData._mapScale*8;
             //#1
-            _terrain->_skirtVerticesOffset[0] = (int)_originalVertices.size();
+            _skirtVerticesOffset[0] = (int)_originalVertices.size();
             for(int i =_size.height*m;i<=_size.height*(m+1);++i)
             {
                 auto v = _terrain->_vertices[i*imgWidth +_size.width*(n+1)];
@@ -1002,7 +1141,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
             }
 
             //#2
-            _terrain->_skirtVerticesOffset[1] = (int)_originalVertices.size();
+            _skirtVerticesOffset[1] = (int)_originalVertices.size();
             for(int j =_size.width*n;j<=_size.width*(n+1);j++)
             {
                 auto v = _terrain->_vertices[_size.height*(m+1)*imgWidth + j];
@@ -1011,7 +1150,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
             }
 
             //#3
-            _terrain->_skirtVerticesOffset[2] = (int)_originalVertices.size();
+            _skirtVerticesOffset[2] = (int)_originalVertices.size();
             for(int i =_size.height*m;i<=_size.height*(m+1);++i)
             {
                 auto v = _terrain->_vertices[i*imgWidth + _size.width*n];
@@ -1020,7 +1159,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
             }
 
             //#4
-            _terrain->_skirtVerticesOffset[3] = (int)_originalVertices.size();
+            _skirtVerticesOffset[3] = (int)_originalVertices.size();
             for(int j =_size.width*n;j<=_size.width*(n+1);j++)
             {
                 auto v = _terrain->_vertices[_size.height*m*imgWidth+j];
@@ -1046,6 +1185,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
         break;
     }
     //store triangle:
+    _trianglesList.reserve((size_t)(_size.height*_size.width*2));
     for (int i = 0; i < _size.height; ++i)
     {
         for (int j = 0; j < _size.width; j++)
@@ -1060,7 +1200,7 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
     }
 
     calculateAABB();
-    finish();
+    calculateSlope();
 }
 
 Terrain::Chunk::Chunk()
@@ -1071,9 +1211,12 @@ Terrain::Chunk::Chunk()
     _back = nullptr;
     _front = nullptr;
     _oldLod = -1;
+    _pendingVertices = false;
+    _pendingIndices = false;
     for(int i =0;i<4;++i)
     {
         _neighborOldLOD[i] = -1;
+        _skirtVerticesOffset[i] = 0;
     }
 }
 
@@ -1258,7 +1401,7 @@ void Terrain::Chunk::updateIndicesLOD()
             }
         }
 
-        _chunkIndices = _terrain->insertIndicesLOD(currentNeighborLOD,_currentLod,&_lod[_currentLod]._indices[0],(int)_lod[_currentLod]._indices.size());
+        _pendingIndices = true;
     }else{
         //No lod difference, use simple method
         _lod[_currentLod]._indices.clear();
@@ -1277,7 +1420,7 @@ void Terrain::Chunk::updateIndicesLOD()
                 _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1) + step);
             }
         }
-        _chunkIndices = _terrain->insertIndicesLOD(currentNeighborLOD,_currentLod,&_lod[_currentLod]._indices[0],(int)_lod[_currentLod]._indices.size());
+        _pendingIndices = true;
     }
 }
 
@@ -1370,7 +1513,7 @@ void Terrain::Chunk::updateVerticesForLOD()
             }
     }
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(TerrainVertexData)*_currentVertices.size(), &_currentVertices[0], GL_STREAM_DRAW);
+    _pendingVertices = true;
     _oldLod = _currentLod;
 }
 
@@ -1391,6 +1534,7 @@ void Terrain::Chunk::updateIndicesLODSkirt()
     int gridX = _size.width;
     int step = 1<<_currentLod;
     int k =0;
+    _lod[_currentLod]._indices.clear();
     for(int i =0;i<gridY;i+=step,k+=step)
     {
         for(int j = 0;j<gridX;j+=step)
@@ -1424,12 +1568,12 @@ void Terrain::Chunk::updateIndicesLODSkirt()
     {
         int nLocIndex = (gridY)* (gridX+1) + j;
         _lod[_currentLod]._indices.push_back (nLocIndex);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[1] +j);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[1] +j);
         _lod[_currentLod]._indices.push_back (nLocIndex + step);
 
         _lod[_currentLod]._indices.push_back (nLocIndex + step);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[1] +j);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[1] +j + step);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[1] +j);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[1] +j + step);
     }
 
     //#3
@@ -1437,12 +1581,12 @@ void Terrain::Chunk::updateIndicesLODSkirt()
     {
         int nLocIndex = i * (gridX+1);
         _lod[_currentLod]._indices.push_back (nLocIndex);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[2]+i);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[2]+i);
         _lod[_currentLod]._indices.push_back ((i+step)*(gridX+1));
 
         _lod[_currentLod]._indices.push_back ((i+step)*(gridX+1));
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[2]+i);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[2]+i +step);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[2]+i);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[2]+i +step);
     }
 
     //#4
@@ -1450,16 +1594,16 @@ void Terrain::Chunk::updateIndicesLODSkirt()
     {
         int nLocIndex = j;
         _lod[_currentLod]._indices.push_back (nLocIndex + step);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[3]+j);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[3]+j);
         _lod[_currentLod]._indices.push_back (nLocIndex);
 
 
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[3] + j + step);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[3] +j);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[3] + j + step);
+        _lod[_currentLod]._indices.push_back (_skirtVerticesOffset[3] +j);
         _lod[_currentLod]._indices.push_back (nLocIndex + step);
     }
 
-    _chunkIndices = _terrain->insertIndicesLODSkirt(_currentLod,&_lod[_currentLod]._indices[0], (int)_lod[_currentLod]._indices.size());
+    _pendingIndices = true;
 }
 
 Terrain::QuadTree::QuadTree(int x, int y, int w, int h, Terrain * terrain)
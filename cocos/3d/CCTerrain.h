@@ -214,7 +214,7 @@ private:
         LOD _lod[4];
         /**AABB in local space*/
         AABB _aabb;
-        /**setup Chunk data*/
+        /**setup Chunk data, only touches the CPU side so it can run on a worker thread*/
         void generate(int map_width, int map_height, int m, int n, const unsigned char * data);
         /**calculateAABB*/
         void calculateAABB();
@@ -229,6 +229,11 @@ private:
 
         void updateIndicesLODSkirt();
 
+        /**rebuild the LOD vertices & indices on the CPU, safe to run on a worker thread*/
+        void prepareLOD();
+        /**upload the results of prepareLOD, must run on the GL thread*/
+        void commitLOD();
+
         /**calculate the average slop of chunk*/
         void calculateSlope();
 
@@ -240,6 +245,11 @@ private:
         int _oldLod;
 
         int _neighborOldLOD[4];
+        /**prepareLOD produced vertices or indices which commitLOD has not uploaded yet*/
+        bool _pendingVertices;
+        bool _pendingIndices;
+        /**where each of the four skirts starts in _originalVertices*/
+        int _skirtVerticesOffset[4];
         /*the left,right,front,back neighbors*/
         Chunk * _left;
         Chunk * _right;
@@ -317,10 +327,16 @@ public:
     bool initProperties();
     /**initialize heightMap data */
     bool initHeightMap(const std::string& heightMap);
+    /**initialize heightMap data from an already decoded image, the image is retained */
+    bool initHeightMap(Image * heightMap);
     /**initialize alphaMap ,detailMaps textures*/
     bool initTextures();
     /**create entry*/
     static Terrain * create(TerrainData &parameter, CrackFixedType fixedType = CrackFixedType::INCREASE_LOWER);
+    /**create entry, the height map is an already decoded image and parameter._heightMapSrc is ignored.
+     * It lets the height map be decoded on another thread, see PagedTerrain.
+     */
+    static Terrain * create(TerrainData &parameter, Image * heightMap, CrackFixedType fixedType = CrackFixedType::INCREASE_LOWER);
     /**get specified position's height mapping to the terrain,use bi-linear interpolation method
      * @param x the X position
      * @param z the Z position
@@ -435,6 +451,7 @@ protected:
     Terrain();
     virtual ~Terrain();
     bool initWithTerrainData(TerrainData &parameter, CrackFixedType fixedType);
+    bool initWithTerrainData(TerrainData &parameter, Image * heightMap, CrackFixedType fixedType);
 protected:
     void onDraw(const Mat4 &transform, uint32_t flags);
 
@@ -444,6 +461,11 @@ protected:
      **/
     void setChunksLOD(const Vec3& cameraPos);
 
+    /**
+     * rebuild the LOD data of the visible chunks on the job pool, then upload it
+     **/
+    void updateChunksLOD();
+
     /**
      * load Vertices from height filed for the whole terrain.
      **/
@@ -491,6 +513,7 @@ protected:
     Chunk * _chunkesArray[MAX_CHUNKES][MAX_CHUNKES];
     std::vector<TerrainVertexData> _vertices;
     std::vector<unsigned int> _indices;
+    std::vector<Chunk*> _lodChunks;
     int _imageWidth;
     int _imageHeight;
     Size _chunkSize;
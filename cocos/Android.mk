@@ -89,6 +89,7 @@ cocos2d.cpp \
 platform/CCFileUtils.cpp \
 platform/CCGLView.cpp \
 platform/CCImage.cpp \
+platform/CCMappedFile.cpp \
 platform/CCSAXParser.cpp \
 platform/CCThread.cpp \
 $(MATHNEONFILE) \
@@ -129,6 +130,7 @@ base/CCEventListenerTouch.cpp \
 base/CCEventMouse.cpp \
 base/CCEventTouch.cpp \
 base/CCIMEDispatcher.cpp \
+base/CCJobPool.cpp \
 base/CCNS.cpp \
 base/CCProfiling.cpp \
 base/CCProperties.cpp \
@@ -24,6 +24,7 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "base/CCAsyncTaskPool.h"
+#include "base/ccConfig.h"
 
 namespace cocos2d {
 
@@ -46,6 +47,17 @@ void AsyncTaskPool::destroyInstance()
 
 AsyncTaskPool::AsyncTaskPool()
 {
+    unsigned int decodeThreads = CC_ASYNC_DECODE_THREADS;
+    if (decodeThreads == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        decodeThreads = cores > 1 ? cores - 1 : 1;
+    }
+    
+    for (int i = 0; i < int(TaskType::TASK_MAX_TYPE); ++i)
+    {
+        _threadTasks[i].start(i == int(TaskType::TASK_DECODE) ? decodeThreads : 1);
+    }
 }
 
 AsyncTaskPool::~AsyncTaskPool()
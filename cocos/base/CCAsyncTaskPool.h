@@ -59,6 +59,7 @@ public:
         TASK_IO,
         TASK_NETWORK,
         TASK_OTHER,
+        TASK_DECODE, // cpu bound tasks, run concurrently by CC_ASYNC_DECODE_THREADS threads
         TASK_MAX_TYPE,
     };
 
@@ -82,7 +83,8 @@ public:
     /**
      * Enqueue a asynchronous task.
      *
-     * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+     * @param type task type is io task, network task, decode task or others, each type of task has a thread to deal with it,
+     *             except the decode tasks which run on several threads and may complete in any order.
      * @param callback callback when the task is finished. The callback is called in the main thread instead of task thread.
      * @param callbackParam parameter used by the callback.
      * @param f task can be lambda function.
@@ -108,7 +110,12 @@ protected:
         ThreadTasks()
         : _stop(false)
         {
-            _thread = std::thread(
+        }
+        void start(unsigned int threadCount)
+        {
+            for (unsigned int i = 0; i < threadCount; ++i)
+            {
+                _threads.emplace_back(
                                   [this]
                                   {
                                       for(;;)
@@ -132,6 +139,7 @@ protected:
                                       }
                                   }
                                   );
+            }
         }
         ~ThreadTasks()
         {
@@ -145,7 +153,8 @@ protected:
                     _taskCallBacks.pop();
             }
             _condition.notify_all();
-            _thread.join();
+            for (auto& thread : _threads)
+                thread.join();
         }
         void clear()
         {
@@ -180,8 +189,8 @@ protected:
         }
     private:
         
-        // need to keep track of thread so we can join them
-        std::thread _thread;
+        // need to keep track of threads so we can join them
+        std::vector<std::thread> _threads;
         // the task queue
         std::queue< std::function<void()> > _tasks;
         std::queue<AsyncTaskCallBack>            _taskCallBacks;
@@ -49,6 +49,7 @@ Configuration::Configuration()
 , _supportsBGRA8888(false)
 , _supportsDiscardFramebuffer(false)
 , _supportsShareableVAO(false)
+, _supportsInstancing(false)
 , _supportsOESMapBuffer(false)
 , _supportsOESDepth24(false)
 , _supportsOESPackedDepthStencil(false)
@@ -157,6 +158,16 @@ void Configuration::gatherGPUInfo()
 #endif
     _valueDict["gl.supports_vertex_array_object"] = Value(_supportsShareableVAO);
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    _supportsInstancing = checkForGLExtension("GL_ARB_instanced_arrays") && checkForGLExtension("GL_ARB_draw_instanced");
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+    _supportsInstancing = checkForGLExtension("GL_EXT_instanced_arrays");
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    // the entry points are loaded by the GLView
+    _supportsInstancing = checkForGLExtension("GL_EXT_instanced_arrays") && glDrawElementsInstancedEXT && glVertexAttribDivisorEXT;
+#endif
+    _valueDict["gl.supports_instancing"] = Value(_supportsInstancing);
+
     _supportsOESMapBuffer = checkForGLExtension("GL_OES_mapbuffer");
     _valueDict["gl.supports_OES_map_buffer"] = Value(_supportsOESMapBuffer);
 
@@ -264,6 +275,11 @@ bool Configuration::supportsShareableVAO() const
 #endif
 }
 
+bool Configuration::supportsInstancing() const
+{
+    return _supportsInstancing;
+}
+
 bool Configuration::supportsMapBuffer() const
 {
     // Fixes Github issue #16123
@@ -140,6 +140,15 @@ public:
      */
 	bool supportsShareableVAO() const;
 
+    /** Whether or not instanced drawing is supported, with per instance vertex attributes.
+     *
+     * On iOS and Android it checks for the extension `GL_EXT_instanced_arrays`,
+     * on Desktop for `GL_ARB_instanced_arrays` and `GL_ARB_draw_instanced`.
+     *
+     * @return Is true if supports instanced drawing.
+     */
+    bool supportsInstancing() const;
+
     /** Whether or not OES_depth24 is supported.
      *
      * @return Is true if supports OES_depth24.
@@ -251,6 +260,7 @@ protected:
     bool            _supportsBGRA8888;
     bool            _supportsDiscardFramebuffer;
     bool            _supportsShareableVAO;
+    bool            _supportsInstancing;
     bool            _supportsOESMapBuffer;
     bool            _supportsOESDepth24;
     bool            _supportsOESPackedDepthStencil;
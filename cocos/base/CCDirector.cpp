@@ -57,6 +57,7 @@ THE SOFTWARE.
 #include "base/CCAutoreleasePool.h"
 #include "base/CCConfiguration.h"
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCJobPool.h"
 #include "platform/CCApplication.h"
 
 /**
@@ -969,6 +970,7 @@ void Director::reset()
     GLProgramStateCache::destroyInstance();
     FileUtils::destroyInstance();
     AsyncTaskPool::destroyInstance();
+    JobPool::destroyInstance();
     
     // cocos2d-x specific data structures
     UserDefault::destroyInstance();
@@ -0,0 +1,166 @@
+/****************************************************************************
+ Copyright (c) 2017      Iakov Sergeev <yahont@github>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCJobPool.h"
+#include "base/ccConfig.h"
+
+#include <algorithm>
+
+namespace cocos2d {
+
+JobPool* JobPool::s_jobPool = nullptr;
+
+JobPool* JobPool::getInstance()
+{
+    if (s_jobPool == nullptr)
+    {
+        s_jobPool = new (std::nothrow) JobPool();
+    }
+    return s_jobPool;
+}
+
+void JobPool::destroyInstance()
+{
+    delete s_jobPool;
+    s_jobPool = nullptr;
+}
+
+JobPool::JobPool()
+: _busy(false)
+, _job(nullptr)
+, _count(0)
+, _grainSize(1)
+, _next(0)
+, _generation(0)
+, _finishedWorkers(0)
+, _stop(false)
+{
+    unsigned int threads = CC_JOB_POOL_THREADS;
+    if (threads == 0)
+    {
+        auto cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 0;
+    }
+
+    _workers.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        _workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+JobPool::~JobPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    for (auto&& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void JobPool::parallelFor(size_t count, const Job& job, size_t grainSize)
+{
+    grainSize = std::max<size_t>(grainSize, 1);
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (_workers.empty() || count <= grainSize || _busy.exchange(true))
+    {
+        for (size_t index = 0; index < count; ++index)
+        {
+            job(index);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &job;
+        _count = count;
+        _grainSize = grainSize;
+        _next = 0;
+        _finishedWorkers = 0;
+        ++_generation;
+    }
+    _condition.notify_all();
+
+    runChunks();
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _finishedCondition.wait(lock, [this] { return _finishedWorkers == _workers.size(); });
+        _job = nullptr;
+    }
+
+    _busy = false;
+}
+
+void JobPool::workerLoop()
+{
+    unsigned int generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this, generation] { return _stop || _generation != generation; });
+            if (_stop)
+            {
+                return;
+            }
+            generation = _generation;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_finishedWorkers;
+        }
+        _finishedCondition.notify_one();
+    }
+}
+
+void JobPool::runChunks()
+{
+    for (;;)
+    {
+        size_t begin = _next.fetch_add(_grainSize);
+        if (begin >= _count)
+        {
+            return;
+        }
+
+        size_t end = std::min(begin + _grainSize, _count);
+        for (size_t index = begin; index < end; ++index)
+        {
+            (*_job)(index);
+        }
+    }
+}
+
+} // namespace cocos2d
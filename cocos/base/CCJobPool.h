@@ -0,0 +1,108 @@
+/****************************************************************************
+ Copyright (c) 2017      Iakov Sergeev <yahont@github>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CCJOB_POOL_H_
+#define __CCJOB_POOL_H_
+
+#include "platform/CCPlatformMacros.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* @addtogroup base
+* @{
+*/
+namespace cocos2d {
+
+/**
+ * @class JobPool
+ * @brief Runs data parallel work on a fixed set of worker threads.
+ *
+ * Unlike AsyncTaskPool, which runs background tasks one at a time and reports back
+ * on the next frame, JobPool splits a loop across all cores and returns once every
+ * iteration has run, so it can be used inside a frame.
+ * @js NA
+ */
+class CC_DLL JobPool
+{
+public:
+    typedef std::function<void(size_t)> Job;
+
+    /**
+     * Returns the shared instance of the job pool.
+     */
+    static JobPool* getInstance();
+
+    /**
+     * Destroys the job pool, joining the worker threads.
+     */
+    static void destroyInstance();
+
+    /**
+     * Returns the number of threads running a parallelFor, the calling thread included.
+     */
+    unsigned int getConcurrency() const { return static_cast<unsigned int>(_workers.size()) + 1; }
+
+    /**
+     * Calls job for every index in [0, count) and returns when all calls have finished.
+     * The calling thread takes part in the work.
+     *
+     * @param count number of iterations.
+     * @param job called with the iteration index, possibly from several threads at once.
+     * @param grainSize number of consecutive indices handed to a thread at a time.
+     * Nested calls, or calls made while another thread's loop is running, run serially on the calling thread.
+     */
+    void parallelFor(size_t count, const Job& job, size_t grainSize = 1);
+
+protected:
+    JobPool();
+    ~JobPool();
+
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::condition_variable _finishedCondition;
+    std::atomic<bool> _busy;
+
+    const Job* _job;
+    size_t _count;
+    size_t _grainSize;
+    std::atomic<size_t> _next;
+    unsigned int _generation;
+    size_t _finishedWorkers;
+    bool _stop;
+
+    static JobPool* s_jobPool;
+};
+
+} // namespace cocos2d
+// end group
+/// @}
+#endif //__CCJOB_POOL_H_
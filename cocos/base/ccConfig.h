@@ -179,6 +179,16 @@ THE SOFTWARE.
 #define CC_LABEL_DEBUG_DRAW 0
 #endif
 
+/** @def CC_LABEL_LAYOUT_CACHE_SIZE
+ * Maximum number of wrapped text layouts cached per FontAtlas.
+ * Labels showing the same string with the same layout settings share one layout,
+ * so repeated strings skip measuring and wrapping.
+ * To disable the cache set it to 0. 256 by default.
+ */
+#ifndef CC_LABEL_LAYOUT_CACHE_SIZE
+#define CC_LABEL_LAYOUT_CACHE_SIZE 256
+#endif
+
 /** @def CC_SPRITEBATCHNODE_DEBUG_DRAW
  * If enabled, all subclasses of Sprite that are rendered using an SpriteBatchNode draw a bounding box.
  * Useful for debugging purposes only. It is recommended to leave it disabled.
@@ -234,6 +244,14 @@ THE SOFTWARE.
 #ifndef CC_ENABLE_BULLET_INTEGRATION
 #define CC_ENABLE_BULLET_INTEGRATION 1
 #endif
+
+/** @def CC_ENABLE_BULLET_MULTITHREADING
+ * Lets Physics3DWorld run Bullet's multithreaded dynamics world, see Physics3DWorldDes::isMultiThreadingEnabled.
+ * It requires Bullet 2.88 or newer built with BT_THREADSAFE.
+ */
+#ifndef CC_ENABLE_BULLET_MULTITHREADING
+#define CC_ENABLE_BULLET_MULTITHREADING 0
+#endif
 #endif
 
 /** Use 3D navigation API */
@@ -321,6 +339,30 @@ THE SOFTWARE.
 # define CC_ALLOCATOR_GLOBAL_NEW_DELETE cocos2d::allocator::AllocatorStrategyGlobalSmallBlock
 #endif
 
+/** @def CC_JOB_POOL_THREADS
+ * Number of worker threads started by JobPool.
+ * 0 starts one thread per extra CPU core, so the calling thread and the workers use all cores.
+ */
+#ifndef CC_JOB_POOL_THREADS
+# define CC_JOB_POOL_THREADS 0
+#endif
+
+/** @def CC_ASYNC_DECODE_THREADS
+ * Number of threads running the AsyncTaskPool::TaskType::TASK_DECODE tasks.
+ * 0 starts one thread per extra CPU core, leaving one core to the main thread.
+ */
+#ifndef CC_ASYNC_DECODE_THREADS
+# define CC_ASYNC_DECODE_THREADS 0
+#endif
+
+/** @def CC_PHYSICS_SOLVER_THREADS
+ * Default number of threads solving the contacts and joints of a PhysicsWorld, see PhysicsWorld::setSolverThreads.
+ * 0 uses one thread per CPU core.
+ */
+#ifndef CC_PHYSICS_SOLVER_THREADS
+# define CC_PHYSICS_SOLVER_THREADS 0
+#endif
+
 #ifndef CC_FILEUTILS_APPLE_ENABLE_OBJC
 #define CC_FILEUTILS_APPLE_ENABLE_OBJC  1
 #endif
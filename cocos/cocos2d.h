@@ -46,6 +46,7 @@ THE SOFTWARE.
 #include "base/CCDirector.h"
 #include "base/CCIMEDelegate.h"
 #include "base/CCIMEDispatcher.h"
+#include "base/CCJobPool.h"
 #include "base/CCNS.h"
 #include "base/CCProfiling.h"
 #include "base/CCProperties.h"
@@ -277,6 +278,7 @@ THE SOFTWARE.
 #include "3d/CCAnimation3D.h"
 #include "3d/CCAttachNode.h"
 #include "3d/CCBillBoard.h"
+#include "3d/CCBoundingVolumeTree.h"
 #include "3d/CCFrustum.h"
 #include "3d/CCMesh.h"
 #include "3d/CCMeshSkin.h"
@@ -290,6 +292,7 @@ THE SOFTWARE.
 #include "3d/CCSprite3D.h"
 #include "3d/CCSprite3DMaterial.h"
 #include "3d/CCTerrain.h"
+#include "3d/CCPagedTerrain.h"
 
 // vr
 #include "vr/CCVRGenericRenderer.h"
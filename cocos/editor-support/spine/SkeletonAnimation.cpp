@@ -32,7 +32,10 @@
 #include <spine/SkeletonAnimation.h>
 #include <spine/spine-cocos2dx.h>
 #include <spine/extension.h>
+#include "base/CCDirector.h"
 #include <algorithm>
+#include <cmath>
+#include <unordered_map>
 
 using namespace cocos2d;
 using std::min;
@@ -69,6 +72,50 @@ void disposeTrackEntry (spTrackEntry* entry) {
 	_spTrackEntry_dispose(entry);
 }
 
+struct SharedPoseKey {
+	const spSkeletonData* data;
+	const spSkin* skin;
+	const spAnimation* animation;
+	int timeIndex;
+	uint32_t color;
+	bool premultipliedAlpha;
+	float x, y;
+	int flipX, flipY;
+	/* the slot attachments, which setAttachment may have changed from what the animation keys */
+	const spSkeleton* skeleton;
+	size_t attachmentsHash;
+
+	bool operator== (const SharedPoseKey& other) const {
+		if (data != other.data || skin != other.skin || animation != other.animation || timeIndex != other.timeIndex
+			|| color != other.color || premultipliedAlpha != other.premultipliedAlpha
+			|| x != other.x || y != other.y || flipX != other.flipX || flipY != other.flipY
+			|| attachmentsHash != other.attachmentsHash) return false;
+		for (int i = 0; i < skeleton->slotsCount; ++i)
+			if (skeleton->slots[i]->attachment != other.skeleton->slots[i]->attachment) return false;
+		return true;
+	}
+};
+
+struct SharedPoseKeyHash {
+	size_t operator() (const SharedPoseKey& key) const {
+		size_t hash = std::hash<const void*>()(key.data);
+		hash = hash * 31 + std::hash<const void*>()(key.skin);
+		hash = hash * 31 + std::hash<const void*>()(key.animation);
+		hash = hash * 31 + std::hash<int>()(key.timeIndex);
+		hash = hash * 31 + std::hash<uint32_t>()(key.color);
+		hash = hash * 31 + std::hash<float>()(key.x);
+		hash = hash * 31 + std::hash<float>()(key.y);
+		hash = hash * 31 + key.attachmentsHash;
+		hash = hash * 4 + (key.flipX ? 2 : 0) + (key.flipY ? 1 : 0);
+		return hash * 2 + key.premultipliedAlpha;
+	}
+};
+
+// instances evaluating a pose this frame, rebuilt every frame
+static std::unordered_map<SharedPoseKey, SkeletonAnimation*, SharedPoseKeyHash> s_sharedPoses;
+static unsigned int s_sharedPosesFrame = 0;
+static float s_sharedPoseTimeStep = 1.0f / 30;
+
 //
 
 SkeletonAnimation* SkeletonAnimation::createWithData (spSkeletonData* skeletonData, bool ownsSkeletonData) {
@@ -122,21 +169,101 @@ void SkeletonAnimation::initialize () {
 }
 
 SkeletonAnimation::SkeletonAnimation ()
-		: SkeletonRenderer() {
+		: SkeletonRenderer()
+		, _poseSharing(false) {
 }
 
 SkeletonAnimation::~SkeletonAnimation () {
+	if (_poseSharing) setPoseSharingEnabled(false);
 	if (_ownsAnimationStateData) spAnimationStateData_dispose(_state->data);
 	spAnimationState_dispose(_state);
 }
 
 void SkeletonAnimation::update (float deltaTime) {
-	super::update(deltaTime);
+	if (!_poseSharing) {
+		super::update(deltaTime);
+
+		deltaTime *= _timeScale;
+		spAnimationState_update(_state, deltaTime);
+		spAnimationState_apply(_state, _skeleton);
+		requestWorldTransform();
+		return;
+	}
 
-	deltaTime *= _timeScale;
-	spAnimationState_update(_state, deltaTime);
+	// the local pose is cheap and keeps the runtime's track bookkeeping and listeners, the world transforms
+	// and vertices are what sharing instances skip
+	spAnimationState_update(_state, deltaTime * _timeScale);
 	spAnimationState_apply(_state, _skeleton);
-	spSkeleton_updateWorldTransform(_skeleton);
+
+	SkeletonAnimation* source = findPoseSource();
+	setPoseSource(source);
+	if (source) {
+		spSkeleton_update(_skeleton, deltaTime * _timeScale);
+		return;
+	}
+
+	super::update(deltaTime);
+	requestWorldTransform();
+}
+
+void SkeletonAnimation::setPoseSharingEnabled (bool enabled) {
+	_poseSharing = enabled;
+	if (enabled) return;
+
+	setPoseSource(nullptr);
+	for (auto it = s_sharedPoses.begin(); it != s_sharedPoses.end();) {
+		if (it->second == this) it = s_sharedPoses.erase(it);
+		else ++it;
+	}
+}
+
+void SkeletonAnimation::setPoseSharingTimeStep (float timeStep) {
+	s_sharedPoseTimeStep = timeStep;
+}
+
+float SkeletonAnimation::getPoseSharingTimeStep () {
+	return s_sharedPoseTimeStep;
+}
+
+SkeletonAnimation* SkeletonAnimation::findPoseSource () {
+	unsigned int frame = Director::getInstance()->getTotalFrames();
+	if (s_sharedPosesFrame != frame) {
+		s_sharedPoses.clear();
+		s_sharedPosesFrame = frame;
+	}
+
+	// a single unmixed track
+	spTrackEntry* current = nullptr;
+	for (int i = 0; i < _state->tracksCount; ++i) {
+		if (!_state->tracks[i]) continue;
+		if (current) return nullptr;
+		current = _state->tracks[i];
+	}
+	if (!current || current->previous || current->mix != 1) return nullptr;
+
+	float time = current->time;
+	if (current->loop && current->animation->duration) time = std::fmod(time, current->animation->duration);
+	else if (time > current->endTime) time = current->endTime;
+
+	Color4B color = getVerticesColor();
+	SharedPoseKey key;
+	key.data = _skeleton->data;
+	key.skin = _skeleton->skin;
+	key.animation = current->animation;
+	key.timeIndex = (int)std::floor(time / s_sharedPoseTimeStep);
+	key.color = (uint32_t)color.r << 24 | (uint32_t)color.g << 16 | (uint32_t)color.b << 8 | color.a;
+	key.premultipliedAlpha = _premultipliedAlpha;
+	key.x = _skeleton->x;
+	key.y = _skeleton->y;
+	key.flipX = _skeleton->flipX;
+	key.flipY = _skeleton->flipY;
+	key.skeleton = _skeleton;
+	key.attachmentsHash = 0;
+	for (int i = 0; i < _skeleton->slotsCount; ++i)
+		key.attachmentsHash = key.attachmentsHash * 31 + std::hash<const void*>()(_skeleton->slots[i]->attachment);
+
+	auto result = s_sharedPoses.emplace(key, this);
+	return result.second || result.first->second == this ? nullptr : result.first->second;
 }
 
 void SkeletonAnimation::setAnimationStateData (spAnimationStateData* stateData) {
@@ -89,11 +89,27 @@ public:
 
 	spAnimationState* getState() const;
 
+	/* When enabled, skeletons with the same data, skin, color, position, flips and slot attachments playing a
+	 * single unmixed animation at the same quantized track time share one evaluated pose: only the first of them
+	 * computes the world transforms and skins, the others draw its vertices with their own node transform. Every
+	 * instance still applies its animation state, so listeners fire as usual, but the world transforms of a sharing
+	 * instance's own bones are not updated. Disabled by default. */
+	void setPoseSharingEnabled (bool enabled);
+	bool isPoseSharingEnabled () const { return _poseSharing; }
+
+	/* Track time granularity, in seconds, under which instances share a pose. 1/30 by default. */
+	static void setPoseSharingTimeStep (float timeStep);
+	static float getPoseSharingTimeStep ();
+
 protected:
 	virtual void initialize () override;
 
+	/* Returns the instance already evaluating this frame's pose, registering this one when it is the first. */
+	SkeletonAnimation* findPoseSource ();
+
 protected:
 	spAnimationState* _state;
+	bool _poseSharing;
 
 	bool _ownsAnimationStateData;
 
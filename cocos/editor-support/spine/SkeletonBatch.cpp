@@ -31,8 +31,10 @@
 
 #include "base/CCDirector.h"
 #include "base/CCEventDispatcher.h"
+#include "base/CCJobPool.h"
 #include "renderer/CCRenderer.h"
 #include "spine/SkeletonBatch.h"
+#include "spine/SkeletonRenderer.h"
 #include "spine/extension.h"
 
 #include <algorithm>
@@ -58,6 +60,7 @@ namespace spine {
     }
 
     SkeletonBatch::SkeletonBatch ()
+    : _parallelUpdate(true)
     {
         _firstCommand = new Command();
         _command = _firstCommand;
@@ -65,10 +68,16 @@ namespace spine {
         Director::getInstance()->getEventDispatcher()->addCustomEventListener(EVENT_AFTER_DRAW_RESET_POSITION, [this](EventCustom* /*eventCustom*/){
             this->update(0);
         });;
+        Director::getInstance()->getEventDispatcher()->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this](EventCustom* /*eventCustom*/){
+            this->updateSkeletons();
+        });
     }
 
     SkeletonBatch::~SkeletonBatch () {
         Director::getInstance()->getEventDispatcher()->removeCustomEventListeners(EVENT_AFTER_DRAW_RESET_POSITION);
+        Director::getInstance()->getEventDispatcher()->removeCustomEventListeners(Director::EVENT_AFTER_UPDATE);
+
+        for (auto skeleton : _skeletons) skeleton->_batched = false;
 
         Command* command = _firstCommand;
         while (command) {
@@ -104,6 +113,36 @@ namespace spine {
         _command = _command->next;
     }
 
+    void SkeletonBatch::setParallelUpdate (bool enabled) {
+        if (!enabled) updateSkeletons();
+        _parallelUpdate = enabled;
+    }
+
+    void SkeletonBatch::addSkeleton (SkeletonRenderer* skeleton) {
+        if (skeleton->_batched) return;
+        skeleton->_batched = true;
+        _skeletons.push_back(skeleton);
+    }
+
+    void SkeletonBatch::removeSkeleton (SkeletonRenderer* skeleton) {
+        if (!skeleton->_batched) return;
+        skeleton->_batched = false;
+        _skeletons.erase(std::remove(_skeletons.begin(), _skeletons.end(), skeleton), _skeletons.end());
+    }
+
+    void SkeletonBatch::updateSkeletons () {
+        if (_skeletons.empty()) return;
+
+        // each skeleton only touches its own pose and vertices, draw still feeds them in draw order
+        unsigned int frame = Director::getInstance()->getTotalFrames();
+        JobPool::getInstance()->parallelFor(_skeletons.size(), [this, frame](size_t index) {
+            _skeletons[index]->updateBatched(frame);
+        });
+
+        for (auto skeleton : _skeletons) skeleton->_batched = false;
+        _skeletons.clear();
+    }
+
     SkeletonBatch::Command::Command () :
     next(nullptr)
     {
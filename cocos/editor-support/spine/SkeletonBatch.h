@@ -35,6 +35,8 @@
 #include "spine/spine.h"
 #include "renderer/CCTrianglesCommand.h"
 
+#include <vector>
+
 namespace cocos2d {
     class Renderer;
     class GLProgramState;
@@ -42,6 +44,8 @@ namespace cocos2d {
 }
 
 namespace spine {
+
+    class SkeletonRenderer;
     
     class SkeletonBatch {
     public:
@@ -53,6 +57,14 @@ namespace spine {
         
         void addCommand (cocos2d::Renderer* renderer, float globalOrder, GLuint textureID, cocos2d::GLProgramState* glProgramState,
                          cocos2d::BlendFunc blendType, const cocos2d::TrianglesCommand:: Triangles& triangles, const cocos2d::Mat4& mv, uint32_t flags);
+
+        /* When enabled (the default), the poses and skinned vertices of all skeletons updated during a frame are
+         * computed together on the JobPool once the scheduler is done, instead of one skeleton at a time. */
+        void setParallelUpdate (bool enabled);
+        bool isParallelUpdate () const { return _parallelUpdate; }
+
+        void addSkeleton (SkeletonRenderer* skeleton);
+        void removeSkeleton (SkeletonRenderer* skeleton);
         
     protected:
         SkeletonBatch ();
@@ -68,8 +80,14 @@ namespace spine {
             Command* next;
         };
         
+        void updateSkeletons ();
+
         Command* _firstCommand;
         Command* _command;
+
+        // skeletons updated this frame, in scheduler order
+        std::vector<SkeletonRenderer*> _skeletons;
+        bool _parallelUpdate;
     };
     
 }
@@ -31,6 +31,7 @@
 
 #include "2d/CCDrawNode.h"
 #include "base/CCDirector.h"
+#include "renderer/CCTexture2D.h"
 #include "renderer/CCGLProgram.h"
 #include "spine/SkeletonRenderer.h"
 #include "spine/extension.h"
@@ -84,6 +85,11 @@ SkeletonRenderer::SkeletonRenderer ()
     , _timeScale(1)
     , _debugSlots(false)
     , _debugBones(false)
+    , _verticesFrame(0)
+    , _verticesValid(false)
+    , _worldTransformPending(false)
+    , _batched(false)
+    , _poseSource(nullptr)
 {}
 
 SkeletonRenderer::SkeletonRenderer (spSkeletonData *skeletonData, bool ownsSkeletonData)
@@ -92,6 +98,11 @@ SkeletonRenderer::SkeletonRenderer (spSkeletonData *skeletonData, bool ownsSkele
     , _timeScale(1)
     , _debugSlots(false)
     , _debugBones(false)
+    , _verticesFrame(0)
+    , _verticesValid(false)
+    , _worldTransformPending(false)
+    , _batched(false)
+    , _poseSource(nullptr)
 {
 	initWithData(skeletonData, ownsSkeletonData);
 }
@@ -102,6 +113,11 @@ SkeletonRenderer::SkeletonRenderer (const std::string& skeletonDataFile, spAtlas
     , _timeScale(1)
     , _debugSlots(false)
     , _debugBones(false)
+    , _verticesFrame(0)
+    , _verticesValid(false)
+    , _worldTransformPending(false)
+    , _batched(false)
+    , _poseSource(nullptr)
 {
 	initWithJsonFile(skeletonDataFile, atlas, scale);
 }
@@ -112,12 +128,19 @@ SkeletonRenderer::SkeletonRenderer (const std::string& skeletonDataFile, const s
     , _timeScale(1)
     , _debugSlots(false)
     , _debugBones(false)
+    , _verticesFrame(0)
+    , _verticesValid(false)
+    , _worldTransformPending(false)
+    , _batched(false)
+    , _poseSource(nullptr)
 {
 	initWithJsonFile(skeletonDataFile, atlasFile, scale);
 }
 
 SkeletonRenderer::~SkeletonRenderer ()
 {
+	if (_batched) SkeletonBatch::getInstance()->removeSkeleton(this);
+	CC_SAFE_RELEASE(_poseSource);
 	if (_ownsSkeletonData) spSkeletonData_dispose(_skeleton->data);
 	spSkeleton_dispose(_skeleton);
 	if (_atlas) spAtlas_dispose(_atlas);
@@ -198,66 +221,186 @@ void SkeletonRenderer::initWithBinaryFile (const std::string& skeletonDataFile,
 
 void SkeletonRenderer::update (float deltaTime) {
 	spSkeleton_update(_skeleton, deltaTime * _timeScale);
-}
 
-void SkeletonRenderer::draw (Renderer* renderer, const Mat4& transform, uint32_t transformFlags) {
 	SkeletonBatch* batch = SkeletonBatch::getInstance();
+	if (batch->isParallelUpdate()) batch->addSkeleton(this);
+}
+
+void SkeletonRenderer::requestWorldTransform () {
+	if (SkeletonBatch::getInstance()->isParallelUpdate()) {
+		_worldTransformPending = true;
+		SkeletonBatch::getInstance()->addSkeleton(this);
+	} else
+		updateWorldTransform();
+}
+
+void SkeletonRenderer::updateBatched (unsigned int frame) {
+	if (_worldTransformPending) {
+		spSkeleton_updateWorldTransform(_skeleton);
+		_worldTransformPending = false;
+	}
+	if (isVisible()) updateVertices(frame);
+}
+
+Color4B SkeletonRenderer::getVerticesColor () const {
+	const Color3B& color = getColor();
+	return Color4B(color.r, color.g, color.b, getDisplayedOpacity());
+}
+
+void SkeletonRenderer::updateVertices (unsigned int frame) {
+	_verticesColor = getVerticesColor();
+	_skeleton->r = _verticesColor.r / (float)255;
+	_skeleton->g = _verticesColor.g / (float)255;
+	_skeleton->b = _verticesColor.b / (float)255;
+	_skeleton->a = _verticesColor.a / (float)255;
+
+	// pack the bone transforms so skinning reads them from one contiguous array
+	_bonePalette.resize(_skeleton->bonesCount * 6);
+	float* palette = _bonePalette.data();
+	for (int i = 0, n = _skeleton->bonesCount; i < n; ++i, palette += 6) {
+		const spBone* bone = _skeleton->bones[i];
+		palette[0] = bone->a;
+		palette[1] = bone->b;
+		palette[2] = bone->c;
+		palette[3] = bone->d;
+		palette[4] = bone->worldX;
+		palette[5] = bone->worldY;
+	}
+	palette = _bonePalette.data();
+	const float x = _skeleton->x, y = _skeleton->y;
+
+	_vertices.clear();
+	_slotVertexOffsets.assign(_skeleton->slotsCount, -1);
 
-	Color3B nodeColor = getColor();
-	_skeleton->r = nodeColor.r / (float)255;
-	_skeleton->g = nodeColor.g / (float)255;
-	_skeleton->b = nodeColor.b / (float)255;
-	_skeleton->a = getDisplayedOpacity() / (float)255;
-    
-    Color4F color;
-	AttachmentVertices* attachmentVertices = nullptr;
 	for (int i = 0, n = _skeleton->slotsCount; i < n; ++i) {
 		spSlot* slot = _skeleton->drawOrder[i];
 		if (!slot->attachment) continue;
 
+		AttachmentVertices* attachmentVertices;
+		float r, g, b, a;
 		switch (slot->attachment->type) {
 		case SP_ATTACHMENT_REGION: {
 			spRegionAttachment* attachment = (spRegionAttachment*)slot->attachment;
-			spRegionAttachment_computeWorldVertices(attachment, slot->bone, _worldVertices);
 			attachmentVertices = getAttachmentVertices(attachment);
-            color.r = attachment->r;
-			color.g = attachment->g;
-			color.b = attachment->b;
-			color.a = attachment->a;
+			r = attachment->r;
+			g = attachment->g;
+			b = attachment->b;
+			a = attachment->a;
 			break;
 		}
 		case SP_ATTACHMENT_MESH: {
 			spMeshAttachment* attachment = (spMeshAttachment*)slot->attachment;
-			spMeshAttachment_computeWorldVertices(attachment, slot, _worldVertices);
 			attachmentVertices = getAttachmentVertices(attachment);
-            color.r = attachment->r;
-            color.g = attachment->g;
-            color.b = attachment->b;
-            color.a = attachment->a;
+			r = attachment->r;
+			g = attachment->g;
+			b = attachment->b;
+			a = attachment->a;
 			break;
 		}
 		default:
 			continue;
 		}
 
-		color.a *= _skeleton->a * slot->a * 255;
-		float multiplier = _premultipliedAlpha ? color.a : 255;
-		color.r *= _skeleton->r * slot->r * multiplier;
-		color.g *= _skeleton->g * slot->g * multiplier;
-		color.b *= _skeleton->b * slot->b * multiplier;
-        
-        
-        
-		for (int v = 0, w = 0, vn = attachmentVertices->_triangles->vertCount; v < vn; ++v, w += 2) {
-			V3F_C4B_T2F* vertex = attachmentVertices->_triangles->verts + v;
-			vertex->vertices.x = _worldVertices[w];
-			vertex->vertices.y = _worldVertices[w + 1];
-            vertex->colors.r = (GLubyte)color.r;
-            vertex->colors.g = (GLubyte)color.g;
-            vertex->colors.b = (GLubyte)color.b;
-            vertex->colors.a = (GLubyte)color.a;
+		a *= _skeleton->a * slot->a * 255;
+		float multiplier = _premultipliedAlpha ? a : 255;
+		Color4B color((GLubyte)(r * _skeleton->r * slot->r * multiplier),
+			(GLubyte)(g * _skeleton->g * slot->g * multiplier),
+			(GLubyte)(b * _skeleton->b * slot->b * multiplier),
+			(GLubyte)a);
+
+		const TrianglesCommand::Triangles& triangles = *attachmentVertices->_triangles;
+		int offset = (int)_vertices.size();
+		_slotVertexOffsets[i] = offset;
+		_vertices.resize(offset + triangles.vertCount);
+		V3F_C4B_T2F* out = _vertices.data() + offset;
+		for (int v = 0; v < triangles.vertCount; ++v) {
+			out[v].vertices.z = 0;
+			out[v].colors = color;
+			out[v].texCoords = triangles.verts[v].texCoords;
+		}
+
+		if (slot->attachment->type == SP_ATTACHMENT_REGION) {
+			const float* bone = palette + slot->bone->data->index * 6;
+			const float* local = ((spRegionAttachment*)slot->attachment)->offset;
+			for (int v = 0; v < 4; ++v, local += 2) {
+				out[v].vertices.x = local[0] * bone[0] + local[1] * bone[1] + bone[4] + x;
+				out[v].vertices.y = local[0] * bone[2] + local[1] * bone[3] + bone[5] + y;
+			}
+			continue;
 		}
 
+		spMeshAttachment* meshAttachment = (spMeshAttachment*)slot->attachment;
+		spVertexAttachment* mesh = SUPER(meshAttachment);
+		const float* deform = slot->attachmentVerticesCount > 0 ? slot->attachmentVertices : nullptr;
+		if (!mesh->bones) {
+			const float* bone = palette + slot->bone->data->index * 6;
+			const float* local = deform ? deform : mesh->vertices;
+			for (int v = 0; v < triangles.vertCount; ++v, local += 2) {
+				out[v].vertices.x = local[0] * bone[0] + local[1] * bone[1] + bone[4] + x;
+				out[v].vertices.y = local[0] * bone[2] + local[1] * bone[3] + bone[5] + y;
+			}
+		} else {
+			// weighted vertices: bone count, then (bone index) per influence;
+			// vertices hold (x, y, weight) and deform an (x, y) offset per influence
+			const int* bones = mesh->bones;
+			const float* weighted = mesh->vertices;
+			for (int v = 0; v < triangles.vertCount; ++v) {
+				float wx = x, wy = y;
+				for (int influences = *bones++; influences > 0; --influences, weighted += 3) {
+					const float* bone = palette + *bones++ * 6;
+					float vx = weighted[0], vy = weighted[1];
+					if (deform) {
+						vx += deform[0];
+						vy += deform[1];
+						deform += 2;
+					}
+					wx += (vx * bone[0] + vy * bone[1] + bone[4]) * weighted[2];
+					wy += (vx * bone[2] + vy * bone[3] + bone[5]) * weighted[2];
+				}
+				out[v].vertices.x = wx;
+				out[v].vertices.y = wy;
+			}
+		}
+	}
+
+	_verticesFrame = frame;
+	_verticesValid = true;
+}
+
+void SkeletonRenderer::setPoseSource (SkeletonRenderer* source) {
+	if (source == _poseSource) return;
+	CC_SAFE_RETAIN(source);
+	CC_SAFE_RELEASE(_poseSource);
+	_poseSource = source;
+}
+
+void SkeletonRenderer::draw (Renderer* renderer, const Mat4& transform, uint32_t transformFlags) {
+	SkeletonBatch* batch = SkeletonBatch::getInstance();
+
+	SkeletonRenderer* source = _poseSource ? _poseSource : this;
+	if (source->_worldTransformPending) source->updateWorldTransform();
+
+	unsigned int frame = Director::getInstance()->getTotalFrames();
+	if (!source->_verticesValid || source->_verticesFrame != frame || source->_verticesColor != source->getVerticesColor()) {
+		source->updateVertices(frame);
+	}
+
+	const spSkeleton* skeleton = source->_skeleton;
+	TrianglesCommand::Triangles triangles;
+	for (int i = 0, n = skeleton->slotsCount; i < n; ++i) {
+		int offset = source->_slotVertexOffsets[i];
+		if (offset < 0) continue;
+
+		spSlot* slot = skeleton->drawOrder[i];
+		AttachmentVertices* attachmentVertices = slot->attachment->type == SP_ATTACHMENT_REGION
+			? getAttachmentVertices((spRegionAttachment*)slot->attachment)
+			: getAttachmentVertices((spMeshAttachment*)slot->attachment);
+
+		triangles.verts = source->_vertices.data() + offset;
+		triangles.vertCount = attachmentVertices->_triangles->vertCount;
+		triangles.indices = attachmentVertices->_triangles->indices;
+		triangles.indexCount = attachmentVertices->_triangles->indexCount;
+
 		BlendFunc blendFunc;
 		switch (slot->data->blendMode) {
 		case SP_BLEND_MODE_ADDITIVE:
@@ -278,7 +421,7 @@ void SkeletonRenderer::draw (Renderer* renderer, const Mat4& transform, uint32_t
 		}
 
 		batch->addCommand(renderer, _globalZOrder, attachmentVertices->_texture->getName(), _glProgramState, blendFunc,
-			*attachmentVertices->_triangles, transform, transformFlags);
+			triangles, transform, transformFlags);
 	}
 
 	if (_debugSlots || _debugBones) {
@@ -344,8 +487,9 @@ AttachmentVertices* SkeletonRenderer::getAttachmentVertices (spMeshAttachment* a
 Rect SkeletonRenderer::getBoundingBox () const {
 	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
 	float scaleX = getScaleX(), scaleY = getScaleY();
-	for (int i = 0; i < _skeleton->slotsCount; ++i) {
-		spSlot* slot = _skeleton->slots[i];
+	const spSkeleton* skeleton = _poseSource ? _poseSource->_skeleton : _skeleton;
+	for (int i = 0; i < skeleton->slotsCount; ++i) {
+		spSlot* slot = skeleton->slots[i];
 		if (!slot->attachment) continue;
 		int verticesCount;
 		if (slot->attachment->type == SP_ATTACHMENT_REGION) {
@@ -375,16 +519,20 @@ Rect SkeletonRenderer::getBoundingBox () const {
 
 void SkeletonRenderer::updateWorldTransform () {
 	spSkeleton_updateWorldTransform(_skeleton);
+	_worldTransformPending = false;
+	_verticesValid = false;
 }
 
 void SkeletonRenderer::setToSetupPose () {
 	spSkeleton_setToSetupPose(_skeleton);
+	_verticesValid = false;
 }
 void SkeletonRenderer::setBonesToSetupPose () {
 	spSkeleton_setBonesToSetupPose(_skeleton);
 }
 void SkeletonRenderer::setSlotsToSetupPose () {
 	spSkeleton_setSlotsToSetupPose(_skeleton);
+	_verticesValid = false;
 }
 
 spBone* SkeletonRenderer::findBone (const std::string& boneName) const {
@@ -396,9 +544,11 @@ spSlot* SkeletonRenderer::findSlot (const std::string& slotName) const {
 }
 
 bool SkeletonRenderer::setSkin (const std::string& skinName) {
+	_verticesValid = false;
 	return spSkeleton_setSkinByName(_skeleton, skinName.empty() ? 0 : skinName.c_str()) ? true : false;
 }
 bool SkeletonRenderer::setSkin (const char* skinName) {
+	_verticesValid = false;
 	return spSkeleton_setSkinByName(_skeleton, skinName) ? true : false;
 }
 
@@ -406,9 +556,11 @@ spAttachment* SkeletonRenderer::getAttachment (const std::string& slotName, cons
 	return spSkeleton_getAttachmentForSlotName(_skeleton, slotName.c_str(), attachmentName.c_str());
 }
 bool SkeletonRenderer::setAttachment (const std::string& slotName, const std::string& attachmentName) {
+	_verticesValid = false;
 	return spSkeleton_setAttachment(_skeleton, slotName.c_str(), attachmentName.empty() ? 0 : attachmentName.c_str()) ? true : false;
 }
 bool SkeletonRenderer::setAttachment (const std::string& slotName, const char* attachmentName) {
+	_verticesValid = false;
 	return spSkeleton_setAttachment(_skeleton, slotName.c_str(), attachmentName) ? true : false;
 }
 
@@ -447,6 +599,7 @@ void SkeletonRenderer::onEnter () {
 
 void SkeletonRenderer::onExit () {
 	Node::onExit();
+	if (_batched) SkeletonBatch::getInstance()->removeSkeleton(this);
 	Director::getInstance()->getScheduler().unscheduleUpdateJob(this);
 }
 
@@ -460,6 +613,7 @@ void SkeletonRenderer::setBlendFunc (const BlendFunc &blendFunc) {
 
 void SkeletonRenderer::setOpacityModifyRGB (bool value) {
 	_premultipliedAlpha = value;
+	_verticesValid = false;
 }
 
 bool SkeletonRenderer::isOpacityModifyRGB () const {
@@ -37,10 +37,12 @@
 #include "spine/spine.h"
 
 #include <string>
+#include <vector>
 
 namespace spine {
 
 class AttachmentVertices;
+class SkeletonBatch;
 
 /* Draws a skeleton. */
 class SkeletonRenderer : public cocos2d::Node
@@ -80,6 +82,8 @@ public:
 	bool getDebugBonesEnabled() const;
 
 	// --- Convenience methods for common Skeleton_* functions.
+	/* Applies the pose right away. When SkeletonBatch runs parallel updates, the pose set during update is only
+	 * applied once all nodes are updated, so call this before reading bone world transforms in an update callback. */
 	void updateWorldTransform ();
 
 	void setToSetupPose ();
@@ -130,6 +134,17 @@ protected:
 	virtual AttachmentVertices* getAttachmentVertices (spRegionAttachment* attachment) const;
 	virtual AttachmentVertices* getAttachmentVertices (spMeshAttachment* attachment) const;
 
+	/* Applies the pose, deferred to SkeletonBatch when it runs parallel updates. */
+	void requestWorldTransform ();
+	/* Skins the visible attachments into _vertices, may run on a JobPool thread. */
+	void updateVertices (unsigned int frame);
+	void updateBatched (unsigned int frame);
+	cocos2d::Color4B getVerticesColor () const;
+	/* Draws the pose and vertices of another instance instead of its own skeleton. */
+	void setPoseSource (SkeletonRenderer* source);
+
+	friend class SkeletonBatch;
+
 	bool _ownsSkeletonData;
 	spAtlas* _atlas;
 	spAttachmentLoader* _attachmentLoader;
@@ -141,6 +156,17 @@ protected:
 	float _timeScale;
 	bool _debugSlots;
 	bool _debugBones;
+
+	// skinned vertices of the slots in draw order, -1 offset for slots drawing nothing
+	std::vector<cocos2d::V3F_C4B_T2F> _vertices;
+	std::vector<int> _slotVertexOffsets;
+	std::vector<float> _bonePalette;
+	cocos2d::Color4B _verticesColor;
+	unsigned int _verticesFrame;
+	bool _verticesValid;
+	bool _worldTransformPending;
+	bool _batched;
+	SkeletonRenderer* _poseSource;
 };
 
 }
@@ -24,6 +24,7 @@
 #include "navmesh/CCNavMesh.h"
 #if CC_USE_NAVMESH
 
+#include "base/CCJobPool.h"
 #include "platform/CCFileUtils.h"
 #include "renderer/CCRenderer.h"
 #include "recast/Detour/DetourCommon.h"
@@ -85,6 +86,8 @@ static unsigned char* parseRow(unsigned char* buf, unsigned char* bufEnd, char*
 static const int TILECACHESET_MAGIC = 'T' << 24 | 'S' << 16 | 'E' << 8 | 'T'; //'TSET';
 static const int TILECACHESET_VERSION = 1;
 static const int MAX_AGENTS = 128;
+static const int MAX_POLYS = 256;
+static const int MAX_NODES = 2048;
 
 NavMesh::NavMesh(const std::string & navFilePath, const std::string & geomFilePath)
     : _navMesh(nullptr)
@@ -98,6 +101,8 @@ NavMesh::NavMesh(const std::string & navFilePath, const std::string & geomFilePa
     , _navFilePath( navFilePath )
     , _geomFilePath( geomFilePath )
     , _isDebugDrawEnabled(false)
+    , _nextPathQueryId(0)
+    , _pathQueryBudget(1024)
 {
     loadGeomFile();
     loadNavMeshFile();
@@ -109,6 +114,8 @@ NavMesh::~NavMesh()
     dtFreeCrowd(_crowed);
     dtFreeNavMesh(_navMesh);
     dtFreeNavMeshQuery(_navMeshQuery);
+    for (auto& lane : _pathQueryLanes)
+        dtFreeNavMeshQuery(lane.query);
     CC_SAFE_DELETE(_allocator);
     CC_SAFE_DELETE(_compressor);
     CC_SAFE_DELETE(_meshProcess);
@@ -199,7 +206,7 @@ void NavMesh::loadNavMeshFile()
 
     //create NavMeshQuery
     _navMeshQuery = dtAllocNavMeshQuery();
-    _navMeshQuery->init(_navMesh, 2048);
+    _navMeshQuery->init(_navMesh, MAX_NODES);
 
     _agentList.assign(MAX_AGENTS, nullptr);
     _obstacleList.assign(header.cacheParams.maxObstacles, nullptr);
@@ -433,6 +440,8 @@ void NavMesh::debugDraw(Renderer* renderer)
 
 void NavMesh::update(float dt)
 {
+    runPathQueries();
+
     for (auto iter : _agentList){
         if (iter)
             iter->preUpdate(dt);
@@ -458,12 +467,168 @@ void NavMesh::update(float dt)
         if (iter)
             iter->postUpdate(dt);
     }
+
+    // the callbacks are free to change the navmesh, so they run last
+    deliverPathQueries();
+}
+
+unsigned int NavMesh::findPathAsync(const Vec3 &start, const Vec3 &end, const FindPathCallback &callback)
+{
+    unsigned int queryId = ++_nextPathQueryId;
+
+    auto key = std::make_tuple(start.x, start.y, start.z, end.x, end.y, end.z);
+    auto& query = _pathQueries[key];
+    if (!query)
+    {
+        query.reset(new PathQuery);
+        query->start = start;
+        query->end = end;
+        query->startRef = 0;
+        query->started = false;
+        _newPathQueries.push_back(query.get());
+    }
+    query->callbacks.emplace_back(queryId, callback);
+
+    return queryId;
+}
+
+static bool eraseCallback(std::vector<std::pair<unsigned int, NavMesh::FindPathCallback>> &callbacks, unsigned int queryId)
+{
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
+    {
+        if (it->first == queryId)
+        {
+            callbacks.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void NavMesh::cancelPathQuery(unsigned int queryId)
+{
+    // a pending query without callbacks is dropped by its lane
+    for (auto& iter : _pathQueries)
+    {
+        if (eraseCallback(iter.second->callbacks, queryId))
+            return;
+    }
+    for (auto& query : _finishedPathQueries)
+    {
+        if (eraseCallback(query->callbacks, queryId))
+            return;
+    }
+}
+
+void NavMesh::setPathQueryBudget(int iterations)
+{
+    _pathQueryBudget = std::max(iterations, 1);
+}
+
+void NavMesh::runPathQueries()
+{
+    if (_pathQueries.empty())
+        return;
+
+    if (_pathQueryLanes.empty())
+    {
+        _pathQueryLanes.resize(JobPool::getInstance()->getConcurrency());
+        for (auto& lane : _pathQueryLanes)
+        {
+            lane.query = dtAllocNavMeshQuery();
+            lane.query->init(_navMesh, MAX_NODES);
+        }
+    }
+
+    for (auto query : _newPathQueries)
+    {
+        auto lane = std::min_element(_pathQueryLanes.begin(), _pathQueryLanes.end(), [](const PathQueryLane &a, const PathQueryLane &b) {
+            return a.queries.size() < b.queries.size();
+        });
+        lane->queries.push_back(query);
+    }
+    _newPathQueries.clear();
+
+    // the lanes only read the navmesh, which the tile cache changes later in update()
+    JobPool::getInstance()->parallelFor(_pathQueryLanes.size(), [this](size_t i) {
+        runPathQueries(_pathQueryLanes[i]);
+    });
+
+    for (auto& lane : _pathQueryLanes)
+    {
+        for (auto query : lane.finished)
+        {
+            auto iter = _pathQueries.find(std::make_tuple(query->start.x, query->start.y, query->start.z, query->end.x, query->end.y, query->end.z));
+            _finishedPathQueries.push_back(std::move(iter->second));
+            _pathQueries.erase(iter);
+        }
+        lane.finished.clear();
+    }
+}
+
+void NavMesh::runPathQueries(PathQueryLane &lane)
+{
+    float ext[3];
+    ext[0] = 2; ext[1] = 4; ext[2] = 2;
+    int budget = _pathQueryBudget;
+
+    while (!lane.queries.empty() && budget > 0)
+    {
+        auto query = lane.queries.front();
+        if (query->callbacks.empty())
+        {
+            lane.queries.pop_front();
+            lane.finished.push_back(query);
+            continue;
+        }
+
+        if (!query->started)
+        {
+            dtPolyRef endRef = 0;
+            lane.query->findNearestPoly(&query->start.x, ext, &lane.filter, &query->startRef, 0);
+            lane.query->findNearestPoly(&query->end.x, ext, &lane.filter, &endRef, 0);
+            lane.query->initSlicedFindPath(query->startRef, endRef, &query->start.x, &query->end.x, &lane.filter);
+            query->started = true;
+        }
+
+        int iterations = 0;
+        dtStatus status = lane.query->updateSlicedFindPath(budget, &iterations);
+        budget -= iterations;
+        if (dtStatusInProgress(status))
+            break; // resumed on the next update
+
+        lane.queries.pop_front();
+        if (dtStatusSucceed(status))
+        {
+            dtPolyRef polys[MAX_POLYS];
+            int npolys = 0;
+            lane.query->finalizeSlicedFindPath(polys, &npolys, MAX_POLYS);
+            if (npolys)
+                smoothPath(lane.query, lane.filter, query->startRef, query->start, query->end, polys, npolys, query->pathPoints);
+        }
+        lane.finished.push_back(query);
+    }
+}
+
+void NavMesh::deliverPathQueries()
+{
+    if (_finishedPathQueries.empty())
+        return;
+
+    std::vector<std::unique_ptr<PathQuery>> finished;
+    finished.swap(_finishedPathQueries);
+    for (auto& query : finished)
+    {
+        for (auto& callback : query->callbacks)
+        {
+            if (callback.second)
+                callback.second(query->pathPoints);
+        }
+    }
 }
 
 void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<Vec3> &pathPoints)
 {
-    static const int MAX_POLYS = 256;
-    static const int MAX_SMOOTH = 2048;
     float ext[3];
     ext[0] = 2; ext[1] = 4; ext[2] = 2;
     dtQueryFilter filter;
@@ -475,137 +640,141 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
     _navMeshQuery->findPath(startRef, endRef, &start.x, &end.x, &filter, polys, &npolys, MAX_POLYS);
 
     if (npolys)
-    {
-        //// Iterate over the path to find smooth path on the detail mesh surface.
-        //dtPolyRef polys[MAX_POLYS];
-        //memcpy(polys, polys, sizeof(dtPolyRef)*npolys);
-        //int npolys = npolys;
+        smoothPath(_navMeshQuery, filter, startRef, start, end, polys, npolys, pathPoints);
+}
 
-        float iterPos[3], targetPos[3];
-        _navMeshQuery->closestPointOnPoly(startRef, &start.x, iterPos, 0);
-        _navMeshQuery->closestPointOnPoly(polys[npolys - 1], &end.x, targetPos, 0);
+void NavMesh::smoothPath(dtNavMeshQuery *navMeshQuery, const dtQueryFilter &filter, dtPolyRef startRef, const Vec3 &start, const Vec3 &end, dtPolyRef *polys, int npolys, std::vector<Vec3> &pathPoints) const
+{
+    static const int MAX_SMOOTH = 2048;
+    //// Iterate over the path to find smooth path on the detail mesh surface.
+    //dtPolyRef polys[MAX_POLYS];
+    //memcpy(polys, polys, sizeof(dtPolyRef)*npolys);
+    //int npolys = npolys;
 
-        static const float STEP_SIZE = 0.5f;
-        static const float SLOP = 0.01f;
+    float iterPos[3], targetPos[3];
+    navMeshQuery->closestPointOnPoly(startRef, &start.x, iterPos, 0);
+    navMeshQuery->closestPointOnPoly(polys[npolys - 1], &end.x, targetPos, 0);
 
-        int nsmoothPath = 0;
-        //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
-        //m_nsmoothPath++;
+    static const float STEP_SIZE = 0.5f;
+    static const float SLOP = 0.01f;
 
-        pathPoints.push_back(Vec3(iterPos[0], iterPos[1], iterPos[2]));
-        nsmoothPath++;
+    int nsmoothPath = 0;
+    //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
+    //m_nsmoothPath++;
+
+    pathPoints.push_back(Vec3(iterPos[0], iterPos[1], iterPos[2]));
+    nsmoothPath++;
+
+    // Move towards target a small advancement at a time until target reached or
+    // when ran out of memory to store the path.
+    while (npolys && nsmoothPath < MAX_SMOOTH)
+    {
+        // Find location to steer towards.
+        float steerPos[3];
+        unsigned char steerPosFlag;
+        dtPolyRef steerPosRef;
 
-        // Move towards target a small advancement at a time until target reached or
-        // when ran out of memory to store the path.
-        while (npolys && nsmoothPath < MAX_SMOOTH)
+        if (!getSteerTarget(navMeshQuery, iterPos, targetPos, SLOP,
+            polys, npolys, steerPos, steerPosFlag, steerPosRef))
+            break;
+
+        bool endOfPath = (steerPosFlag & DT_STRAIGHTPATH_END) ? true : false;
+        bool offMeshConnection = (steerPosFlag & DT_STRAIGHTPATH_OFFMESH_CONNECTION) ? true : false;
+
+        // Find movement delta.
+        float delta[3], len;
+        dtVsub(delta, steerPos, iterPos);
+        len = dtMathSqrtf(dtVdot(delta, delta));
+        // If the steer target is end of path or off-mesh link, do not move past the location.
+        if ((endOfPath || offMeshConnection) && len < STEP_SIZE)
+            len = 1;
+        else
+            len = STEP_SIZE / len;
+        float moveTgt[3];
+        dtVmad(moveTgt, iterPos, delta, len);
+
+        // Move
+        float result[3];
+        dtPolyRef visited[16];
+        int nvisited = 0;
+        navMeshQuery->moveAlongSurface(polys[0], iterPos, moveTgt, &filter,
+            result, visited, &nvisited, 16);
+
+        npolys = fixupCorridor(polys, npolys, MAX_POLYS, visited, nvisited);
+        npolys = fixupShortcuts(polys, npolys, navMeshQuery);
+
+        float h = 0;
+        navMeshQuery->getPolyHeight(polys[0], result, &h);
+        result[1] = h;
+        dtVcopy(iterPos, result);
+
+        // Handle end of path and off-mesh links when close enough.
+        if (endOfPath && inRange(iterPos, steerPos, SLOP, 1.0f))
         {
-            // Find location to steer towards.
-            float steerPos[3];
-            unsigned char steerPosFlag;
-            dtPolyRef steerPosRef;
-
-            if (!getSteerTarget(_navMeshQuery, iterPos, targetPos, SLOP,
-                polys, npolys, steerPos, steerPosFlag, steerPosRef))
-                break;
-
-            bool endOfPath = (steerPosFlag & DT_STRAIGHTPATH_END) ? true : false;
-            bool offMeshConnection = (steerPosFlag & DT_STRAIGHTPATH_OFFMESH_CONNECTION) ? true : false;
-
-            // Find movement delta.
-            float delta[3], len;
-            dtVsub(delta, steerPos, iterPos);
-            len = dtMathSqrtf(dtVdot(delta, delta));
-            // If the steer target is end of path or off-mesh link, do not move past the location.
-            if ((endOfPath || offMeshConnection) && len < STEP_SIZE)
-                len = 1;
-            else
-                len = STEP_SIZE / len;
-            float moveTgt[3];
-            dtVmad(moveTgt, iterPos, delta, len);
-
-            // Move
-            float result[3];
-            dtPolyRef visited[16];
-            int nvisited = 0;
-            _navMeshQuery->moveAlongSurface(polys[0], iterPos, moveTgt, &filter,
-                result, visited, &nvisited, 16);
-
-            npolys = fixupCorridor(polys, npolys, MAX_POLYS, visited, nvisited);
-            npolys = fixupShortcuts(polys, npolys, _navMeshQuery);
-
-            float h = 0;
-            _navMeshQuery->getPolyHeight(polys[0], result, &h);
-            result[1] = h;
-            dtVcopy(iterPos, result);
-
-            // Handle end of path and off-mesh links when close enough.
-            if (endOfPath && inRange(iterPos, steerPos, SLOP, 1.0f))
+            // Reached end of path.
+            dtVcopy(iterPos, targetPos);
+            if (nsmoothPath < MAX_SMOOTH)
             {
-                // Reached end of path.
-                dtVcopy(iterPos, targetPos);
-                if (nsmoothPath < MAX_SMOOTH)
-                {
-                    //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
-                    //m_nsmoothPath++;
-                    pathPoints.push_back(Vec3(iterPos[0], iterPos[1], iterPos[2]));
-                    nsmoothPath++;
-                }
-                break;
+                //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
+                //m_nsmoothPath++;
+                pathPoints.push_back(Vec3(iterPos[0], iterPos[1], iterPos[2]));
+                nsmoothPath++;
             }
-            else if (offMeshConnection && inRange(iterPos, steerPos, SLOP, 1.0f))
-            {
-                // Reached off-mesh connection.
-                float startPos[3], endPos[3];
+            break;
+        }
+        else if (offMeshConnection && inRange(iterPos, steerPos, SLOP, 1.0f))
+        {
+            // Reached off-mesh connection.
+            float startPos[3], endPos[3];
 
-                // Advance the path up to and over the off-mesh connection.
-                dtPolyRef prevRef = 0, polyRef = polys[0];
-                int npos = 0;
-                while (npos < npolys && polyRef != steerPosRef)
-                {
-                    prevRef = polyRef;
-                    polyRef = polys[npos];
-                    npos++;
-                }
-                for (int i = npos; i < npolys; ++i)
-                    polys[i - npos] = polys[i];
-                npolys -= npos;
+            // Advance the path up to and over the off-mesh connection.
+            dtPolyRef prevRef = 0, polyRef = polys[0];
+            int npos = 0;
+            while (npos < npolys && polyRef != steerPosRef)
+            {
+                prevRef = polyRef;
+                polyRef = polys[npos];
+                npos++;
+            }
+            for (int i = npos; i < npolys; ++i)
+                polys[i - npos] = polys[i];
+            npolys -= npos;
 
-                // Handle the connection.
-                dtStatus status = _navMesh->getOffMeshConnectionPolyEndPoints(prevRef, polyRef, startPos, endPos);
-                if (dtStatusSucceed(status))
+            // Handle the connection.
+            dtStatus status = _navMesh->getOffMeshConnectionPolyEndPoints(prevRef, polyRef, startPos, endPos);
+            if (dtStatusSucceed(status))
+            {
+                if (nsmoothPath < MAX_SMOOTH)
                 {
-                    if (nsmoothPath < MAX_SMOOTH)
+                    //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], startPos);
+                    //m_nsmoothPath++;
+                    pathPoints.push_back(Vec3(startPos[0], startPos[1], startPos[2]));
+                    nsmoothPath++;
+                    // Hack to make the dotted path not visible during off-mesh connection.
+                    if (nsmoothPath & 1)
                     {
                         //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], startPos);
                         //m_nsmoothPath++;
                         pathPoints.push_back(Vec3(startPos[0], startPos[1], startPos[2]));
                         nsmoothPath++;
-                        // Hack to make the dotted path not visible during off-mesh connection.
-                        if (nsmoothPath & 1)
-                        {
-                            //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], startPos);
-                            //m_nsmoothPath++;
-                            pathPoints.push_back(Vec3(startPos[0], startPos[1], startPos[2]));
-                            nsmoothPath++;
-                        }
                     }
-                    // Move position at the other side of the off-mesh link.
-                    dtVcopy(iterPos, endPos);
-                    float eh = 0.0f;
-                    _navMeshQuery->getPolyHeight(polys[0], iterPos, &eh);
-                    iterPos[1] = eh;
                 }
+                // Move position at the other side of the off-mesh link.
+                dtVcopy(iterPos, endPos);
+                float eh = 0.0f;
+                navMeshQuery->getPolyHeight(polys[0], iterPos, &eh);
+                iterPos[1] = eh;
             }
+        }
 
-            // Store results.
-            if (nsmoothPath < MAX_SMOOTH)
-            {
-                //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
-                //m_nsmoothPath++;
+        // Store results.
+        if (nsmoothPath < MAX_SMOOTH)
+        {
+            //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
+            //m_nsmoothPath++;
 
-                pathPoints.push_back(Vec3(iterPos[0], iterPos[1], iterPos[2]));
-                nsmoothPath++;
-            }
+            pathPoints.push_back(Vec3(iterPos[0], iterPos[1], iterPos[2]));
+            nsmoothPath++;
         }
     }
 }
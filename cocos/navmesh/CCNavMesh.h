@@ -34,7 +34,12 @@
 #include "recast/Detour/DetourNavMeshQuery.h"
 #include "recast/DetourCrowd/DetourCrowd.h"
 #include "recast/DetourTileCache/DetourTileCache.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "navmesh/CCNavMeshAgent.h"
@@ -55,6 +60,8 @@ class CC_DLL NavMesh final
 {
 public:
 
+    typedef std::function<void(const std::vector<Vec3> &pathPoints)> FindPathCallback;
+
     /**
     Create navmesh
 
@@ -97,14 +104,63 @@ public:
     */
     void findPath(const Vec3 &start, const Vec3 &end, std::vector<Vec3> &pathPoints);
 
+    /**
+    find a path on navmesh asynchronously
+
+    The queries run at the beginning of update(), spread over the threads of the JobPool, each of them
+    searching with its own dtNavMeshQuery. A query which needs more search iterations than the budget
+    continues on the next update. Identical queries which are pending at the same time are searched once.
+    The callbacks are called at the end of update(), with empty pathPoints when no path was found.
+
+    @param start The start search position in world coordinate system.
+    @param end The end search position in world coordinate system.
+    @param callback Called with the key points of path.
+    @return The id of the query, see cancelPathQuery.
+    */
+    unsigned int findPathAsync(const Vec3 &start, const Vec3 &end, const FindPathCallback &callback);
+
+    /** cancel a query of findPathAsync which didn't finish yet, its callback won't be called. */
+    void cancelPathQuery(unsigned int queryId);
+
+    /** set the maximum search iterations of each thread per update for findPathAsync, 1024 by default. */
+    void setPathQueryBudget(int iterations);
+
+    /** get the search iterations of each thread per update. */
+    int getPathQueryBudget() const { return _pathQueryBudget; }
+
 private:
 
+    struct PathQuery
+    {
+        Vec3 start;
+        Vec3 end;
+        std::vector<std::pair<unsigned int, FindPathCallback>> callbacks;
+        std::vector<Vec3> pathPoints;
+        dtPolyRef startRef;
+        bool started;
+    };
+
+    /** the queries searched by one thread, the sliced search of the front query is kept by the dtNavMeshQuery between updates */
+    struct PathQueryLane
+    {
+        dtNavMeshQuery *query;
+        dtQueryFilter filter;
+        std::deque<PathQuery*> queries;
+        std::vector<PathQuery*> finished;
+    };
+
+    typedef std::tuple<float, float, float, float, float, float> PathQueryKey;
+
     void loadNavMeshFile();
     void loadGeomFile();
     void dtDraw();
     void drawAgents();
     void drawObstacles();
     void drawOffMeshConnections();
+    void smoothPath(dtNavMeshQuery *navMeshQuery, const dtQueryFilter &filter, dtPolyRef startRef, const Vec3 &start, const Vec3 &end, dtPolyRef *polys, int npolys, std::vector<Vec3> &pathPoints) const;
+    void runPathQueries();
+    void runPathQueries(PathQueryLane &lane);
+    void deliverPathQueries();
 
 private:
 
@@ -123,6 +179,13 @@ private:
     std::string _navFilePath;
     std::string _geomFilePath;
     bool _isDebugDrawEnabled;
+
+    std::map<PathQueryKey, std::unique_ptr<PathQuery>> _pathQueries; // the pending queries by start and end
+    std::vector<PathQuery*> _newPathQueries;
+    std::vector<PathQueryLane> _pathQueryLanes;
+    std::vector<std::unique_ptr<PathQuery>> _finishedPathQueries;
+    unsigned int _nextPathQueryId;
+    int _pathQueryBudget;
 };
 
 /** @} */
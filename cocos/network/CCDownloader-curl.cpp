@@ -24,7 +24,9 @@
 
 #include "network/CCDownloader-curl.h"
 
+#include <algorithm>
 #include <set>
+#include <chrono>
 
 #include <curl/curl.h>
 
@@ -45,6 +47,48 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
 
     using namespace std;
 
+    // the chunks of a split file task land in the temp file at their offsets
+    static int seekFile(FILE* fp, int64_t offset)
+    {
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+        return _fseeki64(fp, offset, SEEK_SET);
+#else
+        return fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+    }
+
+    // whether the last response in the header lines, redirects included, accepts byte ranges
+    static bool acceptsByteRanges(const string& header)
+    {
+        static const char ACCEPT_RANGES[] = "accept-ranges:";
+        static const size_t ACCEPT_RANGES_LEN = sizeof(ACCEPT_RANGES) - 1;
+
+        bool accepted = false;
+        size_t begin = 0;
+        while (begin < header.size())
+        {
+            size_t end = header.find('\n', begin);
+            if (string::npos == end)
+            {
+                end = header.size();
+            }
+            string line = header.substr(begin, end - begin);
+            begin = end + 1;
+            std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+
+            if (0 == line.compare(0, 5, "http/"))
+            {
+                accepted = false;
+            }
+            else if (0 == line.compare(0, ACCEPT_RANGES_LEN, ACCEPT_RANGES))
+            {
+                // "none" or any other unit means no byte ranges
+                accepted = string::npos != line.find("bytes", ACCEPT_RANGES_LEN);
+            }
+        }
+        return accepted;
+    }
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Implementation DownloadTaskCURL
 
@@ -95,6 +139,7 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             _fileName = filename;
             _tempFileName = filename;
             _tempFileName.append(tempSuffix);
+            _chunkFileName = _tempFileName + ".chunks";
 
             if (_sStoragePathSet.end() != _sStoragePathSet.find(_tempFileName))
             {
@@ -165,6 +210,115 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             _errDescription = desc;
         }
 
+        // A byte range of a file task, downloaded on its own curl handle
+        struct Chunk
+        {
+            DownloadTaskCURL* task;
+            int64_t begin;      // offset of the first byte in the file
+            int64_t end;        // offset after the last byte
+            int64_t received;
+            bool    rangeChecked;
+            CURL*   handle;
+        };
+
+        size_t writeChunkProc(Chunk& chunk, unsigned char *buffer, size_t size, size_t count)
+        {
+            size_t len = size * count;
+            if (!chunk.rangeChecked)
+            {
+                // a server which ignores the range sends the whole file, the task then falls back to a single stream
+                long httpResponseCode = 0;
+                curl_easy_getinfo(chunk.handle, CURLINFO_RESPONSE_CODE, &httpResponseCode);
+                if (206 != httpResponseCode)
+                {
+                    _rangesRejected = true;
+                    return 0;
+                }
+                chunk.rangeChecked = true;
+            }
+            if (chunk.received + (int64_t)len > chunk.end - chunk.begin)
+            {
+                return 0;
+            }
+
+            lock_guard<mutex> lock(_mutex);
+            if (0 != seekFile(_fp, chunk.begin + chunk.received))
+            {
+                return 0;
+            }
+            size_t ret = fwrite(buffer, 1, len, _fp);
+            chunk.received += ret;
+            _bytesReceived += ret;
+            _totalBytesReceived += ret;
+            return ret;
+        }
+
+        // The chunk file lists the chunks of a split temp file, so a later task resumes each of them.
+        // A temp file without chunk file was written from its beginning.
+        bool loadChunksProc(int64_t totalBytesExpected)
+        {
+            FILE* fp = fopen(FileUtils::getInstance()->getSuitableFOpen(_chunkFileName).c_str(), "rb");
+            if (nullptr == fp)
+            {
+                return false;
+            }
+
+            long long total = 0;
+            int count = 0;
+            bool valid = 2 == fscanf(fp, "%lld %d", &total, &count) && total == totalBytesExpected && count > 0;
+            vector<Chunk> chunks;
+            int64_t next = 0;
+            for (int i = 0; valid && i < count; ++i)
+            {
+                long long begin = 0, end = 0, received = 0;
+                // the chunks cover the file in order
+                valid = 3 == fscanf(fp, "%lld %lld %lld", &begin, &end, &received)
+                    && begin == next && end > begin && received >= 0 && received <= end - begin;
+                chunks.push_back({this, begin, end, received, false, nullptr});
+                next = end;
+            }
+            fclose(fp);
+
+            if (!valid || next != totalBytesExpected)
+            {
+                return false;
+            }
+            _chunks = std::move(chunks);
+            return true;
+        }
+
+        void saveChunksProc()
+        {
+            lock_guard<mutex> lock(_mutex);
+            // the received bytes must be in the temp file before the chunk file counts them
+            fflush(_fp);
+            FILE* fp = fopen(FileUtils::getInstance()->getSuitableFOpen(_chunkFileName).c_str(), "wb");
+            if (nullptr == fp)
+            {
+                return;
+            }
+            fprintf(fp, "%lld %d\n", (long long)_totalBytesExpected, (int)_chunks.size());
+            for (auto& chunk : _chunks)
+            {
+                fprintf(fp, "%lld %lld %lld\n", (long long)chunk.begin, (long long)chunk.end, (long long)chunk.received);
+            }
+            fclose(fp);
+            _chunksSavedTime = chrono::steady_clock::now();
+        }
+
+        // Empties the temp file, it's only invoked before any transfer of the task
+        bool truncateFileProc()
+        {
+            auto util = FileUtils::getInstance();
+            if (_fp)
+            {
+                fclose(_fp);
+            }
+            _fp = fopen(util->getSuitableFOpen(_tempFileName).c_str(), "wb");
+            util->removeFile(_chunkFileName);
+            return nullptr != _fp;
+        }
+
         size_t writeDataProc(unsigned char *buffer, size_t size, size_t count)
         {
             lock_guard<mutex> lock(_mutex);
@@ -220,6 +374,13 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
         vector<unsigned char> _buf;
         FILE*  _fp;
 
+        // for split file task, only used in thread proc
+        string _chunkFileName;
+        vector<Chunk> _chunks;
+        int _runningChunks;
+        bool _rangesRejected;
+        chrono::steady_clock::time_point _chunksSavedTime;
+
         void _initInternal()
         {
             _acceptRanges = (false);
@@ -229,6 +390,9 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             _totalBytesExpected = (0);
             _errCode = (DownloadTask::ERROR_NO_ERROR);
             _errCodeInternal = (CURLE_OK);
+            _chunks.clear();
+            _runningChunks = 0;
+            _rangesRejected = false;
             _header.resize(0);
             _header.reserve(384);   // pre alloc header string buffer
         }
@@ -247,7 +411,8 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
         DownloaderHints hints;
 
         Impl()
-//        : _thread(nullptr)
+        : _curlmHandle(nullptr)
+        , _processingTaskCount(0)
         {
             DLLOG("Construct DownloaderCURL::Impl %p", this);
         }
@@ -263,6 +428,13 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             {
                 lock_guard<mutex> lock(_requestMutex);
                 _requestQueue.push_back(make_pair(task, coTask));
+#if LIBCURL_VERSION_NUM >= 0x074400
+                // the work thread may be waiting for its transfers
+                if (_curlmHandle)
+                {
+                    curl_multi_wakeup(_curlmHandle);
+                }
+#endif
             }
             else
             {
@@ -330,10 +502,16 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             return coTask->writeDataProc((unsigned char *)buffer, size, count);
         }
 
+        static size_t _outputChunkCallbackProc(void *buffer, size_t size, size_t count, void *userdata)
+        {
+            DownloadTaskCURL::Chunk *chunk = (DownloadTaskCURL::Chunk*)userdata;
+            return chunk->task->writeChunkProc(*chunk, (unsigned char *)buffer, size, count);
+        }
+
         // this function designed call in work thread
         // the curl handle destroyed in _threadProc
-        // handle inited for get header
-        void _initCurlHandleProc(CURL *handle, TaskWrapper& wrapper, bool forContent = false)
+        // handle inited for get header, or for a chunk of the content
+        void _initCurlHandleProc(CURL *handle, TaskWrapper& wrapper, bool forContent = false, DownloadTaskCURL::Chunk* chunk = nullptr)
         {
             const DownloadTask& task = *wrapper.first;
             const DownloadTaskCURL* coTask = wrapper.second;
@@ -342,15 +520,23 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             curl_easy_setopt(handle, CURLOPT_URL, task.requestURL.c_str());
 
             // set write func
-            if (forContent)
+            if (chunk)
+            {
+                chunk->handle = handle;
+                curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, DownloaderCURL::Impl::_outputChunkCallbackProc);
+                curl_easy_setopt(handle, CURLOPT_WRITEDATA, chunk);
+                curl_easy_setopt(handle, CURLOPT_PRIVATE, chunk);
+            }
+            else if (forContent)
             {
                 curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, DownloaderCURL::Impl::_outputDataCallbackProc);
+                curl_easy_setopt(handle, CURLOPT_WRITEDATA, coTask);
             }
             else
             {
                 curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, DownloaderCURL::Impl::_outputHeaderCallbackProc);
+                curl_easy_setopt(handle, CURLOPT_WRITEDATA, coTask);
             }
-            curl_easy_setopt(handle, CURLOPT_WRITEDATA, coTask);
 
             curl_easy_setopt(handle, CURLOPT_NOPROGRESS, true);
 //            curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, DownloaderCURL::Impl::_progressCallbackProc);
@@ -359,7 +545,13 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             curl_easy_setopt(handle, CURLOPT_FAILONERROR, true);
             curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
 
-            if (forContent)
+            if (chunk)
+            {
+                char range[64];
+                sprintf(range, "%lld-%lld", (long long)(chunk->begin + chunk->received), (long long)(chunk->end - 1));
+                curl_easy_setopt(handle, CURLOPT_RANGE, range);
+            }
+            else if (forContent)
             {
                 /** if server acceptRanges and local has part of file, we continue to download **/
                 if (coTask->_acceptRanges && coTask->_totalBytesReceived > 0)
@@ -428,20 +620,60 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
                     break;
                 }
 
-                bool acceptRanges = (string::npos != coTask._header.find("Accept-Ranges")) ? true : false;
+                bool acceptRanges = acceptsByteRanges(coTask._header);
 
-                // get current file size
+                // get current file size, or the chunks of a split file
                 int64_t fileSize = 0;
-                if (acceptRanges && coTask._tempFileName.length())
+                int64_t chunksReceived = 0;
+                if (coTask._tempFileName.length())
                 {
-                    fileSize = FileUtils::getInstance()->getFileSize(coTask._tempFileName);
+                    auto util = FileUtils::getInstance();
+                    bool resumable = false;
+                    if (util->isFileExist(coTask._chunkFileName))
+                    {
+                        // a split file only resumes with the chunks it was written with
+                        resumable = acceptRanges && coTask.loadChunksProc((int64_t)contentLen);
+                        for (auto& chunk : coTask._chunks)
+                        {
+                            chunksReceived += chunk.received;
+                        }
+                    }
+                    else if (acceptRanges)
+                    {
+                        fileSize = util->getFileSize(coTask._tempFileName);
+                        resumable = fileSize > 0 && fileSize <= (int64_t)contentLen;
+                    }
+
+                    // the data of another version or server can't be continued
+                    if (!resumable)
+                    {
+                        fileSize = 0;
+                        coTask._chunks.clear();
+                        bool truncated = true;
+                        if (util->getFileSize(coTask._tempFileName) > 0 || util->isFileExist(coTask._chunkFileName))
+                        {
+                            lock_guard<mutex> lock(coTask._mutex);
+                            truncated = coTask.truncateFileProc();
+                        }
+                        if (!truncated)
+                        {
+                            string desc = "Can't open file:";
+                            desc.append(coTask._tempFileName);
+                            coTask.setErrorProc(DownloadTask::ERROR_FILE_OP_FAILED, 0, desc.c_str());
+                            break;
+                        }
+                    }
                 }
 
                 // set header info to coTask
                 lock_guard<mutex> lock(coTask._mutex);
                 coTask._totalBytesExpected = (int64_t)contentLen;
                 coTask._acceptRanges = acceptRanges;
-                if (acceptRanges && fileSize > 0)
+                if (coTask._chunks.size())
+                {
+                    coTask._totalBytesReceived = chunksReceived;
+                }
+                else if (acceptRanges && fileSize > 0)
                 {
                     coTask._totalBytesReceived = fileSize;
                 }
@@ -455,6 +687,209 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             return coTask._headerAchieved;
         }
 
+        // splits a file task into chunks downloaded in parallel, the chunks of a resumed task are kept
+        bool _splitTaskProc(TaskWrapper& wrapper)
+        {
+            DownloadTaskCURL& coTask = *wrapper.second;
+            if (coTask._chunks.size())
+            {
+                return true;
+            }
+            int64_t minChunkSize = hints.minChunkSizeInBytes;
+            if (nullptr == coTask._fp || !coTask._acceptRanges || hints.countOfMaxChunksPerTask < 2 || minChunkSize <= 0)
+            {
+                return false;
+            }
+            int64_t begin = coTask._totalBytesReceived;
+            int64_t remaining = coTask._totalBytesExpected - begin;
+            int64_t count = std::min<int64_t>(hints.countOfMaxChunksPerTask, remaining / minChunkSize);
+            if (count < 2)
+            {
+                return false;
+            }
+
+            // the data of a temp file written from its beginning is the first chunk
+            if (begin > 0)
+            {
+                coTask._chunks.push_back({&coTask, 0, begin, begin, true, nullptr});
+            }
+            for (int64_t i = 0; i < count; ++i)
+            {
+                coTask._chunks.push_back({&coTask, begin + remaining * i / count, begin + remaining * (i + 1) / count, 0, false, nullptr});
+            }
+            return true;
+        }
+
+        // adds a curl handle for each unfinished chunk, returns false if none is running
+        bool _startChunksProc(CURLM* curlmHandle, TaskWrapper& wrapper, unordered_map<CURL*, TaskWrapper>& coTaskMap)
+        {
+            DownloadTaskCURL& coTask = *wrapper.second;
+            {
+                // the chunks seek in the file, which an append stream doesn't allow
+                lock_guard<mutex> lock(coTask._mutex);
+                fclose(coTask._fp);
+                coTask._fp = fopen(FileUtils::getInstance()->getSuitableFOpen(coTask._tempFileName).c_str(), "r+b");
+            }
+            if (nullptr == coTask._fp)
+            {
+                string desc = "Can't open file:";
+                desc.append(coTask._tempFileName);
+                coTask.setErrorProc(DownloadTask::ERROR_FILE_OP_FAILED, 0, desc.c_str());
+                return false;
+            }
+            coTask.saveChunksProc();
+
+            for (auto& chunk : coTask._chunks)
+            {
+                if (chunk.received == chunk.end - chunk.begin)
+                {
+                    continue;
+                }
+                CURL* curlHandle = curl_easy_init();
+                if (nullptr == curlHandle)
+                {
+                    coTask.setErrorProc(DownloadTask::ERROR_IMPL_INTERNAL, 0, "Alloc curl handle failed.");
+                    break;
+                }
+                _initCurlHandleProc(curlHandle, wrapper, true, &chunk);
+                CURLMcode mcode = curl_multi_add_handle(curlmHandle, curlHandle);
+                if (CURLM_OK != mcode)
+                {
+                    curl_easy_cleanup(curlHandle);
+                    coTask.setErrorProc(DownloadTask::ERROR_IMPL_INTERNAL, mcode, curl_multi_strerror(mcode));
+                    break;
+                }
+                DLLOG("    _threadProc task create chunk curl handle:%p", curlHandle);
+                coTaskMap[curlHandle] = wrapper;
+                ++coTask._runningChunks;
+            }
+            return coTask._runningChunks > 0;
+        }
+
+        // stops the running chunks of a task
+        void _stopChunksProc(CURLM* curlmHandle, DownloadTaskCURL& coTask, unordered_map<CURL*, TaskWrapper>& coTaskMap)
+        {
+            for (auto iter = coTaskMap.begin(); iter != coTaskMap.end();)
+            {
+                if (iter->second.second == &coTask)
+                {
+                    curl_multi_remove_handle(curlmHandle, iter->first);
+                    curl_easy_cleanup(iter->first);
+                    iter = coTaskMap.erase(iter);
+                    --coTask._runningChunks;
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+        }
+
+        // downloads the whole file of a task on a single handle, after the server refused the ranges of its chunks
+        bool _restartUnsplitProc(CURLM* curlmHandle, TaskWrapper& wrapper, unordered_map<CURL*, TaskWrapper>& coTaskMap)
+        {
+            DownloadTaskCURL& coTask = *wrapper.second;
+            bool truncated = false;
+            {
+                lock_guard<mutex> lock(coTask._mutex);
+                coTask._chunks.clear();
+                coTask._acceptRanges = false;
+                coTask._totalBytesReceived = 0;
+                truncated = coTask.truncateFileProc();
+            }
+            if (!truncated)
+            {
+                string desc = "Can't open file:";
+                desc.append(coTask._tempFileName);
+                coTask.setErrorProc(DownloadTask::ERROR_FILE_OP_FAILED, 0, desc.c_str());
+                return false;
+            }
+
+            CURL* curlHandle = curl_easy_init();
+            if (nullptr == curlHandle)
+            {
+                coTask.setErrorProc(DownloadTask::ERROR_IMPL_INTERNAL, 0, "Alloc curl handle failed.");
+                return false;
+            }
+            _initCurlHandleProc(curlHandle, wrapper, true);
+            CURLMcode mcode = curl_multi_add_handle(curlmHandle, curlHandle);
+            if (CURLM_OK != mcode)
+            {
+                curl_easy_cleanup(curlHandle);
+                coTask.setErrorProc(DownloadTask::ERROR_IMPL_INTERNAL, mcode, curl_multi_strerror(mcode));
+                return false;
+            }
+            DLLOG("    _threadProc task restart unsplit with curl handle:%p", curlHandle);
+            coTaskMap[curlHandle] = wrapper;
+            return true;
+        }
+
+        // cleans up the handle of a finished chunk, returns true when the last chunk of the task finished
+        bool _finishChunkProc(CURLM* curlmHandle, CURL* curlHandle, CURLcode errCode, DownloadTaskCURL::Chunk& chunk, TaskWrapper& wrapper, unordered_map<CURL*, TaskWrapper>& coTaskMap)
+        {
+            DownloadTaskCURL& coTask = *chunk.task;
+            curl_easy_cleanup(curlHandle);
+            coTaskMap.erase(curlHandle);
+            --coTask._runningChunks;
+
+            if (coTask._rangesRejected)
+            {
+                _stopChunksProc(curlmHandle, coTask, coTaskMap);
+                return false == _restartUnsplitProc(curlmHandle, wrapper, coTaskMap);
+            }
+
+            bool failed = CURLE_OK != errCode || chunk.received != chunk.end - chunk.begin;
+            if (failed && DownloadTask::ERROR_NO_ERROR == coTask._errCode)
+            {
+                if (CURLE_OK != errCode)
+                {
+                    coTask.setErrorProc(DownloadTask::ERROR_IMPL_INTERNAL, errCode, curl_easy_strerror(errCode));
+                }
+                else
+                {
+                    coTask.setErrorProc(DownloadTask::ERROR_IMPL_INTERNAL, CURLE_OK, "The server closed a chunk before its end.");
+                }
+
+                // stop the other chunks of the task, the chunk file keeps what they received
+                _stopChunksProc(curlmHandle, coTask, coTaskMap);
+            }
+            if (coTask._runningChunks > 0)
+            {
+                return false;
+            }
+
+            if (DownloadTask::ERROR_NO_ERROR == coTask._errCode)
+            {
+                lock_guard<mutex> lock(coTask._mutex);
+                fflush(coTask._fp);
+                FileUtils::getInstance()->removeFile(coTask._chunkFileName);
+            }
+            else
+            {
+                coTask.saveChunksProc();
+            }
+            return true;
+        }
+
+        void _finishTaskProc(TaskWrapper& wrapper)
+        {
+            --_processingTaskCount;
+
+            // remove from _processSet
+            {
+                lock_guard<mutex> lock(_processMutex);
+                if (_processSet.end() != _processSet.find(wrapper)) {
+                    _processSet.erase(wrapper);
+                }
+            }
+
+            // add to finishedQueue
+            {
+                lock_guard<mutex> lock(_finishedMutex);
+                _finishedQueue.push_back(wrapper);
+            }
+        }
+
         void _threadProc()
         {
             DLLOG("++++DownloaderCURL::Impl::_threadProc begin %p", this);
@@ -467,7 +902,10 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
             unordered_map<CURL*, TaskWrapper> coTaskMap;
             int runningHandles = 0;
             CURLMcode mcode = CURLM_OK;
-            int rc = 0;                 // select return code
+            {
+                lock_guard<mutex> lock(_requestMutex);
+                _curlmHandle = curlmHandle;
+            }
 
             do
             {
@@ -483,51 +921,23 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
 
                 if (runningHandles)
                 {
-                    // get timeout setting from multi-handle
-                    long timeoutMS = -1;
-                    curl_multi_timeout(curlmHandle, &timeoutMS);
-
-                    if(timeoutMS < 0)
+                    // wait for the sockets of the transfers, addTask wakes the wait up
+#if LIBCURL_VERSION_NUM >= 0x074400
+                    mcode = curl_multi_poll(curlmHandle, nullptr, 0, 1000, nullptr);
+#else
+                    int numfds = 0;
+                    mcode = curl_multi_wait(curlmHandle, nullptr, 0, 1000, &numfds);
+                    if (CURLM_OK == mcode && 0 == numfds)
                     {
-                        timeoutMS = 1000;
+                        // curl_multi_wait doesn't wait when no socket is ready to be waited for
+                        this_thread::sleep_for(chrono::milliseconds(10));
                     }
-
-                    /* get file descriptors from the transfers */
-                    fd_set fdread;
-                    fd_set fdwrite;
-                    fd_set fdexcep;
-                    int maxfd = -1;
-
-                    FD_ZERO(&fdread);
-                    FD_ZERO(&fdwrite);
-                    FD_ZERO(&fdexcep);
-
-                    mcode = curl_multi_fdset(curlmHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+#endif
                     if (CURLM_OK != mcode)
                     {
+                        DLLOG("    _threadProc: wait return unexpect code: %d", mcode);
                         break;
                     }
-
-                    // do wait action
-                    if(maxfd == -1)
-                    {
-                        this_thread::sleep_for(chrono::milliseconds(timeoutMS));
-                        rc = 0;
-                    }
-                    else
-                    {
-                        struct timeval timeout;
-
-                        timeout.tv_sec = timeoutMS / 1000;
-                        timeout.tv_usec = (timeoutMS % 1000) * 1000;
-
-                        rc = select(maxfd+1, &fdread, &fdwrite, &fdexcep, &timeout);
-                    }
-
-                    if (rc < 0)
-                    {
-                        DLLOG("    _threadProc: select return unexpect code: %d", rc);
-                    }
                 }
 
                 if (coTaskMap.size())
@@ -555,7 +965,20 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
 
                             // remove from multi-handle
                             curl_multi_remove_handle(curlmHandle, curlHandle);
+
+                            DownloadTaskCURL::Chunk* chunk = nullptr;
+                            curl_easy_getinfo(curlHandle, CURLINFO_PRIVATE, (char**)&chunk);
+                            if (chunk)
+                            {
+                                if (_finishChunkProc(curlmHandle, curlHandle, errCode, *chunk, wrapper, coTaskMap))
+                                {
+                                    _finishTaskProc(wrapper);
+                                }
+                                continue;
+                            }
+
                             bool reinited = false;
+                            bool split = false;
                             do
                             {
                                 if (CURLE_OK != errCode)
@@ -586,8 +1009,19 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
                                 {
                                     // the file has download complete
                                     // break to move this task to finish queue
+                                    if (wrapper.second->_chunks.size())
+                                    {
+                                        FileUtils::getInstance()->removeFile(wrapper.second->_chunkFileName);
+                                    }
                                     break;
                                 }
+                                // a large file is downloaded in chunks on handles of their own
+                                if (_splitTaskProc(wrapper))
+                                {
+                                    split = _startChunksProc(curlmHandle, wrapper, coTaskMap);
+                                    break;
+                                }
+
                                 // reinit curl handle for download content
                                 curl_easy_reset(curlHandle);
                                 _initCurlHandleProc(curlHandle, wrapper, true);
@@ -610,26 +1044,28 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
                            // remove from coTaskMap
                             coTaskMap.erase(curlHandle);
 
-                            // remove from _processSet
+                            if (split)
                             {
-                                lock_guard<mutex> lock(_processMutex);
-                                if (_processSet.end() != _processSet.find(wrapper)) {
-                                    _processSet.erase(wrapper);
-                                }
-                            }
-
-                            // add to finishedQueue
-                            {
-                                lock_guard<mutex> lock(_finishedMutex);
-                                _finishedQueue.push_back(wrapper);
+                                continue;
                             }
+                            _finishTaskProc(wrapper);
                         }
                     } while(m);
+
+                    // keep the chunk files of split tasks close to their temp files
+                    auto now = chrono::steady_clock::now();
+                    for (auto& item : coTaskMap)
+                    {
+                        DownloadTaskCURL& coTask = *item.second.second;
+                        if (coTask._runningChunks > 0 && now - coTask._chunksSavedTime >= chrono::seconds(1))
+                        {
+                            coTask.saveChunksProc();
+                        }
+                    }
                 }
 
-                // process tasks in _requestList
-                auto size = coTaskMap.size();
-                while (0 == countOfMaxProcessingTasks || size < countOfMaxProcessingTasks)
+                // process tasks in _requestList, the chunks of a task count as one
+                while (0 == countOfMaxProcessingTasks || _processingTaskCount < countOfMaxProcessingTasks)
                 {
                     // get task wrapper from request queue
                     TaskWrapper wrapper;
@@ -676,17 +1112,36 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
 
                     DLLOG("    _threadProc task create curl handle:%p", curlHandle);
                     coTaskMap[curlHandle] = wrapper;
+                    ++_processingTaskCount;
                     lock_guard<mutex> lock(_processMutex);
                     _processSet.insert(wrapper);
                 }
             } while (coTaskMap.size());
 
+            // a stopped downloader leaves its split tasks to be resumed from what their chunks received
+            for (auto& item : coTaskMap)
+            {
+                DownloadTaskCURL& coTask = *item.second.second;
+                if (coTask._runningChunks > 0)
+                {
+                    coTask.saveChunksProc();
+                }
+                curl_multi_remove_handle(curlmHandle, item.first);
+                curl_easy_cleanup(item.first);
+            }
+
+            {
+                lock_guard<mutex> lock(_requestMutex);
+                _curlmHandle = nullptr;
+            }
             curl_multi_cleanup(curlmHandle);
             this->stop();
             DLLOG("----DownloaderCURL::Impl::_threadProc end");
         }
 
         thread _thread;
+        CURLM* _curlmHandle;            // guarded by _requestMutex, for waking the work thread up
+        uint32_t _processingTaskCount;  // only used in thread proc
         deque<TaskWrapper>  _requestQueue;
         set<TaskWrapper>    _processSet;
         deque<TaskWrapper>  _finishedQueue;
@@ -813,6 +1268,12 @@ static constexpr TimedJob::id_type SCHED_JOB_ID = 0;
                         break;
                     }
 
+                    // a failed task keeps its temp file, the next task of the file resumes from it
+                    if (DownloadTask::ERROR_NO_ERROR != coTask._errCode)
+                    {
+                        break;
+                    }
+
                     auto util = FileUtils::getInstance();
                     // if file already exist, remove it
                     if (util->isFileExist(coTask._fileName))
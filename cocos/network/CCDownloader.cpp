@@ -68,7 +68,9 @@ namespace cocos2d { namespace network {
         {
             6,
             45,
-            ".tmp"
+            ".tmp",
+            4,
+            1024 * 1024
         };
         new(this)Downloader(hints);
     }
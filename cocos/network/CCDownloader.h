@@ -63,6 +63,11 @@ namespace cocos2d { namespace network {
         uint32_t countOfMaxProcessingTasks;
         uint32_t timeoutInSeconds;
         std::string tempFileNameSuffix;
+        // A file task of a server which accepts ranges is split into up to this many chunks downloaded in parallel,
+        // 0 or 1 downloads files as a single stream. Only the curl based downloader splits files.
+        uint32_t countOfMaxChunksPerTask;
+        // The smallest chunk, smaller files aren't split
+        uint32_t minChunkSizeInBytes;
     };
 
     class CC_DLL Downloader final
@@ -26,6 +26,7 @@
 
 #include "network/HttpClient.h"
 #include <queue>
+#include <unordered_map>
 #include <errno.h>
 #include <curl/curl.h>
 #include "base/CCDirector.h"
@@ -69,100 +70,116 @@ static size_t writeHeaderData(void *ptr, size_t size, size_t nmemb, void *stream
     return sizes;
 }
 
+// The chunks of a response body on their way to a main thread data callback
+struct HttpStream
+{
+    std::shared_ptr<HttpResponse> response;
+    std::mutex mutex;
+    std::vector<char> ring;
+    size_t head;    // the first byte which isn't delivered yet
+    size_t size;    // the bytes waiting in the ring
+    bool paused;    // the transfer waits for room in the ring
+    bool cancelled; // the data callback returned false
+    bool finished;  // the response is complete, its callback runs once the ring is drained
+};
 
-static int processGetTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-static int processPostTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-static int processPutTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-static int processDeleteTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void *stream, long *errorCode, write_callback headerCallback, void *headerStream, char* errorBuffer);
-
-// Worker thread
-void HttpClient::networkThread()
-{   
-	increaseThreadCount();
-    
-    while (true) 
-    {
-        std::shared_ptr<HttpRequest> request;
-
-        // step 1: send http request if the requestQueue isn't empty
-        {
-            std::lock_guard<std::mutex> lock(_requestQueueMutex);
-            while (_requestQueue.empty())
-			{
-                _sleepCondition.wait(_requestQueueMutex);
-            }
-            request = _requestQueue.front();
-            _requestQueue.pop_front();
-        }
+// A request running on the multi handle of the network thread
+struct HttpTransfer
+{
+    std::shared_ptr<HttpResponse> response;
+    std::string host;
+    curl_slist *headers;
+    char errorBuffer[CURL_ERROR_SIZE];
+
+    CURL* handle;
+    // the response body is streamed to one of these instead of HttpResponse::getResponseData
+    FILE* file;
+    ResizableBuffer* buffer;
+    size_t bufferSize;
+    size_t bufferCapacity;
+    const ccHttpDataCallback* dataCallback;
+    std::shared_ptr<HttpStream> stream;
+};
 
-        if (!request)
-        {
-            break;
-        }
+static size_t writeFile(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+    HttpTransfer* transfer = (HttpTransfer*)stream;
+    return fwrite(ptr, 1, size * nmemb, transfer->file);
+}
 
-        // step 2: libcurl sync access
-        
-        // Create a HttpResponse object, the default setting is http access failed
-        auto response = std::make_shared<HttpResponse>(request);
-        
-		processResponse(response, _responseMessage);
+static size_t writeBuffer(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+    HttpTransfer* transfer = (HttpTransfer*)stream;
+    size_t sizes = size * nmemb;
 
-        // add response packet into queue
-        {
-            std::lock_guard<std::mutex> lock(_responseQueueMutex);
-            _responseQueue.push_back(response);
-        }
-        
+    size_t required = transfer->bufferSize + sizes;
+    if (required > transfer->bufferCapacity)
+    {
+        // the first chunk sizes the buffer for the whole body when its length is known. The length of a
+        // compressed body is smaller than the decoded one, past it the buffer grows geometrically
+        size_t capacity = std::max(required, transfer->bufferCapacity * 2);
+        if (transfer->bufferSize == 0)
         {
-            std::lock_guard<std::mutex> lock(_schedulerMutex);
-            if (_scheduler)
-            {
-                _scheduler->performFunctionInCocosThread(CC_CALLBACK_0(HttpClient::dispatchResponseCallbacks, this));
-            }
+#if LIBCURL_VERSION_NUM >= 0x073700
+            curl_off_t length = -1;
+            curl_easy_getinfo(transfer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+#else
+            double length = -1;
+            curl_easy_getinfo(transfer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &length);
+#endif
+            if (length > 0 && (size_t)length > capacity)
+                capacity = (size_t)length;
         }
-    }
-    
-    // cleanup: if worker thread received quit signal, clean up un-completed request queue
-    {
-        std::lock_guard<std::mutex> lock(_requestQueueMutex);
-        _requestQueue.clear();
-    }
-    
-    {
-        std::lock_guard<std::mutex> lock(_responseQueueMutex);
-        _responseQueue.clear();
+        transfer->buffer->resize(capacity);
+        transfer->bufferCapacity = capacity;
     }
 
-	decreaseThreadCountAndMayDeleteThis();    
+    memcpy((char*)transfer->buffer->buffer() + transfer->bufferSize, ptr, sizes);
+    transfer->bufferSize = required;
+    return sizes;
 }
 
-// Worker thread
-void HttpClient::networkThreadAlone(std::shared_ptr<HttpRequest> request, std::shared_ptr<HttpResponse> response)
+// the chunk is read in place by the data callback, returning 0 aborts the transfer
+static size_t writeDataCallback(void *ptr, size_t size, size_t nmemb, void *stream)
 {
-	increaseThreadCount();
+    HttpTransfer* transfer = (HttpTransfer*)stream;
+    size_t sizes = size * nmemb;
+    return (*transfer->dataCallback)((const char*)ptr, sizes) ? sizes : 0;
+}
 
-	char responseMessage[RESPONSE_BUFFER_SIZE] = { 0 };
-	processResponse(response, responseMessage);
-	
-    {
-        std::lock_guard<std::mutex> lock(_schedulerMutex);
+// Copies the chunk into the ring of a main thread data callback, pauses the transfer while the ring is full
+static size_t writeStream(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    HttpTransfer* transfer = (HttpTransfer*)userdata;
+    HttpStream& stream = *transfer->stream;
+    size_t sizes = size * nmemb;
 
-        if (_scheduler && request->getCallback())
-        {
-            _scheduler->performFunctionInCocosThread(
-                [this, response, request]
-                {
-                    auto & callback = request->getCallback();
-                    if (callback)
-                    {
-                        callback(this, response);
-                    }
-                }
-            );
-        }
+    std::lock_guard<std::mutex> lock(stream.mutex);
+    if (stream.cancelled)
+        return 0;
+    size_t capacity = stream.ring.size();
+    if (capacity - stream.size < sizes)
+    {
+        stream.paused = true;
+        return CURL_WRITEFUNC_PAUSE;
     }
 
-	decreaseThreadCountAndMayDeleteThis();
+    size_t tail = (stream.head + stream.size) % capacity;
+    size_t first = std::min(sizes, capacity - tail);
+    memcpy(stream.ring.data() + tail, ptr, first);
+    memcpy(stream.ring.data(), (char*)ptr + first, sizes - first);
+    stream.size += sizes;
+    return sizes;
+}
+
+
+// The scheme, user info and port are part of the host, requests are limited per connection target
+static std::string getHost(const char* url)
+{
+    const char* begin = strstr(url, "://");
+    begin = begin ? begin + 3 : url;
+    const char* end = begin + strcspn(begin, "/?#");
+    return std::string(url, end);
 }
 
 //Configure curl's timeout property
@@ -177,11 +194,11 @@ static bool configureCURL(HttpClient* client, CURL* handle, char* errorBuffer)
     if (code != CURLE_OK) {
         return false;
     }
-    code = curl_easy_setopt(handle, CURLOPT_TIMEOUT, HttpClient::getInstance()->getTimeoutForRead());
+    code = curl_easy_setopt(handle, CURLOPT_TIMEOUT, client->getTimeoutForRead());
     if (code != CURLE_OK) {
         return false;
     }
-    code = curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, HttpClient::getInstance()->getTimeoutForConnect());
+    code = curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, client->getTimeoutForConnect());
     if (code != CURLE_OK) {
         return false;
     }
@@ -202,140 +219,403 @@ static bool configureCURL(HttpClient* client, CURL* handle, char* errorBuffer)
 
     curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");
 
+#if LIBCURL_VERSION_NUM >= 0x072F00
+    // negotiate HTTP/2 over TLS, the requests to a host then share its connection
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+#endif
+
     return true;
 }
 
-class CURLRaii
+/**
+ * @brief Sets a pooled easy handle up for a request
+ * @param handle A handle fresh from curl_easy_init or curl_easy_reset
+ */
+static bool initTransfer(HttpClient* client, CURL* handle, HttpTransfer* transfer)
 {
-    /// Instance of CURL
-    CURL *_curl;
-    /// Keeps custom header data
-    curl_slist *_headers;
-public:
-    CURLRaii()
-        : _curl(curl_easy_init())
-        , _headers(nullptr)
+    auto response = transfer->response;
+    auto request = response->getHttpRequest();
+
+    if (!configureCURL(client, handle, transfer->errorBuffer))
+        return false;
+
+    /* get custom header data (if set) */
+    std::vector<std::string> headers = request->getHeaders();
+    if(!headers.empty())
     {
+        /* append custom headers one by one */
+        for (auto& header : headers)
+            transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+        /* set custom headers for curl */
+        if (CURLE_OK != curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->headers))
+            return false;
+    }
+    std::string cookieFilename = client->getCookieFilename();
+    if (!cookieFilename.empty()) {
+        if (CURLE_OK != curl_easy_setopt(handle, CURLOPT_COOKIEFILE, cookieFilename.c_str())) {
+            return false;
+        }
+        if (CURLE_OK != curl_easy_setopt(handle, CURLOPT_COOKIEJAR, cookieFilename.c_str())) {
+            return false;
+        }
     }
 
-    ~CURLRaii()
+    write_callback writeFunction = writeData;
+    void* writeStreamData = response->getResponseData();
+    if (!request->getResponseFile().empty())
     {
-        if (_curl)
-            curl_easy_cleanup(_curl);
-        /* free the linked list for header data */
-        if (_headers)
-            curl_slist_free_all(_headers);
+        transfer->file = fopen(FileUtils::getInstance()->getSuitableFOpen(request->getResponseFile()).c_str(), "wb");
+        if (!transfer->file)
+        {
+            snprintf(transfer->errorBuffer, CURL_ERROR_SIZE, "Can't open the response file %s", request->getResponseFile().c_str());
+            return false;
+        }
+        writeFunction = writeFile;
+        writeStreamData = transfer;
+    }
+    else if (request->getResponseBuffer())
+    {
+        transfer->buffer = request->getResponseBuffer();
+        writeFunction = writeBuffer;
+        writeStreamData = transfer;
+    }
+    else if (request->getResponseDataCallback())
+    {
+        if (request->getResponseDataCallbackThread() == HttpRequest::DataCallbackThread::MAIN)
+        {
+            // room for a few frames of chunks, and for the largest chunk curl writes at once
+            transfer->stream->ring.resize(std::max(client->getDataCallbackBudget() * 4, (size_t)CURL_MAX_WRITE_SIZE * 4));
+            writeFunction = writeStream;
+        }
+        else
+        {
+            transfer->dataCallback = &request->getResponseDataCallback();
+            writeFunction = writeDataCallback;
+        }
+        writeStreamData = transfer;
     }
 
-    template <class T>
-    bool setOption(CURLoption option, T data)
+    bool ok = CURLE_OK == curl_easy_setopt(handle, CURLOPT_URL, request->getUrl())
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeFunction)
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_WRITEDATA, writeStreamData)
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, writeHeaderData)
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_HEADERDATA, response->getResponseHeader())
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer);
+    if (!ok)
+        return false;
+
+    switch (request->getRequestType())
     {
-        return CURLE_OK == curl_easy_setopt(_curl, option, data);
+    case HttpRequest::Type::GET: // HTTP GET
+        return CURLE_OK == curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+
+    case HttpRequest::Type::POST: // HTTP POST
+        return CURLE_OK == curl_easy_setopt(handle, CURLOPT_POST, 1L)
+            && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request->getRequestData())
+            && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, (long)request->getRequestDataSize());
+
+    case HttpRequest::Type::PUT:
+        return CURLE_OK == curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, "PUT")
+            && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request->getRequestData())
+            && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, (long)request->getRequestDataSize());
+
+    case HttpRequest::Type::DELETE:
+        return CURLE_OK == curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, "DELETE")
+            && CURLE_OK == curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+
+    default:
+        CCASSERT(true, "CCHttpClient: unknown request type, only GET and POSt are supported");
+        return false;
     }
+}
 
-    /**
-     * @brief Inits CURL instance for common usage
-     * @param request Null not allowed
-     * @param callback Response write callback
-     * @param stream Response write stream
-     */
-    bool init(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void* stream, write_callback headerCallback, void* headerStream, char* errorBuffer)
+// Writes the result of a finished transfer to its HttpResponse
+static void finishTransfer(CURL* handle, CURLcode result, HttpTransfer* transfer)
+{
+    auto response = transfer->response;
+    long responseCode = -1;
+    bool succeed = false;
+
+    if (result == CURLE_OK)
     {
-        if (!_curl)
-            return false;
-		if (!configureCURL(client, _curl, errorBuffer))
-            return false;
+        CURLcode code = curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &responseCode);
+        if (code != CURLE_OK || !(responseCode >= 200 && responseCode < 300)) {
+            CCLOGERROR("Curl curl_easy_getinfo failed: %s", curl_easy_strerror(code));
+        } else {
+            succeed = true;
+        }
+    }
+    else if (transfer->errorBuffer[0] == '\0')
+    {
+        strncpy(transfer->errorBuffer, curl_easy_strerror(result), CURL_ERROR_SIZE - 1);
+    }
+
+    // write data to HttpResponse
+    response->setResponseCode(responseCode);
+    response->setSucceed(succeed);
+    if (!succeed)
+        response->setErrorBuffer(transfer->errorBuffer);
+}
 
-        /* get custom header data (if set) */
-        std::vector<std::string> headers = request->getHeaders();
-        if(!headers.empty())
+// Worker thread
+void HttpClient::networkThread()
+{   
+	increaseThreadCount();
+
+    // all the transfers run on one multi handle, which keeps the connections alive between them
+    CURLM* multi = curl_multi_init();
+#ifdef CURLPIPE_MULTIPLEX
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+    // the easy handles share cookies, dns and tls sessions, they're only used by this thread
+    CURLSH* share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    {
+        std::lock_guard<std::mutex> lock(_requestQueueMutex);
+        _multiHandle = multi;
+    }
+
+    std::vector<CURL*> runningHandles;
+    std::vector<CURL*> idleHandles;
+    std::unordered_map<std::string, int> hostTransfers;
+    std::vector<std::shared_ptr<HttpRequest>> requests;
+    long maxConnects = 0;
+
+    while (true)
+    {
+        // step 1: pick the requests to start, sleep while there is nothing to do
         {
-            /* append custom headers one by one */
-            for (auto& header : headers)
-                _headers = curl_slist_append(_headers,header.c_str());
-            /* set custom headers for curl */
-            if (!setOption(CURLOPT_HTTPHEADER, _headers))
-                return false;
+            std::unique_lock<std::mutex> lock(_requestQueueMutex);
+            while (runningHandles.empty() && _requestQueue.empty() && _immediateRequestQueue.empty())
+            {
+                _sleepCondition.wait(lock);
+            }
+
+            // destroyInstance queues an empty request last
+            if (!_requestQueue.empty() && !_requestQueue.back())
+            {
+                break;
+            }
+
+            // immediate requests don't wait for a free slot
+            requests.assign(_immediateRequestQueue.begin(), _immediateRequestQueue.end());
+            _immediateRequestQueue.clear();
+            for (auto& request : requests)
+                ++hostTransfers[getHost(request->getUrl())];
+
+            int maxRequests = _maxConcurrentRequests;
+            int maxRequestsPerHost = _maxRequestsPerHost;
+            while ((int)(runningHandles.size() + requests.size()) < maxRequests)
+            {
+                // the first request of the highest priority whose host has a free slot
+                auto best = _requestQueue.end();
+                for (auto it = _requestQueue.begin(); it != _requestQueue.end(); ++it)
+                {
+                    if (best != _requestQueue.end() && (*it)->getPriority() <= (*best)->getPriority())
+                        continue;
+                    auto host = hostTransfers.find(getHost((*it)->getUrl()));
+                    if (host == hostTransfers.end() || host->second < maxRequestsPerHost)
+                        best = it;
+                }
+                if (best == _requestQueue.end())
+                    break;
+
+                ++hostTransfers[getHost((*best)->getUrl())];
+                requests.push_back(*best);
+                _requestQueue.erase(best);
+            }
+
+            if (maxConnects != maxRequests)
+            {
+                // keep an idle connection for every slot
+                maxConnects = maxRequests;
+                curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, maxConnects);
+            }
         }
-		std::string cookieFilename = client->getCookieFilename();
-		if (!cookieFilename.empty()) {
-			if (!setOption(CURLOPT_COOKIEFILE, cookieFilename.c_str())) {
-                return false;
+
+        // step 2: start them on pooled easy handles
+        for (auto& request : requests)
+        {
+            auto transfer = new HttpTransfer;
+            // Create a HttpResponse object, the default setting is http access failed
+            transfer->response = std::make_shared<HttpResponse>(request);
+            transfer->host = getHost(request->getUrl());
+            transfer->headers = nullptr;
+            transfer->errorBuffer[0] = '\0';
+            transfer->handle = nullptr;
+            transfer->file = nullptr;
+            transfer->buffer = nullptr;
+            transfer->bufferSize = 0;
+            transfer->bufferCapacity = 0;
+            transfer->dataCallback = nullptr;
+            if (request->getResponseDataCallback() && request->getResponseDataCallbackThread() == HttpRequest::DataCallbackThread::MAIN)
+            {
+                auto stream = std::make_shared<HttpStream>();
+                stream->response = transfer->response;
+                stream->head = 0;
+                stream->size = 0;
+                stream->paused = false;
+                stream->cancelled = false;
+                stream->finished = false;
+                transfer->stream = stream;
+                addStream(stream);
+            }
+
+            CURL* handle = nullptr;
+            if (!idleHandles.empty())
+            {
+                handle = idleHandles.back();
+                idleHandles.pop_back();
+            }
+            else
+            {
+                handle = curl_easy_init();
             }
-			if (!setOption(CURLOPT_COOKIEJAR, cookieFilename.c_str())) {
-                return false;
+            transfer->handle = handle;
+
+            if (handle && CURLE_OK == curl_easy_setopt(handle, CURLOPT_SHARE, share)
+                && initTransfer(this, handle, transfer)
+                && CURLM_OK == curl_multi_add_handle(multi, handle))
+            {
+                runningHandles.push_back(handle);
+                continue;
             }
+
+            // the request failed before it was sent, the handle isn't reused
+            if (handle)
+            {
+                finishTransfer(handle, CURLE_FAILED_INIT, transfer);
+                curl_easy_cleanup(handle);
+            }
+            else
+            {
+                transfer->response->setErrorBuffer("curl_easy_init failed");
+            }
+            if (--hostTransfers[transfer->host] == 0)
+                hostTransfers.erase(transfer->host);
+            completeTransfer(transfer);
         }
+        requests.clear();
 
-        return setOption(CURLOPT_URL, request->getUrl())
-                && setOption(CURLOPT_WRITEFUNCTION, callback)
-                && setOption(CURLOPT_WRITEDATA, stream)
-                && setOption(CURLOPT_HEADERFUNCTION, headerCallback)
-                && setOption(CURLOPT_HEADERDATA, headerStream);
-        
-    }
+        // step 3: transfer data, and hand the finished responses to the cocos thread
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
 
-    /// @param responseCode Null not allowed
-    bool perform(long *responseCode)
-    {
-        if (CURLE_OK != curl_easy_perform(_curl))
-            return false;
-        CURLcode code = curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, responseCode);
-        if (code != CURLE_OK || !(*responseCode >= 200 && *responseCode < 300)) {
-            CCLOGERROR("Curl curl_easy_getinfo failed: %s", curl_easy_strerror(code));
-            return false;
+        // the streams with new chunks have the cocos thread read them, the drained ones resume
+        for (auto handle : runningHandles)
+        {
+            HttpTransfer* transfer = nullptr;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**)&transfer);
+            if (!transfer->stream)
+                continue;
+
+            HttpStream& stream = *transfer->stream;
+            bool resume = false;
+            bool pending = false;
+            {
+                std::lock_guard<std::mutex> lock(stream.mutex);
+                if (stream.paused && (stream.cancelled || stream.ring.size() - stream.size >= CURL_MAX_WRITE_SIZE))
+                {
+                    stream.paused = false;
+                    resume = true;
+                }
+                pending = stream.size > 0;
+            }
+            // the write function may run again inside curl_easy_pause
+            if (resume)
+                curl_easy_pause(handle, CURLPAUSE_CONT);
+            if (pending)
+                scheduleDataCallbacks();
+        }
+
+        int messagesLeft = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &messagesLeft))
+        {
+            if (message->msg != CURLMSG_DONE)
+                continue;
+
+            CURL* handle = message->easy_handle;
+            HttpTransfer* transfer = nullptr;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**)&transfer);
+            finishTransfer(handle, message->data.result, transfer);
+
+            curl_multi_remove_handle(multi, handle);
+            runningHandles.erase(std::find(runningHandles.begin(), runningHandles.end(), handle));
+            if (--hostTransfers[transfer->host] == 0)
+                hostTransfers.erase(transfer->host);
+
+            if (!getCookieFilename().empty())
+                curl_easy_setopt(handle, CURLOPT_COOKIELIST, "FLUSH");
+
+            // reset keeps the caches of the handle, extra handles are freed
+            if ((int)idleHandles.size() < _maxConcurrentRequests)
+            {
+                curl_easy_reset(handle);
+                idleHandles.push_back(handle);
+            }
+            else
+            {
+                curl_easy_cleanup(handle);
+            }
+
+            completeTransfer(transfer);
+        }
+
+        // step 4: wait for the sockets, send() and destroyInstance() wake the wait up
+        if (!runningHandles.empty())
+        {
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+#else
+            int numfds = 0;
+            curl_multi_wait(multi, nullptr, 0, 50, &numfds);
+            if (numfds == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
         }
-        // Get some mor data.
-        
-        return true;
     }
-};
 
-//Process Get Request
-static int processGetTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
-{
-    CURLRaii curl;
-	bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_FOLLOWLOCATION, true)
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
-}
+    // cleanup: if worker thread received quit signal, abort the running requests and clean up un-completed request queue
+    {
+        std::lock_guard<std::mutex> lock(_requestQueueMutex);
+        _multiHandle = nullptr;
+        _requestQueue.clear();
+        _immediateRequestQueue.clear();
+    }
 
-//Process POST Request
-static int processPostTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
-{
-    CURLRaii curl;
-	bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_POST, 1)
-            && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
-            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize())
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
-}
+    for (auto handle : runningHandles)
+    {
+        HttpTransfer* transfer = nullptr;
+        curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**)&transfer);
+        curl_multi_remove_handle(multi, handle);
+        curl_easy_cleanup(handle);
+        if (transfer->file)
+        {
+            fclose(transfer->file);
+            FileUtils::getInstance()->removeFile(transfer->response->getHttpRequest()->getResponseFile());
+        }
+        curl_slist_free_all(transfer->headers);
+        delete transfer;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_dataStreamsMutex);
+        _dataStreams.clear();
+    }
+    for (auto handle : idleHandles)
+        curl_easy_cleanup(handle);
+    curl_multi_cleanup(multi);
+    curl_share_cleanup(share);
 
-//Process PUT Request
-static int processPutTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
-{
-    CURLRaii curl;
-	bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_CUSTOMREQUEST, "PUT")
-            && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
-            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize())
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
-}
+    {
+        std::lock_guard<std::mutex> lock(_responseQueueMutex);
+        _responseQueue.clear();
+    }
 
-//Process DELETE Request
-static int processDeleteTask(HttpClient* client, std::shared_ptr<HttpRequest> request, write_callback callback, void* stream, long* responseCode, write_callback headerCallback, void* headerStream, char* errorBuffer)
-{
-    CURLRaii curl;
-	bool ok = curl.init(client, request, callback, stream, headerCallback, headerStream, errorBuffer)
-            && curl.setOption(CURLOPT_CUSTOMREQUEST, "DELETE")
-            && curl.setOption(CURLOPT_FOLLOWLOCATION, true)
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+	decreaseThreadCountAndMayDeleteThis();    
 }
-
 // HttpClient implementation
 HttpClient* HttpClient::getInstance()
 {
@@ -368,6 +648,7 @@ void HttpClient::destroyInstance()
 
 	thiz->_requestQueueMutex.lock();
 	thiz->_requestQueue.push_back(std::shared_ptr<HttpRequest>());
+	thiz->wakeUpNetworkThread();
 	thiz->_requestQueueMutex.unlock();
 
 	thiz->_sleepCondition.notify_one();
@@ -426,6 +707,17 @@ bool HttpClient::lazyInitThreadSemphore()
     return _isInited;
 }
 
+// Interrupts the network thread waiting for its transfers, the caller holds _requestQueueMutex
+void HttpClient::wakeUpNetworkThread()
+{
+#if LIBCURL_VERSION_NUM >= 0x074400
+    if (_multiHandle)
+    {
+        curl_multi_wakeup(static_cast<CURLM*>(_multiHandle));
+    }
+#endif
+}
+
 //Add a get task to queue
 void HttpClient::send(std::shared_ptr<HttpRequest> request)
 {    
@@ -442,6 +734,7 @@ void HttpClient::send(std::shared_ptr<HttpRequest> request)
     {
         std::lock_guard<std::mutex> lock(_requestQueueMutex);
         _requestQueue.push_back(request);
+        wakeUpNetworkThread();
     }
 
 	// Notify thread start to work
@@ -450,17 +743,182 @@ void HttpClient::send(std::shared_ptr<HttpRequest> request)
 
 void HttpClient::sendImmediate(std::shared_ptr<HttpRequest> request)
 {
+    if (!lazyInitThreadSemphore())
+    {
+        return;
+    }
+
     if(!request)
     {
         return;
     }
 
-    // Create a HttpResponse object, the default setting is http access failed
-    std::shared_ptr<HttpResponse> response( new (std::nothrow) HttpResponse(request) );
+    // the request skips the queue and the concurrency limits
+    {
+        std::lock_guard<std::mutex> lock(_requestQueueMutex);
+        _immediateRequestQueue.push_back(request);
+        wakeUpNetworkThread();
+    }
+
+    _sleepCondition.notify_one();
+}
 
-    auto t = std::thread(&HttpClient::networkThreadAlone, this, request, response);
+// Queues a finished response and has the cocos thread call its callback
+void HttpClient::addResponse(std::shared_ptr<HttpResponse> response)
+{
+    {
+        std::lock_guard<std::mutex> lock(_responseQueueMutex);
+        _responseQueue.push_back(response);
+    }
 
-    t.detach();
+    {
+        std::lock_guard<std::mutex> lock(_schedulerMutex);
+        if (_scheduler)
+        {
+            _scheduler->performFunctionInCocosThread(CC_CALLBACK_0(HttpClient::dispatchResponseCallbacks, this));
+        }
+    }
+}
+
+// Closes the sink of a finished transfer and hands its response to the cocos thread
+void HttpClient::completeTransfer(HttpTransfer* transfer)
+{
+    auto response = transfer->response;
+
+    if (transfer->file)
+    {
+        if (fclose(transfer->file) != 0 && response->isSucceed())
+        {
+            response->setSucceed(false);
+            response->setErrorBuffer("Can't write the response file");
+        }
+        if (!response->isSucceed())
+            FileUtils::getInstance()->removeFile(response->getHttpRequest()->getResponseFile());
+    }
+
+    // the buffer was sized for the announced length or grown past the body
+    if (transfer->buffer && transfer->bufferSize < transfer->bufferCapacity)
+        transfer->buffer->resize(transfer->bufferSize);
+
+    if (transfer->stream)
+    {
+        {
+            std::lock_guard<std::mutex> lock(transfer->stream->mutex);
+            transfer->stream->finished = true;
+        }
+        scheduleDataCallbacks();
+    }
+    else
+    {
+        addResponse(response);
+    }
+
+    curl_slist_free_all(transfer->headers);
+    delete transfer;
+}
+
+void HttpClient::addStream(std::shared_ptr<HttpStream> stream)
+{
+    std::lock_guard<std::mutex> lock(_dataStreamsMutex);
+    _dataStreams.push_back(stream);
+}
+
+// Has the cocos thread deliver the streamed chunks, once per frame at most
+void HttpClient::scheduleDataCallbacks()
+{
+    {
+        std::lock_guard<std::mutex> lock(_dataStreamsMutex);
+        if (_dataCallbacksScheduled)
+            return;
+        _dataCallbacksScheduled = true;
+    }
+
+    std::lock_guard<std::mutex> lock(_schedulerMutex);
+    if (_scheduler)
+    {
+        _scheduler->performFunctionInCocosThread(CC_CALLBACK_0(HttpClient::dispatchDataCallbacks, this));
+    }
+}
+
+void HttpClient::dispatchDataCallbacks()
+{
+    std::vector<std::shared_ptr<HttpStream>> streams;
+    {
+        std::lock_guard<std::mutex> lock(_dataStreamsMutex);
+        _dataCallbacksScheduled = false;
+        streams = _dataStreams;
+    }
+
+    size_t budget = _dataCallbackBudget;
+    bool resume = false;
+    bool pending = false;
+
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        auto& stream = streams[i];
+        auto request = stream->response->getHttpRequest();
+        auto& dataCallback = request->getResponseDataCallback();
+
+        // the streams share the budget, what one of them leaves goes to the next ones
+        size_t share = std::max(budget / (streams.size() - i), (size_t)1);
+        budget -= std::min(share, budget);
+
+        // the chunks are read in place, only this thread moves the head of the ring
+        while (share > 0)
+        {
+            const char* data = nullptr;
+            size_t size = 0;
+            {
+                std::lock_guard<std::mutex> lock(stream->mutex);
+                if (stream->cancelled || stream->size == 0)
+                    break;
+                size = std::min(std::min(stream->size, stream->ring.size() - stream->head), share);
+                data = stream->ring.data() + stream->head;
+            }
+
+            bool keep = dataCallback(data, size);
+            share -= size;
+
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->head = (stream->head + size) % stream->ring.size();
+            stream->size -= size;
+            if (!keep)
+                stream->cancelled = true;
+            resume = resume || stream->paused;
+        }
+        budget += share;
+
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            bool drained = stream->cancelled || stream->size == 0;
+            done = stream->finished && drained;
+            pending = pending || !drained;
+            resume = resume || (stream->paused && stream->cancelled);
+        }
+        if (!done)
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(_dataStreamsMutex);
+            _dataStreams.erase(std::find(_dataStreams.begin(), _dataStreams.end(), stream));
+        }
+        auto& callback = request->getCallback();
+        if (callback)
+        {
+            callback(this, stream->response);
+        }
+    }
+
+    if (resume)
+    {
+        std::lock_guard<std::mutex> lock(_requestQueueMutex);
+        wakeUpNetworkThread();
+    }
+    if (pending)
+    {
+        scheduleDataCallbacks();
+    }
 }
 
 // Poll and notify main thread if responses exists in queue
@@ -491,74 +949,6 @@ void HttpClient::dispatchResponseCallbacks()
     }
 }
 
-// Process Response
-void HttpClient::processResponse(std::shared_ptr<HttpResponse> response, char* responseMessage)
-{
-	auto request = response->getHttpRequest();
-	long responseCode = -1;
-	int retValue = 0;
-
-	// Process the request -> get response packet
-	switch (request->getRequestType())
-	{
-	case HttpRequest::Type::GET: // HTTP GET
-		retValue = processGetTask(this, request,
-			writeData,
-			response->getResponseData(),
-			&responseCode,
-			writeHeaderData,
-			response->getResponseHeader(),
-			responseMessage);
-		break;
-
-	case HttpRequest::Type::POST: // HTTP POST
-		retValue = processPostTask(this, request,
-			writeData,
-			response->getResponseData(),
-			&responseCode,
-			writeHeaderData,
-			response->getResponseHeader(),
-			responseMessage);
-		break;
-
-	case HttpRequest::Type::PUT:
-		retValue = processPutTask(this, request,
-			writeData,
-			response->getResponseData(),
-			&responseCode,
-			writeHeaderData,
-			response->getResponseHeader(),
-			responseMessage);
-		break;
-
-	case HttpRequest::Type::DELETE:
-		retValue = processDeleteTask(this, request,
-			writeData,
-			response->getResponseData(),
-			&responseCode,
-			writeHeaderData,
-			response->getResponseHeader(),
-			responseMessage);
-		break;
-
-	default:
-		CCASSERT(true, "CCHttpClient: unknown request type, only GET and POSt are supported");
-		break;
-	}
-
-	// write data to HttpResponse
-	response->setResponseCode(responseCode);
-	if (retValue != 0)
-	{
-		response->setSucceed(false);
-		response->setErrorBuffer(responseMessage);
-	}
-	else
-	{
-		response->setSucceed(true);
-	}
-}
-
 void HttpClient::increaseThreadCount()
 {
     std::lock_guard<std::mutex> lock(_threadCountMutex);
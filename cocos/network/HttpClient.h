@@ -32,6 +32,8 @@
 #include "network/HttpResponse.h"
 #include "network/HttpCookie.h"
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <thread>
@@ -45,7 +47,8 @@ namespace cocos2d {
 
 namespace network {
 
-
+struct HttpStream;
+struct HttpTransfer;
 
 /** Singleton that handles asynchronous http requests.
  *
@@ -117,6 +120,52 @@ public:
      */
     void sendImmediate(std::shared_ptr<HttpRequest> request);
 
+    /**
+     * Set the number of requests which are transferred at the same time, 4 by default.
+     * Requests sent with sendImmediate aren't limited.
+     * Only the curl based HttpClient runs several requests at a time.
+     *
+     * @param value the number of concurrent requests.
+     */
+    void setMaxConcurrentRequests(int value) { _maxConcurrentRequests = std::max(value, 1); }
+
+    /**
+     * Get the number of requests which are transferred at the same time.
+     *
+     * @return int the number of concurrent requests.
+     */
+    int getMaxConcurrentRequests() const { return _maxConcurrentRequests; }
+
+    /**
+     * Set the number of concurrent requests to the same host, 2 by default.
+     * HTTP/2 servers multiplex them over one connection.
+     *
+     * @param value the number of concurrent requests per host.
+     */
+    void setMaxRequestsPerHost(int value) { _maxRequestsPerHost = std::max(value, 1); }
+
+    /**
+     * Get the number of concurrent requests to the same host.
+     *
+     * @return int the number of concurrent requests per host.
+     */
+    int getMaxRequestsPerHost() const { return _maxRequestsPerHost; }
+
+    /**
+     * Set the bytes handed to main thread data callbacks per frame, 256 KiB by default.
+     * See HttpRequest::setResponseDataCallback.
+     *
+     * @param value the bytes per frame.
+     */
+    void setDataCallbackBudget(size_t value) { _dataCallbackBudget = std::max(value, (size_t)1); }
+
+    /**
+     * Get the bytes handed to main thread data callbacks per frame.
+     *
+     * @return size_t the bytes per frame.
+     */
+    size_t getDataCallbackBudget() const { return _dataCallbackBudget; }
+
     /**
      * Set the timeout value for connecting.
      *
@@ -166,6 +215,13 @@ private:
     void dispatchResponseCallbacks();
 
     void processResponse(std::shared_ptr<HttpResponse>, char* responseMessage);
+    void addResponse(std::shared_ptr<HttpResponse> response);
+    void completeTransfer(HttpTransfer* transfer);
+    void addStream(std::shared_ptr<HttpStream> stream);
+    void scheduleDataCallbacks();
+    /** Called from main thread, hands the streamed chunks to the data callbacks within the budget **/
+    void dispatchDataCallbacks();
+    void wakeUpNetworkThread();
     void increaseThreadCount();
     void decreaseThreadCountAndMayDeleteThis();
 
@@ -185,7 +241,17 @@ private:
     std::mutex _schedulerMutex;
 
     std::deque<std::shared_ptr<HttpRequest>> _requestQueue;
+    std::deque<std::shared_ptr<HttpRequest>> _immediateRequestQueue;
     std::mutex _requestQueueMutex;
+    void* _multiHandle{nullptr}; // the curl multi handle of the network thread, guarded by _requestQueueMutex
+
+    std::atomic<int> _maxConcurrentRequests{4};
+    std::atomic<int> _maxRequestsPerHost{2};
+
+    std::vector<std::shared_ptr<HttpStream>> _dataStreams; // the streams with main thread data callbacks
+    bool _dataCallbacksScheduled{false};
+    std::mutex _dataStreamsMutex;
+    std::atomic<size_t> _dataCallbackBudget{256 * 1024};
 
     std::deque<std::shared_ptr<HttpResponse>> _responseQueue;
     std::mutex _responseQueueMutex;
@@ -38,12 +38,16 @@
 
 namespace cocos2d {
 
+class ResizableBuffer;
+
 namespace network {
 
 class HttpClient;
 class HttpResponse;
 
 typedef std::function<void(HttpClient*, std::shared_ptr<HttpResponse>)> ccHttpRequestCallback;
+/** Receives a chunk of the response body, returning false cancels the request. */
+typedef std::function<bool(const char* data, size_t size)> ccHttpDataCallback;
 
 /**
  * Defines the object which users must packed for HttpClient::send(std::shared_ptr<HttpRequest>) method.
@@ -74,6 +78,13 @@ public:
         UNKNOWN,
     };
 
+    /** The thread which calls the data callback, see setResponseDataCallback. */
+    enum class DataCallbackThread
+    {
+        NETWORK,
+        MAIN,
+    };
+
     /**
      *  Constructor.
      *   Because HttpRequest object will be used between UI thread and network thread,
@@ -85,6 +96,9 @@ public:
         : _requestType(Type::UNKNOWN)
         , _pCallback(nullptr)
         , _pUserData(nullptr)
+        , _priority(0)
+        , _responseBuffer(nullptr)
+        , _dataCallbackThread(DataCallbackThread::NETWORK)
     {
     }
 
@@ -251,6 +265,74 @@ public:
         return _headers;
     }
 
+    /**
+     * Set the priority of the request, queued requests with a higher priority are sent first.
+     * Requests of the same priority are sent in order, the default priority is 0.
+     * Only the curl based HttpClient orders its queue by priority.
+     */
+    void setPriority(int priority)
+    {
+        _priority = priority;
+    }
+
+    int getPriority() const
+    {
+        return _priority;
+    }
+
+    /**
+     * Write the response body to a file as it arrives, instead of collecting it in HttpResponse::getResponseData.
+     * The file is written on the network thread and removed when the request fails.
+     * Only the curl based HttpClient streams response bodies.
+     */
+    void setResponseFile(const std::string& path)
+    {
+        _responseFile = path;
+    }
+
+    const std::string& getResponseFile() const
+    {
+        return _responseFile;
+    }
+
+    /**
+     * Write the response body into a buffer of the caller as it arrives, instead of collecting it in HttpResponse::getResponseData.
+     * The buffer is written on the network thread, it must stay alive and untouched until the response callback.
+     * It is resized as the body grows, and to the size of the body when the response completes.
+     */
+    void setResponseBuffer(ResizableBuffer* buffer)
+    {
+        _responseBuffer = buffer;
+    }
+
+    ResizableBuffer* getResponseBuffer() const
+    {
+        return _responseBuffer;
+    }
+
+    /**
+     * Hand the response body to a callback chunk by chunk, instead of collecting it in HttpResponse::getResponseData.
+     * On the network thread, the callback reads the buffer of the transfer without a copy.
+     * On the main thread, the chunks go through a ring buffer of the transfer and the callbacks of all the requests
+     * get at most HttpClient::getDataCallbackBudget bytes per frame; the transfer pauses while its ring buffer is full.
+     * The response callback is called after the last chunk.
+     */
+    void setResponseDataCallback(const ccHttpDataCallback& callback, DataCallbackThread thread = DataCallbackThread::NETWORK)
+    {
+        _dataCallback = callback;
+        _dataCallbackThread = thread;
+    }
+
+    const ccHttpDataCallback& getResponseDataCallback() const
+    {
+        return _dataCallback;
+    }
+
+    DataCallbackThread getResponseDataCallbackThread() const
+    {
+        return _dataCallbackThread;
+    }
+
 protected:
     // properties
     Type                        _requestType;    /// kHttpRequestGet, kHttpRequestPost or other enums
@@ -260,6 +342,11 @@ protected:
     ccHttpRequestCallback       _pCallback;      /// C++11 style callbacks
     void*                       _pUserData;      /// You can add your customed data here
     std::vector<std::string>    _headers;        /// custom http headers
+    int                         _priority;       /// higher priorities leave the queue first
+    std::string                 _responseFile;   /// the file the response body is streamed to
+    ResizableBuffer*            _responseBuffer; /// the buffer the response body is streamed to
+    ccHttpDataCallback          _dataCallback;   /// the callback the response body is streamed to
+    DataCallbackThread          _dataCallbackThread;
 };
 
 }
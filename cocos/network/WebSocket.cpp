@@ -35,8 +35,8 @@
 
 #include <thread>
 #include <mutex>
-#include <queue>
-#include <list>
+#include <condition_variable>
+#include <algorithm>
 #include <signal.h>
 #include <errno.h>
 
@@ -112,184 +112,858 @@ private:
 unsigned int WsMessage::__id = 0;
 
 /**
- *  @brief Websocket thread helper, it's used for sending message between UI thread and websocket thread.
+ *  @brief A queue with one producer thread and one consumer thread, which don't need a lock.
+ *         The nodes are allocated by the producer and freed by the consumer.
  */
-class WsThreadHelper
+template <typename T>
+class WsSpscQueue
 {
 public:
-    WsThreadHelper();
-    ~WsThreadHelper();
+    WsSpscQueue()
+    : _head(new Node())
+    , _tail(_head)
+    {
+    }
+
+    ~WsSpscQueue()
+    {
+        while (_head)
+        {
+            Node* next = _head->next.load(std::memory_order_relaxed);
+            delete _head;
+            _head = next;
+        }
+    }
 
-    // Creates a new thread
-    bool createWebSocketThread(const WebSocket& ws);
-    // Quits websocket thread.
-    void quitWebSocketThread();
+    // Invoked by the producer
+    void push(T value)
+    {
+        Node* node = new Node();
+        node->value = value;
+        _tail->next.store(node, std::memory_order_release);
+        _tail = node;
+    }
 
-    // Sends message to Cocos thread. It's needed to be invoked in Websocket thread.
-    void sendMessageToCocosThread(const std::function<void()>& cb);
+    // Invoked by the consumer, the first value or nullptr
+    T* front()
+    {
+        Node* next = _head->next.load(std::memory_order_acquire);
+        return next ? &next->value : nullptr;
+    }
 
-    // Sends message to Websocket thread. It's needs to be invoked in Cocos thread.
-    void sendMessageToWebSocketThread(WsMessage *msg);
+    // Invoked by the consumer
+    bool pop(T& value)
+    {
+        Node* next = _head->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+        value = next->value;
+        delete _head;
+        _head = next;
+        return true;
+    }
 
-    // Waits the sub-thread (websocket thread) to exit,
-    void joinWebSocketThread();
+    bool empty() const
+    {
+        return _head->next.load(std::memory_order_acquire) == nullptr;
+    }
 
-protected:
-    void wsThreadEntryFunc();
 private:
-    std::list<WsMessage*>* _subThreadWsMessageQueue;
-    std::mutex   _subThreadWsMessageQueueMutex;
-    std::thread* _subThreadInstance;
-    WebSocket* _ws;
-    bool _needQuit;
-    friend class WebSocket;
+    struct Node
+    {
+        Node() : value(), next(nullptr) {}
+        T value;
+        std::atomic<Node*> next;
+    };
+
+    Node* _head; // the consumer's, its value was popped already
+    Node* _tail; // the producer's
 };
 
-// Wrapper for converting websocket callback from static function to member function of WebSocket class.
-class WebSocketCallbackWrapper {
+// Define a WebSocket frame
+class WebSocketFrame
+{
 public:
+    WebSocketFrame()
+        : _payload(nullptr)
+        , _payloadLength(0)
+        , _frameLength(0)
+    {
+    }
 
-    static int onSocketCallback(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *in, size_t len)
+    bool init(unsigned char* buf, ssize_t len)
     {
-        // Gets the user data from context. We know that it's a 'WebSocket' instance.
-        if (wsi == nullptr) {
-            return 0;
+        if (buf == nullptr && len > 0)
+            return false;
+
+        if (!_data.empty())
+        {
+            LOGD("WebSocketFrame was initialized, should not init it again!\n");
+            return false;
         }
 
-        lws_context* context = lws_get_context(wsi);
-        WebSocket* wsInstance = (WebSocket*)lws_context_user(context);
-        if (wsInstance)
+        _data.reserve(LWS_PRE + len);
+        _data.resize(LWS_PRE, 0x00);
+        if (len > 0)
         {
-            return wsInstance->onSocketCallback(wsi, reason, user, in, len);
+            _data.insert(_data.end(), buf, buf + len);
         }
-        return 0;
+
+        _payload = _data.data() + LWS_PRE;
+        _payloadLength = len;
+        _frameLength = len;
+        return true;
+    }
+
+    void update(ssize_t issued)
+    {
+        _payloadLength -= issued;
+        _payload += issued;
+    }
+
+    unsigned char* getPayload() const { return _payload; }
+    ssize_t getPayloadLength() const { return _payloadLength; }
+    ssize_t getFrameLength() const { return _frameLength; }
+private:
+    unsigned char* _payload;
+    ssize_t _payloadLength;
+
+    ssize_t _frameLength;
+    std::vector<unsigned char> _data;
+};
+
+
+enum WS_MSG {
+    WS_MSG_TO_SUBTRHEAD_SENDING_STRING = 0,
+    WS_MSG_TO_SUBTRHEAD_SENDING_BINARY,
+};
+
+static void deleteMessage(WsMessage* msg)
+{
+    WebSocket::Data* data = (WebSocket::Data*)msg->obj;
+    CC_SAFE_FREE(data->bytes);
+    delete ((WebSocketFrame*)data->ext);
+    CC_SAFE_DELETE(data);
+    CC_SAFE_DELETE(msg);
+}
+
+// An event of a connection, queued by the websocket thread for the Cocos thread
+struct WsEvent
+{
+    enum class Type
+    {
+        OPENED,
+        RECEIVED,
+        FAILED,
+        CLOSED,
+    };
+
+    explicit WsEvent(Type t) : type(t), isBinary(false) {}
+
+    Type type;
+    std::vector<char> data; // a received text message is terminated by '\0', which isn't part of its length
+    bool isBinary;
+};
+
+// A connection, shared by its WebSocket and the websocket thread, which may outlive one another
+struct WsConnection
+{
+    WsConnection()
+    : port(80)
+    , ssl(0)
+    , closeRequested(false)
+    , wsi(nullptr)
+    , context(nullptr)
+    , established(false)
+    , closing(false)
+    , finished(false)
+    {
+        // reserve data buffer to avoid allocate memory frequently
+        receivedData.reserve(WS_RESERVE_RECEIVE_BUFFER_SIZE);
+    }
+
+    ~WsConnection()
+    {
+        WsMessage* msg = nullptr;
+        while (outgoing.pop(msg))
+            deleteMessage(msg);
+        WsEvent* event = nullptr;
+        while (incoming.pop(event))
+            delete event;
     }
+
+    std::string host;
+    unsigned int port;
+    std::string path;
+    int ssl;
+    std::string protocols; // the protocols of the handshake, e.g. "chat, superchat"
+
+    WsSpscQueue<WsMessage*> outgoing; // Cocos thread to websocket thread
+    WsSpscQueue<WsEvent*> incoming;   // websocket thread to Cocos thread
+    std::atomic<bool> closeRequested;
+
+    // Only used in websocket thread
+    struct lws* wsi;
+    struct lws_context* context;
+    bool established;
+    bool closing;
+    bool finished;
+    std::vector<char> receivedData;
+};
+
+/**
+ *  @brief The websocket thread. It services the connections of all WebSocket instances, and has the Cocos thread
+ *         dispatch their events once per frame.
+ */
+class WsServiceLoop
+{
+public:
+    static WsServiceLoop* getInstance();
+    // Quits websocket thread and waits for it to exit, the remaining connections are dropped.
+    static void destroyInstance();
+
+    // Hands a new connection to websocket thread. It's needed to be invoked in Cocos thread.
+    void connect(const std::shared_ptr<WsConnection>& connection);
+
+    // Interrupts the service of websocket thread to have it look at the queues of the connections.
+    // Many calls before the thread wakes up cost one interruption.
+    void wakeUp();
+
+    static int onSocketCallback(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *in, size_t len);
+
+private:
+    // The connections with the same protocols share a libwebsockets context
+    struct Context
+    {
+        std::string protocolNames;
+        std::vector<std::string> names;
+        std::vector<lws_protocols> protocols;
+        struct lws_context* context;
+        int connections;
+    };
+
+    WsServiceLoop();
+    ~WsServiceLoop();
+
+    void wsThreadEntryFunc();
+    void startConnection(const std::shared_ptr<WsConnection>& connection);
+    Context* acquireContext(const std::string& protocolNames);
+    void releaseContext(struct lws_context* context);
+
+    // The following functions are invoked in websocket thread
+    void pushEvent(WsConnection* connection, WsEvent* event);
+    void onConnectionFinished(WsConnection* connection, WsEvent::Type type);
+    int onClientWritable(WsConnection* connection);
+    void onClientReceivedData(WsConnection* connection, void* in, ssize_t len);
+
+    // Delivers the queued events of all WebSocket instances, it's invoked in Cocos thread.
+    static void dispatchEvents();
+
+    std::thread _thread;
+    std::atomic<bool> _needQuit;
+    std::atomic<bool> _wakeUpPending;
+    bool _eventsPushed;
+
+    std::mutex _pendingConnectionsMutex;
+    std::condition_variable _sleepCondition;
+    std::vector<std::shared_ptr<WsConnection>> _pendingConnections;
+
+    // Only modified in websocket thread, wakeUp() reads them in other threads
+    std::mutex _contextsMutex;
+    std::vector<std::unique_ptr<Context>> _contexts;
+
+    std::vector<std::shared_ptr<WsConnection>> _connections;
 };
 
-// Implementation of WsThreadHelper
-WsThreadHelper::WsThreadHelper()
-: _subThreadInstance(nullptr)
-, _ws(nullptr)
-, _needQuit(false)
+static WsServiceLoop* __serviceLoop = nullptr;
+static std::atomic<bool> __dispatchScheduled(false);
+static std::vector<WebSocket*>* __websocketInstances = nullptr;
+
+WsServiceLoop* WsServiceLoop::getInstance()
+{
+    if (__serviceLoop == nullptr)
+    {
+        __serviceLoop = new (std::nothrow) WsServiceLoop();
+    }
+    return __serviceLoop;
+}
+
+void WsServiceLoop::destroyInstance()
+{
+    if (__serviceLoop == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(__serviceLoop->_pendingConnectionsMutex);
+        __serviceLoop->_needQuit = true;
+    }
+    __serviceLoop->_sleepCondition.notify_one();
+    __serviceLoop->wakeUp();
+
+    LOGD("Waiting websocket thread to exit!\n");
+    delete __serviceLoop;
+    __serviceLoop = nullptr;
+}
+
+WsServiceLoop::WsServiceLoop()
+: _needQuit(false)
+, _wakeUpPending(false)
+, _eventsPushed(false)
+{
+    _thread = std::thread(&WsServiceLoop::wsThreadEntryFunc, this);
+}
+
+WsServiceLoop::~WsServiceLoop()
 {
-    _subThreadWsMessageQueue = new (std::nothrow) std::list<WsMessage*>();
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
 }
 
-WsThreadHelper::~WsThreadHelper()
+void WsServiceLoop::connect(const std::shared_ptr<WsConnection>& connection)
 {
-    joinWebSocketThread();
-    CC_SAFE_DELETE(_subThreadInstance);
-    delete _subThreadWsMessageQueue;
+    {
+        std::lock_guard<std::mutex> lk(_pendingConnectionsMutex);
+        _pendingConnections.push_back(connection);
+    }
+    _sleepCondition.notify_one();
+    wakeUp();
 }
 
-bool WsThreadHelper::createWebSocketThread(const WebSocket& ws)
+void WsServiceLoop::wakeUp()
 {
-    _ws = const_cast<WebSocket*>(&ws);
+    // websocket thread clears the flag before it looks at the queues
+    if (_wakeUpPending.exchange(true))
+    {
+        return;
+    }
 
-    // Creates websocket thread
-    _subThreadInstance = new (std::nothrow) std::thread(&WsThreadHelper::wsThreadEntryFunc, this);
-    return true;
+    std::lock_guard<std::mutex> lk(_contextsMutex);
+    for (auto& context : _contexts)
+    {
+        lws_cancel_service(context->context);
+    }
+}
+
+void WsServiceLoop::wsThreadEntryFunc()
+{
+    LOGD("WebSocket thread start, loop instance: %p\n", this);
+
+    int log_level = LLL_ERR | LLL_WARN | LLL_NOTICE/* | LLL_INFO | LLL_DEBUG | LLL_PARSER*/ | LLL_HEADER | LLL_EXT | LLL_CLIENT | LLL_LATENCY;
+    lws_set_log_level(log_level, printWebSocketLog);
+
+    std::vector<std::shared_ptr<WsConnection>> pendingConnections;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lk(_pendingConnectionsMutex);
+            while (!_needQuit && _pendingConnections.empty() && _connections.empty())
+            {
+                _sleepCondition.wait(lk);
+            }
+            if (_needQuit)
+            {
+                break;
+            }
+            pendingConnections.swap(_pendingConnections);
+        }
+
+        // The messages sent and the connections closed before this point are seen below
+        _wakeUpPending.exchange(false);
+
+        for (auto& connection : pendingConnections)
+        {
+            startConnection(connection);
+        }
+        pendingConnections.clear();
+
+        for (auto& connection : _connections)
+        {
+            if (connection->finished)
+                continue;
+
+            if (connection->closeRequested && !connection->closing)
+            {
+                connection->closing = true;
+                if (connection->established)
+                {
+                    // The writable callback closes the connection
+                    lws_callback_on_writable(connection->wsi);
+                }
+                else
+                {
+                    lws_set_timeout(connection->wsi, PENDING_TIMEOUT_AWAITING_SERVER_RESPONSE, 1);
+                }
+            }
+            else if (connection->established && !connection->outgoing.empty())
+            {
+                lws_callback_on_writable(connection->wsi);
+            }
+        }
+
+        // Every context gets its share of the wait, wakeUp() interrupts them all
+        int timeout = _contexts.empty() ? 0 : std::max(50 / (int)_contexts.size(), 1);
+        for (size_t i = 0; i < _contexts.size(); ++i)
+        {
+            lws_service(_contexts[i]->context, timeout);
+        }
+
+        // The connections whose socket is gone leave the thread
+        for (auto iter = _connections.begin(); iter != _connections.end();)
+        {
+            if ((*iter)->finished)
+            {
+                releaseContext((*iter)->context);
+                iter = _connections.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+
+        if (_eventsPushed)
+        {
+            _eventsPushed = false;
+            if (!__dispatchScheduled.exchange(true))
+            {
+                Director::getInstance()->getScheduler().performFunctionInCocosThread(&WsServiceLoop::dispatchEvents);
+            }
+        }
+    }
+
+    // Destroying the contexts closes the remaining sockets
+    {
+        std::lock_guard<std::mutex> lk(_contextsMutex);
+        for (auto& context : _contexts)
+        {
+            lws_context_destroy(context->context);
+        }
+        _contexts.clear();
+    }
+    _connections.clear();
+
+    LOGD("WebSocket thread exit, loop instance: %p\n", this);
 }
 
-void WsThreadHelper::quitWebSocketThread()
+void WsServiceLoop::startConnection(const std::shared_ptr<WsConnection>& connection)
 {
-    _needQuit = true;
+    if (connection->closeRequested)
+    {
+        pushEvent(connection.get(), new (std::nothrow) WsEvent(WsEvent::Type::CLOSED));
+        return;
+    }
+
+    Context* context = acquireContext(connection->protocols);
+    if (context == nullptr)
+    {
+        CCLOGERROR("Create websocket context failed!");
+        onConnectionFinished(connection.get(), WsEvent::Type::FAILED);
+        return;
+    }
+    connection->context = context->context;
+    _connections.push_back(connection);
+
+    char portStr[10];
+    sprintf(portStr, "%d", connection->port);
+    std::string ads_port = connection->host + ":" + portStr;
+
+    struct lws_client_connect_info info;
+    memset(&info, 0, sizeof info);
+    info.context = context->context;
+    info.address = connection->host.c_str();
+    info.port = connection->port;
+    info.ssl_connection = connection->ssl;
+    info.path = connection->path.c_str();
+    info.host = ads_port.c_str();
+    info.origin = ads_port.c_str();
+    info.protocol = connection->protocols.c_str();
+    info.ietf_version_or_minus_one = -1;
+    // The callbacks of the socket get the connection as their user data
+    info.userdata = connection.get();
+
+    connection->wsi = lws_client_connect_via_info(&info);
+    if (nullptr == connection->wsi)
+    {
+        // The connection error callback may have run already
+        onConnectionFinished(connection.get(), WsEvent::Type::FAILED);
+    }
 }
 
-void WsThreadHelper::wsThreadEntryFunc()
+WsServiceLoop::Context* WsServiceLoop::acquireContext(const std::string& protocolNames)
 {
-    LOGD("WebSocket thread start, helper instance: %p\n", this);
-    _ws->onSubThreadStarted();
+    for (auto& context : _contexts)
+    {
+        if (context->protocolNames == protocolNames)
+        {
+            ++context->connections;
+            return context.get();
+        }
+    }
+
+    std::unique_ptr<Context> context(new (std::nothrow) Context());
+    if (nullptr == context)
+    {
+        return nullptr;
+    }
+    context->protocolNames = protocolNames;
+    size_t begin = 0;
+    while (begin < protocolNames.size())
+    {
+        size_t end = protocolNames.find(", ", begin);
+        if (end == std::string::npos)
+            end = protocolNames.size();
+        context->names.push_back(protocolNames.substr(begin, end - begin));
+        begin = end + 2;
+    }
 
-    while (!_needQuit)
+    // The names outlive the context, the list ends with a zeroed protocol
+    context->protocols.resize(context->names.size() + 1);
+    for (size_t i = 0; i < context->names.size(); ++i)
     {
-        _ws->onSubThreadLoop();
+        context->protocols[i].name = context->names[i].c_str();
+        context->protocols[i].callback = WsServiceLoop::onSocketCallback;
+        context->protocols[i].rx_buffer_size = WS_RX_BUFFER_SIZE;
     }
 
-    _ws->onSubThreadEnded();
+    struct lws_context_creation_info info;
+    memset(&info, 0, sizeof info);
+    /*
+     * create the websocket context.  This tracks open connections and
+     * knows how to route any traffic and which protocol version to use,
+     * and if each connection is client or server side.
+     *
+     * For this client-only demo, we tell it to not listen on any port.
+     */
+
+    info.port = CONTEXT_PORT_NO_LISTEN;
+    info.protocols = context->protocols.data();
+
+    // FIXME: Disable 'permessage-deflate' extension temporarily because of issues:
+    // https://github.com/cocos2d/cocos2d-x/issues/16045, https://github.com/cocos2d/cocos2d-x/issues/15767
+    // libwebsockets issue: https://github.com/warmcat/libwebsockets/issues/593
+    // Currently, we couldn't find out the exact reason.
+    // libwebsockets official said it's probably an issue of user code
+    // since 'libwebsockets' passed AutoBahn stressed Test.
+
+//    info.extensions = exts;
+
+    info.gid = -1;
+    info.uid = -1;
+    info.options = 0;
+    info.user = this;
+
+    context->context = lws_create_context(&info);
+    if (nullptr == context->context)
+    {
+        return nullptr;
+    }
+    context->connections = 1;
 
-    LOGD("WebSocket thread exit, helper instance: %p\n", this);
+    std::lock_guard<std::mutex> lk(_contextsMutex);
+    _contexts.push_back(std::move(context));
+    return _contexts.back().get();
 }
 
-void WsThreadHelper::sendMessageToCocosThread(const std::function<void()>& cb)
+void WsServiceLoop::releaseContext(struct lws_context* context)
 {
-    Director::getInstance()->getScheduler().performFunctionInCocosThread(cb);
+    for (auto iter = _contexts.begin(); iter != _contexts.end(); ++iter)
+    {
+        if ((*iter)->context != context)
+            continue;
+
+        if (--(*iter)->connections == 0)
+        {
+            std::unique_ptr<Context> unused;
+            {
+                std::lock_guard<std::mutex> lk(_contextsMutex);
+                unused = std::move(*iter);
+                _contexts.erase(iter);
+            }
+            lws_context_destroy(unused->context);
+        }
+        return;
+    }
 }
 
-void WsThreadHelper::sendMessageToWebSocketThread(WsMessage *msg)
+void WsServiceLoop::pushEvent(WsConnection* connection, WsEvent* event)
 {
-    std::lock_guard<std::mutex> lk(_subThreadWsMessageQueueMutex);
-    _subThreadWsMessageQueue->push_back(msg);
+    // Nobody listens anymore
+    if (_needQuit)
+    {
+        delete event;
+        return;
+    }
+
+    connection->incoming.push(event);
+    _eventsPushed = true;
 }
 
-void WsThreadHelper::joinWebSocketThread()
+void WsServiceLoop::onConnectionFinished(WsConnection* connection, WsEvent::Type type)
 {
-    if (_subThreadInstance->joinable())
+    if (connection->finished)
+    {
+        return;
+    }
+
+    LOGD("WebSocket connection (%p) finished, type=%d\n", connection, static_cast<int>(type));
+    connection->finished = true;
+    connection->wsi = nullptr;
+    // A connection closed while it was connecting ends with the timeout error
+    if (connection->closeRequested)
     {
-        _subThreadInstance->join();
+        type = WsEvent::Type::CLOSED;
+    }
+    pushEvent(connection, new (std::nothrow) WsEvent(type));
+    // A failed connection is closed after its error, like any other
+    if (type == WsEvent::Type::FAILED)
+    {
+        pushEvent(connection, new (std::nothrow) WsEvent(WsEvent::Type::CLOSED));
     }
 }
 
-// Define a WebSocket frame
-class WebSocketFrame
+void WsServiceLoop::dispatchEvents()
 {
-public:
-    WebSocketFrame()
-        : _payload(nullptr)
-        , _payloadLength(0)
-        , _frameLength(0)
+    // The events websocket thread queues from now on are dispatched next frame
+    __dispatchScheduled.exchange(false);
+
+    if (__websocketInstances == nullptr)
     {
+        return;
     }
 
-    bool init(unsigned char* buf, ssize_t len)
+    // The delegates may close or delete any instance
+    std::vector<std::pair<WebSocket*, std::shared_ptr<std::atomic<bool>>>> instances;
+    instances.reserve(__websocketInstances->size());
+    for (auto ws : *__websocketInstances)
     {
-        if (buf == nullptr && len > 0)
-            return false;
+        instances.push_back(std::make_pair(ws, ws->_isDestroyed));
+    }
 
-        if (!_data.empty())
+    for (auto& instance : instances)
+    {
+        WsEvent* event = nullptr;
+        while (!*instance.second && instance.first->_connection && instance.first->_connection->incoming.pop(event))
         {
-            LOGD("WebSocketFrame was initialized, should not init it again!\n");
-            return false;
+            instance.first->onEvent(*event);
+            delete event;
         }
+    }
+}
 
-        _data.reserve(LWS_PRE + len);
-        _data.resize(LWS_PRE, 0x00);
-        if (len > 0)
+int WsServiceLoop::onSocketCallback(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *in, size_t len)
+{
+    // The callbacks of the contexts themselves have no connection
+    WsConnection* connection = (WsConnection*)user;
+    if (wsi == nullptr || connection == nullptr)
+    {
+        return 0;
+    }
+
+    WsServiceLoop* loop = (WsServiceLoop*)lws_context_user(lws_get_context(wsi));
+    switch (reason)
+    {
+        case LWS_CALLBACK_CLIENT_ESTABLISHED:
+            connection->established = true;
+            loop->pushEvent(connection, new (std::nothrow) WsEvent(WsEvent::Type::OPENED));
+            /*
+             * start the ball rolling,
+             * LWS_CALLBACK_CLIENT_WRITEABLE will come next service
+             */
+            lws_callback_on_writable(wsi);
+            break;
+
+        case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+            loop->onConnectionFinished(connection, WsEvent::Type::FAILED);
+            break;
+
+        case LWS_CALLBACK_CLOSED:
+            loop->onConnectionFinished(connection, WsEvent::Type::CLOSED);
+            break;
+
+        case LWS_CALLBACK_CLIENT_RECEIVE:
+            loop->onClientReceivedData(connection, in, len);
+            break;
+
+        case LWS_CALLBACK_CLIENT_WRITEABLE:
+            return loop->onClientWritable(connection);
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+int WsServiceLoop::onClientWritable(WsConnection* connection)
+{
+    // Returning -1 closes the socket
+    if (connection->closing)
+    {
+        return -1;
+    }
+
+    WsMessage** front = connection->outgoing.front();
+    if (front == nullptr)
+    {
+        return 0;
+    }
+
+    WsMessage* subThreadMsg = *front;
+    WebSocket::Data* data = (WebSocket::Data*)subThreadMsg->obj;
+
+    const ssize_t c_bufferSize = WS_RX_BUFFER_SIZE;
+
+    const ssize_t remaining = data->len - data->issued;
+    const ssize_t n = std::min(remaining, c_bufferSize);
+
+    WebSocketFrame* frame = nullptr;
+
+    if (data->ext)
+    {
+        frame = (WebSocketFrame*)data->ext;
+    }
+    else
+    {
+        frame = new (std::nothrow) WebSocketFrame();
+        bool success = frame && frame->init((unsigned char*)(data->bytes + data->issued), n);
+        if (success)
         {
-            _data.insert(_data.end(), buf, buf + len);
+            data->ext = frame;
+        }
+        else
+        { // If frame initialization failed, delete the frame and drop the sending data
+          // These codes should never be called.
+            LOGD("WebSocketFrame initialization failed, drop the sending data, msg(%d)\n", (int)subThreadMsg->id);
+            delete frame;
+            connection->outgoing.pop(subThreadMsg);
+            deleteMessage(subThreadMsg);
+            return 0;
         }
+    }
 
-        _payload = _data.data() + LWS_PRE;
-        _payloadLength = len;
-        _frameLength = len;
-        return true;
+    int writeProtocol;
+
+    if (data->issued == 0)
+    {
+        if (WS_MSG_TO_SUBTRHEAD_SENDING_STRING == subThreadMsg->what)
+        {
+            writeProtocol = LWS_WRITE_TEXT;
+        }
+        else
+        {
+            writeProtocol = LWS_WRITE_BINARY;
+        }
+
+        // If we have more than 1 fragment
+        if (data->len > c_bufferSize)
+            writeProtocol |= LWS_WRITE_NO_FIN;
+    } else {
+        // we are in the middle of fragments
+        writeProtocol = LWS_WRITE_CONTINUATION;
+        // and if not in the last fragment
+        if (remaining != n)
+            writeProtocol |= LWS_WRITE_NO_FIN;
     }
 
-    void update(ssize_t issued)
+    ssize_t bytesWrite = lws_write(connection->wsi, frame->getPayload(), frame->getPayloadLength(), (lws_write_protocol)writeProtocol);
+
+    // Handle the result of lws_write
+    // Buffer overrun?
+    if (bytesWrite < 0)
     {
-        _payloadLength -= issued;
-        _payload += issued;
+        LOGD("ERROR: msg(%u), lws_write return: %d, but it should be %d, drop this message.\n", subThreadMsg->id, (int)bytesWrite, (int)n);
+        // socket error, we need to close the socket connection
+        connection->outgoing.pop(subThreadMsg);
+        deleteMessage(subThreadMsg);
+        return -1;
+    }
+    else if (bytesWrite < frame->getPayloadLength())
+    {
+        frame->update(bytesWrite);
+        LOGD("frame wasn't sent completely, bytesWrite: %d, remain: %d\n", (int)bytesWrite, (int)frame->getPayloadLength());
+    }
+    // Do we have another fragments to send?
+    else if (remaining > frame->getFrameLength() && bytesWrite == frame->getPayloadLength())
+    {
+        // A frame was totally sent, plus data->issued to send next frame
+        LOGD("msg(%u) append: %d + %d = %d\n", subThreadMsg->id, (int)data->issued, (int)frame->getFrameLength(), (int)(data->issued + frame->getFrameLength()));
+        data->issued += frame->getFrameLength();
+        delete ((WebSocketFrame*)data->ext);
+        data->ext = nullptr;
+    }
+    // Safely done!
+    else
+    {
+        LOGD("Safely done, msg(%d)!\n", subThreadMsg->id);
+        bool dropped = remaining != frame->getFrameLength();
+        if (!dropped)
+        {
+            LOGD("msg(%u) append: %d + %d = %d\n", subThreadMsg->id, (int)data->issued, (int)frame->getFrameLength(), (int)(data->issued + frame->getFrameLength()));
+            LOGD("msg(%u) was totally sent!\n", subThreadMsg->id);
+        }
+        else
+        {
+            LOGD("ERROR: msg(%u), remaining(%d) < bytesWrite(%d)\n", subThreadMsg->id, (int)remaining, (int)frame->getFrameLength());
+            LOGD("Drop the msg(%u)\n", subThreadMsg->id);
+        }
+
+        connection->outgoing.pop(subThreadMsg);
+        deleteMessage(subThreadMsg);
+
+        LOGD("-----------------------------------------------------------\n");
+        if (dropped)
+        {
+            return -1;
+        }
     }
 
-    unsigned char* getPayload() const { return _payload; }
-    ssize_t getPayloadLength() const { return _payloadLength; }
-    ssize_t getFrameLength() const { return _frameLength; }
-private:
-    unsigned char* _payload;
-    ssize_t _payloadLength;
+    // The next fragment or message goes out when the socket is writable again
+    if (!connection->outgoing.empty())
+    {
+        lws_callback_on_writable(connection->wsi);
+    }
+    return 0;
+}
+
+void WsServiceLoop::onClientReceivedData(WsConnection* connection, void* in, ssize_t len)
+{
+    // In websocket thread
+    if (in != nullptr && len > 0)
+    {
+        LOGD("Receiving data: len=%d\n", (int)len);
+
+        unsigned char* inData = (unsigned char*)in;
+        connection->receivedData.insert(connection->receivedData.end(), inData, inData + len);
+    }
+    else
+    {
+        LOGD("Empty message received!\n");
+    }
 
-    ssize_t _frameLength;
-    std::vector<unsigned char> _data;
-};
-//
+    // If no more data pending, queue it for the Cocos thread
+    size_t remainingSize = lws_remaining_packet_payload(connection->wsi);
+    int isFinalFragment = lws_is_final_fragment(connection->wsi);
 
+    if (remainingSize == 0 && isFinalFragment)
+    {
+        WsEvent* event = new (std::nothrow) WsEvent(WsEvent::Type::RECEIVED);
+        event->data = std::move(connection->receivedData);
+        event->isBinary = (lws_frame_is_binary(connection->wsi) != 0);
+        if (!event->isBinary)
+        {
+            event->data.push_back('\0');
+        }
 
-enum WS_MSG {
-    WS_MSG_TO_SUBTRHEAD_SENDING_STRING = 0,
-    WS_MSG_TO_SUBTRHEAD_SENDING_BINARY,
-};
+        // reset capacity of received data buffer
+        connection->receivedData.reserve(WS_RESERVE_RECEIVE_BUFFER_SIZE);
 
-static std::vector<WebSocket*>* __websocketInstances = nullptr;
+        pushEvent(connection, event);
+    }
+}
 
 void WebSocket::closeAllConnections()
 {
@@ -305,21 +979,17 @@ void WebSocket::closeAllConnections()
         __websocketInstances->clear();
         __websocketInstances = nullptr;
     }
+
+    WsServiceLoop::destroyInstance();
 }
 
 WebSocket::WebSocket()
 : _readyState(State::CONNECTING)
 , _port(80)
-, _wsHelper(nullptr)
-, _wsInstance(nullptr)
-, _wsContext(nullptr)
 , _isDestroyed(std::make_shared<std::atomic<bool>>(false))
 , _delegate(nullptr)
 , _SSLConnection(0)
-, _wsProtocols(nullptr)
 {
-    // reserve data buffer to avoid allocate memory frequently
-    _receivedData.reserve(WS_RESERVE_RECEIVE_BUFFER_SIZE);
     if (__websocketInstances == nullptr)
     {
         __websocketInstances = new (std::nothrow) std::vector<WebSocket*>();
@@ -338,16 +1008,8 @@ WebSocket::WebSocket()
 WebSocket::~WebSocket()
 {
     LOGD("In the destructor of WebSocket (%p)\n", this);
-    CC_SAFE_DELETE(_wsHelper);
-
-    if (_wsProtocols != nullptr)
-    {
-        for (int i = 0; _wsProtocols[i].callback != nullptr; ++i)
-        {
-            CC_SAFE_DELETE_ARRAY(_wsProtocols[i].name);
-        }
-    }
-    CC_SAFE_DELETE_ARRAY(_wsProtocols);
+    // websocket thread drops the connection once it's closed
+    requestClose();
 
     if (__websocketInstances != nullptr)
     {
@@ -371,7 +1033,6 @@ bool WebSocket::init(const Delegate& delegate,
                      const std::string& url,
                      const std::vector<std::string>* protocols/* = nullptr*/)
 {
-    bool ret = false;
     bool useSSL = false;
     std::string host = url;
     size_t pos = 0;
@@ -411,46 +1072,31 @@ bool WebSocket::init(const Delegate& delegate,
 
     LOGD("[WebSocket::init] _host: %s, _port: %d, _path: %s\n", _host.c_str(), _port, _path.c_str());
 
-    size_t protocolCount = 0;
-    if (protocols && protocols->size() > 0)
-    {
-        protocolCount = protocols->size();
-    }
-    else
-    {
-        protocolCount = 1;
-    }
-
-    _wsProtocols = new (std::nothrow) lws_protocols[protocolCount+1];
-    memset(_wsProtocols, 0, sizeof(lws_protocols)*(protocolCount+1));
-
+    std::string name;
     if (protocols && protocols->size() > 0)
     {
-        int i = 0;
         for (auto& protocol : *protocols)
         {
-            char* name = new (std::nothrow) char[protocol.length()+1];
-            strcpy(name, protocol.c_str());
-            _wsProtocols[i].name = name;
-            _wsProtocols[i].callback = WebSocketCallbackWrapper::onSocketCallback;
-            _wsProtocols[i].rx_buffer_size = WS_RX_BUFFER_SIZE;
-            ++i;
+            if (!name.empty()) name += ", ";
+            name += protocol;
         }
     }
     else
     {
-        char* name = new (std::nothrow) char[20];
-        strcpy(name, "default-protocol");
-        _wsProtocols[0].name = name;
-        _wsProtocols[0].callback = WebSocketCallbackWrapper::onSocketCallback;
-        _wsProtocols[0].rx_buffer_size = WS_RX_BUFFER_SIZE;
+        name = "default-protocol";
     }
 
-    // WebSocket thread needs to be invoked at the end of this method.
-    _wsHelper = new (std::nothrow) WsThreadHelper();
-    ret = _wsHelper->createWebSocketThread(*this);
+    _connection = std::make_shared<WsConnection>();
+    _connection->host = _host;
+    _connection->port = _port;
+    _connection->path = _path;
+    _connection->ssl = _SSLConnection;
+    _connection->protocols = name;
+
+    // websocket thread starts connecting on its next loop
+    WsServiceLoop::getInstance()->connect(_connection);
 
-    return ret;
+    return true;
 }
 
 void WebSocket::send(const std::string& message)
@@ -468,7 +1114,8 @@ void WebSocket::send(const std::string& message)
         WsMessage* msg = new (std::nothrow) WsMessage();
         msg->what = WS_MSG_TO_SUBTRHEAD_SENDING_STRING;
         msg->obj = data;
-        _wsHelper->sendMessageToWebSocketThread(msg);
+        _connection->outgoing.push(msg);
+        WsServiceLoop::getInstance()->wakeUp();
     }
     else
     {
@@ -498,7 +1145,8 @@ void WebSocket::send(const unsigned char* binaryMsg, unsigned int len)
         WsMessage* msg = new (std::nothrow) WsMessage();
         msg->what = WS_MSG_TO_SUBTRHEAD_SENDING_BINARY;
         msg->obj = data;
-        _wsHelper->sendMessageToWebSocketThread(msg);
+        _connection->outgoing.push(msg);
+        WsServiceLoop::getInstance()->wakeUp();
     }
     else
     {
@@ -515,435 +1163,83 @@ void WebSocket::close()
         _readStateMutex.unlock();
         return;
     }
-    // Sets the state to 'closed' to make sure 'onConnectionClosed' which is
-    // invoked by websocket thread don't post 'close' message to Cocos thread since
-    // WebSocket instance is destroyed at next frame.
-    // 'closed' state has to be set before quit websocket thread.
+    // Sets the state to 'closed' to make sure the events websocket thread still
+    // queues for this instance, including its own 'close', are ignored.
     _readyState = State::CLOSED;
     _readStateMutex.unlock();
-    
-    _wsHelper->quitWebSocketThread();
-    LOGD("Waiting WebSocket (%p) to exit!\n", this);
-    _wsHelper->joinWebSocketThread();
-    // Since 'onConnectionClosed' didn't post message to Cocos Thread for invoking 'onClose' callback, do it here.
+
+    requestClose();
     // onClose must be invoked at the end of this method.
     _delegate->onClose(this);
 }
     
 void WebSocket::closeAsync()
 {
-    _wsHelper->quitWebSocketThread();
-}
-
-WebSocket::State WebSocket::getReadyState()
-{
-    std::lock_guard<std::mutex> lk(_readStateMutex);
-    return _readyState;
-}
-
-void WebSocket::onSubThreadLoop()
-{
-    _readStateMutex.lock();
-    if (_wsContext && _readyState != State::CLOSED && _readyState != State::CLOSING)
-    {
-        _readStateMutex.unlock();
-        _wsHelper->_subThreadWsMessageQueueMutex.lock();
-        bool isEmpty = _wsHelper->_subThreadWsMessageQueue->empty();
-        _wsHelper->_subThreadWsMessageQueueMutex.unlock();
-        if (!isEmpty)
-        {
-            lws_callback_on_writable(_wsInstance);
-        }
-
-        lws_service(_wsContext, 50);
-    }
-    else
-    {
-        LOGD("Ready state is closing or was closed, code=%d, quit websocket thread!\n", static_cast<int>(_readyState));
-        _readStateMutex.unlock();
-        _wsHelper->quitWebSocketThread();
-    }
+    requestClose();
 }
 
-void WebSocket::onSubThreadStarted()
+void WebSocket::requestClose()
 {
-    struct lws_context_creation_info info;
-    memset(&info, 0, sizeof info);
-    /*
-     * create the websocket context.  This tracks open connections and
-     * knows how to route any traffic and which protocol version to use,
-     * and if each connection is client or server side.
-     *
-     * For this client-only demo, we tell it to not listen on any port.
-     */
-
-    info.port = CONTEXT_PORT_NO_LISTEN;
-    info.protocols = _wsProtocols;
-    
-    // FIXME: Disable 'permessage-deflate' extension temporarily because of issues:
-    // https://github.com/cocos2d/cocos2d-x/issues/16045, https://github.com/cocos2d/cocos2d-x/issues/15767
-    // libwebsockets issue: https://github.com/warmcat/libwebsockets/issues/593
-    // Currently, we couldn't find out the exact reason.
-    // libwebsockets official said it's probably an issue of user code
-    // since 'libwebsockets' passed AutoBahn stressed Test.
-
-//    info.extensions = exts;
-
-    info.gid = -1;
-    info.uid = -1;
-    info.options = 0;
-    info.user = this;
-
-    int log_level = LLL_ERR | LLL_WARN | LLL_NOTICE/* | LLL_INFO | LLL_DEBUG | LLL_PARSER*/ | LLL_HEADER | LLL_EXT | LLL_CLIENT | LLL_LATENCY;
-    lws_set_log_level(log_level, printWebSocketLog);
-
-    _wsContext = lws_create_context(&info);
-
-    if (nullptr != _wsContext)
-    {
-        _readStateMutex.lock();
-        _readyState = State::CONNECTING;
-        _readStateMutex.unlock();
-        
-        std::string name;
-        for (int i = 0; _wsProtocols[i].callback != nullptr; ++i)
-        {
-            name += (_wsProtocols[i].name);
-
-            if (_wsProtocols[i+1].callback != nullptr) name += ", ";
-        }
-
-        char portStr[10];
-        sprintf(portStr, "%d", _port);
-        std::string ads_port = _host + ":" + portStr;
-
-        _wsInstance = lws_client_connect(_wsContext, _host.c_str(), _port, _SSLConnection,
-                                             _path.c_str(), ads_port.c_str(), ads_port.c_str(),
-                                             name.c_str(), -1);
-
-        if (nullptr == _wsInstance)
-        {
-            onConnectionError();
-        }
-    }
-    else
+    if (_connection && !_connection->closeRequested.exchange(true) && __serviceLoop)
     {
-        CCLOGERROR("Create websocket context failed!");
+        __serviceLoop->wakeUp();
     }
 }
 
-void WebSocket::onSubThreadEnded()
+WebSocket::State WebSocket::getReadyState()
 {
-    if (_wsContext != nullptr)
-    {
-        lws_context_destroy(_wsContext);
-    }
+    std::lock_guard<std::mutex> lk(_readStateMutex);
+    return _readyState;
 }
 
-void WebSocket::onClientWritable()
+void WebSocket::onEvent(const WsEvent& event)
 {
-    std::lock_guard<std::mutex> lk(_wsHelper->_subThreadWsMessageQueueMutex);
-
-    if (_wsHelper->_subThreadWsMessageQueue->empty())
+    // In Cocos thread
+    std::unique_lock<std::mutex> lk(_readStateMutex);
+    if (_readyState == State::CLOSED)
     {
+        LOGD("WebSocket (%p) was closed, drop the event %d\n", this, static_cast<int>(event.type));
         return;
     }
 
-    std::list<WsMessage*>::iterator iter = _wsHelper->_subThreadWsMessageQueue->begin();
-
-    ssize_t bytesWrite = 0;
-    if (iter != _wsHelper->_subThreadWsMessageQueue->end())
+    switch (event.type)
     {
-        WsMessage* subThreadMsg = *iter;
-        Data* data = (Data*)subThreadMsg->obj;
-
-        const ssize_t c_bufferSize = WS_RX_BUFFER_SIZE;
-
-        const ssize_t remaining = data->len - data->issued;
-        const ssize_t n = std::min(remaining, c_bufferSize);
-
-        WebSocketFrame* frame = nullptr;
-
-        if (data->ext)
-        {
-            frame = (WebSocketFrame*)data->ext;
-        }
-        else
-        {
-            frame = new (std::nothrow) WebSocketFrame();
-            bool success = frame && frame->init((unsigned char*)(data->bytes + data->issued), n);
-            if (success)
-            {
-                data->ext = frame;
-            }
-            else
-            { // If frame initialization failed, delete the frame and drop the sending data
-              // These codes should never be called.
-                LOGD("WebSocketFrame initialization failed, drop the sending data, msg(%d)\n", (int)subThreadMsg->id);
-                delete frame;
-                CC_SAFE_FREE(data->bytes);
-                CC_SAFE_DELETE(data);
-                _wsHelper->_subThreadWsMessageQueue->erase(iter);
-                CC_SAFE_DELETE(subThreadMsg);
-                return;
-            }
-        }
-
-        int writeProtocol;
-
-        if (data->issued == 0)
-        {
-            if (WS_MSG_TO_SUBTRHEAD_SENDING_STRING == subThreadMsg->what)
-            {
-                writeProtocol = LWS_WRITE_TEXT;
-            }
-            else
-            {
-                writeProtocol = LWS_WRITE_BINARY;
-            }
-
-            // If we have more than 1 fragment
-            if (data->len > c_bufferSize)
-                writeProtocol |= LWS_WRITE_NO_FIN;
-        } else {
-            // we are in the middle of fragments
-            writeProtocol = LWS_WRITE_CONTINUATION;
-            // and if not in the last fragment
-            if (remaining != n)
-                writeProtocol |= LWS_WRITE_NO_FIN;
-        }
-
-        bytesWrite = lws_write(_wsInstance, frame->getPayload(), frame->getPayloadLength(), (lws_write_protocol)writeProtocol);
-
-        // Handle the result of lws_write
-        // Buffer overrun?
-        if (bytesWrite < 0)
-        {
-            LOGD("ERROR: msg(%u), lws_write return: %d, but it should be %d, drop this message.\n", subThreadMsg->id, (int)bytesWrite, (int)n);
-            // socket error, we need to close the socket connection
-            CC_SAFE_FREE(data->bytes);
-            delete ((WebSocketFrame*)data->ext);
-            data->ext = nullptr;
-            CC_SAFE_DELETE(data);
-            _wsHelper->_subThreadWsMessageQueue->erase(iter);
-            CC_SAFE_DELETE(subThreadMsg);
-
-            closeAsync();
-        }
-        else if (bytesWrite < frame->getPayloadLength())
-        {
-            frame->update(bytesWrite);
-            LOGD("frame wasn't sent completely, bytesWrite: %d, remain: %d\n", (int)bytesWrite, (int)frame->getPayloadLength());
-        }
-        // Do we have another fragments to send?
-        else if (remaining > frame->getFrameLength() && bytesWrite == frame->getPayloadLength())
-        {
-            // A frame was totally sent, plus data->issued to send next frame
-            LOGD("msg(%u) append: %d + %d = %d\n", subThreadMsg->id, (int)data->issued, (int)frame->getFrameLength(), (int)(data->issued + frame->getFrameLength()));
-            data->issued += frame->getFrameLength();
-            delete ((WebSocketFrame*)data->ext);
-            data->ext = nullptr;
-        }
-        // Safely done!
-        else
+        case WsEvent::Type::OPENED:
         {
-            LOGD("Safely done, msg(%d)!\n", subThreadMsg->id);
-            if (remaining == frame->getFrameLength())
-            {
-                LOGD("msg(%u) append: %d + %d = %d\n", subThreadMsg->id, (int)data->issued, (int)frame->getFrameLength(), (int)(data->issued + frame->getFrameLength()));
-                LOGD("msg(%u) was totally sent!\n", subThreadMsg->id);
-            }
-            else
-            {
-                LOGD("ERROR: msg(%u), remaining(%d) < bytesWrite(%d)\n", subThreadMsg->id, (int)remaining, (int)frame->getFrameLength());
-                LOGD("Drop the msg(%u)\n", subThreadMsg->id);
-                closeAsync();
-            }
-
-            CC_SAFE_FREE(data->bytes);
-            delete ((WebSocketFrame*)data->ext);
-            data->ext = nullptr;
-            CC_SAFE_DELETE(data);
-            _wsHelper->_subThreadWsMessageQueue->erase(iter);
-            CC_SAFE_DELETE(subThreadMsg);
-
-            LOGD("-----------------------------------------------------------\n");
+            _readyState = State::OPEN;
+            lk.unlock();
+            _delegate->onOpen(this);
+            break;
         }
-    }
-}
-
-void WebSocket::onClientReceivedData(void* in, ssize_t len)
-{
-    // In websocket thread
-    static int packageIndex = 0;
-    packageIndex++;
-    if (in != nullptr && len > 0)
-    {
-        LOGD("Receiving data:index:%d, len=%d\n", packageIndex, (int)len);
-
-        unsigned char* inData = (unsigned char*)in;
-        _receivedData.insert(_receivedData.end(), inData, inData + len);
-    }
-    else
-    {
-        LOGD("Empty message received, index=%d!\n", packageIndex);
-    }
-
-    // If no more data pending, send it to the client thread
-    size_t remainingSize = lws_remaining_packet_payload(_wsInstance);
-    int isFinalFragment = lws_is_final_fragment(_wsInstance);
-//    LOGD("remainingSize: %d, isFinalFragment: %d\n", (int)remainingSize, isFinalFragment);
-
-    if (remainingSize == 0 && isFinalFragment)
-    {
-        std::vector<char>* frameData = new (std::nothrow) std::vector<char>(std::move(_receivedData));
-
-        // reset capacity of received data buffer
-        _receivedData.reserve(WS_RESERVE_RECEIVE_BUFFER_SIZE);
-
-        ssize_t frameSize = frameData->size();
-
-        bool isBinary = (lws_frame_is_binary(_wsInstance) != 0);
-
-        if (!isBinary)
+        case WsEvent::Type::RECEIVED:
         {
-            frameData->push_back('\0');
-        }
-
-        std::shared_ptr<std::atomic<bool>> isDestroyed = _isDestroyed;
-        _wsHelper->sendMessageToCocosThread([this, frameData, frameSize, isBinary, isDestroyed](){
-            // In UI thread
-            LOGD("Notify data len %d to Cocos thread.\n", (int)frameSize);
+            lk.unlock();
+            LOGD("Notify data len %d to Cocos thread.\n", (int)event.data.size());
 
             Data data;
-            data.isBinary = isBinary;
-            data.bytes = (char*)frameData->data();
-            data.len = frameSize;
-
-            if (*isDestroyed)
-            {
-                LOGD("WebSocket instance was destroyed!\n");
-            }
-            else
-            {
-                _delegate->onMessage(this, data);
-            }
-
-            delete frameData;
-        });
-    }
-}
-
-void WebSocket::onConnectionOpened()
-{
-    /*
-     * start the ball rolling,
-     * LWS_CALLBACK_CLIENT_WRITEABLE will come next service
-     */
-    lws_callback_on_writable(_wsInstance);
-
-    _readStateMutex.lock();
-    _readyState = State::OPEN;
-    _readStateMutex.unlock();
-
-    std::shared_ptr<std::atomic<bool>> isDestroyed = _isDestroyed;
-    _wsHelper->sendMessageToCocosThread([this, isDestroyed](){
-        if (*isDestroyed)
-        {
-            LOGD("WebSocket instance was destroyed!\n");
-        }
-        else
-        {
-            _delegate->onOpen(this);
-        }
-    });
-}
-
-void WebSocket::onConnectionError()
-{
-    LOGD("WebSocket (%p) onConnectionError ...\n", this);
-
-    _readStateMutex.lock();
-    _readyState = State::CLOSING;
-    _readStateMutex.unlock();
-
-    std::shared_ptr<std::atomic<bool>> isDestroyed = _isDestroyed;
-    _wsHelper->sendMessageToCocosThread([this, isDestroyed](){
-        if (*isDestroyed)
-        {
-            LOGD("WebSocket instance was destroyed!\n");
+            data.isBinary = event.isBinary;
+            data.bytes = const_cast<char*>(event.data.data());
+            data.len = static_cast<ssize_t>(event.isBinary ? event.data.size() : event.data.size() - 1);
+            _delegate->onMessage(this, data);
+            break;
         }
-        else
+        case WsEvent::Type::FAILED:
         {
+            LOGD("WebSocket (%p) onConnectionError ...\n", this);
+            _readyState = State::CLOSING;
+            lk.unlock();
             _delegate->onError(this, ErrorCode::CONNECTION_FAILURE);
+            break;
         }
-    });
-}
-
-void WebSocket::onConnectionClosed()
-{
-    _readStateMutex.lock();
-    if (_readyState == State::CLOSED)
-    {
-        LOGD("onConnectionClosed: WebSocket (%p) was closed, no need to close it again!\n", this);
-        _readStateMutex.unlock();
-        return;
-    }
-
-    LOGD("WebSocket (%p) onConnectionClosed ...\n", this);
-    _readyState = State::CLOSED;
-    _readStateMutex.unlock();
-
-    _wsHelper->quitWebSocketThread();
-    std::shared_ptr<std::atomic<bool>> isDestroyed = _isDestroyed;
-    _wsHelper->sendMessageToCocosThread([this, isDestroyed](){
-        if (*isDestroyed)
-        {
-            LOGD("WebSocket instance was destroyed!\n");
-        }
-        else
+        case WsEvent::Type::CLOSED:
         {
-            // Waiting for the subThread safety exit
-            _wsHelper->joinWebSocketThread();
+            LOGD("WebSocket (%p) onConnectionClosed ...\n", this);
+            _readyState = State::CLOSED;
+            lk.unlock();
             _delegate->onClose(this);
-        }
-    });
-}
-
-int WebSocket::onSocketCallback(struct lws *,
-                                int         reason,
-                                void       *,
-                                void       *in,
-                                ssize_t     len)
-{
-    switch (reason)
-    {
-        case LWS_CALLBACK_CLIENT_ESTABLISHED:
-            onConnectionOpened();
-            break;
-
-        case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
-            onConnectionError();
-            break;
-
-        case LWS_CALLBACK_PROTOCOL_DESTROY:
-        case LWS_CALLBACK_CLOSED:
-            onConnectionClosed();
-            break;
-
-        case LWS_CALLBACK_CLIENT_RECEIVE:
-            onClientReceivedData(in, len);
-            break;
-
-        case LWS_CALLBACK_CLIENT_WRITEABLE:
-            onClientWritable();
-            break;
-
-        default:
             break;
+        }
     }
-
-    return 0;
 }
 
 }
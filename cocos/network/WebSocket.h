@@ -39,10 +39,6 @@
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCStdC.h"
 
-struct lws;
-struct lws_context;
-struct lws_protocols;
-
 /**
  * @addtogroup network
  * @{
@@ -54,17 +50,23 @@ class EventListenerCustom;
 
 namespace network {
 
-class WsThreadHelper;
+class WsServiceLoop;
+struct WsConnection;
+struct WsEvent;
 
 /**
  * WebSocket is wrapper of the libwebsockets-protocol, let the develop could call the websocket easily.
  * Please note that all public methods of WebSocket have to be invoked on Cocos Thread.
+ *
+ * All the WebSocket instances are serviced by one websocket thread, on libwebsockets contexts shared by
+ * the instances with the same protocols. The events of all the instances reach the Cocos Thread together,
+ * once per frame.
  */
 class CC_DLL WebSocket
 {
 public:
     /**
-     * Close all connections and wait for all websocket threads to exit
+     * Close all connections and wait for the websocket thread to exit
      * @note This method has to be invoked on Cocos Thread
      */
     static void closeAllConnections();
@@ -192,13 +194,14 @@ public:
 
     /**
      *  @brief Closes the connection to server synchronously.
-     *  @note It's a synchronous method, it will not return until websocket thread exits.
+     *  @note It's a synchronous method, 'onClose' is invoked before it returns and no event of
+     *        the connection is delivered afterwards. The websocket thread drops the connection in the background.
      */
     void close();
     
     /**
      *  @brief Closes the connection to server asynchronously.
-     *  @note It's an asynchronous method, it just notifies websocket thread to exit and returns directly,
+     *  @note It's an asynchronous method, it just notifies websocket thread to close the connection and returns directly,
      *        If using 'closeAsync' to close websocket connection, 
      *        be careful of not using destructed variables in the callback of 'onClose'.
      */
@@ -211,18 +214,9 @@ public:
     State getReadyState();
 
 private:
-    void onSubThreadStarted();
-    void onSubThreadLoop();
-    void onSubThreadEnded();
-
-    // The following callback functions are invoked in websocket thread
-    int onSocketCallback(struct lws *wsi, int reason, void *user, void *in, ssize_t len);
-
-    void onClientWritable();
-    void onClientReceivedData(void* in, ssize_t len);
-    void onConnectionOpened();
-    void onConnectionError();
-    void onConnectionClosed();
+    // Invoked in Cocos thread for the events the websocket thread queued for this instance
+    void onEvent(const WsEvent& event);
+    void requestClose();
 
 private:
     std::mutex   _readStateMutex;
@@ -231,18 +225,12 @@ private:
     unsigned int _port;
     std::string  _path;
 
-    std::vector<char> _receivedData;
-
-    friend class WsThreadHelper;
-    friend class WebSocketCallbackWrapper;
-    WsThreadHelper* _wsHelper;
+    friend class WsServiceLoop;
+    std::shared_ptr<WsConnection> _connection;
 
-    struct lws*         _wsInstance;
-    struct lws_context* _wsContext;
     std::shared_ptr<std::atomic<bool>> _isDestroyed;
     Delegate* _delegate;
     int _SSLConnection;
-    struct lws_protocols* _wsProtocols;
     EventListenerCustom* _resetDirectorListener;
 };
 
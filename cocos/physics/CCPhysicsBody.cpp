@@ -94,6 +94,10 @@ PhysicsBody::PhysicsBody()
 , _linearDamping(0.0f)
 , _angularDamping(0.0f)
 , _tag(0)
+, _worldIndex(-1)
+, _delayAddIndex(-1)
+, _delayRemoveIndex(-1)
+, _tagIndex(-1)
 , _massSetByUser(false)
 , _momentSetByUser(false)
 , _rotationOffset(0)
@@ -101,6 +105,20 @@ PhysicsBody::PhysicsBody()
 , _recordedAngle(0.0)
 , _recordScaleX(1.f)
 , _recordScaleY(1.f)
+, _recordPosX(0.f)
+, _recordPosY(0.f)
+, _previousPosX(0.0)
+, _previousPosY(0.0)
+, _previousAngle(0.0)
+, _syncedPosX(0.f)
+, _syncedPosY(0.f)
+, _syncedRotation(0.f)
+, _interpolated(false)
+, _simulatedPosX(0.f)
+, _simulatedPosY(0.f)
+, _simulatedRotation(0.f)
+, _simulatedMoved(false)
+, _interpolating(false)
 {
     _cpBody = cpBodyNew(_mass, _moment);
     if (_cpBody == nullptr)
@@ -653,6 +671,25 @@ void PhysicsBody::removeFromWorld()
     removeFromPhysicsWorld();
 }
 
+void PhysicsBody::setTag(int tag)
+{
+    if (_tag == tag)
+    {
+        return;
+    }
+
+    if (_world)
+    {
+        _world->unindexBodyTag(this);
+        _tag = tag;
+        _world->indexBodyTag(this);
+    }
+    else
+    {
+        _tag = tag;
+    }
+}
+
 void PhysicsBody::setEnabled(bool enable)
 {
     if (_enabled != enable)
@@ -801,7 +838,23 @@ Vec2 PhysicsBody::local2World(const Vec2& point)
     return PhysicsHelper::cpv2point(cpBodyLocalToWorld(_cpBody, PhysicsHelper::point2cpv(point)));
 }
 
-void PhysicsBody::beforeSimulation(const Mat4& parentToWorldTransform, const Mat4& nodeToWorldTransform, float scaleX, float scaleY, float rotation)
+void PhysicsBody::prepareSimulation(const Mat4& parentToWorldTransform, const Mat4& nodeToWorldTransform)
+{
+    auto worldPosition = _ownerCenterOffset;
+    nodeToWorldTransform.transformVector(worldPosition.x, worldPosition.y, worldPosition.z, 1.f, &worldPosition);
+
+    _recordPosX = worldPosition.x;
+    _recordPosY = worldPosition.y;
+
+    if (_owner->getAnchorPoint() != Vec2::ANCHOR_MIDDLE)
+    {
+        parentToWorldTransform.getInversed().transformVector(worldPosition.x, worldPosition.y, worldPosition.z, 1.f, &worldPosition);
+        _offset.x = worldPosition.x - _owner->getPositionX();
+        _offset.y = worldPosition.y - _owner->getPositionY();
+    }
+}
+
+void PhysicsBody::beforeSimulation(float scaleX, float scaleY, float rotation)
 {
     if (_recordScaleX != scaleX || _recordScaleY != scaleY)
     {
@@ -810,41 +863,90 @@ void PhysicsBody::beforeSimulation(const Mat4& parentToWorldTransform, const Mat
         setScale(scaleX, scaleY);
     }
 
+    // an owner which still has the interpolated transform written by afterSimulation doesn't move the body
+    bool keepRotation = _interpolated && rotation == _syncedRotation;
+    bool keepPosition = _interpolated && _recordPosX == _syncedPosX && _recordPosY == _syncedPosY;
+
     // set rotation
-    if (_recordedRotation != rotation)
+    if (!keepRotation && (_interpolated || _recordedRotation != rotation))
     {
         setRotation(rotation);
+        _previousAngle = cpBodyGetAngle(_cpBody);
     }
 
-    // set position
-    auto worldPosition = _ownerCenterOffset;
-    nodeToWorldTransform.transformVector(worldPosition.x, worldPosition.y, worldPosition.z, 1.f, &worldPosition);
-    setPosition(worldPosition.x, worldPosition.y);
-
-    _recordPosX = worldPosition.x;
-    _recordPosY = worldPosition.y;
-
-    if (_owner->getAnchorPoint() != Vec2::ANCHOR_MIDDLE)
+    // set position, after the rotation which moves the center of gravity
+    if (!keepPosition)
     {
-        parentToWorldTransform.getInversed().transformVector(worldPosition.x, worldPosition.y, worldPosition.z, 1.f, &worldPosition);
-        _offset.x = worldPosition.x - _owner->getPositionX();
-        _offset.y = worldPosition.y - _owner->getPositionY();
+        setPosition(_recordPosX, _recordPosY);
+        cpVect position = cpBodyGetPosition(_cpBody);
+        _previousPosX = position.x;
+        _previousPosY = position.y;
     }
 }
 
-void PhysicsBody::afterSimulation(const Mat4& parentToWorldTransform, float parentRotation)
+void PhysicsBody::recordPreviousState()
+{
+    cpVect position = cpBodyGetPosition(_cpBody);
+    _previousPosX = position.x;
+    _previousPosY = position.y;
+    _previousAngle = cpBodyGetAngle(_cpBody);
+}
+
+void PhysicsBody::prepareAfterSimulation(const Mat4& parentToWorldTransform, float parentRotation)
 {
-    // set Node position   
+    // Node position
     auto tmp = getPosition();
     Vec3 positionInParent(tmp.x, tmp.y, 0.f);
-    if (_recordPosX != positionInParent.x || _recordPosY != positionInParent.y)
+    _simulatedMoved = _recordPosX != positionInParent.x || _recordPosY != positionInParent.y;
+    if (_simulatedMoved)
     {
         parentToWorldTransform.getInversed().transformVector(positionInParent.x, positionInParent.y, positionInParent.z, 1.f, &positionInParent);
-        _owner->setPosition(positionInParent.x - _offset.x, positionInParent.y - _offset.y);
+        _simulatedPosX = positionInParent.x - _offset.x;
+        _simulatedPosY = positionInParent.y - _offset.y;
     }
 
-    // set Node rotation
-    _owner->setRotation(getRotation() - parentRotation);
+    // Node rotation
+    _simulatedRotation = getRotation() - parentRotation;
+
+    _interpolating = false;
+}
+
+void PhysicsBody::prepareAfterSimulation(const Mat4& parentToWorldTransform, float parentRotation, float alpha)
+{
+    cpVect current = cpBodyGetPosition(_cpBody);
+    double currentAngle = cpBodyGetAngle(_cpBody);
+    Vec3 positionInParent(static_cast<float>(_previousPosX + (current.x - _previousPosX) * alpha - _positionOffset.x),
+                          static_cast<float>(_previousPosY + (current.y - _previousPosY) * alpha - _positionOffset.y),
+                          0.f);
+    double angle = _previousAngle + (currentAngle - _previousAngle) * alpha;
+
+    parentToWorldTransform.getInversed().transformVector(positionInParent.x, positionInParent.y, positionInParent.z, 1.f, &positionInParent);
+    _simulatedPosX = positionInParent.x - _offset.x;
+    _simulatedPosY = positionInParent.y - _offset.y;
+    _simulatedRotation = static_cast<float>(- angle * 180.0 / M_PI - _rotationOffset) - parentRotation;
+    _simulatedMoved = true;
+    _interpolating = true;
+}
+
+void PhysicsBody::afterSimulation(const Mat4& parentToWorldTransform, float parentRotation)
+{
+    if (_simulatedMoved)
+    {
+        _owner->setPosition(_simulatedPosX, _simulatedPosY);
+    }
+    _owner->setRotation(_simulatedRotation);
+
+    _interpolated = _interpolating;
+    if (_interpolated)
+    {
+        // what the next beforeSimulation reads from the owner if nothing else moves it
+        auto nodeToWorldTransform = parentToWorldTransform * _owner->getNodeToParentTransform();
+        auto worldPosition = _ownerCenterOffset;
+        nodeToWorldTransform.transformVector(worldPosition.x, worldPosition.y, worldPosition.z, 1.f, &worldPosition);
+        _syncedPosX = worldPosition.x;
+        _syncedPosY = worldPosition.y;
+        _syncedRotation = parentRotation + _owner->getRotation();
+    }
 }
 
 void PhysicsBody::onEnter()
@@ -465,7 +465,7 @@ public:
     int getTag() const { return _tag; }
     
     /** set the body's tag. */
-    void setTag(int tag) { _tag = tag; }
+    void setTag(int tag);
     
     /** Convert the world point to local. */
     Vec2 world2Local(const Vec2& point);
@@ -499,8 +499,18 @@ protected:
     void addToPhysicsWorld();
     void removeFromPhysicsWorld();
 
-    void beforeSimulation(const Mat4& parentToWorldTransform, const Mat4& nodeToWorldTransform, float scaleX, float scaleY, float rotation);
+    // computes the world position of the body from its owner, it doesn't touch the space so it may run on any thread
+    void prepareSimulation(const Mat4& parentToWorldTransform, const Mat4& nodeToWorldTransform);
+    // moves the body to its owner, after prepareSimulation
+    void beforeSimulation(float scaleX, float scaleY, float rotation);
+    // computes where the owner goes after a step, it only reads the space so it may run on any thread
+    void prepareAfterSimulation(const Mat4& parentToWorldTransform, float parentRotation);
+    // computes the owner transform between the previous state and the body
+    void prepareAfterSimulation(const Mat4& parentToWorldTransform, float parentRotation, float alpha);
+    // moves the owner to the body after prepareAfterSimulation, the Node setters run in the cocos thread
     void afterSimulation(const Mat4& parentToWorldTransform, float parentRotation);
+    // keeps the state of the body before a fixed step, see PhysicsWorld::setInterpolationEnabled
+    void recordPreviousState();
 protected:
     std::vector<PhysicsJoint*> _joints;
     std::vector<retaining_ptr<PhysicsShape>> _shapes;
@@ -523,6 +533,12 @@ protected:
     float _angularDamping;
 
     int _tag;
+
+    // positions in the body lists of the world, see PhysicsWorld::BodyList
+    int _worldIndex;
+    int _delayAddIndex;
+    int _delayRemoveIndex;
+    int _tagIndex;
     
     // when setMass() is invoked, it means body's mass is not calculated by shapes
     bool _massSetByUser;
@@ -544,6 +560,22 @@ protected:
     float _recordPosX;
     float _recordPosY;
 
+    // state of the body before the last fixed step
+    double _previousPosX;
+    double _previousPosY;
+    double _previousAngle;
+    // the interpolated transform written to the owner, in the terms beforeSimulation reads it
+    float _syncedPosX;
+    float _syncedPosY;
+    float _syncedRotation;
+    bool _interpolated;
+    // the owner transform computed by prepareAfterSimulation
+    float _simulatedPosX;
+    float _simulatedPosY;
+    float _simulatedRotation;
+    bool _simulatedMoved;
+    bool _interpolating; // the transform was interpolated, afterSimulation records it as synced
+
     friend class PhysicsWorld;
     friend class PhysicsShape;
     friend class PhysicsJoint;
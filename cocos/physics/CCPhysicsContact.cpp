@@ -27,11 +27,13 @@
 
 #include "physics/CCPhysicsBody.h"
 #include "physics/CCPhysicsHelper.h"
+#include "physics/CCPhysicsWorld.h"
 #include "base/CCEventCustom.h"
 
 namespace cocos2d {
 
 const char* PHYSICSCONTACT_EVENT_NAME = "PhysicsContactEvent";
+const char* PHYSICSCONTACT_BATCH_EVENT_NAME = "PhysicsContactBatchEvent";
 
 PhysicsContact::PhysicsContact()
 : EventCustom(PHYSICSCONTACT_EVENT_NAME)
@@ -476,5 +478,101 @@ EventListenerPhysicsContactWithGroup* EventListenerPhysicsContactWithGroup::clon
     return nullptr;
 }
 
+EventListenerPhysicsContactBatch::EventListenerPhysicsContactBatch()
+: onContacts(nullptr)
+, eventMask(PhysicsContactRecord::ALL_MASK)
+, categoryBitmask(~0)
+{
+}
+
+EventListenerPhysicsContactBatch::~EventListenerPhysicsContactBatch()
+{
+}
+
+EventListenerPhysicsContactBatch* EventListenerPhysicsContactBatch::create()
+{
+    EventListenerPhysicsContactBatch* obj = new (std::nothrow) EventListenerPhysicsContactBatch();
+    
+    if (obj != nullptr && obj->init())
+    {
+        obj->autorelease();
+        return obj;
+    }
+    
+    CC_SAFE_DELETE(obj);
+    return nullptr;
+}
+
+bool EventListenerPhysicsContactBatch::init()
+{
+    auto func = [this](EventCustom* event) -> void
+    {
+        onEvent(event);
+    };
+    
+    return EventListenerCustom::init(PHYSICSCONTACT_BATCH_EVENT_NAME, func);
+}
+
+void EventListenerPhysicsContactBatch::onEvent(EventCustom* event)
+{
+    PhysicsWorld* world = static_cast<PhysicsWorld*>(event->getUserData());
+    const auto& records = world->_dispatchedContactRecords;
+    
+    if (onContacts == nullptr || records.empty())
+    {
+        return;
+    }
+    
+    if ((eventMask & PhysicsContactRecord::ALL_MASK) == PhysicsContactRecord::ALL_MASK && categoryBitmask == ~0)
+    {
+        onContacts(*world, records.data(), records.size());
+        return;
+    }
+    
+    // the category bitmasks were copied when the events were recorded, so filtering doesn't touch the shapes
+    _filteredRecords.clear();
+    for (const auto& record : records)
+    {
+        if ((eventMask & (1 << static_cast<int>(record.eventCode))) != 0
+            && ((record.categoryBitmaskA | record.categoryBitmaskB) & categoryBitmask) != 0)
+        {
+            _filteredRecords.push_back(record);
+        }
+    }
+    
+    if (!_filteredRecords.empty())
+    {
+        onContacts(*world, _filteredRecords.data(), _filteredRecords.size());
+    }
+}
+
+bool EventListenerPhysicsContactBatch::checkAvailable()
+{
+    if (onContacts == nullptr)
+    {
+        CCASSERT(false, "Invalid PhysicsContactBatchListener.");
+        return false;
+    }
+    
+    return true;
+}
+
+EventListenerPhysicsContactBatch* EventListenerPhysicsContactBatch::clone() const
+{
+    EventListenerPhysicsContactBatch* obj = EventListenerPhysicsContactBatch::create();
+    
+    if (obj != nullptr)
+    {
+        obj->onContacts = onContacts;
+        obj->eventMask = eventMask;
+        obj->categoryBitmask = categoryBitmask;
+        
+        return obj;
+    }
+    
+    CC_SAFE_DELETE(obj);
+    return nullptr;
+}
+
 } // namespace cocos2d
 #endif // CC_USE_PHYSICS
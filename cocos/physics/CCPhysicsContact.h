@@ -28,6 +28,8 @@
 #include "base/ccConfig.h"
 #if CC_USE_PHYSICS
 
+#include <vector>
+
 #include "base/CCRef.h"
 #include "math/CCGeometry.h"
 #include "base/CCEventListenerCustom.h"
@@ -197,6 +199,36 @@ private:
     friend class EventListenerPhysicsContact;
 };
 
+/**
+ * @brief A contact event recorded during a step when the contact events of a PhysicsWorld are buffered,
+ * see PhysicsWorld::setContactBufferMask.
+ *
+ * The shapes are retained until the records are delivered, but they may have left their body in the meantime.
+ */
+struct CC_DLL PhysicsContactRecord
+{
+    enum EventMask
+    {
+        BEGIN_MASK = 1 << static_cast<int>(PhysicsContact::EventCode::BEGIN),
+        POSTSOLVE_MASK = 1 << static_cast<int>(PhysicsContact::EventCode::POSTSOLVE),
+        SEPARATE_MASK = 1 << static_cast<int>(PhysicsContact::EventCode::SEPARATE),
+        ALL_MASK = BEGIN_MASK | POSTSOLVE_MASK | SEPARATE_MASK
+    };
+
+    PhysicsContact::EventCode eventCode;
+    PhysicsShape* shapeA;
+    PhysicsShape* shapeB;
+    /** the category bitmasks of the shapes when the event was recorded */
+    int categoryBitmaskA;
+    int categoryBitmaskB;
+    /** contact points and normal, empty on SEPARATE */
+    PhysicsContactData data;
+    /** impulse applied to resolve the contact, on POSTSOLVE only */
+    Vec2 totalImpulse;
+    /** kinetic energy lost by the contact, on POSTSOLVE only */
+    float totalKineticEnergy;
+};
+
 /** Contact listener. It will receive all the contact callbacks. */
 class CC_DLL EventListenerPhysicsContact : public EventListenerCustom
 {
@@ -307,6 +339,43 @@ protected:
     virtual ~EventListenerPhysicsContactWithGroup();
 };
 
+/**
+ * This event listener receives the contact events buffered by a PhysicsWorld during a step in one call,
+ * see PhysicsWorld::setContactBufferMask.
+ * It doesn't receive the contact events of worlds which dispatch them synchronously.
+ */
+class CC_DLL EventListenerPhysicsContactBatch : public EventListenerCustom
+{
+public:
+    /** Create the listener. */
+    static EventListenerPhysicsContactBatch* create();
+
+    virtual bool checkAvailable() override;
+
+    EventListenerPhysicsContactBatch* clone() const;
+
+    /**
+     * @brief Called once after a step with the recorded events the listener accepts, in the order they happened.
+     */
+    std::function<void(PhysicsWorld& world, const PhysicsContactRecord* records, size_t count)> onContacts;
+
+    /** The events delivered to onContacts, a combination of PhysicsContactRecord::EventMask. Default is ALL_MASK. */
+    int eventMask;
+
+    /** Only the events with a shape in one of these categories are delivered. Default is all categories. */
+    int categoryBitmask;
+
+protected:
+    bool init();
+    void onEvent(EventCustom* event);
+
+protected:
+    EventListenerPhysicsContactBatch();
+    virtual ~EventListenerPhysicsContactBatch();
+
+    std::vector<PhysicsContactRecord> _filteredRecords;
+};
+
 /** @} */
 /** @} */
 
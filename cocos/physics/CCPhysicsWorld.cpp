@@ -25,6 +25,7 @@
 #if CC_USE_PHYSICS
 #include <algorithm>
 #include <climits>
+#include <thread>
 
 #include "chipmunk/chipmunk_private.h"
 #include "physics/CCPhysicsBody.h"
@@ -38,11 +39,13 @@
 #include "base/CCDirector.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventCustom.h"
+#include "base/CCJobPool.h"
 
 namespace cocos2d {
 
 const float PHYSICS_INFINITY = FLT_MAX;
 extern const char* PHYSICSCONTACT_EVENT_NAME;
+extern const char* PHYSICSCONTACT_BATCH_EVENT_NAME;
 
 namespace
 {
@@ -88,6 +91,10 @@ public:
 
 bool PhysicsWorld::Callbacks::continues = true;
 
+// user data of the arbiters whose events are buffered, a PhysicsContact is only allocated for synchronous events.
+// The buffered arbiters which don't notify have no user data.
+static char s_bufferedContact;
+
 cpBool PhysicsWorld::Callbacks::collisionBeginCallbackFunc(cpArbiter *arb, struct cpSpace* /*space*/, PhysicsWorld *world)
 {
     CP_ARBITER_GET_SHAPES(arb, a, b);
@@ -95,6 +102,21 @@ cpBool PhysicsWorld::Callbacks::collisionBeginCallbackFunc(cpArbiter *arb, struc
     PhysicsShape *shapeA = static_cast<PhysicsShape*>(cpShapeGetUserData(a));
     PhysicsShape *shapeB = static_cast<PhysicsShape*>(cpShapeGetUserData(b));
     CC_ASSERT(shapeA != nullptr && shapeB != nullptr);
+
+    if (world->_contactBufferMask)
+    {
+        bool notify = false;
+        bool ret = world->filterContact(shapeA, shapeB, &notify);
+        if (notify)
+        {
+            cpArbiterSetUserData(arb, &s_bufferedContact);
+            if (world->_contactBufferMask & PhysicsContactRecord::BEGIN_MASK)
+            {
+                world->recordContact(arb, PhysicsContact::EventCode::BEGIN);
+            }
+        }
+        return ret;
+    }
     
     auto contact = PhysicsContact::construct(shapeA, shapeB);
     cpArbiterSetUserData(arb, contact);
@@ -105,21 +127,49 @@ cpBool PhysicsWorld::Callbacks::collisionBeginCallbackFunc(cpArbiter *arb, struc
 
 cpBool PhysicsWorld::Callbacks::collisionPreSolveCallbackFunc(cpArbiter *arb, cpSpace* /*space*/, PhysicsWorld *world)
 {
-    return world->collisionPreSolveCallback(*static_cast<PhysicsContact*>(cpArbiterGetUserData(arb)));
+    void* data = cpArbiterGetUserData(arb);
+    if (data == nullptr || data == &s_bufferedContact)
+    {
+        return cpTrue;
+    }
+
+    return world->collisionPreSolveCallback(*static_cast<PhysicsContact*>(data));
 }
 
 void PhysicsWorld::Callbacks::collisionPostSolveCallbackFunc(cpArbiter *arb, cpSpace* /*space*/, PhysicsWorld *world)
 {
-    world->collisionPostSolveCallback(*static_cast<PhysicsContact*>(cpArbiterGetUserData(arb)));
+    void* data = cpArbiterGetUserData(arb);
+    if (data == &s_bufferedContact)
+    {
+        if (world->_contactBufferMask & PhysicsContactRecord::POSTSOLVE_MASK)
+        {
+            world->recordContact(arb, PhysicsContact::EventCode::POSTSOLVE);
+        }
+    }
+    else if (data != nullptr)
+    {
+        world->collisionPostSolveCallback(*static_cast<PhysicsContact*>(data));
+    }
 }
 
 void PhysicsWorld::Callbacks::collisionSeparateCallbackFunc(cpArbiter *arb, cpSpace* /*space*/, PhysicsWorld *world)
 {
-    PhysicsContact* contact = static_cast<PhysicsContact*>(cpArbiterGetUserData(arb));
-    
-    world->collisionSeparateCallback(*contact);
-    
-    delete contact;
+    void* data = cpArbiterGetUserData(arb);
+    if (data == &s_bufferedContact)
+    {
+        if (world->_contactBufferMask & PhysicsContactRecord::SEPARATE_MASK)
+        {
+            world->recordContact(arb, PhysicsContact::EventCode::SEPARATE);
+        }
+    }
+    else if (data != nullptr)
+    {
+        PhysicsContact* contact = static_cast<PhysicsContact*>(data);
+
+        world->collisionSeparateCallback(*contact);
+
+        delete contact;
+    }
 }
 
 void PhysicsWorld::Callbacks::rayCastCallbackFunc(cpShape *shape, cpVect point, cpVect normal, cpFloat alpha, RayCastCallbackInfo *info)
@@ -297,18 +347,15 @@ void PhysicsWorld::debugDraw()
     }
 }
 
-bool PhysicsWorld::collisionBeginCallback(PhysicsContact& contact)
+bool PhysicsWorld::filterContact(PhysicsShape* shapeA, PhysicsShape* shapeB, bool* notify) const
 {
     bool ret = true;
     
-    PhysicsShape* shapeA = contact.getShapeA();
-    PhysicsShape* shapeB = contact.getShapeB();
     PhysicsBody* bodyA = shapeA->getBody();
     PhysicsBody* bodyB = shapeB->getBody();
-    std::vector<PhysicsJoint*> jointsA = bodyA->getJoints();
     
     // check the joint is collision enable or not
-    for (PhysicsJoint* joint : jointsA)
+    for (PhysicsJoint* joint : bodyA->getJoints())
     {
         if (std::find(_joints.begin(), _joints.end(), joint) == _joints.end())
         {
@@ -321,18 +368,15 @@ bool PhysicsWorld::collisionBeginCallback(PhysicsContact& contact)
             
             if (body == bodyB)
             {
-                contact.setNotificationEnable(false);
+                *notify = false;
                 return false;
             }
         }
     }
     
     // bitmask check
-    if ((shapeA->getCategoryBitmask() & shapeB->getContactTestBitmask()) == 0
-        || (shapeA->getContactTestBitmask() & shapeB->getCategoryBitmask()) == 0)
-    {
-        contact.setNotificationEnable(false);
-    }
+    *notify = (shapeA->getCategoryBitmask() & shapeB->getContactTestBitmask()) != 0
+        && (shapeA->getContactTestBitmask() & shapeB->getCategoryBitmask()) != 0;
     
     if (shapeA->getGroup() != 0 && shapeA->getGroup() == shapeB->getGroup())
     {
@@ -347,6 +391,15 @@ bool PhysicsWorld::collisionBeginCallback(PhysicsContact& contact)
         }
     }
     
+    return ret;
+}
+
+bool PhysicsWorld::collisionBeginCallback(PhysicsContact& contact)
+{
+    bool notify = false;
+    bool ret = filterContact(contact.getShapeA(), contact.getShapeB(), &notify);
+    contact.setNotificationEnable(notify);
+    
     if (contact.isNotificationEnabled())
     {
         contact.setEventCode(PhysicsContact::EventCode::BEGIN);
@@ -395,6 +448,69 @@ void PhysicsWorld::collisionSeparateCallback(PhysicsContact& contact)
     Director::getInstance()->getEventDispatcher()->dispatchEvent(&contact);
 }
 
+void PhysicsWorld::setContactBufferMask(int eventMask)
+{
+    _contactBufferMask = eventMask & PhysicsContactRecord::ALL_MASK;
+}
+
+void PhysicsWorld::recordContact(cpArbiter* arb, PhysicsContact::EventCode eventCode)
+{
+    CP_ARBITER_GET_SHAPES(arb, a, b);
+
+    PhysicsShape *shapeA = static_cast<PhysicsShape*>(cpShapeGetUserData(a));
+    PhysicsShape *shapeB = static_cast<PhysicsShape*>(cpShapeGetUserData(b));
+    shapeA->retain();
+    shapeB->retain();
+
+    _contactRecords.emplace_back();
+    auto& record = _contactRecords.back();
+    record.eventCode = eventCode;
+    record.shapeA = shapeA;
+    record.shapeB = shapeB;
+    record.categoryBitmaskA = shapeA->getCategoryBitmask();
+    record.categoryBitmaskB = shapeB->getCategoryBitmask();
+    record.totalImpulse = Vec2::ZERO;
+    record.totalKineticEnergy = 0.0f;
+
+    if (eventCode != PhysicsContact::EventCode::SEPARATE)
+    {
+        record.data.count = std::min(cpArbiterGetCount(arb), static_cast<int>(PhysicsContactData::POINT_MAX));
+        for (int i = 0; i < record.data.count; ++i)
+        {
+            record.data.points[i] = PhysicsHelper::cpv2point(cpArbiterGetPointA(arb, i));
+        }
+        record.data.normal = record.data.count > 0 ? PhysicsHelper::cpv2point(cpArbiterGetNormal(arb)) : Vec2::ZERO;
+    }
+
+    if (eventCode == PhysicsContact::EventCode::POSTSOLVE)
+    {
+        record.totalImpulse = PhysicsHelper::cpv2point(cpArbiterTotalImpulse(arb));
+        record.totalKineticEnergy = cpArbiterTotalKE(arb);
+    }
+}
+
+void PhysicsWorld::dispatchBufferedContacts()
+{
+    if (_contactRecords.empty())
+    {
+        return;
+    }
+
+    // the listeners may remove bodies, which records new SEPARATE events for the next step
+    _dispatchedContactRecords.swap(_contactRecords);
+
+    EventCustom event(PHYSICSCONTACT_BATCH_EVENT_NAME);
+    event.setUserData(this);
+    _eventDispatcher->dispatchEvent(&event);
+
+    for (auto& record : _dispatchedContactRecords)
+    {
+        record.shapeA->release();
+        record.shapeB->release();
+    }
+    _dispatchedContactRecords.clear();
+}
+
 void PhysicsWorld::rayCast(PhysicsRayCastCallbackFunc func, const Vec2& point1, const Vec2& point2, void* data)
 {
     CCASSERT(func != nullptr, "func shouldn't be nullptr");
@@ -490,7 +606,6 @@ bool PhysicsWorld::init()
     _cpSpace = cpSpaceNew();
 #else
     _cpSpace = cpHastySpaceNew();
-    cpHastySpaceSetThreads(_cpSpace, 0);
 #endif
 
     if (!_cpSpace)
@@ -498,6 +613,8 @@ bool PhysicsWorld::init()
         return false;
     }
 
+    setSolverThreads(CC_PHYSICS_SOLVER_THREADS);
+
     cpSpaceSetGravity(_cpSpace, PhysicsHelper::point2cpv(_gravity));
 
     cpCollisionHandler *handler = cpSpaceAddDefaultCollisionHandler(_cpSpace);
@@ -527,8 +644,20 @@ void PhysicsWorld::addBody(PhysicsBody* body)
     }
     
     addBodyOrDelay(body);
-    _bodies.push_back( to_retaining_ptr( body));
+    pushBody(_bodies, body, &PhysicsBody::_worldIndex);
     body->_world = this;
+    indexBodyTag(body);
+}
+
+void PhysicsWorld::addBodies(const std::vector<PhysicsBody*>& bodies)
+{
+    _bodies.reserve(_bodies.size() + bodies.size());
+    _delayAddBodies.reserve(_delayAddBodies.size() + bodies.size());
+    
+    for (auto body : bodies)
+    {
+        addBody(body);
+    }
 }
 
 void PhysicsWorld::doAddBody(PhysicsBody* body)
@@ -551,29 +680,78 @@ void PhysicsWorld::doAddBody(PhysicsBody* body)
 
 void PhysicsWorld::addBodyOrDelay(PhysicsBody* body)
 {
-    auto removeBodyIter = std::find_if(
-        _delayRemoveBodies.begin(), _delayRemoveBodies.end(),
-        [body](const retaining_ptr<PhysicsBody> & p) {
-            return p.get() == body;
-        }
-    );
+    if (containsBody(_delayRemoveBodies, body, &PhysicsBody::_delayRemoveIndex))
+    {
+        eraseBody(_delayRemoveBodies, body, &PhysicsBody::_delayRemoveIndex);
+        return;
+    }
+    
+    if (!containsBody(_delayAddBodies, body, &PhysicsBody::_delayAddIndex))
+    {
+        pushBody(_delayAddBodies, body, &PhysicsBody::_delayAddIndex);
+    }
+}
+
+bool PhysicsWorld::containsBody(const BodyList& bodies, PhysicsBody* body, int PhysicsBody::*index)
+{
+    // the index may be stale or refer to the list of another world
+    int i = body->*index;
+    return i >= 0 && i < static_cast<int>(bodies.size()) && bodies[i].get() == body;
+}
 
-    if (removeBodyIter != _delayRemoveBodies.end())
+void PhysicsWorld::pushBody(BodyList& bodies, PhysicsBody* body, int PhysicsBody::*index)
+{
+    body->*index = static_cast<int>(bodies.size());
+    bodies.push_back( to_retaining_ptr( body));
+}
+
+void PhysicsWorld::eraseBody(BodyList& bodies, PhysicsBody* body, int PhysicsBody::*index)
+{
+    if (!containsBody(bodies, body, index))
     {
-        _delayRemoveBodies.erase(removeBodyIter);
         return;
     }
+    
+    int i = body->*index;
+    body->*index = -1;
+    if (i != static_cast<int>(bodies.size()) - 1)
+    {
+        bodies[i] = std::move(bodies.back());
+        bodies[i].get()->*index = i;
+    }
+    bodies.pop_back();
+}
 
-    auto addBodyIter = std::find_if(
-        _delayAddBodies.begin(), _delayAddBodies.end(),
-        [body](const retaining_ptr<PhysicsBody> & p) {
-            return p.get() == body;
-        }
-    );
+void PhysicsWorld::indexBodyTag(PhysicsBody* body)
+{
+    auto& tagged = _bodiesByTag[body->getTag()];
+    body->_tagIndex = static_cast<int>(tagged.size());
+    tagged.push_back(body);
+}
+
+void PhysicsWorld::unindexBodyTag(PhysicsBody* body)
+{
+    auto it = _bodiesByTag.find(body->getTag());
+    if (it == _bodiesByTag.end())
+    {
+        return;
+    }
     
-    if (addBodyIter == _delayAddBodies.end())
+    auto& tagged = it->second;
+    int i = body->_tagIndex;
+    if (i < 0 || i >= static_cast<int>(tagged.size()) || tagged[i] != body)
     {
-        _delayAddBodies.push_back( to_retaining_ptr( body));
+        return;
+    }
+    
+    tagged[i] = tagged.back();
+    tagged[i]->_tagIndex = i;
+    tagged.pop_back();
+    body->_tagIndex = -1;
+    
+    if (tagged.empty())
+    {
+        _bodiesByTag.erase(it);
     }
 }
 
@@ -600,13 +778,10 @@ void PhysicsWorld::updateBodies()
 
 void PhysicsWorld::removeBody(int tag)
 {
-    for (auto& body : _bodies)
+    auto body = getBody(tag);
+    if (body)
     {
-        if (body->getTag() == tag)
-        {
-            removeBody(body.get());
-            return;
-        }
+        removeBody(body);
     }
 }
 
@@ -618,6 +793,65 @@ void PhysicsWorld::removeBody(PhysicsBody* body)
         return;
     }
     
+    removeBodyJoints(body);
+    removeBodyOrDelay(body);
+    forgetBody(body);
+}
+
+void PhysicsWorld::removeBodies(const std::vector<PhysicsBody*>& bodies)
+{
+    // keeps the bodies alive until they have left the space
+    BodyList removed;
+    removed.reserve(bodies.size());
+    
+    bool locked = cpSpaceIsLocked(_cpSpace);
+    for (auto body : bodies)
+    {
+        if (body->getWorld() != this)
+        {
+            CCLOG("Physics Warning: this body doesn't belong to this world");
+            continue;
+        }
+        
+        removed.push_back(to_retaining_ptr(body));
+        removeBodyJoints(body);
+        
+        if (containsBody(_delayAddBodies, body, &PhysicsBody::_delayAddIndex))
+        {
+            eraseBody(_delayAddBodies, body, &PhysicsBody::_delayAddIndex);
+        }
+        else if (locked && !containsBody(_delayRemoveBodies, body, &PhysicsBody::_delayRemoveIndex))
+        {
+            pushBody(_delayRemoveBodies, body, &PhysicsBody::_delayRemoveIndex);
+        }
+        
+        forgetBody(body);
+    }
+    
+    if (locked)
+    {
+        return;
+    }
+    
+    // all the shapes leave the space before the bodies, the ones which never entered it are skipped
+    for (auto& body : removed)
+    {
+        for (auto& shape : body->getShapes())
+        {
+            removeShape(shape.get());
+        }
+    }
+    for (auto& body : removed)
+    {
+        if (cpSpaceContainsBody(_cpSpace, body->_cpBody))
+        {
+            cpSpaceRemoveBody(_cpSpace, body->_cpBody);
+        }
+    }
+}
+
+void PhysicsWorld::removeBodyJoints(PhysicsBody* body)
+{
     // destroy the body's joints
     auto removeCopy = body->_joints;
     for (auto joint : removeCopy)
@@ -625,48 +859,29 @@ void PhysicsWorld::removeBody(PhysicsBody* body)
         removeJoint(joint, true);
     }
     body->_joints.clear();
-    
-    removeBodyOrDelay(body);
-    
-    auto it = std::find_if(
-        _bodies.begin(), _bodies.end(),
-        [body](const retaining_ptr<PhysicsBody> & p) {
-            return p.get() == body;
-        }
-    );
-    if (_bodies.end() != it)
-        _bodies.erase(it);
+}
 
+void PhysicsWorld::forgetBody(PhysicsBody* body)
+{
+    unindexBodyTag(body);
     body->_world = nullptr;
+    // may release the last reference to the body
+    eraseBody(_bodies, body, &PhysicsBody::_worldIndex);
 }
 
 void PhysicsWorld::removeBodyOrDelay(PhysicsBody* body)
 {
-    auto addBodyIter = std::find_if(
-        _delayAddBodies.begin(), _delayAddBodies.end(),
-        [body](const retaining_ptr<PhysicsBody> & p) {
-            return p.get() == body;
-        }
-    );
-
-    if (_delayAddBodies.end() != addBodyIter)
+    if (containsBody(_delayAddBodies, body, &PhysicsBody::_delayAddIndex))
     {
-        _delayAddBodies.erase(addBodyIter);
+        eraseBody(_delayAddBodies, body, &PhysicsBody::_delayAddIndex);
         return;
     }
     
     if (cpSpaceIsLocked(_cpSpace))
     {
-        auto removeBodyIter = std::find_if(
-            _delayRemoveBodies.begin(), _delayRemoveBodies.end(),
-            [body](const retaining_ptr<PhysicsBody> & p) {
-                return p.get() == body;
-            }
-        );
-
-        if (_delayRemoveBodies.end() == removeBodyIter)
+        if (!containsBody(_delayRemoveBodies, body, &PhysicsBody::_delayRemoveIndex))
         {
-            _delayRemoveBodies.push_back( to_retaining_ptr( body));
+            pushBody(_delayRemoveBodies, body, &PhysicsBody::_delayRemoveIndex);
         }
     }
     else
@@ -842,9 +1057,12 @@ void PhysicsWorld::removeAllBodies()
     {
         removeBodyOrDelay(child.get());
         child->_world = nullptr;
+        child->_worldIndex = -1;
+        child->_tagIndex = -1;
     }
     
     _bodies.clear();
+    _bodiesByTag.clear();
 }
 
 void PhysicsWorld::setDebugDrawMask(DebugDraw mask)
@@ -864,12 +1082,10 @@ void PhysicsWorld::setDebugDrawMask(DebugDraw mask)
 
 PhysicsBody* PhysicsWorld::getBody(int tag) const
 {
-    for (auto& body : _bodies)
+    auto it = _bodiesByTag.find(tag);
+    if (it != _bodiesByTag.end() && !it->second.empty())
     {
-        if (body->getTag() == tag)
-        {
-            return body.get();
-        }
+        return it->second.front();
     }
     
     return nullptr;
@@ -917,7 +1133,7 @@ void PhysicsWorld::update(float delta, bool userCall/* = false*/)
     }
     
     auto sceneToWorldTransform = _scene->getNodeToParentTransform();
-    beforeSimulation(_scene, sceneToWorldTransform, 1.f, 1.f, 0.f);
+    beforeSimulation(sceneToWorldTransform);
 
     if (!_delayAddJoints.empty() || !_delayRemoveJoints.empty())
     {
@@ -929,30 +1145,51 @@ void PhysicsWorld::update(float delta, bool userCall/* = false*/)
         return;
     }
     
+    _interpolationAlpha = -1.0f;
+    
     if (userCall)
     {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
-		cpSpaceStep(_cpSpace, delta);
-#else
-		cpHastySpaceStep(_cpSpace, delta);
-#endif
+        stepSpace(delta);
     }
     else
     {
         _updateTime += delta;
         if(_fixedRate)
         {
+            // the steps only depend on the sequence of deltas, the time left is carried to the next update
             const float step = 1.0f / _fixedRate;
             const float dt = step * _speed;
-            while(_updateTime>step)
+            int steps = 0;
+            while(_updateTime >= step)
             {
-                _updateTime-=step;
-#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
-				cpSpaceStep(_cpSpace, dt);
-#else
-				cpHastySpaceStep(_cpSpace, dt);
-#endif
-			}
+                _updateTime -= step;
+                ++steps;
+            }
+            if (_maxFixedSteps > 0 && steps > _maxFixedSteps)
+            {
+                steps = _maxFixedSteps;
+            }
+            
+            for (int i = 0; i < steps; ++i)
+            {
+                if (_interpolationEnabled && i == steps - 1)
+                {
+                    for (auto& body : _bodies)
+                    {
+                        body->recordPreviousState();
+                    }
+                }
+                stepSpace(dt);
+                for (auto& body : _bodies)
+                {
+                    body->update(dt);
+                }
+            }
+            
+            if (_interpolationEnabled)
+            {
+                _interpolationAlpha = _updateTime / step;
+            }
         }
         else
         {
@@ -961,12 +1198,8 @@ void PhysicsWorld::update(float delta, bool userCall/* = false*/)
                 const float dt = _updateTime * _speed / _substeps;
                 for (int i = 0; i < _substeps; ++i)
                 {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
-					cpSpaceStep(_cpSpace, dt);
-#else
-					cpHastySpaceStep(_cpSpace, dt);
-#endif 
-					for (auto& body : _bodies)
+                    stepSpace(dt);
+                    for (auto& body : _bodies)
                     {
                         body->update(dt);
                     }
@@ -982,9 +1215,40 @@ void PhysicsWorld::update(float delta, bool userCall/* = false*/)
         debugDraw();
     }
 
-    // Update physics position, should loop as the same sequence as node tree.
-    // PhysicsWorld::afterSimulation() will depend on the sequence.
-    afterSimulation(_scene, sceneToWorldTransform, 0.f);
+    afterSimulation(sceneToWorldTransform);
+
+    dispatchBufferedContacts();
+}
+
+void PhysicsWorld::stepSpace(float delta)
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    cpSpaceStep(_cpSpace, delta);
+#else
+    cpHastySpaceStep(_cpSpace, delta);
+#endif
+}
+
+void PhysicsWorld::setSolverThreads(int threads)
+{
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WINRT && CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+    if (threads <= 0)
+    {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    cpHastySpaceSetThreads(_cpSpace, threads);
+#else
+    CC_UNUSED_PARAM(threads);
+#endif
+}
+
+int PhysicsWorld::getSolverThreads() const
+{
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WINRT && CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+    return static_cast<int>(cpHastySpaceGetThreads(_cpSpace));
+#else
+    return 1;
+#endif
 }
 
 PhysicsWorld* PhysicsWorld::construct(Scene* scene)
@@ -1009,6 +1273,9 @@ PhysicsWorld::PhysicsWorld()
 , _updateTime(0.0f)
 , _substeps(1)
 , _fixedRate(0)
+, _maxFixedSteps(0)
+, _interpolationEnabled(false)
+, _interpolationAlpha(-1.0f)
 , _cpSpace(nullptr)
 , _updateBodyTransform(false)
 , _scene(nullptr)
@@ -1016,14 +1283,21 @@ PhysicsWorld::PhysicsWorld()
 , _debugDrawId()
 , _debugDrawMask(DebugDraw::NONE)
 , _eventDispatcher(nullptr)
+, _contactBufferMask(0)
 {
     
 }
 
 PhysicsWorld::~PhysicsWorld()
 {
+    _contactBufferMask = 0;
     removeAllJoints(true);
     removeAllBodies();
+    for (auto& record : _contactRecords)
+    {
+        record.shapeA->release();
+        record.shapeB->release();
+    }
     if (_cpSpace)
     {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
@@ -1036,7 +1310,7 @@ PhysicsWorld::~PhysicsWorld()
     Director::getInstance()->getRunningScene()->removeChild(_debugDrawId);
 }
 
-void PhysicsWorld::beforeSimulation(Node *node, const Mat4& parentToWorldTransform, float nodeParentScaleX, float nodeParentScaleY, float parentRotation)
+void PhysicsWorld::collectBodyTransforms(Node *node, const Mat4& parentToWorldTransform, float nodeParentScaleX, float nodeParentScaleY, float parentRotation)
 {
     auto scaleX = nodeParentScaleX * node->getScaleX();
     auto scaleY = nodeParentScaleY * node->getScaleY();
@@ -1047,26 +1321,58 @@ void PhysicsWorld::beforeSimulation(Node *node, const Mat4& parentToWorldTransfo
     auto physicsBody = node->getPhysicsBody();
     if (physicsBody)
     {
-        physicsBody->beforeSimulation(parentToWorldTransform, nodeToWorldTransform, scaleX, scaleY, rotation);
+        _bodyTransforms.push_back({physicsBody, parentToWorldTransform, nodeToWorldTransform, scaleX, scaleY, parentRotation, rotation});
     }
 
     for (auto & child : node->getChildren())
-        beforeSimulation(child.get(), nodeToWorldTransform, scaleX, scaleY, rotation);
+        collectBodyTransforms(child.get(), nodeToWorldTransform, scaleX, scaleY, rotation);
 }
 
-void PhysicsWorld::afterSimulation(Node *node, const Mat4& parentToWorldTransform, float parentRotation)
+void PhysicsWorld::beforeSimulation(const Mat4& sceneToWorldTransform)
 {
-    auto nodeToWorldTransform = parentToWorldTransform * node->getNodeToParentTransform();
-    auto nodeRotation = parentRotation + node->getRotation();
+    _bodyTransforms.clear();
+    collectBodyTransforms(_scene, sceneToWorldTransform, 1.f, 1.f, 0.f);
 
-    auto physicsBody = node->getPhysicsBody();
-    if (physicsBody)
+    // the transforms are independent, but moving a body wakes it up in the space so it stays serial
+    JobPool::getInstance()->parallelFor(_bodyTransforms.size(), [this](size_t i) {
+        auto& transform = _bodyTransforms[i];
+        transform.body->prepareSimulation(transform.parentToWorldTransform, transform.nodeToWorldTransform);
+    }, 64);
+
+    for (auto& transform : _bodyTransforms)
     {
-        physicsBody->afterSimulation(parentToWorldTransform, parentRotation);
+        transform.body->beforeSimulation(transform.scaleX, transform.scaleY, transform.rotation);
     }
+}
 
-    for (auto & child : node->getChildren())
-        afterSimulation(child.get(), nodeToWorldTransform, nodeRotation);
+void PhysicsWorld::afterSimulation(const Mat4& sceneToWorldTransform)
+{
+    // the contact callbacks may have changed the node tree since beforeSimulation().
+    // The transforms are collected before any owner moves, so a child body follows
+    // the transform its parent had during the step, whichever body is synced first.
+    _bodyTransforms.clear();
+    collectBodyTransforms(_scene, sceneToWorldTransform, 1.f, 1.f, 0.f);
+
+    if (_interpolationAlpha >= 0.0f)
+    {
+        JobPool::getInstance()->parallelFor(_bodyTransforms.size(), [this](size_t i) {
+            auto& transform = _bodyTransforms[i];
+            transform.body->prepareAfterSimulation(transform.parentToWorldTransform, transform.parentRotation, _interpolationAlpha);
+        }, 64);
+    }
+    else
+    {
+        JobPool::getInstance()->parallelFor(_bodyTransforms.size(), [this](size_t i) {
+            auto& transform = _bodyTransforms[i];
+            transform.body->prepareAfterSimulation(transform.parentToWorldTransform, transform.parentRotation);
+        }, 64);
+    }
+
+    // the Node setters dirty the children of the owner and may be overridden, so the owners move in this thread
+    for (auto& transform : _bodyTransforms)
+    {
+        transform.body->afterSimulation(transform.parentToWorldTransform, transform.parentRotation);
+    }
 }
 
 } // namespace cocos2d
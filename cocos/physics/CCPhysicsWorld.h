@@ -29,11 +29,14 @@
 #if CC_USE_PHYSICS
 
 #include <list>
+#include <unordered_map>
 #include "2d/CCNode.h" // NodeId
 #include "math/CCGeometry.h"
 #include "physics/CCPhysicsBody.h"
+#include "physics/CCPhysicsContact.h"
 
 struct cpSpace;
+struct cpArbiter;
 
 namespace cocos2d {
 
@@ -164,6 +167,14 @@ public:
     */
     void removeBody(int tag);
 
+    /**
+    * Remove several bodies from this physics world at once.
+    *
+    * Same as calling removeBody() for each body, the bodies are taken out of the space in one pass.
+    * @param   bodies   The bodies to remove, the ones which don't belong to this world are ignored.
+    */
+    void removeBodies(const std::vector<PhysicsBody*>& bodies);
+
     /**
     * Remove all bodies from physics world. 
     * 
@@ -231,6 +242,7 @@ public:
     /**
     * Get a body by tag. 
     * 
+    * The bodies are indexed by tag, if several bodies share the tag any of them may be returned.
     * @param   tag   An integer number that identifies a PhysicsBody object. 
     * @return A PhysicsBody object pointer or nullptr if no shapes were found.
     */
@@ -311,10 +323,77 @@ public:
      * 0 - disable fixed step system
      * default value is 0
      */
-    void setFixedUpdateRate(int updatesPerSecond) { if(updatesPerSecond > 0) { _fixedRate = updatesPerSecond; } }
+    void setFixedUpdateRate(int updatesPerSecond) { if(updatesPerSecond >= 0) { _fixedRate = updatesPerSecond; } }
     /** get the number of substeps */
     int getFixedUpdateRate() const { return _fixedRate; }
 
+    /**
+     * set the maximum number of fixed steps in an update of the physics world.
+     *
+     * When a frame takes longer than that many steps, the remaining time is dropped instead of being
+     * simulated in the next frames, so a slow frame doesn't make the following ones slower.
+     * Only used with a fixed update rate.
+     * @param steps An integer number, default value is 0 which doesn't limit the steps.
+     */
+    void setMaxFixedSteps(int steps) { if(steps >= 0) { _maxFixedSteps = steps; } }
+    /** get the maximum number of fixed steps in an update */
+    int getMaxFixedSteps() const { return _maxFixedSteps; }
+
+    /**
+     * Interpolate the owners of the bodies between the two last fixed steps.
+     *
+     * With a fixed update rate, the time left in the accumulator after the steps of a frame is used to
+     * blend the transforms of the previous and the current step when they are written to the nodes,
+     * so the motion stays smooth when the frame rate doesn't match the update rate.
+     * The rendered state lags up to one step behind the simulation; the simulation itself isn't
+     * affected and only depends on the sequence of update deltas, as long as the solver runs on one
+     * thread (see setSolverThreads).
+     * A node moved by the game between two updates still moves its body. Bodies whose owner has a
+     * simulated ancestor are moved along with it, which isn't recommended with interpolation.
+     * Only used with a fixed update rate and auto step.
+     * @param enabled A bool object, default value is false.
+     */
+    void setInterpolationEnabled(bool enabled) { _interpolationEnabled = enabled; }
+    /** Whether the owners of the bodies are interpolated between the fixed steps. */
+    bool isInterpolationEnabled() const { return _interpolationEnabled; }
+
+    /**
+     * Set the number of threads solving the contacts and joints of this world, the calling thread included.
+     *
+     * 0 uses one thread per CPU core, the default is CC_PHYSICS_SOLVER_THREADS.
+     * Chipmunk caps the threads of its solver, and Win32 and WinRT always solve on the calling thread.
+     * @param threads An integer number.
+     */
+    void setSolverThreads(int threads);
+
+    /**
+     * Get the number of threads solving the contacts and joints of this world.
+     *
+     * @return An integer number, it may be lower than the number set.
+     */
+    int getSolverThreads() const;
+
+    /**
+     * Buffer the contact events of this world instead of dispatching them during the step.
+     *
+     * The events in the mask are recorded while the space is stepped, and delivered to the
+     * EventListenerPhysicsContactBatch listeners in one event after the step.
+     * PRESOLVE is never buffered, and the listeners can't reject a contact: the shapes collide
+     * according to their groups and bitmasks. Pairs failing the category and contact test
+     * bitmasks aren't recorded.
+     * EventListenerPhysicsContact listeners don't receive anything while the events are buffered.
+     *
+     * @param eventMask A combination of PhysicsContactRecord::EventMask, default value is 0 which dispatches the events synchronously.
+     */
+    void setContactBufferMask(int eventMask);
+
+    /**
+     * Get the contact events buffered by this world.
+     *
+     * @return A combination of PhysicsContactRecord::EventMask.
+     */
+    int getContactBufferMask() const { return _contactBufferMask; }
+
     /**
     * Set the debug draw mask of this physics world.
     * 
@@ -357,8 +436,13 @@ public:
     void step(float delta);
     
     void addBody(PhysicsBody* body);
+    /** adds several bodies, they enter the space together at the next step like the ones added by addBody() */
+    void addBodies(const std::vector<PhysicsBody*>& bodies);
     void addBodyOrDelay(PhysicsBody* body);
     void removeBodyOrDelay(PhysicsBody* body);
+    /** keep the tag index of getBody() up to date, PhysicsBody::setTag() calls them around a change of tag */
+    void indexBodyTag(PhysicsBody* body);
+    void unindexBodyTag(PhysicsBody* body);
 
     void addShape(PhysicsShape* shape);
     void removeShape(PhysicsShape* shape);
@@ -369,6 +453,7 @@ private:
 
     bool init();
     
+    bool filterContact(PhysicsShape* shapeA, PhysicsShape* shapeB, bool* notify) const;
     bool collisionBeginCallback(PhysicsContact& contact);
     bool collisionPreSolveCallback(PhysicsContact& contact);
     void collisionPostSolveCallback(PhysicsContact& contact);
@@ -380,6 +465,20 @@ private:
 
     void updateBodies();
     void updateJoints();
+
+    // the body lists are unordered, each body stores its position in each list so it's removed by swapping it with the last one
+    typedef std::vector<retaining_ptr<PhysicsBody>> BodyList;
+    static bool containsBody(const BodyList& bodies, PhysicsBody* body, int PhysicsBody::*index);
+    static void pushBody(BodyList& bodies, PhysicsBody* body, int PhysicsBody::*index);
+    static void eraseBody(BodyList& bodies, PhysicsBody* body, int PhysicsBody::*index);
+
+    void removeBodyJoints(PhysicsBody* body);
+    void forgetBody(PhysicsBody* body);
+
+    void stepSpace(float delta);
+
+    void recordContact(cpArbiter* arb, PhysicsContact::EventCode eventCode);
+    void dispatchBufferedContacts();
     
 private:
     Vec2 _gravity;
@@ -389,10 +488,15 @@ private:
     float _updateTime;
     int _substeps;
     int _fixedRate;
+    int _maxFixedSteps;
+    bool _interpolationEnabled;
+    // blend between the previous and the current step for the owners, negative when they aren't interpolated
+    float _interpolationAlpha;
     cpSpace* _cpSpace;
     
     bool _updateBodyTransform;
     std::vector<retaining_ptr<PhysicsBody>> _bodies;
+    std::unordered_map<int, std::vector<PhysicsBody*>> _bodiesByTag;
     std::list<PhysicsJoint*> _joints;
     Scene* _scene;
     
@@ -406,12 +510,32 @@ private:
     std::vector<retaining_ptr<PhysicsBody>> _delayRemoveBodies;
     std::vector<PhysicsJoint*> _delayAddJoints;
     std::vector<PhysicsJoint*> _delayRemoveJoints;
+
+    // the bodies of the scene with the transforms of their owners, in the node tree order
+    struct BodyTransform
+    {
+        PhysicsBody* body;
+        Mat4 parentToWorldTransform;
+        Mat4 nodeToWorldTransform;
+        float scaleX;
+        float scaleY;
+        float parentRotation;
+        float rotation;
+    };
+    std::vector<BodyTransform> _bodyTransforms;
+
+    int _contactBufferMask;
+    std::vector<PhysicsContactRecord> _contactRecords;
+    std::vector<PhysicsContactRecord> _dispatchedContactRecords;
     
 private:
     PhysicsWorld();
     
-    void beforeSimulation(Node *node, const Mat4& parentToWorldTransform, float nodeParentScaleX, float nodeParentScaleY, float parentRotation);
-    void afterSimulation(Node* node, const Mat4& parentToWorldTransform, float parentRotation);
+    void collectBodyTransforms(Node *node, const Mat4& parentToWorldTransform, float nodeParentScaleX, float nodeParentScaleY, float parentRotation);
+    void beforeSimulation(const Mat4& sceneToWorldTransform);
+    void afterSimulation(const Mat4& sceneToWorldTransform);
+
+    friend class EventListenerPhysicsContactBatch;
 };
 
 extern const float CC_DLL PHYSICS_INFINITY;
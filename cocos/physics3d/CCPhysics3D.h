@@ -55,6 +55,13 @@ CC_DLL const char* physics3dVersion();
 #include "bullet/btBulletDynamicsCommon.h"
 #include "bullet/BulletCollision/CollisionDispatch/btGhostObject.h"
 
+#if CC_ENABLE_BULLET_MULTITHREADING
+#include "bullet/LinearMath/btThreads.h"
+#include "bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#endif
+
 //convert between cocos and bullet
 cocos2d::Vec3 convertbtVector3ToVec3(const btVector3 &btVec3);
 btVector3 convertVec3TobtVector3(const cocos2d::Vec3 &vec3);
@@ -37,6 +37,9 @@ Physics3DComponent::Physics3DComponent()
     : Component(PHYSICS_3D_COMPONENT_NAME)
     , _physics3DObj(nullptr)
     , _syncFlag(Physics3DComponent::PhysicsSyncFlag::NODE_AND_NODE)
+    , _syncedNodeToWorldValid(false)
+    , _nested(false)
+    , _depth(0)
 {
 }
 
@@ -57,6 +60,7 @@ void Physics3DComponent::setPhysics3DObject(Physics3DObject* physicsObj)
     CC_SAFE_RETAIN(physicsObj);
     CC_SAFE_RELEASE(_physics3DObj);
     _physics3DObj = physicsObj;
+    _syncedNodeToWorldValid = false;
 }
 
 void Physics3DComponent::setEnabled(bool b)
@@ -80,6 +84,8 @@ void Physics3DComponent::addToPhysicsWorld(Physics3DWorld* world)
         auto it = std::find(components.begin(), components.end(), this);
         if (it == components.end())
         {
+            _syncedNodeToWorldValid = false;
+            world->_componentsChanged = true;
             auto parent = _owner->getParent();
             while (parent) {
                 for (size_t i = 0; i < components.size(); i++) {
@@ -118,27 +124,22 @@ void Physics3DComponent::onExit()
     //remove component from physics world
     if (_physics3DObj)
     {
-        auto& components = _physics3DObj->getPhysicsWorld()->_physicsComponents;
+        auto world = _physics3DObj->getPhysicsWorld();
+        auto& components = world->_physicsComponents;
         auto it = std::find(components.begin(), components.end(), this);
         if (it != components.end())
+        {
             components.erase(it);
+            world->_componentsChanged = true;
+        }
     }
 }
 
-void Physics3DComponent::preSimulate()
-{
-    if (((int)_syncFlag & (int)Physics3DComponent::PhysicsSyncFlag::NODE_TO_PHYSICS) && _physics3DObj && _owner)
-    {
-        syncNodeToPhysics();
-    }
-}
-
-void Physics3DComponent::postSimulate()
+bool Physics3DComponent::needsSync(PhysicsSyncFlag flag) const
 {
-    if (((int)_syncFlag & (int)Physics3DComponent::PhysicsSyncFlag::PHYSICS_TO_NODE) && _physics3DObj && _owner)
-    {
-        syncPhysicsToNode();
-    }
+    return ((int)_syncFlag & (int)flag) && _physics3DObj && _owner
+        && (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY
+         || _physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::COLLIDER);
 }
 
 void Physics3DComponent::setTransformInPhysics(const cocos2d::Vec3& translateInPhysics, const cocos2d::Quaternion& rotInPhsyics)
@@ -149,11 +150,13 @@ void Physics3DComponent::setTransformInPhysics(const cocos2d::Vec3& translateInP
     _transformInPhysics.m[14] = translateInPhysics.z;
     
     _invTransformInPhysics = _transformInPhysics.getInversed();
+    _syncedNodeToWorldValid = false;
 }
 
 void Physics3DComponent::setSyncFlag(PhysicsSyncFlag syncFlag)
 {
     _syncFlag = syncFlag;
+    _syncedNodeToWorldValid = false;
 }
 
 void Physics3DComponent::syncPhysicsToNode()
@@ -164,65 +167,94 @@ void Physics3DComponent::syncPhysicsToNode()
         Mat4 parentMat;
         if (_owner->getParent())
             parentMat = _owner->getParent()->getNodeToWorldTransform();
-        
-        auto mat = parentMat.getInversed() * _physics3DObj->getWorldTransform();
-        //remove scale, no scale support for physics
-        float oneOverLen = 1.f / sqrtf(mat.m[0] * mat.m[0] + mat.m[1] * mat.m[1] + mat.m[2] * mat.m[2]);
-        mat.m[0] *= oneOverLen;
-        mat.m[1] *= oneOverLen;
-        mat.m[2] *= oneOverLen;
-        oneOverLen = 1.f / sqrtf(mat.m[4] * mat.m[4] + mat.m[5] * mat.m[5] + mat.m[6] * mat.m[6]);
-        mat.m[4] *= oneOverLen;
-        mat.m[5] *= oneOverLen;
-        mat.m[6] *= oneOverLen;
-        oneOverLen = 1.f / sqrtf(mat.m[8] * mat.m[8] + mat.m[9] * mat.m[9] + mat.m[10] * mat.m[10]);
-        mat.m[8] *= oneOverLen;
-        mat.m[9] *= oneOverLen;
-        mat.m[10] *= oneOverLen;
-        
-        mat *= _transformInPhysics;
-        static Vec3 scale, translation;
-        static Quaternion quat;
-        mat.decompose(&scale, &quat, &translation);
-        _owner->setPosition3D(translation);
-        quat.normalize();
-        _owner->setRotationQuat(quat);
+
+        syncPhysicsToNode(parentMat);
     }
 }
 
+void Physics3DComponent::syncPhysicsToNode(const Mat4& parentMat)
+{
+    preparePhysicsToNode(parentMat);
+    applyPhysicsToNode(parentMat);
+}
+
+void Physics3DComponent::preparePhysicsToNode(const Mat4& parentMat)
+{
+    auto mat = parentMat.getInversed() * _physics3DObj->getWorldTransform();
+    //remove scale, no scale support for physics
+    float oneOverLen = 1.f / sqrtf(mat.m[0] * mat.m[0] + mat.m[1] * mat.m[1] + mat.m[2] * mat.m[2]);
+    mat.m[0] *= oneOverLen;
+    mat.m[1] *= oneOverLen;
+    mat.m[2] *= oneOverLen;
+    oneOverLen = 1.f / sqrtf(mat.m[4] * mat.m[4] + mat.m[5] * mat.m[5] + mat.m[6] * mat.m[6]);
+    mat.m[4] *= oneOverLen;
+    mat.m[5] *= oneOverLen;
+    mat.m[6] *= oneOverLen;
+    oneOverLen = 1.f / sqrtf(mat.m[8] * mat.m[8] + mat.m[9] * mat.m[9] + mat.m[10] * mat.m[10]);
+    mat.m[8] *= oneOverLen;
+    mat.m[9] *= oneOverLen;
+    mat.m[10] *= oneOverLen;
+    
+    mat *= _transformInPhysics;
+    Vec3 scale;
+    mat.decompose(&scale, &_physicsRotation, &_physicsPosition);
+    _physicsRotation.normalize();
+}
+
+void Physics3DComponent::applyPhysicsToNode(const Mat4& parentMat)
+{
+    _owner->setPosition3D(_physicsPosition);
+    _owner->setRotationQuat(_physicsRotation);
+
+    _syncedNodeToWorld = parentMat * _owner->getNodeToParentTransform();
+    _syncedNodeToWorldValid = true;
+}
+
 void Physics3DComponent::syncNodeToPhysics()
 {
     if (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY
      || _physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::COLLIDER)
     {
-        auto mat = _owner->getNodeToWorldTransform();
-        //remove scale, no scale support for physics
-        float oneOverLen = 1.f / sqrtf(mat.m[0] * mat.m[0] + mat.m[1] * mat.m[1] + mat.m[2] * mat.m[2]);
-        mat.m[0] *= oneOverLen;
-        mat.m[1] *= oneOverLen;
-        mat.m[2] *= oneOverLen;
-        oneOverLen = 1.f / sqrtf(mat.m[4] * mat.m[4] + mat.m[5] * mat.m[5] + mat.m[6] * mat.m[6]);
-        mat.m[4] *= oneOverLen;
-        mat.m[5] *= oneOverLen;
-        mat.m[6] *= oneOverLen;
-        oneOverLen = 1.f / sqrtf(mat.m[8] * mat.m[8] + mat.m[9] * mat.m[9] + mat.m[10] * mat.m[10]);
-        mat.m[8] *= oneOverLen;
-        mat.m[9] *= oneOverLen;
-        mat.m[10] *= oneOverLen;
-        
-        mat *=  _invTransformInPhysics;
-        if (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY)
-        {
-            auto body = static_cast<Physics3DRigidBody*>(_physics3DObj)->getRigidBody();
-            auto motionState = body->getMotionState();
-            motionState->setWorldTransform(convertMat4TobtTransform(mat));
-            body->setMotionState(motionState);
-        }
-        else if (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::COLLIDER)
-        {
-            auto object = static_cast<Physics3DCollider*>(_physics3DObj)->getGhostObject();
-            object->setWorldTransform(convertMat4TobtTransform(mat));
-        }
+        Mat4 parentMat;
+        if (_owner->getParent())
+            parentMat = _owner->getParent()->getNodeToWorldTransform();
+
+        syncNodeToPhysics(parentMat * _owner->getNodeToParentTransform());
+    }
+}
+
+void Physics3DComponent::syncNodeToPhysics(const Mat4& nodeToWorld)
+{
+    _syncedNodeToWorld = nodeToWorld;
+    _syncedNodeToWorldValid = true;
+
+    auto mat = nodeToWorld;
+    //remove scale, no scale support for physics
+    float oneOverLen = 1.f / sqrtf(mat.m[0] * mat.m[0] + mat.m[1] * mat.m[1] + mat.m[2] * mat.m[2]);
+    mat.m[0] *= oneOverLen;
+    mat.m[1] *= oneOverLen;
+    mat.m[2] *= oneOverLen;
+    oneOverLen = 1.f / sqrtf(mat.m[4] * mat.m[4] + mat.m[5] * mat.m[5] + mat.m[6] * mat.m[6]);
+    mat.m[4] *= oneOverLen;
+    mat.m[5] *= oneOverLen;
+    mat.m[6] *= oneOverLen;
+    oneOverLen = 1.f / sqrtf(mat.m[8] * mat.m[8] + mat.m[9] * mat.m[9] + mat.m[10] * mat.m[10]);
+    mat.m[8] *= oneOverLen;
+    mat.m[9] *= oneOverLen;
+    mat.m[10] *= oneOverLen;
+    
+    mat *=  _invTransformInPhysics;
+    if (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY)
+    {
+        auto body = static_cast<Physics3DRigidBody*>(_physics3DObj)->getRigidBody();
+        auto motionState = body->getMotionState();
+        motionState->setWorldTransform(convertMat4TobtTransform(mat));
+        body->setMotionState(motionState);
+    }
+    else if (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::COLLIDER)
+    {
+        auto object = static_cast<Physics3DCollider*>(_physics3DObj)->getGhostObject();
+        object->setWorldTransform(convertMat4TobtTransform(mat));
     }
 }
 
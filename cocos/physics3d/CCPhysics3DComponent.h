@@ -123,15 +123,31 @@ public:
     void syncPhysicsToNode();
     
 protected:
-    void preSimulate();
-    
-    void postSimulate();
+    /** whether the component syncs in the direction of flag, and has a rigid body or a collider and an owner */
+    bool needsSync(PhysicsSyncFlag flag) const;
+
+    /** synchronize node transformation to physics, the world transform of the node is given */
+    void syncNodeToPhysics(const cocos2d::Mat4& nodeToWorld);
+
+    /** synchronize physics transformation to node, the world transform of the parent node is given */
+    void syncPhysicsToNode(const cocos2d::Mat4& parentToWorld);
+    /** computes the node transform of syncPhysicsToNode without touching the node, so it may run on any thread */
+    void preparePhysicsToNode(const cocos2d::Mat4& parentToWorld);
+    /** moves the node to the transform computed by preparePhysicsToNode, in the cocos thread */
+    void applyPhysicsToNode(const cocos2d::Mat4& parentToWorld);
     
     cocos2d::Mat4             _transformInPhysics; //transform in physics space
     cocos2d::Mat4             _invTransformInPhysics;
     
     Physics3DObject*          _physics3DObj;
     PhysicsSyncFlag           _syncFlag;
+
+    cocos2d::Mat4             _syncedNodeToWorld; //the node transform of the last synchronization, nodes which didn't move since aren't synced to physics
+    bool                      _syncedNodeToWorldValid;
+    bool                      _nested; //an ancestor of the owner has a component in the same world
+    int                       _depth; //count of the ancestors of the owner, orders the nested components
+    cocos2d::Vec3             _physicsPosition; //the node transform computed by preparePhysicsToNode
+    cocos2d::Quaternion       _physicsRotation;
 };
 
 // end of 3d group
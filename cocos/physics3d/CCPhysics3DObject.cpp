@@ -87,6 +87,7 @@ bool Physics3DRigidBody::init(Physics3DRigidBodyDes* info)
     btDefaultMotionState* myMotionState = new btDefaultMotionState(transform);
     btRigidBody::btRigidBodyConstructionInfo rbInfo(mass,myMotionState,shape,localInertia);
     _btRigidBody = new btRigidBody(rbInfo);
+    _btRigidBody->setUserPointer(static_cast<Physics3DObject*>(this));
     _type = Physics3DObject::PhysicsObjType::RIGID_BODY;
     _physics3DShape = info->shape;
     _physics3DShape->retain();
@@ -535,6 +536,7 @@ bool Physics3DCollider::init(Physics3DColliderDes *info)
     _physics3DShape = info->shape;
     _physics3DShape->retain();
     _btGhostObject = new btCollider(this);
+    _btGhostObject->setUserPointer(static_cast<Physics3DObject*>(this));
     _btGhostObject->setCollisionShape(_physics3DShape->getbtShape());
     
     setTrigger(info->isTrigger);
@@ -23,23 +23,47 @@
  ****************************************************************************/
 
 #include "physics3d/CCPhysics3D.h"
+#include "2d/CCNode.h"
+#include "base/CCJobPool.h"
 #include "renderer/CCRenderer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
 #if CC_USE_3D_PHYSICS
 
 #if (CC_ENABLE_BULLET_INTEGRATION)
 
 namespace cocos2d {
 
+#if CC_ENABLE_BULLET_MULTITHREADING
+// Bullet has one task scheduler for the process, it's created with the first multithreaded world and kept
+static bool initTaskScheduler()
+{
+    static btITaskScheduler* s_taskScheduler = nullptr;
+    if (s_taskScheduler == nullptr)
+    {
+        s_taskScheduler = btCreateDefaultTaskScheduler();
+        if (s_taskScheduler == nullptr)
+            return false;
+        btSetTaskScheduler(s_taskScheduler);
+    }
+    return true;
+}
+#endif
+
 Physics3DWorld::Physics3DWorld()
 : _needCollisionChecking(false)
 , _collisionCheckingFlag(false)
 , _needGhostPairCallbackChecking(false)
+, _componentsChanged(false)
 , _btPhyiscsWorld(nullptr)
 , _collisionConfiguration(nullptr)
 , _dispatcher(nullptr)
 , _broadphase(nullptr)
 , _solver(nullptr)
+, _solverMt(nullptr)
 , _ghostCallback(nullptr)
 , _debugDrawer(nullptr)
 {
@@ -55,6 +79,7 @@ Physics3DWorld::~Physics3DWorld()
     CC_SAFE_DELETE(_broadphase);
     CC_SAFE_DELETE(_ghostCallback);
     CC_SAFE_DELETE(_solver);
+    CC_SAFE_DELETE(_solverMt);
     CC_SAFE_DELETE(_btPhyiscsWorld);
     CC_SAFE_DELETE(_debugDrawer);
     for (auto it : _physicsComponents)
@@ -86,19 +111,34 @@ bool Physics3DWorld::init(Physics3DWorldDes* info)
     _collisionConfiguration = new (std::nothrow) btDefaultCollisionConfiguration();
     //_collisionConfiguration->setConvexConvexMultipointIterations();
     
-    ///use the default collision dispatcher. For parallel processing you can use a different dispatcher (see Extras/BulletMultiThreaded)
-    _dispatcher = new (std::nothrow) btCollisionDispatcher(_collisionConfiguration);
-    
     _broadphase = new (std::nothrow) btDbvtBroadphase();
-    
-    ///the default constraint solver. For parallel processing you can use a different solver (see Extras/BulletMultiThreaded)
-    btSequentialImpulseConstraintSolver* sol = new btSequentialImpulseConstraintSolver();
-    _solver = sol;
 
     btGhostPairCallback *ghostCallback = new btGhostPairCallback();
     _ghostCallback = ghostCallback;
-    
-    _btPhyiscsWorld = new btDiscreteDynamicsWorld(_dispatcher,_broadphase,_solver,_collisionConfiguration);
+
+#if CC_ENABLE_BULLET_MULTITHREADING
+    if (info->isMultiThreadingEnabled && initTaskScheduler())
+    {
+        ///the multithreaded dispatcher runs the narrowphase of the pairs on the task scheduler
+        _dispatcher = new (std::nothrow) btCollisionDispatcherMt(_collisionConfiguration);
+
+        ///the islands are solved in parallel by a pool of solvers, large islands by the multithreaded solver
+        _solver = new (std::nothrow) btConstraintSolverPoolMt(btGetTaskScheduler()->getNumThreads());
+        _solverMt = new (std::nothrow) btSequentialImpulseConstraintSolverMt();
+
+        _btPhyiscsWorld = new btDiscreteDynamicsWorldMt(_dispatcher, _broadphase, static_cast<btConstraintSolverPoolMt*>(_solver), _solverMt, _collisionConfiguration);
+    }
+    else
+#endif
+    {
+        ///use the default collision dispatcher
+        _dispatcher = new (std::nothrow) btCollisionDispatcher(_collisionConfiguration);
+
+        ///the default constraint solver
+        _solver = new btSequentialImpulseConstraintSolver();
+
+        _btPhyiscsWorld = new btDiscreteDynamicsWorld(_dispatcher,_broadphase,_solver,_collisionConfiguration);
+    }
     _btPhyiscsWorld->setGravity(convertVec3TobtVector3(info->gravity));
     if (info->isDebugDrawEnabled)
     {
@@ -231,21 +271,103 @@ void Physics3DWorld::stepSimulate(float dt)
     {
         setGhostPairCallback();
         //should sync kinematic node before simulation
-        for (auto it : _physicsComponents)
-        {
-            it->preSimulate();
-        }
+        syncNodesToPhysics();
         _btPhyiscsWorld->stepSimulation(dt, 3);
         //sync dynamic node after simulation
-        for (auto it : _physicsComponents)
-        {
-            it->postSimulate();
-        }
+        syncPhysicsToNodes();
         if (needCollisionChecking())
             collisionChecking();
     }
 }
 
+void Physics3DWorld::updateComponentNesting()
+{
+    if (!_componentsChanged)
+        return;
+
+    std::unordered_set<Node*> owners;
+    for (auto it : _physicsComponents)
+        owners.insert(it->getOwner());
+
+    _nestedComponents.clear();
+    for (auto it : _physicsComponents)
+    {
+        it->_nested = false;
+        it->_depth = 0;
+        for (auto parent = it->getOwner() ? it->getOwner()->getParent() : nullptr; parent; parent = parent->getParent())
+        {
+            it->_nested = it->_nested || owners.count(parent);
+            ++it->_depth;
+        }
+        if (it->_nested)
+            _nestedComponents.push_back(it);
+    }
+    // an ancestor is synced before the components below it
+    std::stable_sort(_nestedComponents.begin(), _nestedComponents.end(), [](const Physics3DComponent* a, const Physics3DComponent* b) {
+        return a->_depth < b->_depth;
+    });
+    _componentsChanged = false;
+}
+
+void Physics3DWorld::syncNodesToPhysics()
+{
+    // the world transforms are gathered on this thread, they share the cached transforms of the ancestors
+    _syncComponents.clear();
+    _syncTransforms.clear();
+    for (auto it : _physicsComponents)
+    {
+        if (!it->needsSync(Physics3DComponent::PhysicsSyncFlag::NODE_TO_PHYSICS))
+            continue;
+
+        auto owner = it->getOwner();
+        Mat4 nodeToWorld = owner->getParent()
+            ? owner->getParent()->getNodeToWorldTransform() * owner->getNodeToParentTransform()
+            : owner->getNodeToParentTransform();
+        if (it->_syncedNodeToWorldValid && memcmp(nodeToWorld.m, it->_syncedNodeToWorld.m, sizeof(nodeToWorld.m)) == 0)
+            continue;
+
+        _syncComponents.push_back(it);
+        _syncTransforms.push_back(nodeToWorld);
+    }
+
+    JobPool::getInstance()->parallelFor(_syncComponents.size(), [this](size_t i) {
+        _syncComponents[i]->syncNodeToPhysics(_syncTransforms[i]);
+    }, 64);
+}
+
+void Physics3DWorld::syncPhysicsToNodes()
+{
+    updateComponentNesting();
+
+    // moving a node without an ancestor component doesn't move the parent of another one, so their transforms are computed in parallel
+    _syncComponents.clear();
+    _syncTransforms.clear();
+    for (auto it : _physicsComponents)
+    {
+        if (it->_nested || !it->needsSync(Physics3DComponent::PhysicsSyncFlag::PHYSICS_TO_NODE))
+            continue;
+
+        auto parent = it->getOwner()->getParent();
+        _syncComponents.push_back(it);
+        _syncTransforms.push_back(parent ? parent->getNodeToWorldTransform() : Mat4::IDENTITY);
+    }
+
+    JobPool::getInstance()->parallelFor(_syncComponents.size(), [this](size_t i) {
+        _syncComponents[i]->preparePhysicsToNode(_syncTransforms[i]);
+    }, 64);
+
+    // the Node setters dirty the children of the owner and may be overridden, so the owners move in this thread
+    for (size_t i = 0; i < _syncComponents.size(); ++i)
+        _syncComponents[i]->applyPhysicsToNode(_syncTransforms[i]);
+
+    // the nested components read the transforms of their moved ancestors
+    for (auto it : _nestedComponents)
+    {
+        if (it->needsSync(Physics3DComponent::PhysicsSyncFlag::PHYSICS_TO_NODE))
+            it->syncPhysicsToNode();
+    }
+}
+
 void Physics3DWorld::debugDraw(Renderer* renderer)
 {
     if (_debugDrawer)
@@ -293,20 +415,8 @@ bool Physics3DWorld::sweepShape(Physics3DShape* shape, const cocos2d::Mat4& star
 
 Physics3DObject* Physics3DWorld::getPhysicsObject(const btCollisionObject* btObj)
 {
-    for(auto it : _objects)
-    {
-        if (it->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY)
-        {
-            if (static_cast<Physics3DRigidBody*>(it)->getRigidBody() == btObj)
-                return it;
-        }
-        else if (it->getObjType() == Physics3DObject::PhysicsObjType::COLLIDER)
-        {
-            if (static_cast<Physics3DCollider*>(it)->getGhostObject() == btObj)
-                return it;
-        }
-    }
-    return nullptr;
+    // the rigid bodies and colliders point back to their Physics3DObject
+    return static_cast<Physics3DObject*>(btObj->getUserPointer());
 }
 
 void Physics3DWorld::collisionChecking()
@@ -321,9 +431,10 @@ void Physics3DWorld::collisionChecking()
             Physics3DObject *poA = getPhysicsObject(obA);
             Physics3DObject *poB = getPhysicsObject(obB);
             if (poA->needCollisionCallback() || poB->needCollisionCallback()){
-                Physics3DCollisionInfo ci;
+                Physics3DCollisionInfo& ci = _collisionInfo;
                 ci.objA = poA;
                 ci.objB = poB;
+                ci.collisionPointList.clear();
                 for (int c = 0; c < numContacts; ++c){
                     btManifoldPoint& pt = contactManifold->getContactPoint(c);
                     Physics3DCollisionInfo::CollisionPoint cp = {
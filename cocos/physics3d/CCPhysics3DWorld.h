@@ -28,6 +28,7 @@
 #include "math/CCMath.h"
 #include "base/CCRef.h"
 #include "base/ccConfig.h"
+#include "physics3d/CCPhysics3DObject.h"
 
 #if CC_USE_3D_PHYSICS
 
@@ -37,7 +38,7 @@ class btDynamicsWorld;
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btDbvtBroadphase;
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
 class btGhostPairCallback;
 class btRigidBody;
 class btCollisionObject;
@@ -62,10 +63,16 @@ struct CC_DLL Physics3DWorldDes
 {
     bool           isDebugDrawEnabled; //using physics debug draw?, false by default
     cocos2d::Vec3  gravity;//gravity, (0, -9.8, 0)
+    /**
+     * use Bullet's multithreaded world, which runs the collision detection and the solver on the Bullet task scheduler, false by default.
+     * It's ignored unless CC_ENABLE_BULLET_MULTITHREADING is enabled, and a single threaded world is created when no task scheduler is available.
+     */
+    bool           isMultiThreadingEnabled;
     Physics3DWorldDes()
     {
         isDebugDrawEnabled = false;
         gravity = cocos2d::Vec3(0.f, -9.8f, 0.f);
+        isMultiThreadingEnabled = false;
     }
 };
 
@@ -123,6 +130,9 @@ public:
     
     /** Check debug drawing is enabled. */
     bool isDebugDrawEnabled() const;
+
+    /** Check the world runs Bullet's multithreaded world, see Physics3DWorldDes::isMultiThreadingEnabled. */
+    bool isMultiThreadingEnabled() const { return _solverMt != nullptr; }
     
     /** Internal method, the updater of debug drawing, need called each frame. */
     void debugDraw(cocos2d::Renderer* renderer);
@@ -153,6 +163,13 @@ protected:
     void collisionChecking();
     bool needCollisionChecking();
     void setGhostPairCallback();
+
+    /** recomputes which components have an ancestor with a component, after the components changed */
+    void updateComponentNesting();
+    /** aligns the physics objects to the nodes which moved since the last step */
+    void syncNodesToPhysics();
+    /** aligns the nodes to the physics objects, components without an ancestor component in parallel */
+    void syncPhysicsToNodes();
     
 protected:
     std::vector<Physics3DObject*>      _objects;
@@ -160,13 +177,21 @@ protected:
     bool _needCollisionChecking;
     bool _collisionCheckingFlag;
     bool _needGhostPairCallbackChecking;
+    bool _componentsChanged;
+    std::vector<Physics3DComponent*>   _nestedComponents; //the components with an ancestor component, by depth
+
+    // the components synced in a step and the parent to world transform of their owners
+    std::vector<Physics3DComponent*>   _syncComponents;
+    std::vector<Mat4>                  _syncTransforms;
+    Physics3DCollisionInfo             _collisionInfo; // reused to keep the capacity of its point list
     
 #if (CC_ENABLE_BULLET_INTEGRATION)
     btDynamicsWorld* _btPhyiscsWorld;
     btDefaultCollisionConfiguration* _collisionConfiguration;
     btCollisionDispatcher* _dispatcher;
     btDbvtBroadphase* _broadphase;
-    btSequentialImpulseConstraintSolver* _solver;
+    btConstraintSolver* _solver;
+    btConstraintSolver* _solverMt; // the solver of each thread, only with a multithreaded world
     btGhostPairCallback *_ghostCallback;
     Physics3DDebugDrawer*                _debugDrawer;
 #endif // CC_ENABLE_BULLET_INTEGRATION
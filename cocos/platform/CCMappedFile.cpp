@@ -0,0 +1,177 @@
+/****************************************************************************
+ Copyright (c) 2017      Iakov Sergeev <yahont@github>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "platform/CCMappedFile.h"
+
+#include "platform/CCFileUtils.h"
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <windows.h>
+#include "platform/win32/CCUtils-win32.h"
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
+#include <windows.h>
+#include "platform/winrt/CCWinRTUtils.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cocos2d {
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& filename)
+{
+    auto fileUtils = FileUtils::getInstance();
+    auto fullPath = fileUtils->fullPathForFilename(filename);
+    if (fullPath.empty())
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file(new (std::nothrow) MappedFile);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    if (!file->map(fullPath))
+    {
+        file->_data = fileUtils->getDataFromFile(fullPath);
+        if (file->_data.isNull())
+        {
+            return nullptr;
+        }
+        file->_bytes = file->_data.getBytes();
+        file->_size = file->_data.getSize();
+    }
+
+    return file;
+}
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+
+bool MappedFile::map(const std::string& fullPath)
+{
+    std::wstring widePath = StringUtf8ToWideChar(fullPath);
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
+    HANDLE file = CreateFile2(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+#else
+    HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#endif
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
+    HANDLE fileMapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+#else
+    HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+#endif
+    CloseHandle(file);
+    if (fileMapping == nullptr)
+    {
+        return false;
+    }
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
+    void* mapping = MapViewOfFileFromApp(fileMapping, FILE_MAP_READ, 0, 0);
+#else
+    void* mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+#endif
+    if (mapping == nullptr)
+    {
+        CloseHandle(fileMapping);
+        return false;
+    }
+
+    _fileMapping = fileMapping;
+    _mapping = mapping;
+    _bytes = static_cast<const unsigned char*>(mapping);
+    _size = static_cast<ssize_t>(size.QuadPart);
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (_mapping)
+    {
+        UnmapViewOfFile(_mapping);
+        CloseHandle(_fileMapping);
+    }
+}
+
+#else
+
+bool MappedFile::map(const std::string& fullPath)
+{
+    // absolute paths only, the relative ones may point inside a package
+    if (fullPath.empty() || fullPath[0] != '/')
+    {
+        return false;
+    }
+
+    int fd = ::open(fullPath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    _mapping = mapping;
+    _bytes = static_cast<const unsigned char*>(mapping);
+    _size = static_cast<ssize_t>(st.st_size);
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (_mapping)
+    {
+        munmap(_mapping, static_cast<size_t>(_size));
+    }
+}
+
+#endif
+
+} // namespace cocos2d
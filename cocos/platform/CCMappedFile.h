@@ -0,0 +1,83 @@
+/****************************************************************************
+ Copyright (c) 2017      Iakov Sergeev <yahont@github>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_PLATFORM_MAPPED_FILE_H__
+#define __CC_PLATFORM_MAPPED_FILE_H__
+/// @cond DO_NOT_SHOW
+
+#include <memory>
+#include <string>
+
+#include "platform/CCPlatformMacros.h"
+#include "base/CCData.h"
+
+namespace cocos2d {
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * Read-only view of a whole file.
+ *
+ * The file is memory mapped when the platform allows it, so the pages are
+ * loaded lazily by the OS and shared with its file cache. Files which can't
+ * be mapped (e.g. the ones inside an Android apk) are read through FileUtils.
+ */
+class CC_DLL MappedFile
+{
+public:
+    /** Returns nullptr if the file doesn't exist or is empty. */
+    static std::unique_ptr<MappedFile> open(const std::string& filename);
+
+    ~MappedFile();
+
+    const unsigned char* getBytes() const { return _bytes; }
+    ssize_t getSize() const { return _size; }
+
+    /** Whether the bytes alias the file instead of a heap copy. */
+    bool isMapped() const { return _mapping != nullptr; }
+
+private:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool map(const std::string& fullPath);
+
+    const unsigned char* _bytes = nullptr;
+    ssize_t _size = 0;
+    void* _mapping = nullptr;
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    void* _fileMapping = nullptr;
+#endif
+    Data _data;
+};
+
+// end of platform group
+/** @} */
+
+} // namespace cocos2d
+
+/// @endcond
+#endif // __CC_PLATFORM_MAPPED_FILE_H__
@@ -65,6 +65,15 @@ extern PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT;
 #define glBindVertexArrayOES glBindVertexArrayOESEXT
 #define glDeleteVertexArraysOES glDeleteVertexArraysOESEXT
 
+// GL_EXT_instanced_arrays, not declared by the older ndk headers
+typedef void (GL_APIENTRYP PFNGLDRAWELEMENTSINSTANCEDEXTCCPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount);
+typedef void (GL_APIENTRYP PFNGLVERTEXATTRIBDIVISOREXTCCPROC) (GLuint index, GLuint divisor);
+extern PFNGLDRAWELEMENTSINSTANCEDEXTCCPROC glDrawElementsInstancedEXTEXT;
+extern PFNGLVERTEXATTRIBDIVISOREXTCCPROC glVertexAttribDivisorEXTEXT;
+
+#define glDrawElementsInstancedEXT glDrawElementsInstancedEXTEXT
+#define glVertexAttribDivisorEXT glVertexAttribDivisorEXTEXT
+
 
 #endif // CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 
@@ -40,11 +40,15 @@ THE SOFTWARE.
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT = 0;
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT = 0;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
+PFNGLDRAWELEMENTSINSTANCEDEXTCCPROC glDrawElementsInstancedEXTEXT = 0;
+PFNGLVERTEXATTRIBDIVISOREXTCCPROC glVertexAttribDivisorEXTEXT = 0;
 
 void initExtensions() {
      glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC)eglGetProcAddress("glGenVertexArraysOES");
      glBindVertexArrayOESEXT = (PFNGLBINDVERTEXARRAYOESPROC)eglGetProcAddress("glBindVertexArrayOES");
      glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC)eglGetProcAddress("glDeleteVertexArraysOES");
+     glDrawElementsInstancedEXTEXT = (PFNGLDRAWELEMENTSINSTANCEDEXTCCPROC)eglGetProcAddress("glDrawElementsInstancedEXT");
+     glVertexAttribDivisorEXTEXT = (PFNGLVERTEXATTRIBDIVISOREXTCCPROC)eglGetProcAddress("glVertexAttribDivisorEXT");
 }
 
 namespace cocos2d {
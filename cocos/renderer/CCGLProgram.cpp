@@ -89,6 +89,7 @@ const char* GLProgram::SHADER_NAME_POSITION_COLOR_NO_MVP = "ShaderPositionColor_
 const char* GLProgram::SHADER_NAME_POSITION_TEXTURE = "ShaderPositionTexture";
 const char* GLProgram::SHADER_NAME_POSITION_TEXTURE_U_COLOR = "ShaderPositionTexture_uColor";
 const char* GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR = "ShaderPositionTextureA8Color";
+const char* GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR_NO_MVP = "ShaderPositionTextureA8Color_noMVP";
 const char* GLProgram::SHADER_NAME_POSITION_U_COLOR = "ShaderPosition_uColor";
 const char* GLProgram::SHADER_NAME_POSITION_LENGTH_TEXTURE_COLOR = "ShaderPositionLengthTextureColor";
 const char* GLProgram::SHADER_NAME_POSITION_GRAYSCALE = "ShaderUIGrayScale";
@@ -105,6 +106,10 @@ const char* GLProgram::SHADER_3D_POSITION_NORMAL_TEXTURE = "Shader3DPositionNorm
 const char* GLProgram::SHADER_3D_SKINPOSITION_NORMAL_TEXTURE = "Shader3DSkinPositionNormalTexture";
 const char* GLProgram::SHADER_3D_POSITION_BUMPEDNORMAL_TEXTURE = "Shader3DPositionBumpedNormalTexture";
 const char* GLProgram::SHADER_3D_SKINPOSITION_BUMPEDNORMAL_TEXTURE = "Shader3DSkinPositionBumpedNormalTexture";
+const char* GLProgram::SHADER_3D_POSITION_INSTANCED = "Shader3DPositionInstanced";
+const char* GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED = "Shader3DPositionTextureInstanced";
+const char* GLProgram::SHADER_3D_POSITION_NORMAL_INSTANCED = "Shader3DPositionNormalInstanced";
+const char* GLProgram::SHADER_3D_POSITION_NORMAL_TEXTURE_INSTANCED = "Shader3DPositionNormalTextureInstanced";
 const char* GLProgram::SHADER_3D_PARTICLE_COLOR = "Shader3DParticleColor";
 const char* GLProgram::SHADER_3D_PARTICLE_TEXTURE = "Shader3DParticleTexture";
 const char* GLProgram::SHADER_3D_SKYBOX = "Shader3DSkybox";
@@ -142,6 +147,8 @@ const char* GLProgram::ATTRIBUTE_NAME_BLEND_WEIGHT = "a_blendWeight";
 const char* GLProgram::ATTRIBUTE_NAME_BLEND_INDEX = "a_blendIndex";
 const char* GLProgram::ATTRIBUTE_NAME_TANGENT = "a_tangent";
 const char* GLProgram::ATTRIBUTE_NAME_BINORMAL = "a_binormal";
+const char* GLProgram::ATTRIBUTE_NAME_INSTANCE_MATRIX = "a_instanceMatrix";
+const char* GLProgram::ATTRIBUTE_NAME_INSTANCE_COLOR = "a_instanceColor";
 
 
 
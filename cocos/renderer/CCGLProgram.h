@@ -201,6 +201,8 @@ public:
     static const char* SHADER_NAME_POSITION_TEXTURE_U_COLOR;
     /**Built in shader for 2d. Support Position, Texture and Color vertex attribute. but alpha will be the multiplication of color attribute and texture.*/
     static const char* SHADER_NAME_POSITION_TEXTURE_A8_COLOR;
+    /**Built in shader for 2d. Same as SHADER_NAME_POSITION_TEXTURE_A8_COLOR, but without multiply vertex by MVP matrix.*/
+    static const char* SHADER_NAME_POSITION_TEXTURE_A8_COLOR_NO_MVP;
     /**Built in shader for 2d. Support Position, with color specified by a uniform.*/
     static const char* SHADER_NAME_POSITION_U_COLOR;
     /**Built in shader for draw a sector with 90 degrees with center at bottom left point.*/
@@ -248,6 +250,17 @@ public:
     */
     static const char* SHADER_3D_SKINPOSITION_BUMPEDNORMAL_TEXTURE;
     /**
+    @{
+    Instanced versions of SHADER_3D_POSITION, SHADER_3D_POSITION_TEXTURE, SHADER_3D_POSITION_NORMAL and SHADER_3D_POSITION_NORMAL_TEXTURE.
+    The model view matrix and the color are read from the ATTRIBUTE_NAME_INSTANCE_MATRIX and ATTRIBUTE_NAME_INSTANCE_COLOR
+    vertex attributes instead of uniforms, so the Renderer draws the meshes sharing them with one draw call.
+    */
+    static const char* SHADER_3D_POSITION_INSTANCED;
+    static const char* SHADER_3D_POSITION_TEXTURE_INSTANCED;
+    static const char* SHADER_3D_POSITION_NORMAL_INSTANCED;
+    static const char* SHADER_3D_POSITION_NORMAL_TEXTURE_INSTANCED;
+    /**@}*/
+    /**
     Built in shader for particles, support Position and Texture, with a color specified by a uniform.
     */
     static const char* SHADER_3D_PARTICLE_TEXTURE;
@@ -342,6 +355,10 @@ public:
     static const char* ATTRIBUTE_NAME_TANGENT;
     /**Attribute blend binormal.*/
     static const char* ATTRIBUTE_NAME_BINORMAL;
+    /**Attribute model view matrix of an instance, a mat4 which uses four consecutive locations.*/
+    static const char* ATTRIBUTE_NAME_INSTANCE_MATRIX;
+    /**Attribute color of an instance.*/
+    static const char* ATTRIBUTE_NAME_INSTANCE_COLOR;
     /**
     end of Built Attribute names
     @}
@@ -48,6 +48,7 @@ enum {
     kShaderType_PositionTexture,
     kShaderType_PositionTexture_uColor,
     kShaderType_PositionTextureA8Color,
+    kShaderType_PositionTextureA8Color_noMVP,
     kShaderType_Position_uColor,
     kShaderType_PositionLengthTextureColor,
     kShaderType_LabelDistanceFieldNormal,
@@ -63,6 +64,10 @@ enum {
     kShaderType_3DSkinPositionNormalTex,
     kShaderType_3DPositionBumpedNormalTex,
     kShaderType_3DSkinPositionBumpedNormalTex,
+    kShaderType_3DPositionInstanced,
+    kShaderType_3DPositionTexInstanced,
+    kShaderType_3DPositionNormalInstanced,
+    kShaderType_3DPositionNormalTexInstanced,
     kShaderType_3DParticleTex,
     kShaderType_3DParticleColor,
     kShaderType_3DSkyBox,
@@ -185,6 +190,13 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_PositionTextureA8Color);
     _programs.emplace(GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR, p);
 
+    //
+    // Position Texture A8 Color shader without MVP
+    //
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_PositionTextureA8Color_noMVP);
+    _programs.emplace(GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR_NO_MVP, p);
+
     //
     // Position and 1 color passed as a uniform (to simulate glColor4ub )
     //
@@ -251,6 +263,22 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_3DSkinPositionBumpedNormalTex);
     _programs.emplace(GLProgram::SHADER_3D_SKINPOSITION_BUMPEDNORMAL_TEXTURE, p);
 
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_3DPositionInstanced);
+    _programs.emplace(GLProgram::SHADER_3D_POSITION_INSTANCED, p);
+
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_3DPositionTexInstanced);
+    _programs.emplace(GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED, p);
+
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_3DPositionNormalInstanced);
+    _programs.emplace(GLProgram::SHADER_3D_POSITION_NORMAL_INSTANCED, p);
+
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_3DPositionNormalTexInstanced);
+    _programs.emplace(GLProgram::SHADER_3D_POSITION_NORMAL_TEXTURE_INSTANCED, p);
+
     p = new (std::nothrow) GLProgram();
     loadDefaultGLProgram(p, kShaderType_3DParticleColor);
     _programs.emplace(GLProgram::SHADER_3D_PARTICLE_COLOR, p);
@@ -352,6 +380,13 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_PositionTextureA8Color);
 
+    //
+    // Position Texture A8 Color shader without MVP
+    //
+    p = getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR_NO_MVP);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_PositionTextureA8Color_noMVP);
+
     //
     // Position and 1 color passed as a uniform (to simulate glColor4ub )
     //
@@ -418,6 +453,22 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_3DSkinPositionBumpedNormalTex);
 
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionInstanced);
+
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionTexInstanced);
+
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_NORMAL_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionNormalInstanced);
+
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_NORMAL_TEXTURE_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionNormalTexInstanced);
+
     p = getGLProgram(GLProgram::SHADER_3D_PARTICLE_TEXTURE);
     p->reset();
     loadDefaultGLProgram(p, kShaderType_3DParticleTex);
@@ -460,6 +511,14 @@ void GLProgramCache::reloadDefaultGLProgramsRelativeToLights()
     p = getGLProgram(GLProgram::SHADER_3D_SKINPOSITION_BUMPEDNORMAL_TEXTURE);
     p->reset();
     loadDefaultGLProgram(p, kShaderType_3DSkinPositionBumpedNormalTex);
+
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_NORMAL_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionNormalInstanced);
+
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_NORMAL_TEXTURE_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionNormalTexInstanced);
 }
 
 void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
@@ -495,6 +554,9 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
         case kShaderType_PositionTextureA8Color:
             p->initWithByteArrays(ccPositionTextureA8Color_vert, ccPositionTextureA8Color_frag);
             break;
+        case kShaderType_PositionTextureA8Color_noMVP:
+            p->initWithByteArrays(ccPositionTextureColor_noMVP_vert, ccPositionTextureA8Color_frag);
+            break;
         case kShaderType_Position_uColor:
             p->initWithByteArrays(ccPosition_uColor_vert, ccPosition_uColor_frag);
             p->bindAttribLocation("aVertex", GLProgram::VERTEX_ATTRIB_POSITION);
@@ -559,6 +621,32 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
                 p->initWithByteArrays((def + normalMapDef + std::string(cc3D_SkinPositionNormalTex_vert)).c_str(), (def + normalMapDef + std::string(cc3D_ColorNormalTex_frag)).c_str());
             }
             break;
+        case kShaderType_3DPositionInstanced:
+            {
+                std::string instancingDef = "\n#define USE_INSTANCING 1 \n";
+                p->initWithByteArrays((instancingDef + std::string(cc3D_PositionTex_vert)).c_str(), (instancingDef + std::string(cc3D_Color_frag)).c_str());
+            }
+            break;
+        case kShaderType_3DPositionTexInstanced:
+            {
+                std::string instancingDef = "\n#define USE_INSTANCING 1 \n";
+                p->initWithByteArrays((instancingDef + std::string(cc3D_PositionTex_vert)).c_str(), (instancingDef + std::string(cc3D_ColorTex_frag)).c_str());
+            }
+            break;
+        case kShaderType_3DPositionNormalInstanced:
+            {
+                std::string def = getShaderMacrosForLight();
+                std::string instancingDef = "\n#define USE_INSTANCING 1 \n";
+                p->initWithByteArrays((def + instancingDef + std::string(cc3D_PositionNormalTex_vert)).c_str(), (def + instancingDef + std::string(cc3D_ColorNormal_frag)).c_str());
+            }
+            break;
+        case kShaderType_3DPositionNormalTexInstanced:
+            {
+                std::string def = getShaderMacrosForLight();
+                std::string instancingDef = "\n#define USE_INSTANCING 1 \n";
+                p->initWithByteArrays((def + instancingDef + std::string(cc3D_PositionNormalTex_vert)).c_str(), (def + instancingDef + std::string(cc3D_ColorNormalTex_frag)).c_str());
+            }
+            break;
         case kShaderType_3DParticleTex:
            {
                 p->initWithByteArrays(cc3D_Particle_vert, cc3D_Particle_tex_frag);
@@ -43,12 +43,34 @@
 
 namespace cocos2d {
 
+static void drawElementsInstanced(GLenum primitive, GLsizei count, GLenum type, GLsizei instanceCount)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    glDrawElementsInstancedEXT(primitive, count, type, nullptr, instanceCount);
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    glDrawElementsInstancedARB(primitive, count, type, nullptr, instanceCount);
+#else
+    CCASSERT(false, "instancing isn't supported on this platform");
+#endif
+}
+
+static void vertexAttribDivisor(GLuint index, GLuint divisor)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    glVertexAttribDivisorEXT(index, divisor);
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    glVertexAttribDivisorARB(index, divisor);
+#else
+    CCASSERT(false, "instancing isn't supported on this platform");
+#endif
+}
 
 MeshCommand::MeshCommand()
 : _displayColor(1.0f, 1.0f, 1.0f, 1.0f)
 , _matrixPalette(nullptr)
 , _matrixPaletteSize(0)
 , _materialID(0)
+, _instanceID(0)
 , _vao(0)
 , _material(nullptr)
 , _glProgramState(nullptr)
@@ -185,6 +207,27 @@ uint32_t MeshCommand::getMaterialID() const
     return _materialID;
 }
 
+void MeshCommand::genInstanceID(GLuint texID, GLProgram* glProgram, GLuint vertexBuffer, GLuint indexBuffer, BlendFunc blend)
+{
+    if (!glProgram || !glProgram->getVertexAttrib(GLProgram::ATTRIBUTE_NAME_INSTANCE_MATRIX))
+    {
+        _instanceID = 0;
+        return;
+    }
+
+    int intArray[7] = {0};
+    intArray[0] = (int)texID;
+    *(GLProgram**)&intArray[1] = glProgram;
+    intArray[3] = (int) vertexBuffer;
+    intArray[4] = (int) indexBuffer;
+    intArray[5] = (int) blend.src;
+    intArray[6] = (int) blend.dst;
+    _instanceID = XXH32((const void*)intArray, sizeof(intArray), 0);
+    // 0 means not instanced
+    if (_instanceID == 0)
+        _instanceID = 1;
+}
+
 void MeshCommand::preBatchDraw()
 {
     // Do nothing if using material since each pass needs to bind its own VAO
@@ -236,6 +279,94 @@ void MeshCommand::batchDraw()
         CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
     }
 }
+void MeshCommand::batchDrawInstances(const std::vector<MeshCommand*>& instances, GLuint instanceBuffer)
+{
+    CCASSERT(_material, "instancing needs a material");
+    CCASSERT(!instances.empty() && instances.front() == this, "the first instance must draw the batch");
+
+    const auto& passes = _material->_currentTechnique->_passes;
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        auto& pass = passes.at(i);
+        auto glProgram = pass->getGLProgramState()->getGLProgram();
+        auto matrixAttrib = glProgram->getVertexAttrib(GLProgram::ATTRIBUTE_NAME_INSTANCE_MATRIX);
+        auto colorAttrib = glProgram->getVertexAttrib(GLProgram::ATTRIBUTE_NAME_INSTANCE_COLOR);
+
+        if (!matrixAttrib)
+        {
+            // this pass uses the uniforms, each instance draws with its own
+            for (auto instance : instances)
+            {
+                const auto& instancePasses = instance->_material->_currentTechnique->_passes;
+                if (i >= instancePasses.size())
+                    continue;
+                auto& instancePass = instancePasses.at(i);
+                instancePass->bind(instance->_mv);
+
+                glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, 0);
+                CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
+
+                instancePass->unbind();
+            }
+            continue;
+        }
+
+        pass->bind(_mv);
+
+        if (instanceBuffer)
+        {
+            const GLsizei stride = sizeof(InstanceData);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            // a mat4 attribute takes one location per column
+            for (GLuint column = 0; column < 4; ++column)
+            {
+                GLuint location = matrixAttrib->index + column;
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(sizeof(float) * 4 * column));
+                vertexAttribDivisor(location, 1);
+            }
+            if (colorAttrib)
+            {
+                glEnableVertexAttribArray(colorAttrib->index);
+                glVertexAttribPointer(colorAttrib->index, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)sizeof(Mat4));
+                vertexAttribDivisor(colorAttrib->index, 1);
+            }
+
+            drawElementsInstanced(_primitive, (GLsizei)_indexCount, _indexFormat, (GLsizei)instances.size());
+            CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount * instances.size());
+
+            // the divisors and the enabled arrays stay in the VAO or in the global state, reset them
+            for (GLuint column = 0; column < 4; ++column)
+            {
+                vertexAttribDivisor(matrixAttrib->index + column, 0);
+                glDisableVertexAttribArray(matrixAttrib->index + column);
+            }
+            if (colorAttrib)
+            {
+                vertexAttribDivisor(colorAttrib->index, 0);
+                glDisableVertexAttribArray(colorAttrib->index);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        else
+        {
+            // the material is bound once, only the constant attributes change between the instances
+            for (auto instance : instances)
+            {
+                for (GLuint column = 0; column < 4; ++column)
+                    glVertexAttrib4fv(matrixAttrib->index + column, instance->_mv.m + 4 * column);
+                if (colorAttrib)
+                    glVertexAttrib4fv(colorAttrib->index, &instance->_displayColor.x);
+
+                glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, 0);
+                CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
+            }
+        }
+
+        pass->unbind();
+    }
+}
+
 void MeshCommand::postBatchDraw()
 {
     // when using material, unbind is after draw
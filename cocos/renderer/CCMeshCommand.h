@@ -26,6 +26,7 @@
 #define _CC_MESHCOMMAND_H_
 
 #include <unordered_map>
+#include <vector>
 #include "renderer/CCRenderCommand.h"
 #include "renderer/CCGLProgram.h"
 #include "renderer/CCRenderState.h"
@@ -42,6 +43,12 @@ class Material;
 class CC_DLL MeshCommand : public RenderCommand
 {
 public:
+    /** the per instance vertex attributes of an instanced draw, see batchDrawInstances() */
+    struct InstanceData
+    {
+        Mat4 modelView;
+        Vec4 color;
+    };
 
     MeshCommand();
     virtual ~MeshCommand();
@@ -65,6 +72,29 @@ public:
     void genMaterialID(GLuint texID, void* glProgramState, GLuint vertexBuffer, GLuint indexBuffer, BlendFunc blend);
     
     uint32_t getMaterialID() const;
+
+    /**
+     * The commands sharing an instance ID are drawn together by the Renderer, with one instanced draw call
+     * when Configuration::supportsInstancing(). The ID is 0 when the GLProgram doesn't read the
+     * GLProgram::ATTRIBUTE_NAME_INSTANCE_MATRIX attribute. Unlike the material ID it doesn't depend on the
+     * GLProgramState, the uniforms of the first command of a batch are used for all of them.
+     */
+    void genInstanceID(GLuint texID, GLProgram* glProgram, GLuint vertexBuffer, GLuint indexBuffer, BlendFunc blend);
+
+    uint32_t getInstanceID() const { return _instanceID; }
+
+    /** the color of the instance, used instead of the u_color uniform by the instanced shaders */
+    void setInstanceColor(const Vec4& color) { _displayColor = color; }
+    const Vec4& getInstanceColor() const { return _displayColor; }
+
+    const Mat4& getModelView() const { return _mv; }
+
+    /**
+     * draws the instances with the material of this command, which must be the first one.
+     * The instance data was uploaded to instanceBuffer by the Renderer, when it is 0 the instances are drawn one
+     * by one with constant attributes, which still binds the material and uploads its uniforms only once.
+     */
+    void batchDrawInstances(const std::vector<MeshCommand*>& instances, GLuint instanceBuffer);
     
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
     void listenRendererRecreated(EventCustom* event);
@@ -86,6 +116,7 @@ protected:
     int   _matrixPaletteSize;
     
     uint32_t _materialID; //material ID
+    uint32_t _instanceID;
     
     GLuint   _vao; //use vao if possible
     
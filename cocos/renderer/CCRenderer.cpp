@@ -198,6 +198,8 @@ static const int DEFAULT_RENDER_QUEUE = 0;
 //
 Renderer::Renderer()
 :_lastBatchedMeshCommand(nullptr)
+,_instanceBatchCount(0)
+,_instanceVBO(0)
 ,_triBatchesToDrawCapacity(-1)
 ,_triBatchesToDraw(nullptr)
 ,_filledVertex(0)
@@ -231,6 +233,8 @@ Renderer::~Renderer()
     _groupCommandManager->release();
     
     glDeleteBuffers(2, _buffersVBO);
+    if (_instanceVBO)
+        glDeleteBuffers(1, &_instanceVBO);
 
     free(_triBatchesToDraw);
 
@@ -262,6 +266,9 @@ void Renderer::initGLView()
 
 void Renderer::setupBuffer()
 {
+    // created when the first instanced batch is drawn
+    _instanceVBO = 0;
+
     if(Configuration::getInstance()->supportsShareableVAO())
     {
         setupVBOAndVAO();
@@ -400,7 +407,19 @@ void Renderer::processRenderCommand(RenderCommand* command)
         flush2D();
         auto cmd = static_cast<MeshCommand*>(command);
         
-        if (cmd->isSkipBatching() || _lastBatchedMeshCommand == nullptr || _lastBatchedMeshCommand->getMaterialID() != cmd->getMaterialID())
+        if (cmd->getInstanceID() != 0)
+        {
+            // the instances are drawn when a command which isn't instanced comes
+            if (_lastBatchedMeshCommand || cmd->isSkipBatching())
+                flush3D();
+
+            batchInstance(cmd);
+
+            // transparent instances keep their order
+            if (cmd->isSkipBatching())
+                flush3D();
+        }
+        else if (cmd->isSkipBatching() || _lastBatchedMeshCommand == nullptr || _lastBatchedMeshCommand->getMaterialID() != cmd->getMaterialID())
         {
             flush3D();
 
@@ -661,6 +680,9 @@ void Renderer::clean()
     _filledVertex = 0;
     _filledIndex = 0;
     _lastBatchedMeshCommand = nullptr;
+    for (size_t i = 0; i < _instanceBatchCount; ++i)
+        _instanceBatches[i].commands.clear();
+    _instanceBatchCount = 0;
 }
 
 void Renderer::clear()
@@ -880,6 +902,65 @@ void Renderer::flush3D()
         _lastBatchedMeshCommand->postBatchDraw();
         _lastBatchedMeshCommand = nullptr;
     }
+
+    if (_instanceBatchCount)
+    {
+        CCGL_DEBUG_INSERT_EVENT_MARKER("RENDERER_INSTANCED_MESH");
+
+        drawInstancedMeshes();
+    }
+}
+
+void Renderer::batchInstance(MeshCommand* cmd)
+{
+    // the opaque meshes of multi mesh sprites alternate, so the batches don't have to be consecutive
+    for (size_t i = 0; i < _instanceBatchCount; ++i)
+    {
+        if (_instanceBatches[i].instanceID == cmd->getInstanceID())
+        {
+            _instanceBatches[i].commands.push_back(cmd);
+            return;
+        }
+    }
+
+    if (_instanceBatchCount == _instanceBatches.size())
+        _instanceBatches.emplace_back();
+    auto& batch = _instanceBatches[_instanceBatchCount++];
+    batch.instanceID = cmd->getInstanceID();
+    batch.commands.push_back(cmd);
+}
+
+void Renderer::drawInstancedMeshes()
+{
+    const bool supportsInstancing = Configuration::getInstance()->supportsInstancing();
+
+    for (size_t i = 0; i < _instanceBatchCount; ++i)
+    {
+        auto& instances = _instanceBatches[i].commands;
+
+        GLuint instanceBuffer = 0;
+        if (supportsInstancing && instances.size() > 1)
+        {
+            _instanceData.resize(instances.size());
+            for (size_t j = 0; j < instances.size(); ++j)
+            {
+                _instanceData[j].modelView = instances[j]->getModelView();
+                _instanceData[j].color = instances[j]->getInstanceColor();
+            }
+
+            if (!_instanceVBO)
+                glGenBuffers(1, &_instanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+            // a new storage each time, the previous batch may still be in use
+            glBufferData(GL_ARRAY_BUFFER, sizeof(_instanceData[0]) * _instanceData.size(), _instanceData.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            instanceBuffer = _instanceVBO;
+        }
+
+        instances.front()->batchDrawInstances(instances, instanceBuffer);
+        instances.clear();
+    }
+    _instanceBatchCount = 0;
 }
 
 void Renderer::flushTriangles()
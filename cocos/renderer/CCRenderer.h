@@ -31,6 +31,7 @@
 
 #include "platform/CCPlatformMacros.h"
 #include "renderer/CCRenderCommand.h"
+#include "renderer/CCMeshCommand.h"
 #include "renderer/CCGLProgram.h"
 #include "platform/CCGL.h"
 
@@ -60,7 +61,6 @@ namespace cocos2d {
 
 class EventListenerCustom;
 class TrianglesCommand;
-class MeshCommand;
 
 /** Class that knows how to sort `RenderCommand` objects.
  Since the commands that have `z == 0` are "pushed back" in
@@ -222,6 +222,10 @@ protected:
     
     void flush3D();
 
+    /** queues an instanced mesh command with the commands sharing its instance ID */
+    void batchInstance(MeshCommand* cmd);
+    void drawInstancedMeshes();
+
     void flushTriangles();
 
     void processRenderCommand(RenderCommand* command);
@@ -238,6 +242,18 @@ protected:
     std::vector<RenderQueue> _renderGroups;
 
     MeshCommand* _lastBatchedMeshCommand;
+
+    // instanced mesh commands waiting to be drawn, by instance ID.
+    // The batches are kept to reuse their storage, only the first _instanceBatchCount are in use.
+    struct InstanceBatch
+    {
+        uint32_t instanceID;
+        std::vector<MeshCommand*> commands;
+    };
+    std::vector<InstanceBatch> _instanceBatches;
+    size_t _instanceBatchCount;
+    std::vector<MeshCommand::InstanceData> _instanceData;
+    GLuint _instanceVBO;
     std::vector<TrianglesCommand*> _queuedTriangleCommands;
 
     //for TrianglesCommand
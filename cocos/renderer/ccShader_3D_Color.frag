@@ -6,7 +6,12 @@ varying lowp vec4 DestinationColor;
 #else
 varying vec4 DestinationColor;
 #endif
+#ifdef USE_INSTANCING
+varying vec4 v_instanceColor;
+#define u_color v_instanceColor
+#else
 uniform vec4 u_color;
+#endif
 
 void main(void)
 {
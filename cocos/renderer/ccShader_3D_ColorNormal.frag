@@ -45,7 +45,12 @@ varying vec3 v_normal;
 
 #endif
 
+#ifdef USE_INSTANCING
+varying vec4 v_instanceColor;
+#define u_color v_instanceColor
+#else
 uniform vec4 u_color;
+#endif
 
 vec3 computeLighting(vec3 normalVector, vec3 lightDirection, vec3 lightColor, float attenuation)
 {
@@ -23,6 +23,16 @@ attribute vec3 a_normal;
 attribute vec3 a_tangent;
 attribute vec3 a_binormal;
 #endif
+#ifdef USE_INSTANCING
+// the model view matrix and the color of each instance, see Renderer
+attribute mat4 a_instanceMatrix;
+attribute vec4 a_instanceColor;
+varying vec4 v_instanceColor;
+#define CC_MVMatrix a_instanceMatrix
+#define CC_MVPMatrix (CC_PMatrix * a_instanceMatrix)
+// assumes a uniform scale
+#define CC_NormalMatrix mat3(a_instanceMatrix[0].xyz, a_instanceMatrix[1].xyz, a_instanceMatrix[2].xyz)
+#endif
 varying vec2 TextureCoordOut;
 
 #ifdef USE_NORMAL_MAPPING
@@ -48,6 +58,9 @@ varying vec3 v_normal;
 
 void main(void)
 {
+#ifdef USE_INSTANCING
+    v_instanceColor = a_instanceColor;
+#endif
     vec4 ePosition = CC_MVMatrix * a_position;
 #ifdef USE_NORMAL_MAPPING
     #if ((MAX_DIRECTIONAL_LIGHT_NUM > 0) || (MAX_POINT_LIGHT_NUM > 0) || (MAX_SPOT_LIGHT_NUM > 0))
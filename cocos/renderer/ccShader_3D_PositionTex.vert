@@ -3,11 +3,24 @@ const char* cc3D_PositionTex_vert = R"(
 
 attribute vec4 a_position;
 attribute vec2 a_texCoord;
+#ifdef USE_INSTANCING
+// the model view matrix and the color of each instance, see Renderer
+attribute mat4 a_instanceMatrix;
+attribute vec4 a_instanceColor;
+varying vec4 v_instanceColor;
+#define CC_MVMatrix a_instanceMatrix
+#define CC_MVPMatrix (CC_PMatrix * a_instanceMatrix)
+// assumes a uniform scale
+#define CC_NormalMatrix mat3(a_instanceMatrix[0].xyz, a_instanceMatrix[1].xyz, a_instanceMatrix[2].xyz)
+#endif
 
 varying vec2 TextureCoordOut;
 
 void main(void)
 {
+#ifdef USE_INSTANCING
+    v_instanceColor = a_instanceColor;
+#endif
     gl_Position = CC_MVPMatrix * a_position;
     TextureCoordOut = a_texCoord;
     TextureCoordOut.y = 1.0 - TextureCoordOut.y;
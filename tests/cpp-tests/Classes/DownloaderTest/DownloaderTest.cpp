@@ -27,6 +27,7 @@
 #include "../testResource.h"
 
 #include "2d/CCLabel.h"
+#include "2d/CCMenu.h"
 #include "2d/CCMenuItem.h"
 #include "2d/CCSpriteFrameCache.h"
 #include "base/CCDirector.h"
@@ -36,6 +37,9 @@
 #include "ui/UILoadingBar.h"
 #include "ui/UIScale9Sprite.h"
 
+#include <chrono>
+#include <cstring>
+
 using namespace cocos2d;
 
 static const char* sURLList[] =
@@ -333,7 +337,190 @@ struct DownloaderTest : public TestCase
     }
 };
 
+// Splits a file task into chunks, interrupts it by destroying the downloader and resumes it from the chunk file
+struct DownloaderResumeTest : public TestCase
+{
+    static DownloaderResumeTest* create()
+    {
+        auto ret = new DownloaderResumeTest;
+        ret->init();
+        ret->autorelease();
+        return ret;
+    }
+
+    virtual std::string title() const override { return "Downloader Resume Test"; }
+    virtual std::string subtitle() const override { return "needs an http server with range support on localhost:8000"; }
+
+    enum {
+        JOB_INTERRUPT_OR_RESUME = 0,
+    };
+
+    std::unique_ptr<network::Downloader> downloader;
+    Label* labelStatus;
+    std::string storagePath;
+    std::string status;
+    int64_t firstTotalBytesReceived;
+    bool interrupted;
+    bool resumed;
+    bool pending;
+    std::chrono::steady_clock::time_point startTime;
+
+    DownloaderResumeTest()
+    : labelStatus(nullptr)
+    , storagePath(FileUtils::getInstance()->getWritablePath() + "CppTests/DownloaderTest/cocosvideo.mp4")
+    , firstTotalBytesReceived(-1)
+    , interrupted(false)
+    , resumed(false)
+    , pending(false)
+    {
+        auto winSize = Director::getInstance()->getWinSize();
+
+        auto menu = make_node_ptr<Menu>();
+        menu->setPosition(Vec2::ZERO);
+        auto label = to_node_ptr(Label::createWithTTF("Split, interrupt and resume", "fonts/arial.ttf", 22));
+        auto item = to_node_ptr(MenuItemLabel::create(std::move(label), CC_CALLBACK_1(DownloaderResumeTest::onMenuStartClicked, this)));
+        item->setPosition(winSize.width / 2, winSize.height - 75);
+        menu->addChild(std::move(item));
+        addChild(std::move(menu));
+
+        auto statusLabel = to_node_ptr(Label::createWithTTF("", "fonts/arial.ttf", 16));
+        statusLabel->setDimensions(winSize.width - 40, 0);
+        statusLabel->setPosition(winSize.width / 2, winSize.height / 2 - 40);
+        labelStatus = statusLabel.get();
+        addChild(std::move(statusLabel));
+    }
+
+    virtual ~DownloaderResumeTest()
+    {
+        Director::getInstance()->getScheduler().unscheduleTimedJob(this, JOB_INTERRUPT_OR_RESUME);
+    }
+
+    void createDownloader()
+    {
+        // small chunks, so the file is split in 4 however quickly it is served
+        network::DownloaderHints hints = {6, 45, ".tmp", 4, 64 * 1024};
+        downloader.reset(new network::Downloader(hints));
+
+        downloader->onTaskProgress = [this](const network::DownloadTask& /*task*/,
+                                            int64_t /*bytesReceived*/,
+                                            int64_t totalBytesReceived,
+                                            int64_t totalBytesExpected)
+        {
+            if (firstTotalBytesReceived < 0)
+            {
+                firstTotalBytesReceived = totalBytesReceived;
+            }
+            if (!interrupted)
+            {
+                // the downloader can't be destroyed in its own callback
+                interrupted = true;
+                Director::getInstance()->getScheduler().schedule(
+                    TimedJob(this, &DownloaderResumeTest::interrupt, JOB_INTERRUPT_OR_RESUME)
+                        .repeat(0)
+                        .delay(0.0f)
+                        .paused(isPaused())
+                );
+            }
+            char buf[64];
+            sprintf(buf, "%.1f%% of %d KB", float(totalBytesReceived * 100) / totalBytesExpected, int(totalBytesExpected / 1024));
+            labelStatus->setString(status + buf);
+        };
+
+        downloader->onFileTaskSuccess = [this](const network::DownloadTask& task)
+        {
+            pending = false;
+            Director::getInstance()->getScheduler().unscheduleTimedJob(this, JOB_INTERRUPT_OR_RESUME);
+            float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+            auto util = FileUtils::getInstance();
+            Data downloaded = util->getDataFromFile(task.storagePath);
+            Data expected = util->getDataFromFile("cocosvideo.mp4");
+            bool match = downloaded.getSize() == expected.getSize()
+                && 0 == memcmp(downloaded.getBytes(), expected.getBytes(), expected.getSize());
+
+            char buf[128];
+            if (resumed)
+            {
+                sprintf(buf, "resumed, first progress at %lld bytes, ", (long long)firstTotalBytesReceived);
+                status += buf;
+            }
+            else
+            {
+                status += "finished before it was interrupted, ";
+            }
+            sprintf(buf, "%d bytes %s, %.1f ms", int(downloaded.getSize()), match ? "match" : "mismatch", elapsed);
+            labelStatus->setString(status + buf);
+        };
+
+        downloader->onTaskError = [this](const network::DownloadTask& /*task*/,
+                                         int errorCode,
+                                         int errorCodeInternal,
+                                         const std::string& errorStr)
+        {
+            pending = false;
+            Director::getInstance()->getScheduler().unscheduleTimedJob(this, JOB_INTERRUPT_OR_RESUME);
+            char buf[64];
+            sprintf(buf, "failed with %d(%d): ", errorCode, errorCodeInternal);
+            labelStatus->setString(status + buf + errorStr);
+        };
+    }
+
+    void onMenuStartClicked(Ref*)
+    {
+        if (pending)
+        {
+            return;
+        }
+
+        // start over, with neither the file nor what an earlier run left behind
+        auto util = FileUtils::getInstance();
+        util->removeFile(storagePath);
+        util->removeFile(storagePath + ".tmp");
+        util->removeFile(storagePath + ".tmp.chunks");
+
+        status.clear();
+        firstTotalBytesReceived = -1;
+        interrupted = false;
+        resumed = false;
+        pending = true;
+        startTime = std::chrono::steady_clock::now();
+        createDownloader();
+        downloader->createDownloadFileTask("http://localhost:8000/cocosvideo.mp4", storagePath);
+    }
+
+    void interrupt(float)
+    {
+        downloader.reset();
+
+        char buf[64];
+        sprintf(buf, "interrupted after %lld bytes\n", (long long)firstTotalBytesReceived);
+        status += buf;
+        labelStatus->setString(status);
+
+        // the network thread saves the chunk file and leaves within a second of the downloader going away
+        Director::getInstance()->getScheduler().schedule(
+            TimedJob(this, &DownloaderResumeTest::resume, JOB_INTERRUPT_OR_RESUME)
+                .repeat(0)
+                .delay(1.5f)
+                .paused(isPaused())
+        );
+    }
+
+    void resume(float)
+    {
+        bool hasChunkFile = FileUtils::getInstance()->isFileExist(storagePath + ".tmp.chunks");
+        status += hasChunkFile ? "resuming from the chunk file\n" : "no chunk file, starting over\n";
+        labelStatus->setString(status);
+
+        firstTotalBytesReceived = -1;
+        resumed = true;
+        createDownloader();
+        downloader->createDownloadFileTask("http://localhost:8000/cocosvideo.mp4", storagePath);
+    }
+};
+
 DownloaderTests::DownloaderTests()
 {
     ADD_TEST_CASE(DownloaderTest);
+    ADD_TEST_CASE(DownloaderResumeTest);
 };
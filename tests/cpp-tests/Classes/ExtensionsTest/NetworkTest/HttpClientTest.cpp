@@ -5,6 +5,7 @@
 #include "2d/CCMenuItem.h"
 #include "base/CCDirector.h"
 
+#include <chrono>
 #include <string>
 
 using namespace cocos2d;
@@ -14,6 +15,8 @@ using namespace cocos2d::network;
 HttpClientTests::HttpClientTests()
 {
     ADD_TEST_CASE(HttpClientTest);
+    ADD_TEST_CASE(HttpClientConcurrencyTest);
+    ADD_TEST_CASE(HttpClientStreamTest);
 }
 
 HttpClientTest::HttpClientTest() 
@@ -364,3 +367,171 @@ void HttpClientTest::onHttpRequestCompleted(HttpClient *, std::shared_ptr<HttpRe
     }
     log("\n");
 }
+
+HttpClientConcurrencyTest::HttpClientConcurrencyTest()
+: _labelStatus(nullptr)
+, _pendingRequests(0)
+, _failedRequests(0)
+{
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto menuRequest = make_node_ptr<Menu>();
+    menuRequest->setPosition(Vec2::ZERO);
+
+    const int concurrencies[] = { 1, 4, 8 };
+    for (int i = 0; i < 3; ++i)
+    {
+        char text[64];
+        sprintf(text, "Send 24 requests, %d at a time", concurrencies[i]);
+        auto label = to_node_ptr(Label::createWithTTF(text, "fonts/arial.ttf", 22));
+        auto item = to_node_ptr(MenuItemLabel::create(std::move(label), CC_CALLBACK_1(HttpClientConcurrencyTest::onMenuSendClicked, this, concurrencies[i])));
+        item->setPosition(winSize.width / 2, winSize.height - 75 - i * 35);
+        menuRequest->addChild(std::move(item));
+    }
+    addChild(std::move(menuRequest));
+
+    auto labelStatus = to_node_ptr(Label::createWithTTF("", "fonts/arial.ttf", 16));
+    labelStatus->setDimensions(winSize.width - 40, 0);
+    labelStatus->setPosition(winSize.width / 2, winSize.height / 2 - 40);
+    _labelStatus = labelStatus.get();
+    addChild(std::move(labelStatus));
+}
+
+HttpClientConcurrencyTest::~HttpClientConcurrencyTest()
+{
+    HttpClient::destroyInstance();
+}
+
+void HttpClientConcurrencyTest::onMenuSendClicked(cocos2d::Ref *, int maxConcurrentRequests)
+{
+    if (_pendingRequests > 0)
+    {
+        return;
+    }
+
+    const int REQUEST_COUNT = 24;
+    auto client = HttpClient::getInstance();
+    client->setMaxConcurrentRequests(maxConcurrentRequests);
+
+    _completionOrder.clear();
+    _pendingRequests = REQUEST_COUNT;
+    _failedRequests = 0;
+    _startTime = std::chrono::steady_clock::now();
+
+    // every fourth request has a higher priority, they are expected to complete first
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        char tag[16];
+        sprintf(tag, i % 4 == 0 ? "%d!" : "%d", i);
+
+        auto request = std::make_shared<HttpRequest>();
+        request->setUrl("http://localhost:8000/fonts/arial.ttf");
+        request->setRequestType(HttpRequest::Type::GET);
+        request->setPriority(i % 4 == 0 ? 1 : 0);
+        request->setTag(tag);
+        request->setResponseCallback([this](HttpClient *, std::shared_ptr<HttpResponse> response) {
+            if (!response->isSucceed())
+                ++_failedRequests;
+            _completionOrder += response->getHttpRequest()->getTag();
+            _completionOrder += " ";
+
+            float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _startTime).count();
+
+            char status[64];
+            sprintf(status, "%d left, %d failed, %.1f ms\n", --_pendingRequests, _failedRequests, elapsed);
+            _labelStatus->setString(status + _completionOrder);
+        });
+        client->send(request);
+    }
+}
+
+HttpClientStreamTest::HttpClientStreamTest()
+: _labelStatus(nullptr)
+, _bufferAdapter(&_buffer)
+, _streamedBytes(0)
+, _streamedChunks(0)
+, _pending(false)
+{
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto menuRequest = make_node_ptr<Menu>();
+    menuRequest->setPosition(Vec2::ZERO);
+
+    const char* texts[] = { "Stream to a file", "Stream to a buffer", "Stream to the main thread" };
+    const Sink sinks[] = { Sink::FILE, Sink::BUFFER, Sink::MAIN_THREAD_CALLBACK };
+    for (int i = 0; i < 3; ++i)
+    {
+        auto label = to_node_ptr(Label::createWithTTF(texts[i], "fonts/arial.ttf", 22));
+        auto item = to_node_ptr(MenuItemLabel::create(std::move(label), CC_CALLBACK_1(HttpClientStreamTest::onMenuStreamClicked, this, sinks[i])));
+        item->setPosition(winSize.width / 2, winSize.height - 75 - i * 35);
+        menuRequest->addChild(std::move(item));
+    }
+    addChild(std::move(menuRequest));
+
+    auto labelStatus = to_node_ptr(Label::createWithTTF("", "fonts/arial.ttf", 16));
+    labelStatus->setDimensions(winSize.width - 40, 0);
+    labelStatus->setPosition(winSize.width / 2, winSize.height / 2 - 40);
+    _labelStatus = labelStatus.get();
+    addChild(std::move(labelStatus));
+}
+
+HttpClientStreamTest::~HttpClientStreamTest()
+{
+    HttpClient::destroyInstance();
+}
+
+void HttpClientStreamTest::onMenuStreamClicked(cocos2d::Ref *, Sink sink)
+{
+    // the buffer is written by the network thread until the response callback
+    if (_pending)
+    {
+        return;
+    }
+
+    auto request = std::make_shared<HttpRequest>();
+    request->setUrl("http://localhost:8000/fonts/arial.ttf");
+    request->setRequestType(HttpRequest::Type::GET);
+
+    _buffer.clear();
+    _streamedBytes = 0;
+    _streamedChunks = 0;
+    switch (sink)
+    {
+    case Sink::FILE:
+        request->setResponseFile(FileUtils::getInstance()->getWritablePath() + "http_stream_test.ttf");
+        break;
+    case Sink::BUFFER:
+        request->setResponseBuffer(&_bufferAdapter);
+        break;
+    case Sink::MAIN_THREAD_CALLBACK:
+        request->setResponseDataCallback([this](const char *, size_t size) {
+            _streamedBytes += size;
+            ++_streamedChunks;
+            return true;
+        }, HttpRequest::DataCallbackThread::MAIN);
+        break;
+    }
+
+    request->setResponseCallback([this, sink](HttpClient *, std::shared_ptr<HttpResponse> response) {
+        _pending = false;
+        float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _startTime).count();
+
+        size_t bytes = 0;
+        if (sink == Sink::FILE)
+            bytes = (size_t)FileUtils::getInstance()->getFileSize(response->getHttpRequest()->getResponseFile());
+        else if (sink == Sink::BUFFER)
+            bytes = _buffer.size();
+        else
+            bytes = _streamedBytes;
+
+        char status[128];
+        sprintf(status, "%s, %zu bytes, %d data callbacks, %zu bytes in the response, %.1f ms",
+                response->isSucceed() ? "succeeded" : "failed", bytes, _streamedChunks, response->getResponseData()->size(), elapsed);
+        _labelStatus->setString(status);
+    });
+
+    _pending = true;
+    _startTime = std::chrono::steady_clock::now();
+    _labelStatus->setString("waiting...");
+    HttpClient::getInstance()->send(request);
+}
@@ -5,6 +5,8 @@
 #include "network/HttpClient.h"
 #include "BaseTest.h"
 
+#include <chrono>
+
 DEFINE_TEST_SUITE(HttpClientTests);
 
 class HttpClientTest : public TestCase
@@ -37,4 +39,71 @@ private:
     cocos2d::Label* _labelStatusCode;
 };
 
+// Sends a burst of requests of mixed priorities to a local server, e.g. "python3 -m http.server 8000"
+// run in tests/cpp-tests/Resources, and shows the order and the time in which they complete.
+class HttpClientConcurrencyTest : public TestCase
+{
+public:
+    static HttpClientConcurrencyTest* create()
+    {
+        auto ret = new HttpClientConcurrencyTest;
+        ret->init();
+        ret->autorelease();
+        return ret;
+    }
+
+    HttpClientConcurrencyTest();
+    virtual ~HttpClientConcurrencyTest();
+
+    void onMenuSendClicked(cocos2d::Ref *sender, int maxConcurrentRequests);
+
+    virtual std::string title() const override { return "Http Concurrency Test"; }
+    virtual std::string subtitle() const override { return "needs an http server on localhost:8000"; }
+
+private:
+    cocos2d::Label* _labelStatus;
+    std::string _completionOrder;
+    int _pendingRequests;
+    int _failedRequests;
+    std::chrono::steady_clock::time_point _startTime;
+};
+
+// Streams a response body from the same local server to a file, to a buffer, and to a data callback
+// on the main thread, instead of collecting it in the HttpResponse.
+class HttpClientStreamTest : public TestCase
+{
+public:
+    enum class Sink
+    {
+        FILE,
+        BUFFER,
+        MAIN_THREAD_CALLBACK,
+    };
+
+    static HttpClientStreamTest* create()
+    {
+        auto ret = new HttpClientStreamTest;
+        ret->init();
+        ret->autorelease();
+        return ret;
+    }
+
+    HttpClientStreamTest();
+    virtual ~HttpClientStreamTest();
+
+    void onMenuStreamClicked(cocos2d::Ref *sender, Sink sink);
+
+    virtual std::string title() const override { return "Http Stream Test"; }
+    virtual std::string subtitle() const override { return "needs an http server on localhost:8000"; }
+
+private:
+    cocos2d::Label* _labelStatus;
+    std::vector<char> _buffer;
+    cocos2d::ResizableBufferAdapter<std::vector<char>> _bufferAdapter;
+    size_t _streamedBytes;
+    int _streamedChunks;
+    bool _pending;
+    std::chrono::steady_clock::time_point _startTime;
+};
+
 #endif //__HTTPREQUESTHTTP_H
@@ -910,8 +910,8 @@ std::string AsyncLoadSprite3DTest::subtitle() const
 
 void AsyncLoadSprite3DTest::menuCallback_asyncLoadSprite(Ref*)
 {
-    //Note that you must stop the tasks before leaving the scene.
-    AsyncTaskPool::getInstance()->stopTasks(AsyncTaskPool::TaskType::TASK_IO);
+    //Note that you must stop the loads before leaving the scene.
+    Sprite3D::stopAsyncLoads();
     
     auto node = getChildByTag(101);
     node->removeAllChildren(); //remove all loaded sprite
@@ -0,0 +1,107 @@
+#include "PerformanceBundle3DTest.h"
+#include "3d/CCBundle3D.h"
+#include "Profile.h"
+
+using namespace cocos2d;
+
+PerformceBundle3DTests::PerformceBundle3DTests()
+{
+    ADD_TEST_CASE(Bundle3DPerformceTest);
+}
+
+static const int LOAD_COUNT = 20;
+
+static float calculateDeltaTime( struct timeval *lastUpdate )
+{
+    struct timeval now;
+
+    gettimeofday( &now, nullptr);
+
+    float dt = (now.tv_sec - lastUpdate->tv_sec) + (now.tv_usec - lastUpdate->tv_usec) / 1000000.0f;
+
+    return dt;
+}
+
+////////////////////////////////////////////////////////
+//
+// Bundle3DPerformceTest
+//
+////////////////////////////////////////////////////////
+void Bundle3DPerformceTest::performTestsModel(const std::string& filename, const char* fileType, const char* remark)
+{
+    struct timeval now;
+    bool loaded = true;
+
+    // the same work as Sprite3D::loadFromFile, without the GL objects
+    gettimeofday(&now, nullptr);
+    for (int i = 0; i < LOAD_COUNT && loaded; ++i)
+    {
+        auto bundle = Bundle3D::createBundle();
+        MeshDatas meshdatas;
+        MaterialDatas materialdatas;
+        NodeDatas nodedatas;
+        bundle->setMeshDataAliasing(true);
+        loaded = bundle->load(filename)
+            && bundle->loadMeshDatas(meshdatas)
+            && bundle->loadMaterials(materialdatas)
+            && bundle->loadNodes(nodedatas);
+        Bundle3D::destroyBundle(bundle);
+    }
+
+    if (loaded)
+    {
+        auto dt = calculateDeltaTime(&now) / LOAD_COUNT;
+        log("%s %s ms:%f", fileType, remark, dt * 1000);
+        if (isAutoTesting())
+            Profile::getInstance()->addTestResult(genStrVector(fileType, remark, nullptr),
+                                                  genStrVector(genStr("%fms", dt * 1000).c_str(), nullptr));
+    }
+    else
+        log("%s %s ERROR", fileType, remark);
+}
+
+void Bundle3DPerformceTest::performTests()
+{
+    if (isAutoTesting()) {
+        Profile::getInstance()->testCaseBegin("Bundle3DTest",
+                                              genStrVector("FileType", "Remark", nullptr),
+                                              genStrVector("Time", nullptr));
+    }
+
+    log("--------");
+    log("--- orc, average of %d loads ---", LOAD_COUNT);
+
+    auto fileUtils = FileUtils::getInstance();
+    performTestsModel(fileUtils->fullPathForFilename("Sprite3D/orc.c3t"), "c3t", "");
+    performTestsModel(fileUtils->fullPathForFilename("Sprite3D/orc.c3b"), "c3b", "");
+
+    std::string alignedPath = fileUtils->getWritablePath() + "orc_aligned.c3b";
+    if (Bundle3D::writeAlignedBinary(fileUtils->fullPathForFilename("Sprite3D/orc.c3b"), alignedPath))
+    {
+        performTestsModel(alignedPath, "c3b", "ALIGNED");
+        fileUtils->removeFile(alignedPath);
+    }
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+void Bundle3DPerformceTest::onEnter()
+{
+    TestCase::onEnter();
+
+    performTests();
+}
+
+std::string Bundle3DPerformceTest::title() const
+{
+    return "Bundle3D Performance Test";
+}
+
+std::string Bundle3DPerformceTest::subtitle() const
+{
+    return "See console for results";
+}
@@ -0,0 +1,26 @@
+#ifndef __PERFORMANCE_BUNDLE3D_TEST_H__
+#define __PERFORMANCE_BUNDLE3D_TEST_H__
+
+#include "BaseTest.h"
+
+DEFINE_TEST_SUITE(PerformceBundle3DTests);
+
+class Bundle3DPerformceTest : public TestCase
+{
+public:
+    static Bundle3DPerformceTest* create()
+    {
+        auto ret = new Bundle3DPerformceTest;
+        ret->autorelease();
+        return ret;
+    }
+
+    virtual void performTests();
+    void performTestsModel(const std::string& filename, const char* fileType, const char* remark);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "PerformancePhysicsTest.h"
+#include "physics/CCPhysicsWorld.h"
+#include "Profile.h"
+
+using namespace cocos2d;
+
+PerformcePhysicsTests::PerformcePhysicsTests()
+{
+#if CC_USE_PHYSICS
+    ADD_TEST_CASE(PhysicsBodiesPerformceTest);
+#endif
+}
+
+#if CC_USE_PHYSICS
+
+static const int SPAWN_WAVES = 20;
+static const float STEP = 1.0f / 60;
+
+static float calculateDeltaTime( struct timeval *lastUpdate )
+{
+    struct timeval now;
+
+    gettimeofday( &now, nullptr);
+
+    float dt = (now.tv_sec - lastUpdate->tv_sec) + (now.tv_usec - lastUpdate->tv_usec) / 1000000.0f;
+
+    return dt;
+}
+
+////////////////////////////////////////////////////////
+//
+// PhysicsBodiesPerformceTest
+//
+////////////////////////////////////////////////////////
+bool PhysicsBodiesPerformceTest::init()
+{
+    TestCase::init();
+    return initWithPhysics();
+}
+
+void PhysicsBodiesPerformceTest::performTestsSpawn(int quantity, bool bulk)
+{
+    auto world = getPhysicsWorld();
+    std::vector<PhysicsBody*> bodies;
+    bodies.reserve(quantity);
+    float spawnTime = 0.0f;
+    float lookupTime = 0.0f;
+    float despawnTime = 0.0f;
+    struct timeval now;
+
+    // bullets spawned in a wave, looked up by tag and despawned after a step, like a burst of fire
+    for (int wave = 0; wave < SPAWN_WAVES; ++wave)
+    {
+        bodies.clear();
+        for (int i = 0; i < quantity; ++i)
+        {
+            auto body = PhysicsBody::createCircle(2.0f);
+            body->setTag(i);
+            body->setGravityEnable(false);
+            bodies.push_back(body);
+        }
+
+        gettimeofday(&now, nullptr);
+        if (bulk)
+        {
+            world->addBodies(bodies);
+        }
+        else
+        {
+            for (auto body : bodies)
+                world->addBody(body);
+        }
+        world->step(STEP);
+        spawnTime += calculateDeltaTime(&now);
+
+        int found = 0;
+        gettimeofday(&now, nullptr);
+        for (int i = 0; i < quantity; ++i)
+        {
+            if (world->getBody(i) != nullptr)
+                ++found;
+        }
+        lookupTime += calculateDeltaTime(&now);
+        if (found != quantity)
+            log("%d bodies out of %d found by tag", found, quantity);
+
+        gettimeofday(&now, nullptr);
+        if (bulk)
+        {
+            world->removeBodies(bodies);
+        }
+        else
+        {
+            for (int i = 0; i < quantity; ++i)
+                world->removeBody(i);
+        }
+        despawnTime += calculateDeltaTime(&now);
+    }
+
+    const char* mode = bulk ? "BULK" : "ONE BY ONE";
+    auto quantityStr = genStr("%d", quantity);
+    spawnTime = spawnTime / SPAWN_WAVES * 1000;
+    lookupTime = lookupTime / SPAWN_WAVES * 1000;
+    despawnTime = despawnTime / SPAWN_WAVES * 1000;
+    log("%s bodies %d spawn ms:%f lookup ms:%f despawn ms:%f", mode, quantity, spawnTime, lookupTime, despawnTime);
+    if (isAutoTesting())
+        Profile::getInstance()->addTestResult(genStrVector(quantityStr.c_str(), mode, nullptr),
+                                              genStrVector(genStr("%fms", spawnTime).c_str(),
+                                                           genStr("%fms", lookupTime).c_str(),
+                                                           genStr("%fms", despawnTime).c_str(), nullptr));
+}
+
+void PhysicsBodiesPerformceTest::performTests()
+{
+    if (isAutoTesting()) {
+        Profile::getInstance()->testCaseBegin("PhysicsBodiesTest",
+                                              genStrVector("Quantity", "Mode", nullptr),
+                                              genStrVector("Spawn", "Lookup", "Despawn", nullptr));
+    }
+
+    auto world = getPhysicsWorld();
+    world->setAutoStep(false);
+
+    log("--------");
+    log("--- bodies added, stepped once and removed, average of %d waves ---", SPAWN_WAVES);
+
+    for (int quantity : { 100, 500, 2000 })
+    {
+        performTestsSpawn(quantity, false);
+        performTestsSpawn(quantity, true);
+    }
+
+    world->setAutoStep(true);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+void PhysicsBodiesPerformceTest::onEnter()
+{
+    TestCase::onEnter();
+
+    performTests();
+}
+
+std::string PhysicsBodiesPerformceTest::title() const
+{
+    return "PhysicsWorld Bodies Performance Test";
+}
+
+std::string PhysicsBodiesPerformceTest::subtitle() const
+{
+    return "See console for results";
+}
+
+#endif // CC_USE_PHYSICS
@@ -0,0 +1,33 @@
+#ifndef __PERFORMANCE_PHYSICS_TEST_H__
+#define __PERFORMANCE_PHYSICS_TEST_H__
+
+#include "BaseTest.h"
+
+DEFINE_TEST_SUITE(PerformcePhysicsTests);
+
+#if CC_USE_PHYSICS
+
+class PhysicsBodiesPerformceTest : public TestCase
+{
+public:
+    static PhysicsBodiesPerformceTest* create()
+    {
+        auto ret = new PhysicsBodiesPerformceTest;
+        ret->init();
+        ret->autorelease();
+        return ret;
+    }
+
+    virtual bool init() override;
+
+    virtual void performTests();
+    void performTestsSpawn(int quantity, bool bulk);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+};
+
+#endif // CC_USE_PHYSICS
+
+#endif
@@ -26,6 +26,8 @@ public:
         addTest("Particle3D Tests", []() { return new PerformceParticle3DTests(); });
         addTest("Sprite Tests", []() { return new PerformceSpriteTests(); });
         addTest("Texture Tests", []() { return new PerformceTextureTests(); });
+        addTest("Bundle3D Tests", []() { return new PerformceBundle3DTests(); });
+        addTest("Physics Tests", []() { return new PerformcePhysicsTests(); });
         addTest("Label Tests", []() { return new PerformceLabelTests(); });
         addTest("EventDispatcher Tests", []() { return new PerformceEventDispatcherTests(); });
         addTest("Scenario Tests", []() { return new PerformceScenarioTests(); });
@@ -3,9 +3,11 @@
 
 // sort them alphabetically. thanks
 #include "PerformanceAllocTest.h"
+#include "PerformanceBundle3DTest.h"
 #include "PerformanceNodeChildrenTest.h"
 #include "PerformanceParticleTest.h"
 #include "PerformanceParticle3DTest.h"
+#include "PerformancePhysicsTest.h"
 #include "PerformanceSpriteTest.h"
 #include "PerformanceTextureTest.h"
 #include "PerformanceLabelTest.h"
@@ -14,7 +14,9 @@ LOCAL_SRC_FILES := hellocpp/main.cpp \
                    ../../Classes/tests/BaseTest.cpp \
                    ../../Classes/tests/PerformanceParticle3DTest.cpp \
                    ../../Classes/tests/PerformanceAllocTest.cpp \
+                   ../../Classes/tests/PerformanceBundle3DTest.cpp \
                    ../../Classes/tests/PerformanceParticleTest.cpp \
+                   ../../Classes/tests/PerformancePhysicsTest.cpp \
                    ../../Classes/tests/PerformanceCallbackTest.cpp \
                    ../../Classes/tests/PerformanceScenarioTest.cpp \
                    ../../Classes/tests/PerformanceSpriteTest.cpp \